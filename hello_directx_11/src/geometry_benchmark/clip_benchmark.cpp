@@ -0,0 +1,200 @@
+#include "geometry_check.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//throughput of the clipper and the functions around it, on a scene of boxes around a camera frustum
+using namespace geometry_benchmark;
+
+namespace
+{
+    //best of three runs, in nanoseconds per item
+    template <typename function>
+    double measure(uint32_t items, function f)
+    {
+        double best = INFINITY;
+
+        for (auto run = 0U; run < 3; ++run)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            f();
+            const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            best = std::min(best, ns / items);
+        }
+
+        return best;
+    }
+
+    void print(const char* name, double ns)
+    {
+        printf("%-36s %8.1f ns %12.0f per second\n", name, ns, 1e9 / ns);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t count = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 16384;
+
+    std::mt19937                            g(7);
+    std::uniform_real_distribution<float>   center(-40.0f, 40.0f);
+    std::uniform_real_distribution<float>   size(0.25f, 4.0f);
+
+    const frustum           f = make_frustum(0.5f, 60.0f, 0.8f, 0.45f);
+    std::vector<aabb>       boxes;
+    std::vector<aabb>       intersecting;
+
+    //a third of the boxes cross the frustum planes, the rest is inside or outside, like the casters of a shadow pass
+    for (auto i = 0U; i < count; ++i)
+    {
+        const float3 c = { center(g), center(g), center(g) + 40.0f };
+        const float3 e = { size(g), size(g), size(g) };
+
+        boxes.push_back({ c - e, c + e });
+    }
+
+    const frustum_separating_axes axes = make_separating_axes(f);
+
+    for (auto&& b : boxes)
+    {
+        if (classify(axes, b) == frustum_aabb_classification::intersecting)
+        {
+            intersecting.push_back(b);
+        }
+    }
+
+    std::vector<fixed_convex_polyhedron> bodies(intersecting.size());
+
+    for (auto i = 0U; i < intersecting.size(); ++i)
+    {
+        clip(f, intersecting[i], bodies[i]);
+    }
+
+    std::vector<frustum_aabb_classification>    classes(boxes.size());
+    clip_batch                                  batch;
+    fixed_convex_polyhedron                     r;
+    uint32_t                                    sink = 0;
+
+    printf("boxes %zu, intersecting %zu\n", boxes.size(), intersecting.size());
+
+    print("classify, scalar", measure(count, [&]
+    {
+        for (auto i = 0U; i < count; ++i)
+        {
+            classes[i] = classify(axes, boxes[i]);
+        }
+    }));
+
+    print("classify, batch", measure(count, [&]
+    {
+        classify(axes, boxes.data(), count, classes.data());
+    }));
+
+    //the same boxes rotated, they are tested as oriented boxes and as box shaped frusta
+    std::vector<obb>        oriented(count);
+    std::vector<frustum>    frusta(count);
+
+    for (auto i = 0U; i < count; ++i)
+    {
+        const float3 c = (boxes[i].m_min + boxes[i].m_max) * 0.5f;
+        const float3 a = normalize(float3{ center(g), center(g), center(g) });
+        const float3 b = normalize(cross(a, float3{ center(g), center(g), center(g) }));
+
+        oriented[i] = { c, { a, b, cross(a, b) }, (boxes[i].m_max - boxes[i].m_min) * 0.5f };
+
+        const auto points = make_points(aabb{ float3{ 0.0f, 0.0f, 0.0f } - oriented[i].m_extents, oriented[i].m_extents });
+
+        for (auto j = 0U; j < 8; ++j)
+        {
+            frusta[i].m_points[j] = a * points[j].m_x + b * points[j].m_y + oriented[i].m_axes[2] * points[j].m_z + c;
+        }
+    }
+
+    print("classify obb, scalar", measure(count, [&]
+    {
+        for (auto i = 0U; i < count; ++i)
+        {
+            classes[i] = classify(axes, oriented[i]);
+        }
+    }));
+
+    print("classify obb, batch", measure(count, [&]
+    {
+        classify(axes, oriented.data(), count, classes.data());
+    }));
+
+    print("classify frustum, scalar", measure(count, [&]
+    {
+        for (auto i = 0U; i < count; ++i)
+        {
+            classes[i] = classify(axes, frusta[i]);
+        }
+    }));
+
+    print("classify frustum, batch", measure(count, [&]
+    {
+        classify(axes, frusta.data(), count, classes.data());
+    }));
+
+    print("clip, intersecting boxes", measure(static_cast<uint32_t>(intersecting.size()), [&]
+    {
+        for (auto&& b : intersecting)
+        {
+            sink += clip(f, b, r) ? point_count(r) : 0;
+        }
+    }));
+
+    print("clip batch, all boxes", measure(count, [&]
+    {
+        batch.clear();
+        clip(f, boxes.data(), count, batch);
+        sink += static_cast<uint32_t>(batch.m_polyhedra.size());
+    }));
+
+    print("intersection, intersecting boxes", measure(static_cast<uint32_t>(intersecting.size()), [&]
+    {
+        for (auto&& b : intersecting)
+        {
+            sink += static_cast<uint32_t>(intersection(f, b).size());
+        }
+    }));
+
+    alignas(16) static uint8_t buffer[64 * 1024];
+
+    print("triangulate, clipped bodies", measure(static_cast<uint32_t>(bodies.size()), [&]
+    {
+        for (auto&& body : bodies)
+        {
+            sink += triangulate(body, buffer, sizeof(buffer)).m_index_count;
+        }
+    }));
+
+    const float3 light = { 10.0f, -80.0f, 25.0f };
+
+    print("extrusion, clipped bodies", measure(static_cast<uint32_t>(bodies.size()), [&]
+    {
+        for (auto&& body : bodies)
+        {
+            sink += convex_hull_with_direction(body, light, r) ? face_count(r) : 0;
+        }
+    }));
+
+    std::vector<convex_polyhedron_adjacency> adjacency(bodies.size());
+
+    for (auto i = 0U; i < bodies.size(); ++i)
+    {
+        make_adjacency(bodies[i], adjacency[i]);
+    }
+
+    print("extrusion, cached adjacency", measure(static_cast<uint32_t>(bodies.size()), [&]
+    {
+        for (auto i = 0U; i < bodies.size(); ++i)
+        {
+            sink += convex_hull_with_direction(bodies[i], adjacency[i], light, r) ? face_count(r) : 0;
+        }
+    }));
+
+    //keeps the results alive, so the loops are not removed
+    return sink == 0 ? 1 : 0;
+}
@@ -0,0 +1,617 @@
+#include "geometry_check.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+//randomized and degenerate inputs for clip, intersection, convex_hull_with_direction and triangulate.
+//the clipped body is compared with the brute force predicate "inside the frustum and inside the box" on sampled points.
+using namespace geometry_benchmark;
+
+namespace
+{
+    struct fuzz_statistics : check_statistics
+    {
+        uint32_t    m_non_empty     = 0;
+        float       m_max_error     = 0.0f;     //relative to the scale of the input
+    };
+
+    void fail(fuzz_statistics& s, const char* check, const frustum& f, const aabb& b)
+    {
+        //print the first failures of a group, with enough digits to reproduce them
+        if (s.m_failures++ < 4)
+        {
+            printf("  %s: %s failed\n    box %.9g %.9g %.9g  %.9g %.9g %.9g\n    frustum", s.m_name, check, b.m_min.m_x, b.m_min.m_y, b.m_min.m_z, b.m_max.m_x, b.m_max.m_y, b.m_max.m_z);
+
+            for (auto&& p : f.m_points)
+            {
+                printf(" %.9g %.9g %.9g ", p.m_x, p.m_y, p.m_z);
+            }
+
+            printf("\n");
+        }
+    }
+
+    float3 random_point(std::mt19937& g, const aabb& b)
+    {
+        std::uniform_real_distribution<float> u(0.0f, 1.0f);
+        const float3 e = b.m_max - b.m_min;
+
+        return { b.m_min.m_x + u(g) * e.m_x, b.m_min.m_y + u(g) * e.m_y, b.m_min.m_z + u(g) * e.m_z };
+    }
+
+    bool check_triangulation(const fixed_convex_polyhedron& r)
+    {
+        alignas(16) static uint8_t buffer[64 * 1024];
+
+        const triangle_list_layout layout   = triangulate(r, buffer, sizeof(buffer));
+        uint32_t                   indices  = 0;
+
+        for (auto i = 0U; i < face_count(r); ++i)
+        {
+            indices += 3 * (face_size(r, i) - 2);
+        }
+
+        if (layout.m_index_count != indices || layout.m_vertex_count != point_count(r) || layout.m_size != make_triangle_list_layout(r).m_size)
+        {
+            return false;
+        }
+
+        const float3*   positions   = reinterpret_cast<const float3*>(buffer);
+        const uint16_t* index       = reinterpret_cast<const uint16_t*>(buffer + layout.m_indices_offset);
+        double          area        = 0.0;
+        double          faces_area  = 0.0;
+
+        for (auto i = 0U; i < layout.m_index_count; i += 3)
+        {
+            if (index[i] >= layout.m_vertex_count || index[i + 1] >= layout.m_vertex_count || index[i + 2] >= layout.m_vertex_count)
+            {
+                return false;
+            }
+
+            const float3 n = cross(positions[index[i + 1]] - positions[index[i]], positions[index[i + 2]] - positions[index[i]]);
+            area += sqrt(dot(n, n));
+        }
+
+        for (auto i = 0U; i < face_count(r); ++i)
+        {
+            const float3 o = r.m_points[face_index(r, i, 0)];
+
+            for (auto j = 1U; j + 1 < face_size(r, i); ++j)
+            {
+                const float3 n = cross(r.m_points[face_index(r, i, j)] - o, r.m_points[face_index(r, i, j + 1)] - o);
+                faces_area += sqrt(dot(n, n));
+            }
+        }
+
+        return fabs(area - faces_area) <= 1e-3 * faces_area + 1e-12;
+    }
+
+    //the extrusion contains the body and its moved copy, and its vertices are among them. returns the failed check
+    const char* check_extrusion(const fixed_convex_polyhedron& body, const float3& vector, float epsilon)
+    {
+        fixed_convex_polyhedron r;
+
+        //does not fit the fixed storage, the caller keeps the body
+        if (!convex_hull_with_direction(body, vector, r))
+        {
+            return nullptr;
+        }
+
+        if (!check_polyhedron(r, epsilon).ok())
+        {
+            return "extrusion topology";
+        }
+
+        for (auto&& p : body.m_points)
+        {
+            if (outside_distance(r, p, epsilon) > epsilon || outside_distance(r, p + vector, epsilon) > epsilon)
+            {
+                return "extrusion containment";
+            }
+        }
+
+        for (auto&& p : r.m_points)
+        {
+            const bool found = std::any_of(body.m_points.begin(), body.m_points.end(), [&p, &vector](const float3& q) { return p == q || p == q + vector; });
+
+            if (!found)
+            {
+                return "extrusion vertices";
+            }
+        }
+
+        return nullptr;
+    }
+
+    void check_clip(fuzz_statistics& s, const frustum& f, const aabb& b, std::mt19937& g)
+    {
+        const float                     size        = scale(f, b);
+        const float                     epsilon     = 1e-4f * size;
+        const std::array<plane, 6>      planes      = make_face_planes(f);
+        const frustum_aabb_classification c         = classify(make_separating_axes(f), b);
+
+        fixed_convex_polyhedron r;
+
+        const bool non_empty = clip(f, b, r);
+
+        s.m_cases++;
+        s.m_non_empty += non_empty ? 1 : 0;
+
+        if (non_empty)
+        {
+            const polyhedron_check t = check_polyhedron(r, epsilon);
+
+            s.m_max_error = std::max(s.m_max_error, t.m_max_error / size);
+
+            if (!t.ok())
+            {
+                fail(s, "topology", f, b);
+                return;
+            }
+
+            for (auto&& p : r.m_points)
+            {
+                const float d = std::max(outside_distance(planes, p), outside_distance(b, p));
+
+                s.m_max_error = std::max(s.m_max_error, d / size);
+
+                if (d > epsilon)
+                {
+                    fail(s, "vertex containment", f, b);
+                    return;
+                }
+            }
+
+            if (!check_triangulation(r))
+            {
+                fail(s, "triangulation", f, b);
+                return;
+            }
+
+            //light directions are 1 to 1000 body sizes long, longer ones round the moved copy into a few points.
+            //axis aligned directions make the faces of boxes parallel to them
+            const float body    = extent(std::vector<float3>(r.m_points.begin(), r.m_points.end()));
+            float3      vector  = random_point(g, { { -1.0f, -1.0f, -1.0f }, { 1.0f, 1.0f, 1.0f } }) * body * powf(10.0f, 3.0f * std::uniform_real_distribution<float>(0.0f, 1.0f)(g));
+
+            switch (g() % 4)
+            {
+                case 1: vector.m_x = 0.0f; break;
+                case 2: vector.m_x = 0.0f; vector.m_y = 0.0f; break;
+                default: break;
+            }
+
+            if (const char* check = check_extrusion(r, vector, 1e-4f * (size + max_abs(vector))))
+            {
+                fail(s, check, f, b);
+                return;
+            }
+        }
+        else if (c == frustum_aabb_classification::inside)
+        {
+            fail(s, "classified inside but clipped empty", f, b);
+            return;
+        }
+
+        //brute force reference: a sampled point well inside both inputs is inside the result, a point well outside one of them is outside
+        for (auto i = 0U; i < 64; ++i)
+        {
+            const float3 p          = random_point(g, b);
+            const float  reference  = std::max(outside_distance(planes, p), outside_distance(b, p));
+            const float  clipped    = non_empty ? outside_distance(r, p, 0.0f) : INFINITY;
+
+            if (reference < -epsilon && clipped > epsilon)
+            {
+                fail(s, "point inside both inputs is outside the result", f, b);
+                return;
+            }
+
+            if (reference > epsilon && clipped < -epsilon)
+            {
+                fail(s, "point outside the inputs is inside the result", f, b);
+                return;
+            }
+        }
+
+        //the points of intersection() are the cuts of the box edges with the frustum planes, the box corners or the frustum corners inside the box
+        for (auto&& p : intersection(f, b))
+        {
+            if (outside_distance(b, p) > epsilon)
+            {
+                fail(s, "intersection point containment", f, b);
+                return;
+            }
+        }
+    }
+
+    //random rotation and translation, so the frustum planes are not aligned with the box axes
+    frustum transform(const frustum& f, std::mt19937& g, float translation)
+    {
+        std::normal_distribution<float>         n(0.0f, 1.0f);
+        std::uniform_real_distribution<float>   t(-translation, translation);
+
+        float3 a = normalize(float3{ n(g), n(g), n(g) });
+        float3 b = normalize(cross(a, float3{ n(g), n(g), n(g) }));
+        float3 c = cross(a, b);
+
+        const float3 o = { t(g), t(g), t(g) };
+        frustum      r;
+
+        for (auto i = 0U; i < 8; ++i)
+        {
+            const float3 p  = f.m_points[i];
+            r.m_points[i]   = a * p.m_x + b * p.m_y + c * p.m_z + o;
+        }
+
+        return r;
+    }
+
+    aabb make_aabb(const float3& center, const float3& extent)
+    {
+        return { center - extent, center + extent };
+    }
+
+    //prism over a regular polygon of n sides around the z axis, n + 2 faces and 2n points
+    convex_polyhedron make_prism(uint32_t n, float radius, float z0, float z1)
+    {
+        convex_polyhedron r;
+
+        for (auto i = 0U; i < 2 * n; ++i)
+        {
+            const float a = 6.2831853f * (i % n) / n;
+            r.m_points.push_back({ radius * cosf(a), radius * sinf(a), i < n ? z0 : z1 });
+        }
+
+        r.m_faces.resize(n + 2);
+
+        for (auto i = 0U; i < n; ++i)
+        {
+            r.m_faces[0].m_indices.push_back(n - 1 - i);
+            r.m_faces[1].m_indices.push_back(n + i);
+            r.m_faces[2 + i].m_indices = { i, (i + 1) % n, n + (i + 1) % n, n + i };
+        }
+
+        return r;
+    }
+
+    //every edge is shared by two faces and the euler characteristic is 2. the clipper does not orient the faces, so the winding is not checked
+    bool check_closed(const convex_polyhedron& r)
+    {
+        std::vector<std::pair<uint32_t, uint32_t>> edges;
+
+        for (auto&& f : r.m_faces)
+        {
+            for (auto i = 0U; i < f.m_indices.size(); ++i)
+            {
+                const uint32_t a = f.m_indices[i];
+                const uint32_t b = f.m_indices[(i + 1) % f.m_indices.size()];
+
+                if (a >= r.m_points.size() || b >= r.m_points.size() || a == b)
+                {
+                    return false;
+                }
+
+                edges.push_back({ std::min(a, b), std::max(a, b) });
+            }
+        }
+
+        std::sort(edges.begin(), edges.end());
+
+        for (auto i = 0U; i < edges.size(); i += 2)
+        {
+            if (i + 1 == edges.size() || edges[i] != edges[i + 1] || (i + 2 < edges.size() && edges[i] == edges[i + 2]))
+            {
+                return false;
+            }
+        }
+
+        return r.m_points.size() + r.m_faces.size() == edges.size() / 2 + 2;
+    }
+
+    void fail(fuzz_statistics& s, const char* check, uint32_t sides, const aabb& b)
+    {
+        if (s.m_failures++ < 4)
+        {
+            printf("  %s: %s failed\n    prism of %u sides, box %.9g %.9g %.9g  %.9g %.9g %.9g\n", s.m_name, check, sides,
+                b.m_min.m_x, b.m_min.m_y, b.m_min.m_z, b.m_max.m_x, b.m_max.m_y, b.m_max.m_z);
+        }
+    }
+
+    void print(const fuzz_statistics& s)
+    {
+        printf("%-28s cases %6u  non empty %6u  failures %4u  max error %.3g\n", s.m_name, s.m_cases, s.m_non_empty, s.m_failures, s.m_max_error);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t cases = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 20000;
+
+    std::mt19937                            g(1);
+    std::uniform_real_distribution<float>   u(0.0f, 1.0f);
+    check_groups<fuzz_statistics>           groups;
+
+    //random frusta and boxes
+    {
+        auto& s = groups.add("random");
+
+        for (auto i = 0U; i < cases; ++i)
+        {
+            const float     n       = 0.05f + 2.0f * u(g);
+            const float     far     = n + 5.0f + 500.0f * u(g) * u(g);
+            const frustum   f       = transform(make_frustum(n, far, 0.1f + 2.0f * u(g), 0.1f + 2.0f * u(g)), g, 10.0f);
+            const aabb      bounds  = make_aabb(f);
+            const float3    center  = random_point(g, bounds);
+            const float     e       = distance(bounds.m_min, bounds.m_max) * powf(10.0f, -3.0f * u(g));
+
+            check_clip(s, f, make_aabb(center, float3{ u(g) * e, u(g) * e, u(g) * e } + float3{ 1e-3f, 1e-3f, 1e-3f }), g);
+        }
+    }
+
+    //box faces on the near and the far planes
+    {
+        auto& s = groups.add("coplanar near and far");
+
+        for (auto i = 0U; i < cases / 10; ++i)
+        {
+            const float     far     = 10.0f + 100.0f * u(g);
+            const frustum   f       = make_frustum(1.0f, far, 0.5f + u(g), 0.5f + u(g));
+            const float     x       = 2.0f * u(g) - 1.0f;
+            const float     y       = 2.0f * u(g) - 1.0f;
+
+            check_clip(s, f, { { x - u(g), y - u(g), 1.0f }, { x + u(g), y + u(g), 1.0f + far * u(g) } }, g);
+            check_clip(s, f, { { x - u(g), y - u(g), far * u(g) }, { x + u(g), y + u(g), far } }, g);
+        }
+    }
+
+    //box shaped frusta that share faces with the box, or are the box
+    {
+        auto& s = groups.add("coplanar orthographic");
+
+        for (auto i = 0U; i < cases / 10; ++i)
+        {
+            const aabb  a       = make_aabb({ u(g), u(g), 5.0f + u(g) }, { 0.5f + u(g), 0.5f + u(g), 0.5f + u(g) });
+            aabb        b       = a;
+            const float grow    = u(g);
+
+            switch (i % 4)
+            {
+                case 1: b.m_max.m_x += grow; break;
+                case 2: b.m_max.m_x += grow; b.m_min.m_y -= grow; break;
+                case 3: b.m_min.m_x += 0.5f * grow * (a.m_max.m_x - a.m_min.m_x); b.m_max.m_z += grow; break;
+                default: break;
+            }
+
+            check_clip(s, make_orthographic_frustum(a), b, g);
+        }
+    }
+
+    //boxes touching the frustum from outside on a face, an edge or a corner
+    {
+        auto& s = groups.add("touching");
+
+        for (auto i = 0U; i < cases / 10; ++i)
+        {
+            const frustum   f = make_frustum(1.0f, 20.0f + 50.0f * u(g), 0.5f + u(g), 0.5f + u(g));
+            const float3    e = { 0.1f + u(g), 0.1f + u(g), 0.1f + u(g) };
+            const float3    p = f.m_points[g() % 8];
+
+            switch (i % 3)
+            {
+                case 0: check_clip(s, f, { { p.m_x - e.m_x, p.m_y - e.m_y, 1.0f - 2.0f * e.m_z }, { p.m_x + e.m_x, p.m_y + e.m_y, 1.0f } }, g); break;
+                case 1: check_clip(s, f, { { p.m_x, p.m_y, p.m_z - e.m_z }, { p.m_x + 2.0f * e.m_x, p.m_y + 2.0f * e.m_y, p.m_z + e.m_z } }, g); break;
+                default: check_clip(s, f, { p - 2.0f * e, p }, g); break;
+            }
+        }
+    }
+
+    //far planes at the limit of the float precision, with boxes near the camera and far away
+    {
+        auto& s = groups.add("huge far planes");
+
+        for (auto i = 0U; i < cases / 10; ++i)
+        {
+            const float     far = powf(10.0f, 4.0f + 3.0f * u(g));
+            const frustum   f   = make_frustum(0.1f, far, 0.5f + u(g), 0.5f + u(g));
+            const float     z   = (i % 2) ? 0.1f + 10.0f * u(g) : far * u(g);
+            const float     e   = std::max(0.05f, z * 0.1f * u(g));
+
+            check_clip(s, f, make_aabb({ (2.0f * u(g) - 1.0f) * z, (2.0f * u(g) - 1.0f) * z, z }, { e, e, e }), g);
+        }
+    }
+
+    //boxes inside the frustum and boxes containing it
+    {
+        auto& s = groups.add("nested");
+
+        for (auto i = 0U; i < cases / 10; ++i)
+        {
+            const frustum   f = make_frustum(1.0f, 10.0f + 50.0f * u(g), 0.5f + u(g), 0.5f + u(g));
+            const aabb      a = make_aabb(f);
+
+            if (i % 2)
+            {
+                check_clip(s, f, make_aabb({ 0.0f, 0.0f, 5.0f }, { 0.1f + 0.3f * u(g), 0.1f + 0.3f * u(g), 0.1f + 3.0f * u(g) }), g);
+            }
+            else
+            {
+                check_clip(s, f, { a.m_min - float3{ u(g), u(g), u(g) }, a.m_max + float3{ u(g), u(g), u(g) } }, g);
+            }
+        }
+    }
+
+    //the batch split into ranges, one job per thread with its own batch, gives the batch of one call
+    {
+        auto& s = groups.add("batch ranges");
+
+        for (auto i = 0U; i < cases / 1000; ++i)
+        {
+            const float     far     = 10.0f + 100.0f * u(g);
+            const frustum   f       = transform(make_frustum(1.0f, far, 0.5f + u(g), 0.5f + u(g)), g, 10.0f);
+            const aabb      bounds  = make_aabb(f);
+
+            std::vector<aabb> boxes(1000 + g() % 1000);
+
+            for (auto&& b : boxes)
+            {
+                b = make_aabb(random_point(g, bounds), { 0.1f + 5.0f * u(g), 0.1f + 5.0f * u(g), 0.1f + 5.0f * u(g) });
+            }
+
+            const uint32_t                  count   = static_cast<uint32_t>(boxes.size());
+            const frustum_separating_axes   axes    = make_separating_axes(f);
+            clip_batch                      all;
+            std::array<clip_batch, 4>       jobs;
+            std::vector<std::thread>        threads;
+
+            clip(f, boxes.data(), count, all);
+
+            for (auto j = 0U; j < jobs.size(); ++j)
+            {
+                const uint32_t first = count * j / 4;
+                const uint32_t last  = count * (j + 1) / 4;
+
+                threads.emplace_back([&, j, first, last] { clip(f, axes, boxes.data(), first, last - first, jobs[j]); });
+            }
+
+            for (auto&& t : threads)
+            {
+                t.join();
+            }
+
+            s.m_cases++;
+            s.m_non_empty += all.m_polyhedra.empty() ? 0 : 1;
+
+            uint32_t polyhedra = 0;
+
+            for (auto&& job : jobs)
+            {
+                for (auto&& h : job.m_polyhedra)
+                {
+                    if (polyhedra == all.m_polyhedra.size())
+                    {
+                        polyhedra++;
+                        break;
+                    }
+
+                    const auto& e = all.m_polyhedra[polyhedra++];
+
+                    if (h.m_box != e.m_box || h.m_points_size != e.m_points_size || h.m_faces_size != e.m_faces_size ||
+                        !std::equal(job.m_points.begin() + h.m_points_offset, job.m_points.begin() + h.m_points_offset + h.m_points_size, all.m_points.begin() + e.m_points_offset,
+                            [](const float3& a, const float3& b) { return a.m_x == b.m_x && a.m_y == b.m_y && a.m_z == b.m_z; }))
+                    {
+                        fail(s, "same polyhedra as the whole batch", f, boxes[h.m_box]);
+                        break;
+                    }
+                }
+            }
+
+            if (polyhedra != all.m_polyhedra.size())
+            {
+                fail(s, "same polyhedron count as the whole batch", f, boxes[0]);
+            }
+        }
+    }
+
+    //caller polyhedra beyond the fixed storage of the clipper, 64 faces, and of the output, 64 points and 32 faces:
+    //they are clipped on the heap. a prism of n sides inside the box keeps its 2n points and n + 2 faces,
+    //the boxes around the center of the prism always cut a closed polyhedron out of it
+    {
+        auto& s = groups.add("large polyhedra");
+
+        for (auto i = 0U; i < cases / 20; ++i)
+        {
+            const uint32_t          sides   = 3 + g() % 120;
+            const convex_polyhedron p       = make_prism(sides, 1.0f, -1.0f, 1.0f);
+            const bool              inside  = i % 2 == 0;
+            const aabb              b       = inside ? make_aabb({ 0.0f, 0.0f, 0.0f }, { 1.5f, 1.5f, 1.5f }) : make_aabb(random_point(g, { { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f } }), { 0.5f + u(g), 0.5f + u(g), 0.5f + u(g) });
+            const auto              r       = clip(p, b);
+
+            s.m_cases++;
+            s.m_non_empty += r ? 1 : 0;
+
+            //the extrusion has no heap path, it returns no polyhedron for a prism of more than 30 sides, more than 32 faces
+            const auto e = convex_hull_with_direction(p, { 0.3f, 0.2f, 1.0f });
+
+            if ((sides > 30 && e) || (sides <= 8 && !e))
+            {
+                fail(s, "extrusion beyond the fixed storage", sides, b);
+                continue;
+            }
+
+            if (!r)
+            {
+                fail(s, "prism clipped empty", sides, b);
+                continue;
+            }
+
+            if (inside && (r->m_points.size() != 2 * sides || r->m_faces.size() != sides + 2))
+            {
+                fail(s, "prism inside the box", sides, b);
+                continue;
+            }
+
+            if (!check_closed(*r))
+            {
+                fail(s, "closed polyhedron", sides, b);
+                continue;
+            }
+
+            for (auto&& q : r->m_points)
+            {
+                if (outside_distance(b, q) > 1e-4f || q.m_x * q.m_x + q.m_y * q.m_y > 1.0f + 1e-4f)
+                {
+                    fail(s, "vertex containment", sides, b);
+                    break;
+                }
+            }
+        }
+    }
+
+    //triangulations of prisms beyond the fixed storage of the ordered triangle list take the fans
+    {
+        auto& s = groups.add("large triangulations");
+
+        for (auto i = 0U; i < cases / 20; ++i)
+        {
+            const uint32_t                          sides   = 3 + g() % 120;
+            const convex_polyhedron                 p       = make_prism(sides, 1.0f, -1.0f, 1.0f);
+            const convex_triangulated_polyhedron    r       = triangulate(p);
+            const aabb                              b       = make_aabb({ 0.0f, 0.0f, 0.0f }, { 1.0f, 1.0f, 1.0f });
+
+            s.m_cases++;
+            s.m_non_empty += r.m_faces.empty() ? 0 : 1;
+
+            if (r.m_points.size() != p.m_points.size() || r.m_faces.size() != 2 * (sides - 2) + 2 * sides)
+            {
+                fail(s, "triangle count", sides, b);
+                continue;
+            }
+
+            //a closed surface has no vector area
+            float3 area = { 0.0f, 0.0f, 0.0f };
+
+            for (auto&& f : r.m_faces)
+            {
+                if (f.m_indices[0] >= r.m_points.size() || f.m_indices[1] >= r.m_points.size() || f.m_indices[2] >= r.m_points.size())
+                {
+                    fail(s, "triangle indices", sides, b);
+                    break;
+                }
+
+                area = area + cross(r.m_points[f.m_indices[1]] - r.m_points[f.m_indices[0]], r.m_points[f.m_indices[2]] - r.m_points[f.m_indices[0]]);
+            }
+
+            s.m_max_error = std::max(s.m_max_error, max_abs(area));
+
+            if (max_abs(area) > 1e-4f)
+            {
+                fail(s, "closed triangulation", sides, b);
+            }
+        }
+    }
+
+    return groups.report(print);
+}
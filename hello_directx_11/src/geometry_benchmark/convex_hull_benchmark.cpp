@@ -0,0 +1,97 @@
+#include "geometry_check.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//compares the incremental convex_hull_with_point against a brute force hull on randomized caster bodies and lights
+using namespace geometry_benchmark;
+
+int main(int, char*[])
+{
+    std::mt19937                            g(11);
+    std::uniform_real_distribution<float>   center(-8.0f, 8.0f);
+    std::uniform_real_distribution<float>   size(0.5f, 6.0f);
+    std::uniform_real_distribution<float>   light(-40.0f, 40.0f);
+
+    const frustum f = make_frustum(1.0f, 30.0f, 0.7f, 0.5f);
+
+    std::vector<fixed_convex_polyhedron>    bodies;
+    std::vector<float3>                     lights;
+
+    //outside lights, lights inside the body, lights on the planes of body faces and lights on body vertices
+    for (auto i = 0U; bodies.size() < 4096; ++i)
+    {
+        const float3 c = { center(g), center(g), center(g) + 12.0f };
+        const float3 e = { size(g), size(g), size(g) };
+        const aabb   b = { c - e, c + e };
+
+        fixed_convex_polyhedron body;
+
+        if (!clip(f, b, body))
+        {
+            continue;
+        }
+
+        float3 l = { light(g), light(g), light(g) };
+
+        switch (i % 4)
+        {
+            case 1: l = c; break;
+            case 2: l.m_x = b.m_max.m_x; break;
+            case 3: l = body.m_points[g() % point_count(body)]; l.m_y += 5.0f; break;
+            default: break;
+        }
+
+        bodies.push_back(body);
+        lights.push_back(l);
+    }
+
+    uint32_t failed     = 0;
+    uint32_t wrong      = 0;
+    double   reference  = 0.0;
+
+    for (auto i = 0U; i < bodies.size(); ++i)
+    {
+        std::vector<float3> points(bodies[i].m_points.begin(), bodies[i].m_points.end());
+        points.push_back(lights[i]);
+
+        const float epsilon = 1e-4f * extent(points);
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        brute_force_hull_points(points, epsilon);
+        reference += std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+
+        fixed_convex_polyhedron r;
+
+        if (!convex_hull_with_point(bodies[i], lights[i], r))
+        {
+            failed++;
+            continue;
+        }
+
+        wrong += check_hull(r, points, epsilon) ? 0 : 1;
+    }
+
+    const uint32_t          repeat  = 50;
+    uint32_t                faces   = 0;
+    fixed_convex_polyhedron r;
+    const auto              start   = std::chrono::high_resolution_clock::now();
+
+    for (auto k = 0U; k < repeat; ++k)
+    {
+        for (auto i = 0U; i < bodies.size(); ++i)
+        {
+            convex_hull_with_point(bodies[i], lights[i], r);
+            faces += face_count(r);
+        }
+    }
+
+    const double incremental = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count();
+
+    printf("hulls %zu, not fitting %u, wrong %u, faces per hull %.1f\n", bodies.size(), failed, wrong, double(faces) / (repeat * bodies.size()));
+    printf("incremental %.0f ns/hull, brute force %.0f ns/hull\n", incremental / (repeat * bodies.size()), reference / bodies.size());
+
+    return wrong == 0 ? 0 : 1;
+}
@@ -0,0 +1,368 @@
+#pragma once
+
+#include "frustum_aabb_intersection.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <math.h>
+#include <vector>
+
+//shared helpers of the geometry harness: inputs, brute force predicates, the topology checks of the clipper output and the groups of the fuzzers
+namespace geometry_benchmark
+{
+    using namespace computational_geometry;
+
+    inline frustum make_frustum(float n, float f, float tan_x, float tan_y)
+    {
+        frustum r;
+
+        const float3 points[8] =
+        {
+            { -tan_x * n, -tan_y * n, n }, { tan_x * n, -tan_y * n, n }, { tan_x * n, tan_y * n, n }, { -tan_x * n, tan_y * n, n },
+            { -tan_x * f, -tan_y * f, f }, { tan_x * f, -tan_y * f, f }, { tan_x * f, tan_y * f, f }, { -tan_x * f, tan_y * f, f }
+        };
+
+        std::copy(points, points + 8, r.m_points);
+        return r;
+    }
+
+    //box shaped frustum, its planes can coincide with box faces
+    inline frustum make_orthographic_frustum(const aabb& b)
+    {
+        frustum r;
+
+        const auto points = make_points(b);
+        std::copy(points.begin(), points.end(), r.m_points);
+        return r;
+    }
+
+    inline float max_abs(const float3& p)
+    {
+        return std::max(std::max(fabsf(p.m_x), fabsf(p.m_y)), fabsf(p.m_z));
+    }
+
+    //the float resolution of the inputs, the tolerances of the checks are multiples of it
+    inline float scale(const frustum& f, const aabb& b)
+    {
+        float r = std::max(max_abs(b.m_min), max_abs(b.m_max));
+
+        for (auto&& p : f.m_points)
+        {
+            r = std::max(r, max_abs(p));
+        }
+
+        return r;
+    }
+
+    inline float extent(const std::vector<float3>& points)
+    {
+        float3 minimum = points[0];
+        float3 maximum = points[0];
+
+        for (auto&& p : points)
+        {
+            minimum = { std::min(minimum.m_x, p.m_x), std::min(minimum.m_y, p.m_y), std::min(minimum.m_z, p.m_z) };
+            maximum = { std::max(maximum.m_x, p.m_x), std::max(maximum.m_y, p.m_y), std::max(maximum.m_z, p.m_z) };
+        }
+
+        return distance(minimum, maximum);
+    }
+
+    //signed distance outside of the planes, the planes point inside
+    inline float outside_distance(const std::array<plane, 6>& planes, const float3& p)
+    {
+        float r = -INFINITY;
+
+        for (auto&& q : planes)
+        {
+            r = std::max(r, -(dot(q.m_n, p) + q.m_d));
+        }
+
+        return r;
+    }
+
+    inline float outside_distance(const aabb& b, const float3& p)
+    {
+        const float x = std::max(b.m_min.m_x - p.m_x, p.m_x - b.m_max.m_x);
+        const float y = std::max(b.m_min.m_y - p.m_y, p.m_y - b.m_max.m_y);
+        const float z = std::max(b.m_min.m_z - p.m_z, p.m_z - b.m_max.m_z);
+
+        return std::max(std::max(x, y), z);
+    }
+
+    //face plane in double precision, the float cross products of long thin faces like the silhouette quads of an extrusion cancel
+    struct face_plane_d
+    {
+        double m_x = 0.0;
+        double m_y = 0.0;
+        double m_z = 0.0;
+        double m_d = 0.0;
+        double m_width = 0.0;   //twice the area over the longest diagonal from the first point
+
+        double distance(const float3& p) const
+        {
+            return m_x * p.m_x + m_y * p.m_y + m_z * p.m_z + m_d;
+        }
+    };
+
+    //outward unit normal of a face, relative to its first point to avoid the cancellation of thin faces far from the origin
+    inline face_plane_d face_plane(const fixed_convex_polyhedron& r, uint32_t face)
+    {
+        const uint32_t size = face_size(r, face);
+        const float3   o    = r.m_points[face_index(r, face, 0)];
+        face_plane_d   q;
+        double         diagonal = 0.0;
+
+        for (auto j = 0U; j < size; ++j)
+        {
+            const float3 a  = r.m_points[face_index(r, face, j)];
+            const float3 b  = r.m_points[face_index(r, face, (j + 1) % size)];
+
+            const double ax = double(a.m_x) - o.m_x, ay = double(a.m_y) - o.m_y, az = double(a.m_z) - o.m_z;
+            const double bx = double(b.m_x) - o.m_x, by = double(b.m_y) - o.m_y, bz = double(b.m_z) - o.m_z;
+
+            q.m_x += ay * bz - az * by;
+            q.m_y += az * bx - ax * bz;
+            q.m_z += ax * by - ay * bx;
+
+            diagonal = std::max(diagonal, sqrt(ax * ax + ay * ay + az * az));
+        }
+
+        const double length = sqrt(q.m_x * q.m_x + q.m_y * q.m_y + q.m_z * q.m_z);
+
+        if (length == 0.0)
+        {
+            return q;
+        }
+
+        q.m_width = length / diagonal;
+
+        q.m_x /= length;
+        q.m_y /= length;
+        q.m_z /= length;
+        q.m_d = -(q.m_x * o.m_x + q.m_y * o.m_y + q.m_z * o.m_z);
+        return q;
+    }
+
+    //distance of the point in front of the outward face planes, negative inside. faces not wider than width are skipped
+    inline float outside_distance(const fixed_convex_polyhedron& r, const float3& p, float width)
+    {
+        double d = -INFINITY;
+
+        for (auto i = 0U; i < face_count(r); ++i)
+        {
+            const face_plane_d q = face_plane(r, i);
+
+            if (q.m_width > width)
+            {
+                d = std::max(d, q.distance(p));
+            }
+        }
+
+        return static_cast<float>(d);
+    }
+
+    struct polyhedron_check
+    {
+        bool  m_closed      = true;     //every directed edge has exactly one opposite
+        bool  m_euler       = true;     //v - e + f = 2
+        bool  m_planar      = true;     //face points are on the face plane
+        bool  m_convex      = true;     //every point is behind every face plane
+        bool  m_outward     = true;     //faces are counter clockwise seen from outside
+        float m_max_error   = 0.0f;     //largest planarity or convexity violation
+
+        bool ok() const
+        {
+            return m_closed && m_euler && m_planar && m_convex && m_outward;
+        }
+    };
+
+    inline polyhedron_check check_polyhedron(const fixed_convex_polyhedron& r, float epsilon)
+    {
+        polyhedron_check c;
+        uint32_t         edges  = 0;
+        float3           center = { 0.0f, 0.0f, 0.0f };
+
+        for (auto&& p : r.m_points)
+        {
+            center = center + p;
+        }
+
+        center = center / static_cast<float>(std::max(1U, point_count(r)));
+
+        for (auto i = 0U; i < face_count(r); ++i)
+        {
+            const uint32_t size = face_size(r, i);
+
+            for (auto j = 0U; j < size; ++j)
+            {
+                const uint32_t a        = face_index(r, i, j);
+                const uint32_t b        = face_index(r, i, (j + 1) % size);
+                uint32_t       opposite = 0;
+
+                for (auto f = 0U; f < face_count(r); ++f)
+                {
+                    for (auto k = 0U; k < face_size(r, f); ++k)
+                    {
+                        opposite += (face_index(r, f, k) == b && face_index(r, f, (k + 1) % face_size(r, f)) == a) ? 1 : 0;
+                    }
+                }
+
+                c.m_closed = c.m_closed && opposite == 1;
+            }
+
+            edges += size;
+
+            const face_plane_d q = face_plane(r, i);
+
+            //a face narrower than the tolerance has no plane, the moved copy of a sliver rounds into a line at coordinates of 1e4
+            if (q.m_width <= epsilon)
+            {
+                continue;
+            }
+
+            for (auto j = 0U; j < size; ++j)
+            {
+                const float d   = static_cast<float>(fabs(q.distance(r.m_points[face_index(r, i, j)])));
+                c.m_planar      = c.m_planar && d <= epsilon;
+                c.m_max_error   = std::max(c.m_max_error, d);
+            }
+
+            for (auto&& p : r.m_points)
+            {
+                const float d   = static_cast<float>(q.distance(p));
+                c.m_convex      = c.m_convex && d <= epsilon;
+                c.m_max_error   = std::max(c.m_max_error, d);
+            }
+
+            c.m_outward = c.m_outward && q.distance(center) <= epsilon;
+        }
+
+        c.m_euler = point_count(r) + face_count(r) == edges / 2 + 2;
+        return c;
+    }
+
+    //every plane through three points with all points behind it supports the hull, the points on these planes are the hull points
+    inline std::vector<float3> brute_force_hull_points(const std::vector<float3>& points, float epsilon)
+    {
+        std::vector<bool> on_hull(points.size(), false);
+
+        for (auto i = 0U; i < points.size(); ++i)
+        {
+            for (auto j = i + 1; j < points.size(); ++j)
+            {
+                for (auto k = j + 1; k < points.size(); ++k)
+                {
+                    const float3 n = cross(points[j] - points[i], points[k] - points[i]);
+
+                    if (dot(n, n) < epsilon * epsilon * epsilon * epsilon)
+                    {
+                        continue;
+                    }
+
+                    const float3 nn     = normalize(n);
+                    const float  d      = -dot(nn, points[i]);
+                    uint32_t     front  = 0;
+                    uint32_t     back   = 0;
+
+                    for (auto&& p : points)
+                    {
+                        const float t = dot(nn, p) + d;
+                        front += t > epsilon ? 1 : 0;
+                        back  += t < -epsilon ? 1 : 0;
+                    }
+
+                    if (front == 0 || back == 0)
+                    {
+                        for (auto q = 0U; q < points.size(); ++q)
+                        {
+                            on_hull[q] = on_hull[q] || fabsf(dot(nn, points[q]) + d) <= epsilon;
+                        }
+                    }
+                }
+            }
+        }
+
+        std::vector<float3> r;
+
+        for (auto i = 0U; i < points.size(); ++i)
+        {
+            if (on_hull[i])
+            {
+                r.push_back(points[i]);
+            }
+        }
+
+        return r;
+    }
+
+    //the hull of the points: a closed convex polyhedron that contains them, with vertices among the brute force hull points
+    inline bool check_hull(const fixed_convex_polyhedron& r, const std::vector<float3>& points, float epsilon)
+    {
+        if (!check_polyhedron(r, epsilon).ok())
+        {
+            return false;
+        }
+
+        for (auto&& p : points)
+        {
+            if (outside_distance(r, p, epsilon) > epsilon)
+            {
+                return false;
+            }
+        }
+
+        const std::vector<float3> reference = brute_force_hull_points(points, epsilon);
+
+        for (auto&& p : r.m_points)
+        {
+            if (std::none_of(reference.begin(), reference.end(), [&p](const float3& q) { return p == q; }))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    //the counts of every group of a fuzzer, the fuzzers derive their statistics from it and print their own
+    struct check_statistics
+    {
+        const char* m_name          = "";
+        uint32_t    m_cases         = 0;
+        uint32_t    m_failures      = 0;
+    };
+
+    //the groups of a fuzzer, a deque, so the references of the groups stay valid while new ones are added
+    template <typename statistics>
+    class check_groups
+    {
+    public:
+
+        statistics& add(const char* name)
+        {
+            m_groups.push_back(statistics());
+            m_groups.back().m_name = name;
+            return m_groups.back();
+        }
+
+        //prints the groups, 0 if none failed, 1 otherwise
+        int report(void (*print)(const statistics&)) const
+        {
+            uint32_t failures = 0;
+
+            for (auto&& s : m_groups)
+            {
+                print(s);
+                failures += s.m_failures;
+            }
+
+            return failures == 0 ? 0 : 1;
+        }
+
+    private:
+
+        std::deque<statistics> m_groups;
+    };
+}
@@ -0,0 +1,359 @@
+#include "geometry_check.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//randomized inputs for the separating axis tests of oriented boxes and frusta.
+//the oriented box is checked against the clipper in the local space of the box, the batches must agree exactly with the scalar tests.
+using namespace geometry_benchmark;
+
+namespace
+{
+    struct fuzz_statistics : check_statistics
+    {
+        uint32_t    m_outside       = 0;
+        uint32_t    m_inside        = 0;
+        uint32_t    m_culled        = 0;    //outside, but not outside of the world aabb
+    };
+
+    void fail(fuzz_statistics& s, const char* check, const frustum& f)
+    {
+        //print the first failures of a group, with enough digits to reproduce them
+        if (s.m_failures++ < 4)
+        {
+            printf("  %s: %s failed\n    frustum", s.m_name, check);
+
+            for (auto&& p : f.m_points)
+            {
+                printf(" %.9g %.9g %.9g ", p.m_x, p.m_y, p.m_z);
+            }
+
+            printf("\n");
+        }
+    }
+
+    struct rotation
+    {
+        float3 m_axes[3];
+    };
+
+    rotation random_rotation(std::mt19937& g)
+    {
+        std::normal_distribution<float> n(0.0f, 1.0f);
+
+        const float3 a = normalize(float3{ n(g), n(g), n(g) });
+        const float3 b = normalize(cross(a, float3{ n(g), n(g), n(g) }));
+
+        return { { a, b, cross(a, b) } };
+    }
+
+    frustum transform(const frustum& f, const rotation& r, const float3& o)
+    {
+        frustum t;
+
+        for (auto i = 0U; i < 8; ++i)
+        {
+            const float3 p  = f.m_points[i];
+            t.m_points[i]   = r.m_axes[0] * p.m_x + r.m_axes[1] * p.m_y + r.m_axes[2] * p.m_z + o;
+        }
+
+        return t;
+    }
+
+    //the frustum in the local space of the box, where the box is an aabb around the origin
+    frustum to_local(const frustum& f, const obb& b)
+    {
+        frustum t;
+
+        for (auto i = 0U; i < 8; ++i)
+        {
+            const float3 p  = f.m_points[i] - b.m_center;
+            t.m_points[i]   = { dot(p, b.m_axes[0]), dot(p, b.m_axes[1]), dot(p, b.m_axes[2]) };
+        }
+
+        return t;
+    }
+
+    obb scale(const obb& b, float s)
+    {
+        obb r       = b;
+        r.m_extents = b.m_extents * s;
+        return r;
+    }
+
+    aabb local_aabb(const obb& b)
+    {
+        return { float3{ 0.0f, 0.0f, 0.0f } - b.m_extents, b.m_extents };
+    }
+
+    //the box corners in the point order of a frustum
+    frustum make_frustum(const obb& b)
+    {
+        const auto  points = make_points(local_aabb(b));
+        frustum     r;
+
+        for (auto i = 0U; i < 8; ++i)
+        {
+            const float3 p  = points[i];
+            r.m_points[i]   = b.m_axes[0] * p.m_x + b.m_axes[1] * p.m_y + b.m_axes[2] * p.m_z + b.m_center;
+        }
+
+        return r;
+    }
+
+    aabb world_aabb(const obb& b)
+    {
+        float3 e = { 0.0f, 0.0f, 0.0f };
+
+        for (auto i = 0U; i < 3; ++i)
+        {
+            const float3 u = b.m_axes[i];
+            const float  s = i == 0 ? b.m_extents.m_x : (i == 1 ? b.m_extents.m_y : b.m_extents.m_z);
+
+            e = e + float3{ fabsf(u.m_x), fabsf(u.m_y), fabsf(u.m_z) } * s;
+        }
+
+        return { b.m_center - e, b.m_center + e };
+    }
+
+    //frustum scaled around its center, to keep the checks away from touching configurations
+    frustum scale(const frustum& f, float s)
+    {
+        float3 c = { 0.0f, 0.0f, 0.0f };
+
+        for (auto&& p : f.m_points)
+        {
+            c = c + p;
+        }
+
+        c = c / 8.0f;
+
+        frustum r;
+
+        for (auto i = 0U; i < 8; ++i)
+        {
+            r.m_points[i] = c + (f.m_points[i] - c) * s;
+        }
+
+        return r;
+    }
+
+    bool overlaps(const frustum& f, const obb& b)
+    {
+        fixed_convex_polyhedron r;
+        return clip(to_local(f, b), local_aabb(b), r);
+    }
+
+    //corners of the box against the frustum planes
+    float outside_distance(const frustum& f, const obb& b)
+    {
+        const auto  planes  = make_face_planes(f);
+        const auto  corners = make_frustum(b);
+        float       r       = -INFINITY;
+
+        for (auto&& p : corners.m_points)
+        {
+            r = std::max(r, geometry_benchmark::outside_distance(planes, p));
+        }
+
+        return r;
+    }
+
+    const float tolerance = 1e-3f;
+
+    void check_obb(fuzz_statistics& s, const frustum& f, const obb& b)
+    {
+        const frustum_separating_axes       axes    = make_separating_axes(f);
+        const frustum_aabb_classification   c       = classify(axes, b);
+        const float                         size    = std::max(std::max(b.m_extents.m_x, b.m_extents.m_y), b.m_extents.m_z);
+
+        s.m_cases++;
+        s.m_outside += c == frustum_aabb_classification::outside ? 1 : 0;
+        s.m_inside  += c == frustum_aabb_classification::inside ? 1 : 0;
+        s.m_culled  += c == frustum_aabb_classification::outside && classify(axes, world_aabb(b)) != frustum_aabb_classification::outside ? 1 : 0;
+
+        //the clipper decides, unless the box only touches the frustum
+        if (c == frustum_aabb_classification::outside && overlaps(f, scale(b, 1.0f - tolerance)))
+        {
+            fail(s, "outside of an overlapping box", f);
+        }
+
+        if (c != frustum_aabb_classification::outside && !overlaps(f, scale(b, 1.0f + tolerance)))
+        {
+            fail(s, "overlap of a separated box", f);
+        }
+
+        const float d = outside_distance(f, b);
+
+        if (c == frustum_aabb_classification::inside && d > tolerance * size)
+        {
+            fail(s, "inside with a corner outside", f);
+        }
+
+        if (c != frustum_aabb_classification::inside && d < -tolerance * size)
+        {
+            fail(s, "corners inside, not inside", f);
+        }
+
+        //a box shaped frustum is separated on the same axes
+        const frustum_aabb_classification q = classify(axes, make_frustum(b));
+
+        if (q == frustum_aabb_classification::outside && overlaps(f, scale(b, 1.0f - tolerance)))
+        {
+            fail(s, "frustum pair outside of an overlapping box", f);
+        }
+
+        if (q != frustum_aabb_classification::outside && !overlaps(f, scale(b, 1.0f + tolerance)))
+        {
+            fail(s, "frustum pair overlap of a separated box", f);
+        }
+
+        if (q == frustum_aabb_classification::inside && d > tolerance * size)
+        {
+            fail(s, "frustum pair inside with a corner outside", f);
+        }
+    }
+
+    //separation is symmetric, when it is not decided by rounding
+    void check_frustum_pair(fuzz_statistics& s, const frustum& a, const frustum& b)
+    {
+        const auto outside = [](const frustum& x, const frustum& y)
+        {
+            return classify(make_separating_axes(x), y) == frustum_aabb_classification::outside;
+        };
+
+        const bool ab = outside(a, b);
+
+        s.m_cases++;
+        s.m_outside += ab ? 1 : 0;
+        s.m_inside  += classify(make_separating_axes(a), b) == frustum_aabb_classification::inside ? 1 : 0;
+
+        if (ab != outside(b, a) && outside(a, scale(b, 1.0f + tolerance)) == outside(a, scale(b, 1.0f - tolerance)))
+        {
+            fail(s, "symmetry", b);
+        }
+
+        //a frustum inside of a grown copy of itself
+        if (classify(make_separating_axes(scale(a, 1.0f + tolerance)), a) != frustum_aabb_classification::inside)
+        {
+            fail(s, "inside of a grown copy", a);
+        }
+    }
+
+    //the batches and the scalar tests give the same classes, also for the boxes of the scalar tail
+    template <typename t>
+    void check_batch(fuzz_statistics& s, const frustum& f, const std::vector<t>& items)
+    {
+        const frustum_separating_axes               axes = make_separating_axes(f);
+        std::vector<frustum_aabb_classification>    batch(items.size());
+
+        classify(axes, items.data(), static_cast<uint32_t>(items.size()), batch.data());
+
+        for (auto i = 0U; i < items.size(); ++i)
+        {
+            s.m_cases++;
+
+            if (batch[i] != classify(axes, items[i]))
+            {
+                fail(s, "batch", f);
+            }
+        }
+    }
+
+    void print(const fuzz_statistics& s)
+    {
+        printf("%-28s cases %6u  outside %6u  inside %6u  culled beyond the world aabb %6u  failures %4u\n", s.m_name, s.m_cases, s.m_outside, s.m_inside, s.m_culled, s.m_failures);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t cases = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 20000;
+
+    std::mt19937                            g(3);
+    std::uniform_real_distribution<float>   u(0.0f, 1.0f);
+    std::uniform_real_distribution<float>   t(-10.0f, 10.0f);
+    check_groups<fuzz_statistics>           groups;
+
+    auto random_frustum = [&]()
+    {
+        const float n   = 0.05f + 2.0f * u(g);
+        const float far = n + 5.0f + 100.0f * u(g) * u(g);
+
+        return transform(make_frustum(n, far, 0.1f + 2.0f * u(g), 0.1f + 2.0f * u(g)), random_rotation(g), { t(g), t(g), t(g) });
+    };
+
+    //a box around a random point of the frustum bounds, from small to larger than the frustum
+    auto random_obb = [&](const frustum& f)
+    {
+        const aabb      bounds  = make_aabb(f);
+        const float3    e       = bounds.m_max - bounds.m_min;
+        const float     size    = distance(bounds.m_min, bounds.m_max) * powf(10.0f, -2.5f * u(g));
+        const rotation  r       = random_rotation(g);
+
+        obb b;
+
+        b.m_center  = bounds.m_min + float3{ u(g) * e.m_x, u(g) * e.m_y, u(g) * e.m_z };
+        b.m_axes[0] = r.m_axes[0];
+        b.m_axes[1] = r.m_axes[1];
+        b.m_axes[2] = r.m_axes[2];
+        b.m_extents = float3{ u(g), u(g), u(g) } * size + float3{ 1e-3f, 1e-3f, 1e-3f };
+        return b;
+    };
+
+    {
+        auto& s = groups.add("oriented boxes");
+
+        for (auto i = 0U; i < cases; ++i)
+        {
+            const frustum f = random_frustum();
+            check_obb(s, f, random_obb(f));
+        }
+    }
+
+    //box shaped frusta, the face axes and the edge axes are parallel pairs
+    {
+        auto& s = groups.add("oriented boxes, orthographic");
+
+        for (auto i = 0U; i < cases / 10; ++i)
+        {
+            const float3    c = { t(g), t(g), t(g) };
+            const frustum   f = make_orthographic_frustum({ c, c + float3{ 1.0f + 20.0f * u(g), 1.0f + 20.0f * u(g), 1.0f + 20.0f * u(g) } });
+
+            check_obb(s, f, random_obb(f));
+        }
+    }
+
+    {
+        auto& s = groups.add("frustum pairs");
+
+        for (auto i = 0U; i < cases; ++i)
+        {
+            const frustum a = random_frustum();
+            check_frustum_pair(s, a, random_frustum());
+        }
+    }
+
+    {
+        auto& s = groups.add("batches");
+
+        for (auto i = 0U; i < cases / 100; ++i)
+        {
+            const frustum           f = random_frustum();
+            std::vector<obb>        boxes;
+            std::vector<frustum>    frusta;
+
+            for (auto j = 0U; j < 37; ++j)
+            {
+                boxes.push_back(random_obb(f));
+                frusta.push_back(j % 2 == 0 ? random_frustum() : make_frustum(boxes.back()));
+            }
+
+            check_batch(s, f, boxes);
+            check_batch(s, f, frusta);
+        }
+    }
+
+    return groups.report(print);
+}
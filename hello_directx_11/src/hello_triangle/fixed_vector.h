@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstdint>
+#include <assert.h>
+
+namespace computational_geometry
+{
+    //vector with inline storage and a compile time capacity, it never allocates
+    //overflowing the capacity is a programming error, the asserts are gone in release builds: code, which fills it
+    //from caller input without a bound from the topology, checks full() before every push_back
+    template <typename t, uint32_t capacity>
+    struct fixed_vector
+    {
+        using value_type = t;
+
+        t           m_data[capacity];
+        uint32_t    m_size = 0;
+
+        static constexpr uint32_t max_size()
+        {
+            return capacity;
+        }
+
+        uint32_t size() const
+        {
+            return m_size;
+        }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+        bool full() const
+        {
+            return m_size == capacity;
+        }
+
+        void clear()
+        {
+            m_size = 0;
+        }
+
+        void resize(uint32_t size)
+        {
+            assert(size <= capacity);
+            for (auto i = m_size; i < size; ++i)
+            {
+                m_data[i] = t();
+            }
+            m_size = size;
+        }
+
+        void push_back(const t& v)
+        {
+            assert(m_size < capacity);
+            m_data[m_size++] = v;
+        }
+
+        void pop_back()
+        {
+            assert(m_size > 0);
+            m_size--;
+        }
+
+        //removes the first occurrence of v, keeps the order of the rest
+        void erase_value(const t& v)
+        {
+            for (auto i = 0U; i < m_size; ++i)
+            {
+                if (m_data[i] == v)
+                {
+                    for (auto j = i + 1; j < m_size; ++j)
+                    {
+                        m_data[j - 1] = m_data[j];
+                    }
+
+                    m_size--;
+                    return;
+                }
+            }
+        }
+
+        t& operator[](uint32_t i)
+        {
+            assert(i < m_size);
+            return m_data[i];
+        }
+
+        const t& operator[](uint32_t i) const
+        {
+            assert(i < m_size);
+            return m_data[i];
+        }
+
+        t& back()
+        {
+            assert(m_size > 0);
+            return m_data[m_size - 1];
+        }
+
+        const t& back() const
+        {
+            assert(m_size > 0);
+            return m_data[m_size - 1];
+        }
+
+        t* begin()
+        {
+            return &m_data[0];
+        }
+
+        t* end()
+        {
+            return &m_data[0] + m_size;
+        }
+
+        const t* begin() const
+        {
+            return &m_data[0];
+        }
+
+        const t* end() const
+        {
+            return &m_data[0] + m_size;
+        }
+    };
+}
@@ -4,31 +4,24 @@
 #include <array>
 #include <vector>
 #include <optional>
-#include <unordered_map>
-
-namespace std
-{
-    template <>
-    struct hash< std::tuple<int32_t, int32_t> >
-    {
-        size_t operator()(const std::tuple<int32_t, int32_t> & l) const
-        {
-            // Compute individual hash values for first, second and third
-            // http://stackoverflow.com/a/1646913/126995
-            size_t res = 17;
-            res = res * 31 + hash<int32_t>()(std::get<0>(l));
-            res = res * 31 + hash<int32_t>()(std::get<1>(l));
-            return res;
-        }
-    };
-}
+#include <tuple>
 
 namespace computational_geometry
 {
     //david eberly convex clipper implementation
 
+    //all storage is inline and the clipper is reused per thread, so clipping does not touch the heap.
+    //vertices and edges are never removed, only marked invisible, so their arrays grow with every clip plane.
+    //a clip plane adds at most one vertex per crossed edge and one edge per crossed face.
+    //the frustum and box clips stay within the storage, a caller polyhedron may not: every push checks the capacity.
+    //a clip, which does not fit, fails in the allocation free variants and is redone plane by plane on the heap in the others
     struct closed_convex_clipper
     {
+        static constexpr uint32_t max_vertices      = 256;
+        static constexpr uint32_t max_edges         = 256;
+        static constexpr uint32_t max_faces         = 64;
+        static constexpr uint32_t max_face_edges    = 32;
+
         //todo: split these structures per usage
         struct vertex_attributes
         {
@@ -39,22 +32,34 @@ namespace computational_geometry
 
         struct edge
         {
-            std::vector<int32_t  >  m_faces;
-            std::array<int32_t, 2>  m_vertices = { -1, -1 };
-            bool                    m_visible   = true;
+            fixed_vector<int32_t, 2>    m_faces;
+            std::array<int32_t, 2>      m_vertices = { -1, -1 };
+            bool                        m_visible   = true;
         };
 
         struct face
         {
-            std::vector<int32_t>    m_edges;
-            bool    m_visible       = true;
-            plane                   m_plane;
+            fixed_vector<int32_t, max_face_edges>   m_edges;
+            bool                                    m_visible       = true;
+            plane                                   m_plane;
         };
 
-        std::vector<float3>                     m_vertices_points;
-        std::vector<vertex_attributes>          m_vertices;
-        std::vector<edge>                       m_edges;
-        std::vector<face>                       m_faces;
+        using ordered_vertices = fixed_vector<int32_t, max_face_edges + 1>;
+
+        fixed_vector<float3, max_vertices>              m_vertices_points;
+        fixed_vector<vertex_attributes, max_vertices>   m_vertices;
+        fixed_vector<edge, max_edges>                   m_edges;
+        fixed_vector<face, max_faces>                   m_faces;
+        bool                                            m_overflow = false;
+
+        void reset()
+        {
+            m_vertices_points.clear();
+            m_vertices.clear();
+            m_edges.clear();
+            m_faces.clear();
+            m_overflow = false;
+        }
 
         std::tuple<int32_t, int32_t> process_vertices(const plane& p)
         {
@@ -68,7 +73,9 @@ namespace computational_geometry
                 auto& v         = m_vertices[i];
                 auto& v_point   = m_vertices_points[i];
 
-                const float epsilon = 0.00001f;
+                //the rounding of the distance grows with the coordinates, the vertices of a far plane at 1e6 are off by 0.1
+                const float magnitude   = std::max(std::max(fabsf(v_point.m_x), fabsf(v_point.m_y)), fabsf(v_point.m_z));
+                const float epsilon     = 0.00001f * std::max(1.0f, magnitude);
 
                 if (v.m_visible)
                 {
@@ -117,10 +124,7 @@ namespace computational_geometry
                         {
                             auto&& f = m_faces[fi];
 
-                            f.m_edges.erase(std::remove_if(f.m_edges.begin(), f.m_edges.end(), [i](int32_t e0)
-                            {
-                                return i == e0;
-                            }));
+                            f.m_edges.erase_value(static_cast<int32_t>(i));
 
                             if (f.m_edges.empty())
                             {
@@ -148,6 +152,12 @@ namespace computational_geometry
                     float t = d0 / (d0 - d1);
                     float3 point = (1.0f - t) * v0_point + t * v1_point;
 
+                    if (m_vertices.full())
+                    {
+                        m_overflow = true;
+                        return;
+                    }
+
                     m_vertices_points.push_back(point);
                     m_vertices.push_back({});
 
@@ -215,6 +225,13 @@ namespace computational_geometry
         {
             face close_face;
             close_face.m_plane = clip_plane;
+
+            if (m_faces.full())
+            {
+                m_overflow = true;
+                return;
+            }
+
             m_faces.push_back(close_face);
 
             auto faces_to_process       = static_cast<uint32_t>(m_faces.size());
@@ -246,9 +263,16 @@ namespace computational_geometry
                     //polygon line is open, close it
                     if (is_open)
                     {
+                        if (m_edges.full() || f.m_edges.full() || m_faces[close_face_index].m_edges.full())
+                        {
+                            m_overflow = true;
+                            return;
+                        }
+
                         edge e;
 
                         e.m_faces.push_back(i);
+                        e.m_faces.push_back(close_face_index);
                         e.m_vertices[0] = start;
                         e.m_vertices[1] = end;
                         m_edges.push_back(e);
@@ -256,42 +280,44 @@ namespace computational_geometry
                         auto index = static_cast<int32_t>(m_edges.size() - 1);
 
                         f.m_edges.push_back(index);
-
-                        m_edges[index].m_faces.push_back(close_face_index);
                         m_faces[close_face_index].m_edges.push_back(index);
                     }
                 }
             }
         }
 
-        float3 get_normal(const std::vector<int32_t>& vi)
+        float3 get_normal(const ordered_vertices& vi)
         {
             float3 normal;
             auto   vi_to_process = vi.size();
 
+            //relative to the first vertex, the cross products of coordinates cancel for small faces away from the origin
+            const float3 o = m_vertices_points[vi[0]];
+
+            //the polyline is closed, the first and the last vertices are the same
             for (auto i = 0U; i < vi_to_process-1; ++i)
             {
-                normal = normal + cross(m_vertices_points[i], m_vertices_points[i + 1]);
+                normal = normal + cross(m_vertices_points[vi[i]] - o, m_vertices_points[vi[i + 1]] - o);
             }
 
             return normalize(normal);
         }
 
-        std::vector<int32_t> get_ordered_vertices(int32_t fi)
+        void get_ordered_vertices(int32_t fi, ordered_vertices& r)
         {
             //copy edge indices into fixed continuous memory for sorting
-            std::vector<int32_t> edges = m_faces[fi].m_edges;
+            fixed_vector<int32_t, max_face_edges> edges = m_faces[fi].m_edges;
 
             //bubble sort to arrange edge in continuous order
             int32_t i0 = 0;
             int32_t i1 = 1;
             int32_t choice = 1;
 
-            for ( i0 = 0, i1 = 1, choice = 1; i1 < edges.size() - 1; ) 
+            for ( i0 = 0, i1 = 1, choice = 1; i1 < static_cast<int32_t>(edges.size()) - 1; )
             {
                 int32_t current = m_edges[ edges[i0] ].m_vertices[choice];
 
-                for (auto j = i1; j < edges.size(); ++j)
+                for (auto j = i1; j < static_cast<int32_t>(edges.size()); ++j)
                 {
                     if (m_edges[edges[j]].m_vertices[0] == current)
                     {
@@ -312,7 +338,6 @@ namespace computational_geometry
                 i1 = i1 + 1;
             }
 
-            std::vector<int32_t> r;
             r.resize(edges.size() + 1);
 
             //add the first two vertices
@@ -331,53 +356,6 @@ namespace computational_geometry
                     r[i + 1] = m_edges[ edges[i] ].m_vertices[0];
                 }
             }
-
-            return r;
-        }
-
-        std::vector<int32_t> get_ordered_faces()
-        {
-            std::vector<int32_t> r;
-            auto faces_to_process = m_faces.size();
-
-            for (auto i = 0U; i < faces_to_process; ++i)
-            {
-                const auto& f = m_faces[i];
-                if (f.m_visible)
-                {
-
-                    //get the ordered vertices for a face. the first and the last
-                    //element of the array are the same since the poly line is closed
-                    auto vertices = get_ordered_vertices(i);
-
-                    //push back the size of the elements
-                    r.push_back(static_cast<int32_t>(vertices.size() - 1));
-
-                    //the convention is that the vertices should be counterclockwise
-                    //ordered when viewed from the negative side of the plane of the face.
-                    //if you need the opposite convention, switch the inequality
-                    //in the if else statement
-
-                    if (dot(m_faces[i].m_plane.m_n, get_normal(vertices)) > 0.0f)
-                    {
-                        //counterclockwise
-                        for (int32_t j = static_cast<int32_t>(vertices.size()) - 2; j >= 0; j--)
-                        {
-                            r.push_back(vertices[j]);
-                        }
-                    }
-                    else
-                    {
-                        //clockwise
-                        for (auto j = 0; j <= vertices.size() - 2; j++)
-                        {
-                            r.push_back(vertices[j]);
-                        }
-                    }
-                }
-            }
-
-            return r;
         }
 
         int32_t     clip(const plane& clipPlane)
@@ -403,75 +381,111 @@ namespace computational_geometry
             process_edges();
 
             //faces processing
-            process_faces(clipPlane);
+            if (!m_overflow)
+            {
+                process_faces(clipPlane);
+            }
 
             return 0;
         }
 
-        std::tuple< std::vector<float3>, std::vector<int32_t> > convert()
+        //false, if the polyhedron does not fit the output
+        bool convert(fixed_convex_polyhedron& r)
         {
-            std::vector<float3>     point;
-            std::vector<int32_t>    vmap(m_vertices.size(), -1);
+            fixed_vector<int32_t, max_vertices> vmap;
+
+            r.m_points.clear();
+            r.m_faces.clear();
+            r.m_indices.clear();
 
             //copy the visible attributes into the table
             for (auto i = 0U; i < m_vertices.size(); ++i)
             {
                 if (m_vertices[i].m_visible)
                 {
-                    vmap[i] = static_cast<int32_t>( point.size() );
-                    point.push_back(m_vertices_points[i]);
+                    if (r.m_points.full())
+                    {
+                        return false;
+                    }
+
+                    vmap.push_back(static_cast<int32_t>(r.m_points.size()));
+                    r.m_points.push_back(m_vertices_points[i]);
+                }
+                else
+                {
+                    vmap.push_back(-1);
                 }
             }
 
-            //order the vertices for all the faces. the output array has a
-            //sequence of sub arrays, each sub array having first element sorting
-            //the number of vertices in the face, the remaining elements storing
-            //the vertex indices for that face in the correct order. The indices
-            //are relative to the m_vertices vector
+            //order the vertices for all the faces and map them to the new table
 
-            std::vector<int32_t> faces = get_ordered_faces();
+            ordered_vertices vertices;
 
-            //map the vertex indices to those of the new table
-
-            for (auto i = 0U; i < faces.size() ;)
+            for (auto i = 0U; i < m_faces.size(); ++i)
             {
-                int32_t index_count = faces[i];
-                i = i + 1;
-
-                for (auto j = 0; j < index_count; ++j)
+                const auto& f = m_faces[i];
+                if (f.m_visible)
                 {
-                    faces[i] = vmap[faces[i]];
-                    i++;
+                    //get the ordered vertices for a face. the first and the last
+                    //element of the array are the same since the poly line is closed
+                    get_ordered_vertices(i, vertices);
+
+                    if (r.m_faces.full() || r.m_indices.size() + vertices.size() - 1 > r.m_indices.max_size())
+                    {
+                        return false;
+                    }
+
+                    fixed_convex_polyhedron::polygon polygon;
+                    polygon.m_offset = r.m_indices.size();
+                    polygon.m_size   = vertices.size() - 1;
+                    r.m_faces.push_back(polygon);
+
+                    //the convention is that the vertices should be counterclockwise
+                    //ordered when viewed from the negative side of the plane of the face.
+                    //if you need the opposite convention, switch the inequality
+                    //in the if else statement
+
+                    if (dot(f.m_plane.m_n, get_normal(vertices)) > 0.0f)
+                    {
+                        //counterclockwise
+                        for (int32_t j = static_cast<int32_t>(vertices.size()) - 2; j >= 0; j--)
+                        {
+                            r.m_indices.push_back(vmap[vertices[j]]);
+                        }
+                    }
+                    else
+                    {
+                        //clockwise
+                        for (auto j = 0U; j <= vertices.size() - 2; j++)
+                        {
+                            r.m_indices.push_back(vmap[vertices[j]]);
+                        }
+                    }
                 }
             }
 
-            return make_tuple(std::move(point), std::move(faces));
+            return true;
         }
     };
-   
-    template <typename t>
-    closed_convex_clipper make_clipper(const t& b);
 
-    template <>
-    closed_convex_clipper make_clipper<frustum>(const frustum& b)
+    void make_clipper(const frustum& b, closed_convex_clipper& r)
     {
-        closed_convex_clipper r;
-
-        //todo: b is a frustum or aabb, so topology is known
+        //b is a frustum, so the topology is known
+        const int32_t indices[6][4] =
         {
-            const int32_t indices[6][4] =
-            {
-                {0,3,7,4},
-                {1,5,6,2},
-                {3,2,6,7},
-                {4,5,1,0},
-                {0,1,2,3},
-                {5,4,7,6}
-            };
+            {0,3,7,4},
+            {1,5,6,2},
+            {3,2,6,7},
+            {4,5,1,0},
+            {0,1,2,3},
+            {5,4,7,6}
+        };
 
-            r.m_edges.resize(12);
-            r.m_faces.resize(6);
+        r.reset();
+        r.m_edges.resize(12);
+        r.m_faces.resize(6);
 
+        {
             uint32_t edge = 0;
 
             for (auto i = 0; i < 6; ++i)
@@ -524,9 +538,9 @@ namespace computational_geometry
             }
         }
 
-        for (auto i = 0; i < 12; ++i)
+        for (auto i = 0U; i < 12; ++i)
         {
-            for (auto j = 0; j < r.m_edges[i].m_faces.size(); ++j)
+            for (auto j = 0U; j < r.m_edges[i].m_faces.size(); ++j)
             {
                 r.m_faces[ r.m_edges[i].m_faces[j] ].m_edges.push_back(i);
             }
@@ -545,43 +559,53 @@ namespace computational_geometry
         }
 
         {
-            auto points = make_points(b);
-
-            for (auto i = 0U; i < points.size(); ++i)
+            for (auto i = 0U; i < 8; ++i)
             {
-                r.m_vertices_points.push_back(points[i]);
+                r.m_vertices_points.push_back(b.m_points[i]);
                 r.m_vertices.push_back({});
             }
         }
-
-        return r;
     }
 
-    template <>
-    closed_convex_clipper make_clipper(const convex_polyhedron& b)
+    //sets m_overflow, if the polyhedron does not fit the storage of the clipper
+    template <typename polyhedron>
+    void make_clipper(const polyhedron& b, closed_convex_clipper& r)
     {
-        closed_convex_clipper r;
+        r.reset();
 
-        //build edges
-        {
-            const auto edge_count = b.m_points.size() + b.m_faces.size() - 2;
+        const uint32_t faces = face_count(b);
 
-            std::unordered_map< std::tuple<int32_t, int32_t>, int32_t > edges;
+        if (faces > closed_convex_clipper::max_faces || point_count(b) > closed_convex_clipper::max_vertices)
+        {
+            r.m_overflow = true;
+            return;
+        }
 
-            for (auto i = 0; i < b.m_faces.size(); ++i)
+        //build edges, the polyhedron is small, a linear search is faster than hashing
+        {
+            for (auto i = 0U; i < faces; ++i)
             {
-                const auto& f = b.m_faces[i];
-                const auto indices_size = f.m_indices.size();
+                const auto indices_size = face_size(b, i);
 
                 for (auto p = 0U; p < indices_size; ++p)
                 {
-                    const   int32_t computed_index_0 = f.m_indices[p];
-                    const   int32_t computed_index_1 = f.m_indices[(p + 1) % indices_size];
+                    const   int32_t computed_index_0 = face_index(b, i, p);
+                    const   int32_t computed_index_1 = face_index(b, i, (p + 1) % indices_size);
                     const   int32_t index_0 = std::min(computed_index_0, computed_index_1);
                     const   int32_t index_1 = std::max(computed_index_0, computed_index_1);
 
-                    auto&&  it = edges.find(std::make_tuple(index_0, index_1));
-                    if (it == edges.end())
+                    auto it = std::find_if(r.m_edges.begin(), r.m_edges.end(), [index_0, index_1](const closed_convex_clipper::edge& e)
+                    {
+                        return e.m_vertices[0] == index_0 && e.m_vertices[1] == index_1;
+                    });
+
+                    if (it == r.m_edges.end() ? r.m_edges.full() : it->m_faces.full())
+                    {
+                        r.m_overflow = true;
+                        return;
+                    }
+
+                    if (it == r.m_edges.end())
                     {
                         closed_convex_clipper::edge e;
 
@@ -590,13 +614,11 @@ namespace computational_geometry
                         e.m_faces.push_back(i);
 
                         //new edge
-                        r.m_edges.push_back(std::move(e));
-
-                        edges.insert(std::make_pair(std::make_tuple(index_0, index_1), static_cast<int32_t>(r.m_edges.size()) - 1));
+                        r.m_edges.push_back(e);
                     }
                     else
                     {
-                        r.m_edges[it->second].m_faces.push_back(i);
+                        it->m_faces.push_back(i);
                     }
                 }
             }
@@ -604,22 +626,32 @@ namespace computational_geometry
 
         //build faces
         {
-            r.m_faces.resize(b.m_faces.size());
-            for (auto i = 0; i < r.m_edges.size(); ++i)
+            r.m_faces.resize(faces);
+            for (auto i = 0U; i < r.m_edges.size(); ++i)
             {
-                for (auto j = 0; j < r.m_edges[i].m_faces.size(); ++j)
+                for (auto j = 0U; j < r.m_edges[i].m_faces.size(); ++j)
                 {
-                    r.m_faces[r.m_edges[i].m_faces[j]].m_edges.push_back(i);
+                    auto& f = r.m_faces[r.m_edges[i].m_faces[j]];
+
+                    if (f.m_edges.full())
+                    {
+                        r.m_overflow = true;
+                        return;
+                    }
+
+                    f.m_edges.push_back(i);
                 }
             }
         }
 
         //build points
         {
-            r.m_vertices_points.resize(b.m_points.size());
-            r.m_vertices.resize(b.m_points.size());
+            const uint32_t points = point_count(b);
+
+            r.m_vertices_points.resize(points);
+            r.m_vertices.resize(points);
 
-            for (auto i = 0; i < b.m_points.size();++i)
+            for (auto i = 0U; i < points; ++i)
             {
                 r.m_vertices_points[i] = b.m_points[i];
             }
@@ -637,7 +669,7 @@ namespace computational_geometry
                 const float3 b          = r.m_vertices_points[ e0.m_vertices[1] ];
                 const auto   index      = e0.m_vertices[0] == e1.m_vertices[0] ? 1 : 0;
                 const float3 c          = r.m_vertices_points[e1.m_vertices[index]];
-                
+
                 r.m_faces[i].m_plane    = make_plane(a, b, c);
             }
 
@@ -656,289 +688,1390 @@ namespace computational_geometry
                 }
             }
         }
-
-        return r;
     }
 
-    std::optional<convex_polyhedron> clip(const frustum& f, const aabb& b)
+    namespace
     {
-        auto clipper    = make_clipper(f);
-        auto planes     = make_face_planes(b);
+        //the frustum and the box share the point order of make_points, faces are counterclockwise when viewed from outside
+        const uint32_t box_faces[6][4] =
+        {
+            {4,7,3,0},
+            {2,6,5,1},
+            {7,6,2,3},
+            {0,1,5,4},
+            {3,2,1,0},
+            {6,7,4,5}
+        };
 
-        for (auto i = 0; i < planes.size(); ++i)
+        closed_convex_clipper& thread_clipper()
         {
-            if (clipper.clip(planes[i]) == -1)
-            {
-                return {};
-            }
+            //~20kb of state, keep it out of the stack and reuse it between the calls
+            static thread_local closed_convex_clipper clipper;
+            return clipper;
         }
 
-        convex_polyhedron r;
+        enum class clip_status
+        {
+            empty,
+            clipped,
+            overflow    //the clip does not fit the fixed storage of the clipper
+        };
 
+        template <typename polyhedron>
+        clip_status clip_polyhedron(const polyhedron& f, const std::array<plane, 6>& planes, fixed_convex_polyhedron& r)
         {
-            auto r0 = clipper.convert();
-            r.m_points = std::move(std::get<0>(r0));
-            const auto& faces = std::get<1>(r0);
+            auto& clipper   = thread_clipper();
 
-            for (auto i = 0; i < faces.size(); )
+            make_clipper(f, clipper);
+
+            if (clipper.m_overflow)
             {
-                auto face_count = faces[i]; 
-                i++;
+                return clip_status::overflow;
+            }
 
-                convex_polyhedron::polygon polygon;
-                for (auto j = 0; j < face_count; ++j)
+            for (auto i = 0U; i < planes.size(); ++i)
+            {
+                if (clipper.clip(planes[i]) == -1)
                 {
-                    polygon.m_indices.push_back( faces[i] );
-                    i++;
+                    return clip_status::empty;
                 }
 
-                r.m_faces.push_back(std::move(polygon));
+                if (clipper.m_overflow)
+                {
+                    return clip_status::overflow;
+                }
             }
-        }
 
-        return r;
-    }
+            return clipper.convert(r) ? clip_status::clipped : clip_status::overflow;
+        }
 
-    std::optional< convex_polyhedron > clip(const convex_polyhedron& f, const aabb& b)
-    {
-        auto clipper = make_clipper(f);
-        auto planes = make_face_planes(b);
+        template <typename polyhedron>
+        clip_status clip_polyhedron(const polyhedron& f, const aabb& b, fixed_convex_polyhedron& r)
+        {
+            return clip_polyhedron(f, make_face_planes(b), r);
+        }
 
-        for (auto i = 0; i < planes.size(); ++i)
+        convex_polyhedron make_convex_polyhedron(const float3* points)
         {
-            if (clipper.clip(planes[i]) == -1)
+            convex_polyhedron r;
+
+            r.m_points.assign(points, points + 8);
+            r.m_faces.resize(6);
+
+            for (auto i = 0U; i < 6; ++i)
             {
-                return {};
+                r.m_faces[i].m_indices.assign(box_faces[i], box_faces[i] + 4);
             }
-        }
 
-        convex_polyhedron r;
+            return r;
+        }
 
+        //clips with one plane on the heap, for polyhedra beyond the fixed storage of the clipper.
+        //the faces keep their winding, the cap is counterclockwise when viewed from outside. returns false if everything is clipped
+        bool clip_heap(convex_polyhedron& p, const plane& q)
         {
-            auto r0 = clipper.convert();
-            r.m_points = std::move(std::get<0>(r0));
-            const auto& faces = std::get<1>(r0);
+            const uint32_t points   = static_cast<uint32_t>(p.m_points.size());
+            uint32_t       positive = 0;
+            uint32_t       negative = 0;
 
-            for (auto i = 0; i < faces.size(); )
+            std::vector<float> distances(points);
+
+            for (auto i = 0U; i < points; ++i)
             {
-                auto face_count = faces[i];
-                i++;
+                const float3& v         = p.m_points[i];
+                const float magnitude   = std::max(std::max(fabsf(v.m_x), fabsf(v.m_y)), fabsf(v.m_z));
+                const float epsilon     = 0.00001f * std::max(1.0f, magnitude);
+                const float d           = dot(q.m_n, v) + q.m_d;
 
-                convex_polyhedron::polygon polygon;
-                for (auto j = 0; j < face_count; ++j)
+                if (d >= epsilon)
+                {
+                    positive++;
+                    distances[i] = d;
+                }
+                else if (d <= -epsilon)
                 {
-                    polygon.m_indices.push_back(faces[i]);
-                    i++;
+                    negative++;
+                    distances[i] = d;
                 }
+            }
 
-                r.m_faces.push_back(std::move(polygon));
+            if (positive == 0)
+            {
+                return false;
             }
-        }
 
-        return r;
-    }
+            if (negative == 0)
+            {
+                return true;
+            }
 
-    convex_polyhedron convex_hull_with_direction(const convex_polyhedron& body, const float3& vector)
-    {
-        convex_polyhedron r = body;
+            convex_polyhedron       r;
+            std::vector<uint32_t>   remap(points, UINT32_MAX);
+            std::vector<uint32_t>   cap;
 
-        std::vector<plane> planes;
-        planes.resize(body.m_faces.size());
+            for (auto i = 0U; i < points; ++i)
+            {
+                if (distances[i] >= 0.0f)
+                {
+                    remap[i] = static_cast<uint32_t>(r.m_points.size());
+                    r.m_points.push_back(p.m_points[i]);
 
-        //compute planes
-        for (auto i = 0U; i < planes.size(); ++i)
-        {
-            const float3 a  = body.m_points[body.m_faces[i].m_indices[0]];
-            const float3 b  = body.m_points[body.m_faces[i].m_indices[1]];
-            const float3 c  = body.m_points[body.m_faces[i].m_indices[2]];
-            planes[i]       = make_plane(a, b, c);
-        }
+                    if (distances[i] == 0.0f)
+                    {
+                        cap.push_back(remap[i]);
+                    }
+                }
+            }
 
-        //orient normals to point inside
-        for (auto i = 0U; i < planes.size(); ++i)
-        {
-            auto plane = planes[i];
+            //the new point of an edge is shared by its two faces
+            std::vector<std::tuple<uint32_t, uint32_t, uint32_t>> splits;
 
-            for (auto&& v : body.m_points)
+            auto split = [&](uint32_t a, uint32_t b)
             {
-                if ( dot(plane.m_n, v) + plane.m_d > 0.00001f)
+                const uint32_t v0 = std::min(a, b);
+                const uint32_t v1 = std::max(a, b);
+
+                for (auto&& s : splits)
                 {
-                    planes[i].m_n = -1.0f * plane.m_n;
-                    break;
+                    if (std::get<0>(s) == v0 && std::get<1>(s) == v1)
+                    {
+                        return std::get<2>(s);
+                    }
                 }
-            }
-        }
 
-        std::vector<bool> face_vector;
-        face_vector.resize(planes.size());
-
-        for ( auto i = 0U; i < face_vector.size(); ++i)
-        {
-            face_vector[i] = dot( planes[i].m_n, vector ) > 0.0f;
-        }
+                const float    t = distances[v0] / (distances[v0] - distances[v1]);
+                const uint32_t i = static_cast<uint32_t>(r.m_points.size());
 
-        //1. duplicate points and indices
-        std::vector<int32_t> points_indices(body.m_points.size(), -1);
+                r.m_points.push_back(p.m_points[v0] + t * (p.m_points[v1] - p.m_points[v0]));
+                cap.push_back(i);
+                splits.push_back(std::make_tuple(v0, v1, i));
+                return i;
+            };
 
-        for (auto i = 0U; i < face_vector.size(); ++i)
-        {
-            if (face_vector[i])
+            for (auto&& f : p.m_faces)
             {
-                const auto& face = body.m_faces[i];
-                for (auto p = 0; p < face.m_indices.size(); ++p)
+                convex_polyhedron::polygon g;
+
+                const auto& indices = f.m_indices;
+
+                for (auto i = 0U; i < indices.size(); ++i)
                 {
-                    //split vertex
-                    if ( points_indices[face.m_indices[p]] == -1 )
+                    const uint32_t a = indices[i];
+                    const uint32_t b = indices[(i + 1) % indices.size()];
+
+                    if (distances[a] >= 0.0f)
+                    {
+                        g.m_indices.push_back(remap[a]);
+                    }
+
+                    if ((distances[a] > 0.0f && distances[b] < 0.0f) || (distances[a] < 0.0f && distances[b] > 0.0f))
                     {
-                        float3 v = r.m_points[ face.m_indices[p] ];
-                        r.m_points.push_back(v);
-                        int32_t index = static_cast<int32_t>( r.m_points.size() ) - 1;
-                        points_indices[face.m_indices[p]] = index;
+                        g.m_indices.push_back(split(a, b));
                     }
                 }
+
+                if (g.m_indices.size() >= 3)
+                {
+                    r.m_faces.push_back(std::move(g));
+                }
             }
-        }
 
-        //now patch with quads
-        for (auto i = 0U; i < face_vector.size(); ++i)
-        {
-            if (face_vector[i])
+            if (cap.size() >= 3)
             {
-                const auto&     face            = body.m_faces[i];
-                const int32_t   indices_size    = static_cast<int32_t>(face.m_indices.size());
+                //sort the cap around its center in a basis of the plane, u x v is the outward normal
+                const float3 n      = -1.0f * q.m_n;
+                const float3 axis   = fabsf(n.m_x) < 0.5f ? float3{ 1.0f, 0.0f, 0.0f } : float3{ 0.0f, 1.0f, 0.0f };
+                const float3 u      = normalize(cross(n, axis));
+                const float3 v      = cross(n, u);
 
-                for (auto p = 0; p < indices_size; ++p)
+                float3 center;
+
+                for (auto&& i : cap)
                 {
-                    const   int32_t computed_index_0 = p;
-                    const   int32_t computed_index_1 = (p + 1) % indices_size;
+                    center = center + r.m_points[i];
+                }
 
-                    int32_t index_0  = face.m_indices[computed_index_0];
-                    int32_t index_1  = face.m_indices[computed_index_1];
+                center = center / static_cast<float>(cap.size());
 
-                    int32_t index_0_ = points_indices[index_0];
-                    int32_t index_1_ = points_indices[index_1];
+                std::vector<std::tuple<float, uint32_t>> angles;
 
-                    convex_polyhedron::polygon polygon;
+                for (auto&& i : cap)
+                {
+                    const float3 d = r.m_points[i] - center;
+                    angles.push_back(std::make_tuple(atan2f(dot(d, v), dot(d, u)), i));
+                }
 
-                    polygon.m_indices.push_back(index_0);
-                    polygon.m_indices.push_back(index_1);
-                    polygon.m_indices.push_back(index_1_);
-                    polygon.m_indices.push_back(index_0_);
+                std::sort(angles.begin(), angles.end());
 
-                    r.m_faces.push_back(std::move(polygon));
-                }
+                convex_polyhedron::polygon g;
 
-                //replace the old face indices
-                for (auto p = 0; p < indices_size; ++p)
+                for (auto&& a : angles)
                 {
-                    int32_t index_0             = face.m_indices[p];
-                    r.m_faces[i].m_indices[p]   = points_indices[ index_0 ];
+                    g.m_indices.push_back(std::get<1>(a));
                 }
+
+                r.m_faces.push_back(std::move(g));
             }
+
+            p = std::move(r);
+            return true;
         }
 
-        //now move the points to the light
-        for (auto i = 0U; i < points_indices.size(); ++i)
+        std::optional<convex_polyhedron> clip_heap(convex_polyhedron p, const std::array<plane, 6>& planes)
         {
-            if (points_indices[i] != -1)
+            for (auto&& q : planes)
             {
-                r.m_points[points_indices[i]] = r.m_points[points_indices[i]] + vector;
+                if (!clip_heap(p, q))
+                {
+                    return {};
+                }
             }
-        }
 
-        return r;
-    }
+            return p;
+        }
 
-    convex_polyhedron convex_hull_with_direction(const convex_polyhedron& body, const float3& vector, const aabb& clip_body)
-    {
-        float d = distance(clip_body.m_max, clip_body.m_min);
-        return convex_hull_with_direction(body, d * vector);
+        float max_extent(const aabb& b)
+        {
+            const float3 e = b.m_max - b.m_min;
+            return std::max(std::max(e.m_x, e.m_y), e.m_z);
+        }
     }
 
-    convex_polyhedron convex_hull_with_point(const convex_polyhedron& body, const float3& point)
+    convex_polyhedron make_convex_polyhedron(const fixed_convex_polyhedron& p)
     {
-        convex_polyhedron r = body;
+        convex_polyhedron r;
 
-        std::vector<plane> planes;
-        planes.resize(body.m_faces.size());
+        r.m_points.assign(p.m_points.begin(), p.m_points.end());
+        r.m_faces.resize(p.m_faces.size());
 
-        //compute planes
-        for (auto i = 0U; i < planes.size(); ++i)
+        for (auto i = 0U; i < p.m_faces.size(); ++i)
         {
-            const float3 a = body.m_points[body.m_faces[i].m_indices[0]];
-            const float3 b = body.m_points[body.m_faces[i].m_indices[1]];
-            const float3 c = body.m_points[body.m_faces[i].m_indices[2]];
-            planes[i] = make_plane(a, b, c);
+            const auto& f = p.m_faces[i];
+            r.m_faces[i].m_indices.assign(p.m_indices.begin() + f.m_offset, p.m_indices.begin() + f.m_offset + f.m_size);
         }
 
-        //orient normals to point inside
-        for (auto i = 0U; i < planes.size(); ++i)
-        {
-            auto plane = planes[i];
-
-            for (auto&& v : body.m_points)
-            {
-                if (dot(plane.m_n, v) + plane.m_d > 0.00001f)
-                {
-                    planes[i].m_n = -1.0f * plane.m_n;
-                    break;
-                }
-            }
-        }
+        return r;
+    }
 
+    namespace
+    {
+        clip_status clip_frustum(const frustum& f, const aabb& b, fixed_convex_polyhedron& r)
         {
-            uint32_t inside_all = 0;
-
-            //orient normals to point inside
-            for (auto i = 0U; i < planes.size(); ++i)
+            //the intersection is the same, but the new vertices are on the edges of the clipped body.
+            //clip the smaller one, so a box near the camera is not cut out of far plane edges of length 1e6
+            if (max_extent(b) < max_extent(make_aabb(f)))
             {
-                auto plane = planes[i];
+                frustum box;
 
-                for (auto&& v : body.m_points)
-                {
-                    if (dot(plane.m_n, v) + plane.m_d < -0.00001f)
-                    {
-                        inside_all = inside_all + 1;
-
-                    }
-                }
-            }
+                const auto points = make_points(b);
+                std::copy(points.begin(), points.end(), box.m_points);
 
-            //the point is inside
-            if (inside_all == planes.size())
-            {
-                return r;
+                return clip_polyhedron(box, make_face_planes(f), r);
             }
-        }
 
-        std::vector<bool> face_vector;
-        face_vector.resize(planes.size());
-
-        for (auto i = 0U; i < face_vector.size(); ++i)
-        {
-            face_vector[i] = dot(planes[i].m_n, point) > 0.00001f;
+            return clip_polyhedron(f, b, r);
         }
+    }
 
-        return r;
+    bool clip(const frustum& f, const aabb& b, fixed_convex_polyhedron& r)
+    {
+        return clip_frustum(f, b, r) == clip_status::clipped;
     }
 
-    convex_triangulated_polyhedron triangulate( const convex_polyhedron& p )
+    bool clip(const fixed_convex_polyhedron& f, const aabb& b, fixed_convex_polyhedron& r)
     {
-        //assert(false); //not implemented
-        convex_triangulated_polyhedron r;
+        return clip_polyhedron(f, b, r) == clip_status::clipped;
+    }
 
-        r.m_points = p.m_points;
-        r.m_faces.reserve(p.m_faces.size() * 2);
+    std::optional<convex_polyhedron> clip(const frustum& f, const aabb& b)
+    {
+        fixed_convex_polyhedron r;
 
-        for ( auto i = 0U; i < p.m_faces.size(); ++i)
+        switch (clip_frustum(f, b, r))
         {
-            const auto& f = p.m_faces[i];
-            if (f.m_indices.size() == 3)
-            {
+            case clip_status::clipped:
+                return make_convex_polyhedron(r);
 
-            }
+            case clip_status::overflow:
+                return clip_heap(make_convex_polyhedron(f.m_points), make_face_planes(b));
+
+            default:
+                return {};
         }
+    }
 
-        return r;
+    std::optional< convex_polyhedron > clip(const convex_polyhedron& f, const aabb& b)
+    {
+        fixed_convex_polyhedron r;
+
+        switch (clip_polyhedron(f, b, r))
+        {
+            case clip_status::clipped:
+                return make_convex_polyhedron(r);
+
+            case clip_status::overflow:
+                return clip_heap(f, make_face_planes(b));
+
+            default:
+                return {};
+        }
+    }
+
+    namespace
+    {
+        void append(clip_batch& r, uint32_t box, const fixed_convex_polyhedron& p)
+        {
+            clip_batch::polyhedron h;
+
+            h.m_box             = box;
+            h.m_points_offset   = static_cast<uint32_t>(r.m_points.size());
+            h.m_points_size     = p.m_points.size();
+            h.m_faces_offset    = static_cast<uint32_t>(r.m_faces.size());
+            h.m_faces_size      = p.m_faces.size();
+
+            const uint32_t indices_offset = static_cast<uint32_t>(r.m_indices.size());
+
+            r.m_points.insert(r.m_points.end(), p.m_points.begin(), p.m_points.end());
+            r.m_indices.insert(r.m_indices.end(), p.m_indices.begin(), p.m_indices.end());
+
+            for (auto&& f : p.m_faces)
+            {
+                r.m_faces.push_back({ indices_offset + f.m_offset, f.m_size });
+            }
+
+            r.m_polyhedra.push_back(h);
+        }
+
+        //the box is inside the frustum, so the intersection is the box itself
+        //faces follow the clipper convention, counterclockwise when viewed from outside
+        void append(clip_batch& r, uint32_t box, const aabb& b)
+        {
+            clip_batch::polyhedron h;
+
+            h.m_box             = box;
+            h.m_points_offset   = static_cast<uint32_t>(r.m_points.size());
+            h.m_points_size     = 8;
+            h.m_faces_offset    = static_cast<uint32_t>(r.m_faces.size());
+            h.m_faces_size      = 6;
+
+            const auto points = make_points(b);
+            r.m_points.insert(r.m_points.end(), points.begin(), points.end());
+
+            for (auto i = 0U; i < 6; ++i)
+            {
+                r.m_faces.push_back({ static_cast<uint32_t>(r.m_indices.size()), 4 });
+                r.m_indices.insert(r.m_indices.end(), &box_faces[i][0], &box_faces[i][0] + 4);
+            }
+
+            r.m_polyhedra.push_back(h);
+        }
+    }
+
+    void clip(const frustum& f, const aabb* boxes, uint32_t count, clip_batch& r)
+    {
+        //exact separating axis classification, boxes reported as intersecting really intersect
+        clip(f, make_separating_axes(f), boxes, 0, count, r);
+    }
+
+    void clip(const frustum& f, const frustum_separating_axes& axes, const aabb* boxes, uint32_t first, uint32_t count, clip_batch& r)
+    {
+        //classify in chunks on the stack, so the batch does not allocate
+        const uint32_t chunk_size = 256;
+        const uint32_t end        = first + count;
+
+        frustum_aabb_classification classes[chunk_size];
+        fixed_convex_polyhedron     p;
+
+        for (auto chunk = first; chunk < end; chunk += chunk_size)
+        {
+            const uint32_t size = std::min(chunk_size, end - chunk);
+
+            classify(axes, boxes + chunk, size, &classes[0]);
+
+            for (auto i = 0U; i < size; ++i)
+            {
+                const uint32_t box = chunk + i;
+
+                switch (classes[i])
+                {
+                    case frustum_aabb_classification::inside:
+                    {
+                        append(r, box, boxes[box]);
+                        break;
+                    }
+
+                    case frustum_aabb_classification::intersecting:
+                    {
+                        if (clip(f, boxes[box], p))
+                        {
+                            append(r, box, p);
+                        }
+                        break;
+                    }
+
+                    default:
+                        break;
+                }
+            }
+        }
+    }
+
+    namespace
+    {
+        template <typename polyhedron> uint32_t oriented_face_index(const polyhedron& p, const convex_polyhedron_adjacency& a, uint32_t face, uint32_t i)
+        {
+            const uint32_t size = face_size(p, face);
+            return face_index(p, face, a.m_reversed[face] ? size - 1 - i : i);
+        }
+
+        inline uint32_t neighbor(const convex_polyhedron_adjacency& a, uint32_t face, uint32_t i)
+        {
+            return a.m_neighbors[a.m_offsets[face] + i];
+        }
+
+        template <typename polyhedron> bool make_adjacency(const polyhedron& body, convex_polyhedron_adjacency& r)
+        {
+            const uint32_t points   = point_count(body);
+            const uint32_t faces    = face_count(body);
+
+            if (points == 0 || points > fixed_convex_polyhedron::max_points || faces > fixed_convex_polyhedron::max_faces)
+            {
+                return false;
+            }
+
+            float3 center   = { 0.0f, 0.0f, 0.0f };
+            float3 minimum  = body.m_points[0];
+            float3 maximum  = body.m_points[0];
+
+            for (auto i = 0U; i < points; ++i)
+            {
+                const float3 v = body.m_points[i];
+
+                center  = center + v;
+                minimum = { std::min(minimum.m_x, v.m_x), std::min(minimum.m_y, v.m_y), std::min(minimum.m_z, v.m_z) };
+                maximum = { std::max(maximum.m_x, v.m_x), std::max(maximum.m_y, v.m_y), std::max(maximum.m_z, v.m_z) };
+            }
+
+            r.m_center = center / static_cast<float>(points);
+            r.m_extent = distance(minimum, maximum);
+
+            //area weighted normals are exact for planar polygons and stable for nearly degenerate ones
+            uint32_t offset = 0;
+
+            for (auto i = 0U; i < faces; ++i)
+            {
+                const uint32_t size = face_size(body, i);
+                float3         n    = { 0.0f, 0.0f, 0.0f };
+                float3         c    = { 0.0f, 0.0f, 0.0f };
+
+                if (size < 3 || offset + size > fixed_convex_polyhedron::max_indices)
+                {
+                    return false;
+                }
+
+                for (auto j = 0U; j < size; ++j)
+                {
+                    c = c + body.m_points[face_index(body, i, j)];
+                }
+
+                c = c / static_cast<float>(size);
+
+                //relative to the face center, thin faces far from the origin lose the normal to cancellation otherwise
+                for (auto j = 0U; j < size; ++j)
+                {
+                    const float3 a = body.m_points[face_index(body, i, j)] - c;
+                    const float3 b = body.m_points[face_index(body, i, (j + 1) % size)] - c;
+
+                    n = n + cross(a, b);
+                }
+
+                if (dot(n, n) == 0.0f)
+                {
+                    return false;
+                }
+
+                n = normalize(n);
+
+                //the input winding is not trusted, the centroid of a convex body is behind every face
+                r.m_reversed[i] = dot(n, r.m_center - c) > 0.0f;
+                n               = r.m_reversed[i] ? -1.0f * n : n;
+
+                r.m_planes[i]   = { n, -dot(n, c) };
+                r.m_offsets[i]  = offset;
+                offset         += size;
+            }
+
+            //directed edges listed per start vertex, each edge is shared by exactly two faces in opposite directions
+            struct edge
+            {
+                uint8_t m_to;
+                uint8_t m_face;
+                uint8_t m_next;
+            };
+
+            const uint8_t   end = 0xFF;
+            uint8_t         first[fixed_convex_polyhedron::max_points];
+            edge            edges[fixed_convex_polyhedron::max_indices];
+
+            std::fill(first, first + points, end);
+
+            for (auto i = 0U; i < faces; ++i)
+            {
+                const uint32_t size = face_size(body, i);
+
+                for (auto j = 0U; j < size; ++j)
+                {
+                    const uint32_t from = oriented_face_index(body, r, i, j);
+                    const uint32_t e    = r.m_offsets[i] + j;
+
+                    edges[e]    = { static_cast<uint8_t>(oriented_face_index(body, r, i, (j + 1) % size)), static_cast<uint8_t>(i), first[from] };
+                    first[from] = static_cast<uint8_t>(e);
+                }
+            }
+
+            for (auto i = 0U; i < faces; ++i)
+            {
+                const uint32_t size = face_size(body, i);
+
+                for (auto j = 0U; j < size; ++j)
+                {
+                    const uint32_t from = oriented_face_index(body, r, i, (j + 1) % size);
+                    const uint32_t to   = oriented_face_index(body, r, i, j);
+                    uint8_t        e    = first[from];
+
+                    while (e != end && edges[e].m_to != to)
+                    {
+                        e = edges[e].m_next;
+                    }
+
+                    //open input
+                    if (e == end)
+                    {
+                        return false;
+                    }
+
+                    r.m_neighbors[r.m_offsets[i] + j] = edges[e].m_face;
+                }
+            }
+
+            return true;
+        }
+
+        //appends one face, collapsing the spikes x, y, x and the repeats x, x that appear where a face absorbs a neighbor
+        inline bool append_face(fixed_convex_polyhedron& r, const uint32_t* indices, uint32_t size)
+        {
+            uint32_t face[2 * fixed_convex_polyhedron::max_indices];
+            uint32_t count = 0;
+
+            for (auto i = 0U; i < size; ++i)
+            {
+                face[count++] = indices[i];
+
+                bool collapsed = true;
+
+                while (collapsed)
+                {
+                    collapsed = false;
+
+                    if (count >= 2 && face[count - 1] == face[count - 2])
+                    {
+                        count--;
+                        collapsed = true;
+                    }
+                    else if (count >= 3 && face[count - 1] == face[count - 3])
+                    {
+                        count -= 2;
+                        collapsed = true;
+                    }
+                }
+            }
+
+            //the same across the start of the cycle
+            while (count >= 3)
+            {
+                if (face[0] == face[count - 1])
+                {
+                    count--;
+                }
+                else if (face[count - 2] == face[0])
+                {
+                    count -= 2;
+                }
+                else if (face[count - 1] == face[1])
+                {
+                    std::copy(face + 2, face + count, face);
+                    count -= 2;
+                }
+                else
+                {
+                    break;
+                }
+            }
+
+            if (count < 3)
+            {
+                return true;
+            }
+
+            if (r.m_faces.full() || r.m_indices.size() + count > fixed_convex_polyhedron::max_indices)
+            {
+                return false;
+            }
+
+            fixed_convex_polyhedron::polygon polygon;
+
+            polygon.m_offset    = r.m_indices.size();
+            polygon.m_size      = count;
+
+            for (auto i = 0U; i < count; ++i)
+            {
+                r.m_indices.push_back(face[i]);
+            }
+
+            r.m_faces.push_back(polygon);
+            return true;
+        }
+
+        //drops the points the faces do not reference and renumbers the indices. point(i) gives the position of the input index i
+        template <typename point_function> bool compact(fixed_convex_polyhedron& r, uint32_t* remap, uint32_t count, point_function point)
+        {
+            const uint32_t unused = 0xFFFFFFFF;
+
+            std::fill(remap, remap + count, unused);
+
+            for (auto i = 0U; i < r.m_indices.size(); ++i)
+            {
+                remap[r.m_indices[i]] = 0;
+            }
+
+            r.m_points.clear();
+
+            for (auto i = 0U; i < count; ++i)
+            {
+                if (remap[i] != unused)
+                {
+                    if (r.m_points.full())
+                    {
+                        return false;
+                    }
+
+                    remap[i] = r.m_points.size();
+                    r.m_points.push_back(point(i));
+                }
+            }
+
+            for (auto i = 0U; i < r.m_indices.size(); ++i)
+            {
+                r.m_indices[i] = remap[r.m_indices[i]];
+            }
+
+            return true;
+        }
+
+        template <typename polyhedron> bool copy_oriented(const polyhedron& body, const convex_polyhedron_adjacency& a, fixed_convex_polyhedron& r)
+        {
+            r.m_points.resize(point_count(body));
+            std::copy(body.m_points.begin(), body.m_points.begin() + point_count(body), r.m_points.begin());
+
+            for (auto i = 0U; i < face_count(body); ++i)
+            {
+                uint32_t indices[fixed_convex_polyhedron::max_indices];
+
+                for (auto j = 0U; j < face_size(body, i); ++j)
+                {
+                    indices[j] = oriented_face_index(body, a, i, j);
+                }
+
+                if (!append_face(r, indices, face_size(body, i)))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        //minkowski sum of the body and the segment [0, vector]. faces facing the vector move, the silhouette between them and the rest becomes quads.
+        //faces parallel to the vector take the quads of their silhouette edges into their boundary, so they stay one polygon
+        template <typename polyhedron>
+        bool convex_hull_with_direction(const polyhedron& body, const convex_polyhedron_adjacency& a, const float3& vector, fixed_convex_polyhedron& r)
+        {
+            const uint32_t points   = point_count(body);
+            const uint32_t faces    = face_count(body);
+
+            r.m_points.clear();
+            r.m_faces.clear();
+            r.m_indices.clear();
+
+            const float epsilon = 1e-5f * sqrtf(dot(vector, vector));
+            bool        front[fixed_convex_polyhedron::max_faces];
+            bool        parallel[fixed_convex_polyhedron::max_faces];
+
+            for (auto i = 0U; i < faces; ++i)
+            {
+                const float d   = dot(a.m_planes[i].m_n, vector);
+
+                front[i]        = d > epsilon;
+                parallel[i]     = !front[i] && d >= -epsilon;
+            }
+
+            //moved copies of the points are numbered after the points
+            for (auto i = 0U; i < faces; ++i)
+            {
+                const uint32_t size = face_size(body, i);
+                uint32_t       indices[3 * fixed_convex_polyhedron::max_indices];
+                uint32_t       indices_size = 0;
+
+                if (front[i])
+                {
+                    for (auto j = 0U; j < size; ++j)
+                    {
+                        indices[indices_size++] = oriented_face_index(body, a, i, j) + points;
+                    }
+
+                    if (!append_face(r, indices, indices_size))
+                    {
+                        return false;
+                    }
+
+                    //silhouette quads
+                    for (auto j = 0U; j < size; ++j)
+                    {
+                        const uint32_t n = neighbor(a, i, j);
+
+                        if (!front[n] && !parallel[n])
+                        {
+                            const uint32_t v0       = oriented_face_index(body, a, i, j);
+                            const uint32_t v1       = oriented_face_index(body, a, i, (j + 1) % size);
+                            const uint32_t quad[4]  = { v0, v1, v1 + points, v0 + points };
+
+                            if (!append_face(r, quad, 4))
+                            {
+                                return false;
+                            }
+                        }
+                    }
+                }
+                else
+                {
+                    for (auto j = 0U; j < size; ++j)
+                    {
+                        const uint32_t v0 = oriented_face_index(body, a, i, j);
+
+                        indices[indices_size++] = v0;
+
+                        //the quad of the edge v0 -> v1 is v0, v0 + points, v1 + points, v1
+                        if (parallel[i] && front[neighbor(a, i, j)])
+                        {
+                            indices[indices_size++] = v0 + points;
+                            indices[indices_size++] = oriented_face_index(body, a, i, (j + 1) % size) + points;
+                        }
+                    }
+
+                    if (!append_face(r, indices, indices_size))
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            uint32_t remap[2 * fixed_convex_polyhedron::max_points];
+
+            return compact(r, remap, 2 * points, [&body, &vector, points](uint32_t i)
+            {
+                return i < points ? body.m_points[i] : body.m_points[i - points] + vector;
+            });
+        }
+
+        //quickhull step of a convex polyhedron and one point: the faces the point sees are replaced by a cone from the horizon to the point
+        struct hull_builder
+        {
+            static constexpr uint32_t max_points    = fixed_convex_polyhedron::max_points;
+            static constexpr uint32_t max_faces     = fixed_convex_polyhedron::max_faces;
+            static constexpr uint32_t no_vertex     = 0xFFFFFFFF;
+
+            convex_polyhedron_adjacency             m_adjacency;
+            bool                                    m_visible[max_faces];
+            bool                                    m_coplanar[max_faces];  //not visible, the point lies on the plane
+            uint32_t                                m_horizon_next[max_points];
+            bool                                    m_absorbed[max_points]; //the horizon edge from this vertex merged into a coplanar face
+            uint32_t                                m_remap[max_points + 1];
+        };
+
+        template <typename polyhedron>
+        bool convex_hull_with_point(const polyhedron& body, const float3& point, hull_builder& h, fixed_convex_polyhedron& r)
+        {
+            const uint32_t                      points  = point_count(body);
+            const uint32_t                      faces   = face_count(body);
+            const uint32_t                      apex    = points;
+            const convex_polyhedron_adjacency&  a       = h.m_adjacency;
+
+            r.m_points.clear();
+            r.m_faces.clear();
+            r.m_indices.clear();
+
+            if (!make_adjacency(body, h.m_adjacency))
+            {
+                return false;
+            }
+
+            //tolerance relative to the extent of the input
+            const float epsilon = 1e-5f * (a.m_extent + distance(a.m_center, point));
+            bool        visible = false;
+
+            for (auto i = 0U; i < faces; ++i)
+            {
+                const float d   = dot(a.m_planes[i].m_n, point) + a.m_planes[i].m_d;
+
+                h.m_visible[i]  = d > epsilon;
+                h.m_coplanar[i] = !h.m_visible[i] && d >= -epsilon;
+                visible         = visible || h.m_visible[i];
+            }
+
+            //the point is inside or on the body
+            if (!visible)
+            {
+                return copy_oriented(body, a, r);
+            }
+
+            //horizon: edges of visible faces whose twin face is hidden. they form one loop around the visible region
+            uint32_t horizon_start  = hull_builder::no_vertex;
+            uint32_t horizon_size   = 0;
+
+            std::fill(h.m_horizon_next, h.m_horizon_next + points, hull_builder::no_vertex);
+            std::fill(h.m_absorbed, h.m_absorbed + points, false);
+
+            for (auto i = 0U; i < faces; ++i)
+            {
+                if (h.m_visible[i])
+                {
+                    const uint32_t size = face_size(body, i);
+
+                    for (auto j = 0U; j < size; ++j)
+                    {
+                        const uint32_t v0   = oriented_face_index(body, a, i, j);
+                        const uint32_t v1   = oriented_face_index(body, a, i, (j + 1) % size);
+                        const uint32_t twin = neighbor(a, i, j);
+
+                        if (!h.m_visible[twin])
+                        {
+                            //the visible region is not a disk
+                            if (h.m_horizon_next[v0] != hull_builder::no_vertex)
+                            {
+                                return false;
+                            }
+
+                            h.m_horizon_next[v0]    = v1;
+                            h.m_absorbed[v0]        = h.m_coplanar[twin];
+                            horizon_start           = v0;
+                            horizon_size++;
+                        }
+                    }
+                }
+            }
+
+            //the point sees every face
+            if (horizon_size == 0)
+            {
+                return false;
+            }
+
+            {
+                uint32_t v      = horizon_start;
+                uint32_t size   = 0;
+
+                do
+                {
+                    v = h.m_horizon_next[v];
+                    size++;
+                } while (v != hull_builder::no_vertex && v != horizon_start && size <= horizon_size);
+
+                if (v != horizon_start || size != horizon_size)
+                {
+                    return false;
+                }
+            }
+
+            //hidden faces stay, the coplanar ones take the point into their boundary
+            for (auto i = 0U; i < faces; ++i)
+            {
+                if (!h.m_visible[i])
+                {
+                    const uint32_t size = face_size(body, i);
+                    uint32_t       indices[2 * fixed_convex_polyhedron::max_indices];
+                    uint32_t       indices_size = 0;
+
+                    for (auto j = 0U; j < size; ++j)
+                    {
+                        const uint32_t v0 = oriented_face_index(body, a, i, j);
+                        const uint32_t v1 = oriented_face_index(body, a, i, (j + 1) % size);
+
+                        indices[indices_size++] = v0;
+
+                        if (h.m_coplanar[i] && h.m_horizon_next[v1] == v0)
+                        {
+                            indices[indices_size++] = apex;
+                        }
+                    }
+
+                    if (!append_face(r, indices, indices_size))
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            //the cone, consecutive coplanar triangles are merged into one polygon, which keeps the horizon vertices and avoids t-junctions
+            {
+                //start after a break in the cone, so a coplanar run does not wrap around the start
+                uint32_t start  = horizon_start;
+                uint32_t v      = horizon_start;
+
+                auto coplanar = [&body, &point, epsilon](uint32_t v0, uint32_t v1, uint32_t v2)
+                {
+                    const float3 p0 = body.m_points[v0];
+                    const float3 n  = cross(body.m_points[v1] - p0, point - p0);
+                    const float  l  = sqrtf(dot(n, n));
+
+                    return l > 0.0f && fabsf(dot(n, body.m_points[v2] - p0)) <= epsilon * l;
+                };
+
+                for (auto i = 0U; i < horizon_size; ++i)
+                {
+                    const uint32_t next = h.m_horizon_next[v];
+
+                    if (h.m_absorbed[v] || h.m_absorbed[next] || !coplanar(v, next, h.m_horizon_next[next]))
+                    {
+                        start = next;
+                        break;
+                    }
+
+                    v = next;
+                }
+
+                uint32_t indices[hull_builder::max_points + 1];
+                uint32_t indices_size = 0;
+
+                v = start;
+
+                for (auto i = 0U; i < horizon_size; ++i)
+                {
+                    const uint32_t next = h.m_horizon_next[v];
+
+                    if (!h.m_absorbed[v])
+                    {
+                        if (indices_size == 0)
+                        {
+                            indices[indices_size++] = v;
+                        }
+
+                        indices[indices_size++] = next;
+
+                        const bool closes = h.m_absorbed[next] || next == start || !coplanar(indices[0], indices[1], h.m_horizon_next[next]);
+
+                        if (closes)
+                        {
+                            indices[indices_size++] = apex;
+
+                            if (!append_face(r, indices, indices_size))
+                            {
+                                return false;
+                            }
+
+                            indices_size = 0;
+                        }
+                    }
+
+                    v = next;
+                }
+            }
+
+            //drop the points of the removed faces
+            return compact(r, h.m_remap, points + 1, [&body, &point, apex](uint32_t i)
+            {
+                return i == apex ? point : body.m_points[i];
+            });
+        }
+
+        hull_builder& thread_hull_builder()
+        {
+            static thread_local hull_builder builder;
+            return builder;
+        }
+    }
+
+    bool make_adjacency(const fixed_convex_polyhedron& body, convex_polyhedron_adjacency& r)
+    {
+        return make_adjacency<fixed_convex_polyhedron>(body, r);
+    }
+
+    bool convex_hull_with_direction(const fixed_convex_polyhedron& body, const convex_polyhedron_adjacency& adjacency, const float3& vector, fixed_convex_polyhedron& r)
+    {
+        return convex_hull_with_direction<fixed_convex_polyhedron>(body, adjacency, vector, r);
+    }
+
+    bool convex_hull_with_direction(const fixed_convex_polyhedron& body, const float3& vector, fixed_convex_polyhedron& r)
+    {
+        auto& adjacency = thread_hull_builder().m_adjacency;
+        return make_adjacency<fixed_convex_polyhedron>(body, adjacency) && convex_hull_with_direction<fixed_convex_polyhedron>(body, adjacency, vector, r);
+    }
+
+    std::optional<convex_polyhedron> convex_hull_with_direction(const convex_polyhedron& body, const float3& vector)
+    {
+        auto&                   adjacency = thread_hull_builder().m_adjacency;
+        fixed_convex_polyhedron r;
+
+        if (make_adjacency(body, adjacency) && convex_hull_with_direction(body, adjacency, vector, r))
+        {
+            return make_convex_polyhedron(r);
+        }
+
+        return {};
+    }
+
+    std::optional<convex_polyhedron> convex_hull_with_direction(const convex_polyhedron& body, const float3& vector, const aabb& clip_body)
+    {
+        float d = distance(clip_body.m_max, clip_body.m_min);
+        return convex_hull_with_direction(body, d * vector);
+    }
+
+    bool convex_hull_with_point(const fixed_convex_polyhedron& body, const float3& point, fixed_convex_polyhedron& r)
+    {
+        return convex_hull_with_point(body, point, thread_hull_builder(), r);
+    }
+
+    std::optional<convex_polyhedron> convex_hull_with_point(const convex_polyhedron& body, const float3& point)
+    {
+        fixed_convex_polyhedron r;
+
+        if (convex_hull_with_point(body, point, thread_hull_builder(), r))
+        {
+            return make_convex_polyhedron(r);
+        }
+
+        return {};
+    }
+
+    namespace
+    {
+        //a convex polyhedron with v vertices has at most 2v - 4 triangles
+        constexpr uint32_t max_triangulated_vertices    = 256;
+        constexpr uint32_t max_triangulated_faces       = 64;
+        constexpr uint32_t max_triangulated_indices     = 3 * (2 * max_triangulated_vertices - 4);
+        constexpr uint32_t vertex_cache_size            = 16;
+        constexpr uint16_t not_emitted                  = 0xFFFF;
+
+        struct triangle_list
+        {
+            fixed_vector<uint16_t, max_triangulated_vertices>   m_order;    //emitted vertex -> polyhedron vertex
+            fixed_vector<uint16_t, max_triangulated_indices>    m_indices;  //in the emitted numbering
+        };
+
+        //fifo model of the post transform cache
+        struct vertex_cache
+        {
+            uint16_t m_entries[vertex_cache_size];
+            uint32_t m_size = 0;
+            uint32_t m_next = 0;
+
+            bool contains(uint16_t v) const
+            {
+                for (auto i = 0U; i < m_size; ++i)
+                {
+                    if (m_entries[i] == v)
+                    {
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            void insert(uint16_t v)
+            {
+                if (!contains(v))
+                {
+                    m_entries[m_next] = v;
+                    m_next = (m_next + 1) % vertex_cache_size;
+                    m_size = std::min(m_size + 1, vertex_cache_size);
+                }
+            }
+        };
+
+        template <typename polyhedron> uint32_t triangle_list_index_count(const polyhedron& p)
+        {
+            uint32_t r = 0;
+
+            for (auto i = 0U; i < face_count(p); ++i)
+            {
+                r += face_size(p, i) >= 3 ? 3 * (face_size(p, i) - 2) : 0;
+            }
+
+            return r;
+        }
+
+        template <typename polyhedron> bool fits_triangle_list(const polyhedron& p)
+        {
+            if (point_count(p) > max_triangulated_vertices || face_count(p) > max_triangulated_faces)
+            {
+                return false;
+            }
+
+            for (auto i = 0U; i < face_count(p); ++i)
+            {
+                if (face_size(p, i) > closed_convex_clipper::max_face_edges)
+                {
+                    return false;
+                }
+            }
+
+            return triangle_list_index_count(p) <= max_triangulated_indices;
+        }
+
+        //greedy face order: the next face is the one with most vertices still in the cache.
+        //each polygon is split as a zigzag strip starting at a cached vertex, every triangle after the first brings one new vertex.
+        template <typename polyhedron> void make_triangle_list(const polyhedron& p, triangle_list& r)
+        {
+            uint16_t        remap[max_triangulated_vertices];
+            vertex_cache    cache;
+            uint64_t        emitted = 0;
+
+            const uint32_t points   = point_count(p);
+            const uint32_t faces    = face_count(p);
+
+            std::fill(remap, remap + points, not_emitted);
+            r.m_order.clear();
+            r.m_indices.clear();
+
+            for (auto k = 0U; k < faces; ++k)
+            {
+                uint32_t best       = faces;
+                uint32_t best_score = 0;
+
+                for (auto i = 0U; i < faces; ++i)
+                {
+                    if ((emitted & (1ULL << i)) == 0)
+                    {
+                        uint32_t score = 0;
+
+                        for (auto j = 0U; j < face_size(p, i); ++j)
+                        {
+                            score += cache.contains(static_cast<uint16_t>(face_index(p, i, j))) ? 1 : 0;
+                        }
+
+                        if (best == faces || score > best_score)
+                        {
+                            best        = i;
+                            best_score  = score;
+                        }
+                    }
+                }
+
+                emitted |= 1ULL << best;
+
+                const uint32_t n = face_size(p, best);
+
+                if (n < 3)
+                {
+                    continue;
+                }
+
+                uint32_t start = 0;
+
+                for (auto j = 0U; j < n; ++j)
+                {
+                    if (cache.contains(static_cast<uint16_t>(face_index(p, best, j))))
+                    {
+                        start = j;
+                        break;
+                    }
+                }
+
+                //strip order 0, 1, n - 1, 2, n - 2, ... of the rotated polygon
+                uint32_t strip[closed_convex_clipper::max_face_edges];
+                uint32_t low    = 1;
+                uint32_t high   = n - 1;
+
+                strip[0] = 0;
+
+                for (auto j = 1U; j < n; ++j)
+                {
+                    strip[j] = (j & 1) ? low++ : high--;
+                }
+
+                for (auto j = 0U; j + 2 < n; ++j)
+                {
+                    //odd strip triangles are flipped to keep the winding of the face
+                    const uint32_t a = strip[(j & 1) ? j + 2 : j];
+                    const uint32_t b = strip[j + 1];
+                    const uint32_t c = strip[(j & 1) ? j : j + 2];
+
+                    for (auto v : { a, b, c })
+                    {
+                        const uint16_t index = static_cast<uint16_t>(face_index(p, best, (start + v) % n));
+
+                        if (remap[index] == not_emitted)
+                        {
+                            remap[index] = static_cast<uint16_t>(r.m_order.size());
+                            r.m_order.push_back(index);
+                        }
+
+                        cache.insert(index);
+                        r.m_indices.push_back(remap[index]);
+                    }
+                }
+            }
+
+            //points not referenced by any face keep their place at the end
+            for (auto i = 0U; i < points; ++i)
+            {
+                if (remap[i] == not_emitted)
+                {
+                    remap[i] = static_cast<uint16_t>(r.m_order.size());
+                    r.m_order.push_back(static_cast<uint16_t>(i));
+                }
+            }
+        }
+
+        triangle_list_layout make_layout(uint32_t vertex_count, uint32_t index_count)
+        {
+            triangle_list_layout r;
+
+            r.m_vertex_count    = vertex_count;
+            r.m_index_count     = index_count;
+            r.m_indices_offset  = vertex_count * sizeof(float3);
+            r.m_size            = (r.m_indices_offset + index_count * sizeof(uint16_t) + 3) & ~3U;
+            return r;
+        }
+
+        template <typename polyhedron> triangle_list_layout make_triangle_list_layout_t(const polyhedron& p)
+        {
+            if (!fits_triangle_list(p))
+            {
+                return triangle_list_layout();
+            }
+
+            return make_layout(point_count(p), triangle_list_index_count(p));
+        }
+
+        template <typename polyhedron> triangle_list_layout triangulate_t(const polyhedron& p, void* destination, uint32_t size)
+        {
+            if (!fits_triangle_list(p))
+            {
+                return triangle_list_layout();
+            }
+
+            triangle_list l;
+            make_triangle_list(p, l);
+
+            const triangle_list_layout r = make_layout(l.m_order.size(), l.m_indices.size());
+
+            if (r.m_size > size)
+            {
+                return triangle_list_layout();
+            }
+
+            //sequential writes only, the destination may be write combined memory
+            float3* positions = reinterpret_cast<float3*>(destination);
+
+            for (auto i = 0U; i < l.m_order.size(); ++i)
+            {
+                positions[i] = p.m_points[l.m_order[i]];
+            }
+
+            uint8_t* indices = reinterpret_cast<uint8_t*>(destination) + r.m_indices_offset;
+            std::copy(l.m_indices.begin(), l.m_indices.end(), reinterpret_cast<uint16_t*>(indices));
+
+            if (r.m_size > r.m_indices_offset + l.m_indices.size() * sizeof(uint16_t))
+            {
+                //padding to the 4 byte size
+                reinterpret_cast<uint16_t*>(indices)[l.m_indices.size()] = 0;
+            }
+
+            return r;
+        }
+
+        //fans in the point order of the polyhedron, for polyhedra beyond the fixed storage of the ordered list
+        template <typename polyhedron> convex_triangulated_polyhedron triangulate_fans(const polyhedron& p)
+        {
+            convex_triangulated_polyhedron r;
+
+            r.m_points.assign(p.m_points.begin(), p.m_points.end());
+            r.m_faces.reserve(triangle_list_index_count(p) / 3);
+
+            for (auto i = 0U; i < face_count(p); ++i)
+            {
+                for (auto j = 1U; j + 1 < face_size(p, i); ++j)
+                {
+                    convex_triangulated_polyhedron::polygon t;
+
+                    t.m_indices = { face_index(p, i, 0), face_index(p, i, j), face_index(p, i, j + 1) };
+                    r.m_faces.push_back(t);
+                }
+            }
+
+            return r;
+        }
+
+        template <typename polyhedron> convex_triangulated_polyhedron triangulate_t(const polyhedron& p)
+        {
+            if (!fits_triangle_list(p))
+            {
+                return triangulate_fans(p);
+            }
+
+            triangle_list l;
+            make_triangle_list(p, l);
+
+            convex_triangulated_polyhedron r;
+
+            r.m_points.reserve(l.m_order.size());
+            r.m_faces.reserve(l.m_indices.size() / 3);
+
+            for (auto i = 0U; i < l.m_order.size(); ++i)
+            {
+                r.m_points.push_back(p.m_points[l.m_order[i]]);
+            }
+
+            for (auto i = 0U; i < l.m_indices.size(); i += 3)
+            {
+                convex_triangulated_polyhedron::polygon t;
+
+                t.m_indices = { l.m_indices[i], l.m_indices[i + 1], l.m_indices[i + 2] };
+                r.m_faces.push_back(t);
+            }
+
+            return r;
+        }
+    }
+
+    convex_triangulated_polyhedron triangulate(const convex_polyhedron& p)
+    {
+        return triangulate_t(p);
+    }
+
+    convex_triangulated_polyhedron triangulate(const fixed_convex_polyhedron& p)
+    {
+        return triangulate_t(p);
+    }
+
+    triangle_list_layout make_triangle_list_layout(const convex_polyhedron& p)
+    {
+        return make_triangle_list_layout_t(p);
+    }
+
+    triangle_list_layout make_triangle_list_layout(const fixed_convex_polyhedron& p)
+    {
+        return make_triangle_list_layout_t(p);
+    }
+
+    triangle_list_layout triangulate(const convex_polyhedron& p, void* destination, uint32_t size)
+    {
+        return triangulate_t(p, destination, size);
+    }
+
+    triangle_list_layout triangulate(const fixed_convex_polyhedron& p, void* destination, uint32_t size)
+    {
+        return triangulate_t(p, destination, size);
     }
 }
@@ -2,33 +2,14 @@
 #include "frustum_aabb_intersection.h"
 #include <algorithm>
 #include <array>
-#include <unordered_set>
 #include <functional>
 #include <assert.h>
 #include <iostream>     // std::cout, std::ios
 #include <sstream>      // std::ostringstream
+#include "fixed_vector.h"
 
 
 
-namespace std
-{
-    template <>
-    struct hash<computational_geometry::float3>
-    {
-        size_t operator()(const computational_geometry::float3& k) const
-        {
-            // Compute individual hash values for first, second and third
-            // http://stackoverflow.com/a/1646913/126995
-            size_t res = 17;
-            res = res * 31 + hash<float>()(k.m_x);
-            res = res * 31 + hash<float>()(k.m_y);
-            res = res * 31 + hash<float>()(k.m_z);
-            return res;
-        }
-    };
-
-}
-
 namespace computational_geometry
 {
     struct edge3d
@@ -37,18 +18,6 @@ namespace computational_geometry
         float3 m_b;
     };
 
-    struct edge2d
-    {
-        float2 m_a;
-        float2 m_b;
-    };
-
-    struct line2d
-    {
-        float2 m_n;
-        float  m_d;
-    };
-
     struct triangle_indexed
     {
         uint8_t m_a;
@@ -137,22 +106,6 @@ namespace computational_geometry
         return { {min_x, min_y, min_z}, {max_x, max_y, max_z} };
     }
 
-    line2d make_line_2d(const float2& a, const float2& b)
-    {
-        //note: not normalized
-        float  x1   = a.m_x;
-        float  x2   = b.m_x;
-
-        float  y1   = a.m_y;
-        float  y2   = b.m_y;
-
-        float  a_    = y2 - y1;
-        float  b_    = x1 - x2;
-        float  c_    = x2 * y1 - y2 * x1;
-
-        return { {a_,b_}, c_ };
-    }
-
     template <uint32_t edge>
     constexpr void get_edge(uint32_t& a, uint32_t& b)
     {
@@ -499,18 +452,6 @@ namespace computational_geometry
         return r;
     }
 
-    std::array<line2d, 12> make_lines(const std::array<edge2d, 12> & e)
-    {
-        std::array<line2d, 12> r;
-
-        for (auto i = 0U; i < 12; ++i)
-        {
-            r[i] = make_line_2d(e[i].m_a, e[i].m_b);
-        }
-
-        return r;
-    }
-
     //returns true if b is inside a
     bool inside(const aabb& a, const aabb& b)
     {
@@ -522,7 +463,8 @@ namespace computational_geometry
         float d_max_y = b.m_max.m_y - a.m_max.m_y;
         float d_max_z = b.m_max.m_z - a.m_max.m_z;
 
-        return (d_min_x * d_max_x < 0.0f && d_min_y * d_max_y < 0.0f && d_min_z * d_max_z < 0.0f);
+        //the product test also accepted a inside b on some of the axes
+        return d_min_x >= 0.0f && d_min_y >= 0.0f && d_min_z >= 0.0f && d_max_x <= 0.0f && d_max_y <= 0.0f && d_max_z <= 0.0f;
     }
 
     //returns true if b is inside a
@@ -578,88 +520,106 @@ namespace computational_geometry
         return plane_aabb_intersection::intersection;
     }
 
-    bool outside(const std::array<float2, 8>& a, const line2d& p)
+    bool intersect_segment_plane(const float3& a, const float3& b, const plane& p, float3& r)
     {
-        float dots[8];
-
-        dots[0] = dot(p.m_n, a[0]) + p.m_d;
-        dots[1] = dot(p.m_n, a[1]) + p.m_d;
-        dots[2] = dot(p.m_n, a[2]) + p.m_d;
-        dots[3] = dot(p.m_n, a[3]) + p.m_d;
-
-        dots[4] = dot(p.m_n, a[4]) + p.m_d;
-        dots[5] = dot(p.m_n, a[5]) + p.m_d;
-        dots[6] = dot(p.m_n, a[6]) + p.m_d;
-        dots[7] = dot(p.m_n, a[7]) + p.m_d;
-
-        bool positive_half_plane = true;
-        bool negative_half_plane = true;
+        float3 ab   = b - a;
+        float  t    = (-p.m_d - dot(p.m_n, a)) / dot(p.m_n, ab);
 
-        for (auto i = 0U; i < 8; ++i)
+        if (t > 0.0f && t < 1.0f)
         {
-            positive_half_plane = positive_half_plane && (dots[i] > 0.0f);
+            r = a + t * ab;
+            return true;
         }
-
-        return positive_half_plane;
-    }
-
-    template <uint32_t axis> float2 project_point(const float3& p)
-    {
-        switch (axis)
+        else
         {
-            case 0: return  {p.m_y, p.m_z };
-            case 1: return  {p.m_x, p.m_z };
-            case 2: return  {p.m_x, p.m_y };
-            default: __assume(false);
+            return false;
         }
     }
 
-    template <uint32_t axis> 
-    edge2d project_edge(const edge3d& e)
+    namespace
     {
-        return  { project_point<axis>(e.m_a), project_point<axis>(e.m_b) };
-    }
+        //lexicographic order, -0.0f and +0.0f compare equal
+        bool less_xyz(const float3& a, const float3& b)
+        {
+            if (a.m_x != b.m_x)
+            {
+                return a.m_x < b.m_x;
+            }
 
-    template <uint32_t axis>
-    std::array<edge2d, 12> project_edges(const std::array<edge3d, 12>& e)
-    {
-        std::array<edge2d, 12> r;
+            if (a.m_y != b.m_y)
+            {
+                return a.m_y < b.m_y;
+            }
 
-        for (auto i = 0U; i < 12; ++i)
+            return a.m_z < b.m_z;
+        }
+
+        bool close_to(const float3& a, const float3& b, float epsilon)
         {
-            r[i] = project_edge<axis>(e[i]);
+            return fabsf(a.m_x - b.m_x) <= epsilon && fabsf(a.m_y - b.m_y) <= epsilon && fabsf(a.m_z - b.m_z) <= epsilon;
         }
 
-        return r;
+        //tolerance for the welding of clipped points, relative to the size of the box
+        float weld_epsilon(const aabb& b)
+        {
+            const float3 e = b.m_max - b.m_min;
+            return 1e-5f * std::max(std::max(fabsf(e.m_x), fabsf(e.m_y)), fabsf(e.m_z));
+        }
     }
 
-    template <uint32_t axis>
-    std::array<float2, 8> project_points(const std::array<float3, 8>& p)
+    uint32_t weld(float3* points, uint32_t count, float epsilon)
     {
-        std::array<float2, 8> r;
-
-        for (auto i = 0U; i < 8; ++i)
+        //adding zero turns -0.0f into +0.0f, so the sort is deterministic
+        for (auto i = 0U; i < count; ++i)
         {
-            r[i] = project_point<axis>(p[i]);
+            points[i] = { points[i].m_x + 0.0f, points[i].m_y + 0.0f, points[i].m_z + 0.0f };
         }
 
-        return r;
-    }
+        //the usual 8-20 points are sorted faster by insertion
+        if (count <= 32)
+        {
+            for (auto i = 1U; i < count; ++i)
+            {
+                const float3 p = points[i];
+                auto         j = i;
 
-    bool intersect_segment_plane(const float3& a, const float3& b, const plane& p, float3& r)
-    {
-        float3 ab   = b - a;
-        float  t    = (-p.m_d - dot(p.m_n, a)) / dot(p.m_n, ab);
+                for (; j > 0 && less_xyz(p, points[j - 1]); --j)
+                {
+                    points[j] = points[j - 1];
+                }
 
-        if (t > 0.0f && t < 1.0f)
-        {
-            r = a + t * ab;
-            return true;
+                points[j] = p;
+            }
         }
         else
         {
-            return false;
+            std::sort(points, points + count, less_xyz);
+        }
+
+        //the kept points stay sorted by x, so only the ones closer than epsilon along x are candidates
+        uint32_t r = 0;
+
+        for (auto i = 0U; i < count; ++i)
+        {
+            const float3 p          = points[i];
+            bool         duplicate  = false;
+
+            for (auto j = r; j > 0 && p.m_x - points[j - 1].m_x <= epsilon; --j)
+            {
+                if (close_to(p, points[j - 1], epsilon))
+                {
+                    duplicate = true;
+                    break;
+                }
+            }
+
+            if (!duplicate)
+            {
+                points[r++] = p;
+            }
         }
+
+        return r;
     }
 
     std::vector< float3 > intersection( const frustum& f, const aabb& b )
@@ -685,104 +645,922 @@ namespace computational_geometry
         std::array<plane, 6>     face_planes    = make_face_planes(f);
         uint32_t r_intersections                = 0;    //contains in the bits intersected planes
 
-        //face plane tests
+        //separating axis test
         {
-            uint32_t r_inside                   = 0;
+            const frustum_aabb_classification c = classify(make_separating_axes(f), b);
+
+            if (c == frustum_aabb_classification::outside)
+            {
+                return r;
+            }
+
+            //the box is inside all face planes
+            if (c == frustum_aabb_classification::inside)
+            {
+                return std::vector<float3>(points.begin(), points.end());
+            }
+        }
+
+        //remember the face planes which cut the box
+        for (auto i = 0U; i < 6; ++i)
+        {
+            if (intersects(points, face_planes[i]) == plane_aabb_intersection::intersection)
+            {
+                r_intersections |= (1 << i);
+            }
+        }
+
+        //test all intersected planes against the aabb edges
+        std::array<edge3d, 12>    edge_lines = make_edges(&points[0]);
+
+        fixed_vector<float3, 6 * 12> s;
+
+        for (auto i = 0U; i < 6; ++i)
+        {
+            if ((r_intersections & (1 << i)) != 0)
+            {
+                for (auto e = 0; e < 12; ++e)
+                {
+                    float3 point;
+
+                    if (intersect_segment_plane(edge_lines[e].m_a, edge_lines[e].m_b, face_planes[i], point))
+                    {
+                        s.push_back(point);
+                    }
+                }
+            }
+        }
+
+        const uint32_t size = weld(s.begin(), s.size(), weld_epsilon(b));
+        r.assign(s.begin(), s.begin() + size);
+
+        return r;
+    }
+
+    namespace
+    {
+        //normals point inside the frustum. a box is outside a plane when its farthest corner along the normal is behind it,
+        //and inside when its nearest corner is in front of it
+        frustum_aabb_classification classify(const std::array<plane, 6>& planes, const aabb& b)
+        {
+            const float3 c = 0.5f * (b.m_max + b.m_min);
+            const float3 e = 0.5f * (b.m_max - b.m_min);
+
+            bool inside_all = true;
 
             for (auto i = 0U; i < 6; ++i)
             {
-                plane_aabb_intersection section = intersects(points, face_planes[i]);
+                const plane& p  = planes[i];
+                const float d   = p.m_n.m_x * c.m_x + p.m_n.m_y * c.m_y + p.m_n.m_z * c.m_z + p.m_d;
+                const float r   = fabsf(p.m_n.m_x) * e.m_x + fabsf(p.m_n.m_y) * e.m_y + fabsf(p.m_n.m_z) * e.m_z;
+
+                if (d + r < 0.0f)
+                {
+                    return frustum_aabb_classification::outside;
+                }
+
+                inside_all = inside_all && (d - r >= 0.0f);
+            }
+
+            return inside_all ? frustum_aabb_classification::inside : frustum_aabb_classification::intersecting;
+        }
+    }
+
+    void classify(const frustum& f, const aabb* boxes, uint32_t count, frustum_aabb_classification* r)
+    {
+        const std::array<plane, 6> planes   = make_face_planes(f);
+        const __m128 half                   = _mm_set1_ps(0.5f);
+        const __m128 zero                   = _mm_setzero_ps();
+        const __m128 sign                   = _mm_set1_ps(-0.0f);
+
+        uint32_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            const aabb* b = boxes + i;
+
+            //transpose to structure of arrays, the compiler turns these into inserts
+            const __m128 min_x = _mm_setr_ps(b[0].m_min.m_x, b[1].m_min.m_x, b[2].m_min.m_x, b[3].m_min.m_x);
+            const __m128 min_y = _mm_setr_ps(b[0].m_min.m_y, b[1].m_min.m_y, b[2].m_min.m_y, b[3].m_min.m_y);
+            const __m128 min_z = _mm_setr_ps(b[0].m_min.m_z, b[1].m_min.m_z, b[2].m_min.m_z, b[3].m_min.m_z);
+
+            const __m128 max_x = _mm_setr_ps(b[0].m_max.m_x, b[1].m_max.m_x, b[2].m_max.m_x, b[3].m_max.m_x);
+            const __m128 max_y = _mm_setr_ps(b[0].m_max.m_y, b[1].m_max.m_y, b[2].m_max.m_y, b[3].m_max.m_y);
+            const __m128 max_z = _mm_setr_ps(b[0].m_max.m_z, b[1].m_max.m_z, b[2].m_max.m_z, b[3].m_max.m_z);
+
+            const __m128 c_x = _mm_mul_ps(half, _mm_add_ps(max_x, min_x));
+            const __m128 c_y = _mm_mul_ps(half, _mm_add_ps(max_y, min_y));
+            const __m128 c_z = _mm_mul_ps(half, _mm_add_ps(max_z, min_z));
+
+            const __m128 e_x = _mm_mul_ps(half, _mm_sub_ps(max_x, min_x));
+            const __m128 e_y = _mm_mul_ps(half, _mm_sub_ps(max_y, min_y));
+            const __m128 e_z = _mm_mul_ps(half, _mm_sub_ps(max_z, min_z));
+
+            __m128 outside = _mm_setzero_ps();
+            __m128 inside  = _mm_cmpeq_ps(zero, zero);
+
+            for (auto j = 0U; j < 6; ++j)
+            {
+                const __m128 n_x = _mm_set1_ps(planes[j].m_n.m_x);
+                const __m128 n_y = _mm_set1_ps(planes[j].m_n.m_y);
+                const __m128 n_z = _mm_set1_ps(planes[j].m_n.m_z);
+                const __m128 n_d = _mm_set1_ps(planes[j].m_d);
+
+                //same operation order as the scalar path, so both agree exactly
+                const __m128 d = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(n_x, c_x), _mm_mul_ps(n_y, c_y)), _mm_mul_ps(n_z, c_z)), n_d);
+                const __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign, n_x), e_x), _mm_mul_ps(_mm_andnot_ps(sign, n_y), e_y)), _mm_mul_ps(_mm_andnot_ps(sign, n_z), e_z));
+
+                outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), zero));
+                inside  = _mm_and_ps(inside, _mm_cmpge_ps(_mm_sub_ps(d, r), zero));
+            }
 
-                if (section == plane_aabb_intersection::outside)
+            const int outside_mask  = _mm_movemask_ps(outside);
+            const int inside_mask   = _mm_movemask_ps(inside);
+
+            for (auto k = 0U; k < 4; ++k)
+            {
+                if (outside_mask & (1 << k))
                 {
-                    //no intersection
-                    return r;
+                    r[i + k] = frustum_aabb_classification::outside;
                 }
-                else if (section == plane_aabb_intersection::inside)
+                else if (inside_mask & (1 << k))
                 {
-                    r_inside = r_inside + 1;
+                    r[i + k] = frustum_aabb_classification::inside;
                 }
                 else
                 {
-                    r_intersections |= (1 << i); // remember the intersection
+                    r[i + k] = frustum_aabb_classification::intersecting;
                 }
             }
+        }
 
-            //all face planes
-            if (r_inside == 6)
+        for (; i < count; ++i)
+        {
+            r[i] = classify(planes, boxes[i]);
+        }
+    }
+
+    namespace
+    {
+        void project(const float3* points, const float3& axis, float& min, float& max)
+        {
+            min = dot(axis, points[0]);
+            max = min;
+
+            for (auto i = 1U; i < 8; ++i)
             {
-                return make_points(f);
+                const float d = dot(axis, points[i]);
+                min = std::min(min, d);
+                max = std::max(max, d);
             }
         }
 
-        //edge-lines
+        float3 abs(const float3& a)
         {
-            std::array<edge3d, 12>    edge_lines  = make_edges(f);
+            return { fabsf(a.m_x), fabsf(a.m_y), fabsf(a.m_z) };
+        }
 
-            std::array<edge2d, 12>    edges_x     = project_edges<0>(edge_lines);
-            std::array<edge2d, 12>    edges_y     = project_edges<1>(edge_lines);
-            std::array<edge2d, 12>    edges_z     = project_edges<2>(edge_lines);
+        void add_axis(frustum_separating_axes& r, const frustum& f, const float3& axis)
+        {
+            const uint32_t i = r.m_count;
+
+            r.m_axes[i]     = axis;
+            r.m_abs_axes[i] = abs(axis);
+            project(f.m_points, axis, r.m_min[i], r.m_max[i]);
+            r.m_count = i + 1;
+        }
 
-            std::array<float2, 8>   points_x      = project_points<0>(points);
-            std::array<float2, 8>   points_y      = project_points<1>(points);
-            std::array<float2, 8>   points_z      = project_points<2>(points);
+        //distinct edge directions, a perspective frustum has 6 of them: 4 side edges and the 2 directions of the near and far rectangles
+        uint32_t make_edge_directions(const frustum& f, float3* r)
+        {
+            const std::array<edge3d, 12> edges = make_edges(f);
 
-            std::array<line2d, 12>  lines_x       = make_lines(edges_x);
-            std::array<line2d, 12>  lines_y       = make_lines(edges_y);
-            std::array<line2d, 12>  lines_z       = make_lines(edges_z);
+            uint32_t count = 0;
 
             for (auto i = 0U; i < 12; ++i)
             {
-                if (outside(points_x, lines_x[i]))
+                const float3 e      = edges[i].m_b - edges[i].m_a;
+                bool         unique = true;
+
+                for (auto j = 0U; j < count && unique; ++j)
+                {
+                    const float3 c = cross(e, r[j]);
+                    unique = dot(c, c) > 0.000001f * dot(e, e) * dot(r[j], r[j]);
+                }
+
+                if (unique)
                 {
-                    return r;
+                    r[count++] = e;
                 }
             }
 
-            for (auto i = 0U; i < 12; ++i)
+            return count;
+        }
+    }
+
+    frustum_separating_axes make_separating_axes(const frustum& f)
+    {
+        frustum_separating_axes r;
+
+        //face normals
+        const std::array<plane, 6> planes = make_face_planes(f);
+
+        for (auto i = 0U; i < 6; ++i)
+        {
+            add_axis(r, f, planes[i].m_n);
+
+            //the normals point inside, so the face is the lower end of the projection.
+            //projecting far points at 1e6 rounds by 0.5, the plane from the near corner does not
+            r.m_min[i] = -planes[i].m_d;
+        }
+
+        //box face normals
+        add_axis(r, f, { 1.0f, 0.0f, 0.0f });
+        add_axis(r, f, { 0.0f, 1.0f, 0.0f });
+        add_axis(r, f, { 0.0f, 0.0f, 1.0f });
+
+        std::copy(f.m_points, f.m_points + 8, r.m_points);
+
+        r.m_edges_count = make_edge_directions(f, r.m_edges);
+
+        //cross(box axis, edge), written out for the unit axes
+        for (auto i = 0U; i < r.m_edges_count; ++i)
+        {
+            const float3 e = r.m_edges[i];
+
+            add_axis(r, f, { 0.0f, -e.m_z, e.m_y });
+            add_axis(r, f, { e.m_z, 0.0f, -e.m_x });
+            add_axis(r, f, { -e.m_y, e.m_x, 0.0f });
+        }
+
+        return r;
+    }
+
+    frustum_aabb_classification classify(const frustum_separating_axes& a, const aabb& b)
+    {
+        //box axes, the box is its own projection
+        if (b.m_max.m_x < a.m_min[6] || b.m_min.m_x > a.m_max[6] ||
+            b.m_max.m_y < a.m_min[7] || b.m_min.m_y > a.m_max[7] ||
+            b.m_max.m_z < a.m_min[8] || b.m_min.m_z > a.m_max[8])
+        {
+            return frustum_aabb_classification::outside;
+        }
+
+        const float3 c = 0.5f * (b.m_max + b.m_min);
+        const float3 e = 0.5f * (b.m_max - b.m_min);
+
+        bool inside_all = true;
+
+        for (auto i = 0U; i < a.m_count; ++i)
+        {
+            //box axes are done
+            if (i == 6)
             {
-                if (outside(points_y, lines_y[i]))
+                //the box is on the inner side of all face planes, the edge axes cannot separate it
+                if (inside_all)
                 {
-                    return r;
+                    return frustum_aabb_classification::inside;
                 }
+
+                i = 9;
             }
 
-            for (auto i = 0U; i < 12; ++i)
+            const float3& n = a.m_axes[i];
+            const float3& m = a.m_abs_axes[i];
+
+            const float d   = n.m_x * c.m_x + n.m_y * c.m_y + n.m_z * c.m_z;
+            const float r   = m.m_x * e.m_x + m.m_y * e.m_y + m.m_z * e.m_z;
+
+            if (d + r < a.m_min[i] || d - r > a.m_max[i])
+            {
+                return frustum_aabb_classification::outside;
+            }
+
+            if (i < 6)
+            {
+                inside_all = inside_all && (d - r >= a.m_min[i]);
+            }
+        }
+
+        return inside_all ? frustum_aabb_classification::inside : frustum_aabb_classification::intersecting;
+    }
+
+    namespace
+    {
+        static_assert(sizeof(aabb) == 6 * sizeof(float), "boxes are loaded as packed floats");
+
+        inline __m256 load_2x4(const float* lo, const float* hi)
+        {
+            return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(lo)), _mm_loadu_ps(hi), 1);
+        }
+
+        //transposes 8 packed boxes to structure of arrays. boxes 0-3 go to the low lanes, 4-7 to the high lanes
+        //four boxes are six registers: [a0 a1 a2 a3] [a4 a5 b0 b1] [b2 b3 b4 b5] [c0 c1 c2 c3] [c4 c5 d0 d1] [d2 d3 d4 d5]
+        inline void load_soa(const float* b, __m256& min_x, __m256& min_y, __m256& min_z, __m256& max_x, __m256& max_y, __m256& max_z)
+        {
+            const __m256 m0 = load_2x4(b + 0,  b + 24);
+            const __m256 m1 = load_2x4(b + 4,  b + 28);
+            const __m256 m2 = load_2x4(b + 8,  b + 32);
+            const __m256 m3 = load_2x4(b + 12, b + 36);
+            const __m256 m4 = load_2x4(b + 16, b + 40);
+            const __m256 m5 = load_2x4(b + 20, b + 44);
+
+            const __m256 t0 = _mm256_shuffle_ps(m0, m1, _MM_SHUFFLE(3, 2, 1, 0));   //a0 a1 b0 b1
+            const __m256 t1 = _mm256_shuffle_ps(m3, m4, _MM_SHUFFLE(3, 2, 1, 0));   //c0 c1 d0 d1
+            const __m256 t2 = _mm256_shuffle_ps(m0, m2, _MM_SHUFFLE(1, 0, 3, 2));   //a2 a3 b2 b3
+            const __m256 t3 = _mm256_shuffle_ps(m3, m5, _MM_SHUFFLE(1, 0, 3, 2));   //c2 c3 d2 d3
+            const __m256 t4 = _mm256_shuffle_ps(m1, m2, _MM_SHUFFLE(3, 2, 1, 0));   //a4 a5 b4 b5
+            const __m256 t5 = _mm256_shuffle_ps(m4, m5, _MM_SHUFFLE(3, 2, 1, 0));   //c4 c5 d4 d5
+
+            min_x = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(2, 0, 2, 0));
+            min_y = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 1, 3, 1));
+            min_z = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(2, 0, 2, 0));
+            max_x = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 1, 3, 1));
+            max_y = _mm256_shuffle_ps(t4, t5, _MM_SHUFFLE(2, 0, 2, 0));
+            max_z = _mm256_shuffle_ps(t4, t5, _MM_SHUFFLE(3, 1, 3, 1));
+        }
+
+        struct box8
+        {
+            __m256 m_c_x;
+            __m256 m_c_y;
+            __m256 m_c_z;
+
+            __m256 m_e_x;
+            __m256 m_e_y;
+            __m256 m_e_z;
+        };
+
+        //no fma: the products are rounded separately, exactly as in the scalar reference
+        inline __m256 separated(const frustum_separating_axes& a, uint32_t i, const box8& b, __m256& box_min)
+        {
+            const float3& n = a.m_axes[i];
+            const float3& m = a.m_abs_axes[i];
+
+            const __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(n.m_x), b.m_c_x), _mm256_mul_ps(_mm256_set1_ps(n.m_y), b.m_c_y)), _mm256_mul_ps(_mm256_set1_ps(n.m_z), b.m_c_z));
+            const __m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m.m_x), b.m_e_x), _mm256_mul_ps(_mm256_set1_ps(m.m_y), b.m_e_y)), _mm256_mul_ps(_mm256_set1_ps(m.m_z), b.m_e_z));
+
+            box_min = _mm256_sub_ps(d, r);
+
+            const __m256 box_max = _mm256_add_ps(d, r);
+
+            return _mm256_or_ps(_mm256_cmp_ps(box_max, _mm256_set1_ps(a.m_min[i]), _CMP_LT_OQ), _mm256_cmp_ps(box_min, _mm256_set1_ps(a.m_max[i]), _CMP_GT_OQ));
+        }
+
+        //edge axes are cross products with a box axis, so one component is zero and can be skipped.
+        //adding the zero term does not change the rounding, the result is the same as in the general case
+        template <uint32_t zero>
+        inline __m256 separated_edge_axis(const frustum_separating_axes& a, uint32_t i, const box8& b)
+        {
+            const float3& n = a.m_axes[i];
+            const float3& m = a.m_abs_axes[i];
+
+            __m256 d;
+            __m256 r;
+
+            switch (zero)
+            {
+                case 0:
+                    d = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(n.m_y), b.m_c_y), _mm256_mul_ps(_mm256_set1_ps(n.m_z), b.m_c_z));
+                    r = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m.m_y), b.m_e_y), _mm256_mul_ps(_mm256_set1_ps(m.m_z), b.m_e_z));
+                    break;
+                case 1:
+                    d = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(n.m_x), b.m_c_x), _mm256_mul_ps(_mm256_set1_ps(n.m_z), b.m_c_z));
+                    r = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m.m_x), b.m_e_x), _mm256_mul_ps(_mm256_set1_ps(m.m_z), b.m_e_z));
+                    break;
+                default:
+                    d = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(n.m_x), b.m_c_x), _mm256_mul_ps(_mm256_set1_ps(n.m_y), b.m_c_y));
+                    r = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(m.m_x), b.m_e_x), _mm256_mul_ps(_mm256_set1_ps(m.m_y), b.m_e_y));
+                    break;
+            }
+
+            return _mm256_or_ps(_mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_set1_ps(a.m_min[i]), _CMP_LT_OQ), _mm256_cmp_ps(_mm256_sub_ps(d, r), _mm256_set1_ps(a.m_max[i]), _CMP_GT_OQ));
+        }
+    }
+
+    namespace
+    {
+        //outside = 0, inside = 1, intersecting = 2. the masks are -1 or 0, pack the eight values to bytes
+        inline void store_classes(__m256 outside, __m256 inside, frustum_aabb_classification* r)
+        {
+            const __m256i c     = _mm256_andnot_si256(_mm256_castps_si256(outside), _mm256_add_epi32(_mm256_set1_epi32(2), _mm256_castps_si256(inside)));
+            const __m128i c16   = _mm_packs_epi32(_mm256_castsi256_si128(c), _mm256_extracti128_si256(c, 1));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(r), _mm_packus_epi16(c16, c16));
+        }
+    }
+
+    void classify(const frustum_separating_axes& a, const aabb* boxes, uint32_t count, frustum_aabb_classification* r)
+    {
+        static_assert(sizeof(frustum_aabb_classification) == 1, "the classes are stored as packed bytes");
+
+        const __m256 half = _mm256_set1_ps(0.5f);
+
+        uint32_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+            const float* b = &boxes[i].m_min.m_x;
+
+            __m256 min_x;
+            __m256 min_y;
+            __m256 min_z;
+
+            __m256 max_x;
+            __m256 max_y;
+            __m256 max_z;
+
+            load_soa(b, min_x, min_y, min_z, max_x, max_y, max_z);
+
+            //box axes
+            __m256 outside = _mm256_or_ps(
+                _mm256_or_ps(_mm256_or_ps(_mm256_cmp_ps(max_x, _mm256_set1_ps(a.m_min[6]), _CMP_LT_OQ), _mm256_cmp_ps(min_x, _mm256_set1_ps(a.m_max[6]), _CMP_GT_OQ)),
+                             _mm256_or_ps(_mm256_cmp_ps(max_y, _mm256_set1_ps(a.m_min[7]), _CMP_LT_OQ), _mm256_cmp_ps(min_y, _mm256_set1_ps(a.m_max[7]), _CMP_GT_OQ))),
+                             _mm256_or_ps(_mm256_cmp_ps(max_z, _mm256_set1_ps(a.m_min[8]), _CMP_LT_OQ), _mm256_cmp_ps(min_z, _mm256_set1_ps(a.m_max[8]), _CMP_GT_OQ)));
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+            if (_mm256_movemask_ps(outside) != 0xff)
             {
-                if (outside(points_y, lines_y[i]))
+                box8 box;
+
+                box.m_c_x = _mm256_mul_ps(half, _mm256_add_ps(max_x, min_x));
+                box.m_c_y = _mm256_mul_ps(half, _mm256_add_ps(max_y, min_y));
+                box.m_c_z = _mm256_mul_ps(half, _mm256_add_ps(max_z, min_z));
+
+                box.m_e_x = _mm256_mul_ps(half, _mm256_sub_ps(max_x, min_x));
+                box.m_e_y = _mm256_mul_ps(half, _mm256_sub_ps(max_y, min_y));
+                box.m_e_z = _mm256_mul_ps(half, _mm256_sub_ps(max_z, min_z));
+
+                //face planes
+                for (auto j = 0U; j < 6; ++j)
                 {
-                    return r;
+                    __m256 box_min;
+                    outside = _mm256_or_ps(outside, separated(a, j, box, box_min));
+                    inside  = _mm256_and_ps(inside, _mm256_cmp_ps(box_min, _mm256_set1_ps(a.m_min[j]), _CMP_GE_OQ));
+                }
+
+                //edge axes, only for the boxes which straddle a face plane
+                if (_mm256_movemask_ps(_mm256_or_ps(outside, inside)) != 0xff)
+                {
+                    __m256 edge_outside = _mm256_setzero_ps();
+
+                    for (auto j = 9U; j < a.m_count; j += 3)
+                    {
+                        edge_outside = _mm256_or_ps(edge_outside, separated_edge_axis<0>(a, j + 0, box));
+                        edge_outside = _mm256_or_ps(edge_outside, separated_edge_axis<1>(a, j + 1, box));
+                        edge_outside = _mm256_or_ps(edge_outside, separated_edge_axis<2>(a, j + 2, box));
+                    }
+
+                    outside = _mm256_or_ps(outside, _mm256_andnot_ps(inside, edge_outside));
                 }
             }
+
+            store_classes(outside, inside, r + i);
         }
 
-        //test all intersected planes against the aabb edges
-        std::array<edge3d, 12>    edge_lines = make_edges(&points[0]);
+        for (; i < count; ++i)
+        {
+            r[i] = classify(a, boxes[i]);
+        }
+    }
 
-        std::unordered_set<float3> s;
+    namespace
+    {
+        //|n.u0| e0 + |n.u1| e1 + |n.u2| e2, the half length of the box projected on n
+        float radius(const obb& b, const float3& n)
+        {
+            return fabsf(dot(n, b.m_axes[0])) * b.m_extents.m_x + fabsf(dot(n, b.m_axes[1])) * b.m_extents.m_y + fabsf(dot(n, b.m_axes[2])) * b.m_extents.m_z;
+        }
 
+        float extent(const obb& b, uint32_t axis)
+        {
+            return axis == 0 ? b.m_extents.m_x : (axis == 1 ? b.m_extents.m_y : b.m_extents.m_z);
+        }
+
+        //the cross product of parallel directions is not an axis
+        float parallel_threshold(const float3& a, const float3& b)
+        {
+            return 0.000001f * dot(a, a) * dot(b, b);
+        }
+    }
+
+    frustum_aabb_classification classify(const frustum_separating_axes& a, const obb& b)
+    {
+        bool inside_all = true;
+
+        //face planes
         for (auto i = 0U; i < 6; ++i)
         {
-            if ((r_intersections & (1 << i)) != 0)
+            const float d = dot(a.m_axes[i], b.m_center);
+            const float r = radius(b, a.m_axes[i]);
+
+            if (d + r < a.m_min[i] || d - r > a.m_max[i])
             {
-                for (auto e = 0; e < 12; ++e)
+                return frustum_aabb_classification::outside;
+            }
+
+            inside_all = inside_all && (d - r >= a.m_min[i]);
+        }
+
+        //the box is on the inner side of all face planes, the other axes cannot separate it
+        if (inside_all)
+        {
+            return frustum_aabb_classification::inside;
+        }
+
+        //box axes, the box is its own projection
+        for (auto k = 0U; k < 3; ++k)
+        {
+            float min;
+            float max;
+
+            project(a.m_points, b.m_axes[k], min, max);
+
+            const float d = dot(b.m_axes[k], b.m_center);
+            const float e = extent(b, k);
+
+            if (d + e < min || d - e > max)
+            {
+                return frustum_aabb_classification::outside;
+            }
+        }
+
+        //box axes crossed with the frustum edges
+        for (auto j = 0U; j < a.m_edges_count; ++j)
+        {
+            const float threshold = parallel_threshold(a.m_edges[j], { 1.0f, 0.0f, 0.0f });
+
+            for (auto k = 0U; k < 3; ++k)
+            {
+                const float3 n = cross(b.m_axes[k], a.m_edges[j]);
+
+                if (dot(n, n) <= threshold)
                 {
-                    float3 point;
+                    continue;
+                }
 
-                    if (intersect_segment_plane(edge_lines[e].m_a, edge_lines[e].m_b, face_planes[i], point))
+                float min;
+                float max;
+
+                project(a.m_points, n, min, max);
+
+                const float d = dot(n, b.m_center);
+                const float r = radius(b, n);
+
+                if (d + r < min || d - r > max)
+                {
+                    return frustum_aabb_classification::outside;
+                }
+            }
+        }
+
+        return frustum_aabb_classification::intersecting;
+    }
+
+    namespace
+    {
+        static_assert(sizeof(obb) == 15 * sizeof(float), "boxes are gathered as packed floats");
+
+        struct obb8
+        {
+            __m256 m_c[3];
+            __m256 m_u[3][3];   //axis, component
+            __m256 m_e[3];
+        };
+
+        inline void load(const obb* boxes, obb8& r)
+        {
+            const __m256i offsets   = _mm256_setr_epi32(0, 15, 30, 45, 60, 75, 90, 105);
+            const float*  b         = &boxes->m_center.m_x;
+
+            for (auto i = 0U; i < 3; ++i)
+            {
+                r.m_c[i] = _mm256_i32gather_ps(b + i, offsets, 4);
+                r.m_e[i] = _mm256_i32gather_ps(b + 12 + i, offsets, 4);
+
+                for (auto j = 0U; j < 3; ++j)
+                {
+                    r.m_u[i][j] = _mm256_i32gather_ps(b + 3 + 3 * i + j, offsets, 4);
+                }
+            }
+        }
+
+        //no fma, the products are rounded separately like in the scalar reference
+        inline __m256 dot8(__m256 ax, __m256 ay, __m256 az, __m256 bx, __m256 by, __m256 bz)
+        {
+            return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax, bx), _mm256_mul_ps(ay, by)), _mm256_mul_ps(az, bz));
+        }
+
+        inline __m256 abs8(__m256 a)
+        {
+            return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);
+        }
+
+        inline __m256 radius8(const obb8& b, __m256 nx, __m256 ny, __m256 nz)
+        {
+            const __m256 r0 = _mm256_mul_ps(abs8(dot8(nx, ny, nz, b.m_u[0][0], b.m_u[0][1], b.m_u[0][2])), b.m_e[0]);
+            const __m256 r1 = _mm256_mul_ps(abs8(dot8(nx, ny, nz, b.m_u[1][0], b.m_u[1][1], b.m_u[1][2])), b.m_e[1]);
+            const __m256 r2 = _mm256_mul_ps(abs8(dot8(nx, ny, nz, b.m_u[2][0], b.m_u[2][1], b.m_u[2][2])), b.m_e[2]);
+
+            return _mm256_add_ps(_mm256_add_ps(r0, r1), r2);
+        }
+
+        //interval of the eight points on eight axes
+        inline void project8(const float3* points, __m256 nx, __m256 ny, __m256 nz, __m256& min, __m256& max)
+        {
+            min = dot8(nx, ny, nz, _mm256_set1_ps(points[0].m_x), _mm256_set1_ps(points[0].m_y), _mm256_set1_ps(points[0].m_z));
+            max = min;
+
+            for (auto i = 1U; i < 8; ++i)
+            {
+                const __m256 d = dot8(nx, ny, nz, _mm256_set1_ps(points[i].m_x), _mm256_set1_ps(points[i].m_y), _mm256_set1_ps(points[i].m_z));
+
+                min = _mm256_min_ps(min, d);
+                max = _mm256_max_ps(max, d);
+            }
+        }
+
+        inline __m256 separated8(__m256 d, __m256 r, __m256 min, __m256 max)
+        {
+            return _mm256_or_ps(_mm256_cmp_ps(_mm256_add_ps(d, r), min, _CMP_LT_OQ), _mm256_cmp_ps(_mm256_sub_ps(d, r), max, _CMP_GT_OQ));
+        }
+    }
+
+    void classify(const frustum_separating_axes& a, const obb* boxes, uint32_t count, frustum_aabb_classification* r)
+    {
+        uint32_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+            obb8 b;
+            load(boxes + i, b);
+
+            __m256 outside  = _mm256_setzero_ps();
+            __m256 inside   = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+            //face planes
+            for (auto j = 0U; j < 6; ++j)
+            {
+                const __m256 nx     = _mm256_set1_ps(a.m_axes[j].m_x);
+                const __m256 ny     = _mm256_set1_ps(a.m_axes[j].m_y);
+                const __m256 nz     = _mm256_set1_ps(a.m_axes[j].m_z);
+
+                const __m256 d      = dot8(nx, ny, nz, b.m_c[0], b.m_c[1], b.m_c[2]);
+                const __m256 e      = radius8(b, nx, ny, nz);
+                const __m256 min    = _mm256_set1_ps(a.m_min[j]);
+
+                outside = _mm256_or_ps(outside, separated8(d, e, min, _mm256_set1_ps(a.m_max[j])));
+                inside  = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_sub_ps(d, e), min, _CMP_GE_OQ));
+            }
+
+            //the other axes, only for the boxes which straddle a face plane
+            if (_mm256_movemask_ps(_mm256_or_ps(outside, inside)) != 0xff)
+            {
+                __m256 axis_outside = _mm256_setzero_ps();
+
+                //box axes
+                for (auto k = 0U; k < 3; ++k)
+                {
+                    __m256 min;
+                    __m256 max;
+
+                    project8(a.m_points, b.m_u[k][0], b.m_u[k][1], b.m_u[k][2], min, max);
+
+                    const __m256 d = dot8(b.m_u[k][0], b.m_u[k][1], b.m_u[k][2], b.m_c[0], b.m_c[1], b.m_c[2]);
+                    axis_outside = _mm256_or_ps(axis_outside, separated8(d, b.m_e[k], min, max));
+                }
+
+                //box axes crossed with the frustum edges
+                for (auto j = 0U; j < a.m_edges_count; ++j)
+                {
+                    const __m256 ex         = _mm256_set1_ps(a.m_edges[j].m_x);
+                    const __m256 ey         = _mm256_set1_ps(a.m_edges[j].m_y);
+                    const __m256 ez         = _mm256_set1_ps(a.m_edges[j].m_z);
+                    const __m256 threshold  = _mm256_set1_ps(parallel_threshold(a.m_edges[j], { 1.0f, 0.0f, 0.0f }));
+
+                    for (auto k = 0U; k < 3; ++k)
                     {
-                        s.insert(point);
+                        const __m256 nx = _mm256_sub_ps(_mm256_mul_ps(b.m_u[k][1], ez), _mm256_mul_ps(b.m_u[k][2], ey));
+                        const __m256 ny = _mm256_sub_ps(_mm256_mul_ps(b.m_u[k][2], ex), _mm256_mul_ps(b.m_u[k][0], ez));
+                        const __m256 nz = _mm256_sub_ps(_mm256_mul_ps(b.m_u[k][0], ey), _mm256_mul_ps(b.m_u[k][1], ex));
+
+                        const __m256 axis = _mm256_cmp_ps(dot8(nx, ny, nz, nx, ny, nz), threshold, _CMP_GT_OQ);
+
+                        __m256 min;
+                        __m256 max;
+
+                        project8(a.m_points, nx, ny, nz, min, max);
+
+                        const __m256 d = dot8(nx, ny, nz, b.m_c[0], b.m_c[1], b.m_c[2]);
+                        const __m256 e = radius8(b, nx, ny, nz);
+
+                        axis_outside = _mm256_or_ps(axis_outside, _mm256_and_ps(axis, separated8(d, e, min, max)));
                     }
                 }
+
+                outside = _mm256_or_ps(outside, _mm256_andnot_ps(inside, axis_outside));
             }
+
+            store_classes(outside, inside, r + i);
         }
 
-        for (auto&& s0 : s)
+        for (; i < count; ++i)
         {
-            r.push_back(s0);
+            r[i] = classify(a, boxes[i]);
         }
+    }
 
-        return r;
+    namespace
+    {
+        //the separating axes of a frustum pair beyond the faces of a: the face normals of b, then the edges of a crossed with the edges of b
+        struct frustum_pair_axes
+        {
+            static constexpr uint32_t max_axes = 6 + frustum_separating_axes::max_edges * frustum_separating_axes::max_edges;
+            static constexpr uint32_t capacity = (max_axes + 7) & ~7U;    //whole registers
+
+            alignas(32) float       m_x[capacity];
+            alignas(32) float       m_y[capacity];
+            alignas(32) float       m_z[capacity];
+            uint32_t                m_count = 0;
+
+            std::array<plane, 6>    m_planes;       //faces of b
+
+            //the intervals of a and b on the axes
+            alignas(32) float       m_min_a[capacity];
+            alignas(32) float       m_max_a[capacity];
+            alignas(32) float       m_min_b[capacity];
+            alignas(32) float       m_max_b[capacity];
+        };
+
+        void add_axis(frustum_pair_axes& r, const float3& axis)
+        {
+            r.m_x[r.m_count] = axis.m_x;
+            r.m_y[r.m_count] = axis.m_y;
+            r.m_z[r.m_count] = axis.m_z;
+            r.m_count++;
+        }
+
+        void make_pair_axes(const frustum_separating_axes& a, const frustum& b, frustum_pair_axes& r)
+        {
+            r.m_count   = 0;
+            r.m_planes  = make_face_planes(b);
+
+            for (auto i = 0U; i < 6; ++i)
+            {
+                add_axis(r, r.m_planes[i].m_n);
+            }
+
+            float3          edges[frustum_separating_axes::max_edges];
+            const uint32_t  edges_count = make_edge_directions(b, edges);
+
+            for (auto i = 0U; i < a.m_edges_count; ++i)
+            {
+                for (auto j = 0U; j < edges_count; ++j)
+                {
+                    const float3 n = cross(a.m_edges[i], edges[j]);
+
+                    if (dot(n, n) > parallel_threshold(a.m_edges[i], edges[j]))
+                    {
+                        add_axis(r, n);
+                    }
+                }
+            }
+
+            //zero padding up to a whole register, the padding lanes are projected and ignored
+            for (auto i = r.m_count; i % 8 != 0; ++i)
+            {
+                r.m_x[i] = 0.0f;
+                r.m_y[i] = 0.0f;
+                r.m_z[i] = 0.0f;
+            }
+        }
+
+        //b on the faces of a, where a is known exactly. intersecting means that the other axes decide
+        frustum_aabb_classification classify_faces(const frustum_separating_axes& a, const float* min_b, const float* max_b)
+        {
+            bool inside_all = true;
+
+            for (auto i = 0U; i < 6; ++i)
+            {
+                if (max_b[i] < a.m_min[i] || min_b[i] > a.m_max[i])
+                {
+                    return frustum_aabb_classification::outside;
+                }
+
+                inside_all = inside_all && (min_b[i] >= a.m_min[i]);
+            }
+
+            //b is on the inner side of all face planes, the other axes cannot separate it
+            return inside_all ? frustum_aabb_classification::inside : frustum_aabb_classification::intersecting;
+        }
+
+        //a and b are separated, when their intervals do not overlap on one axis
+        frustum_aabb_classification classify_axes(const frustum_pair_axes& p)
+        {
+            //faces of b, the lower end of b is its plane
+            for (auto i = 0U; i < 6; ++i)
+            {
+                if (p.m_max_a[i] < -p.m_planes[i].m_d || p.m_min_a[i] > p.m_max_b[i])
+                {
+                    return frustum_aabb_classification::outside;
+                }
+            }
+
+            for (auto i = 6U; i < p.m_count; ++i)
+            {
+                if (p.m_max_a[i] < p.m_min_b[i] || p.m_min_a[i] > p.m_max_b[i])
+                {
+                    return frustum_aabb_classification::outside;
+                }
+            }
+
+            return frustum_aabb_classification::intersecting;
+        }
+    }
+
+    frustum_aabb_classification classify(const frustum_separating_axes& a, const frustum& b)
+    {
+        float min_b[6];
+        float max_b[6];
+
+        for (auto i = 0U; i < 6; ++i)
+        {
+            project(b.m_points, a.m_axes[i], min_b[i], max_b[i]);
+        }
+
+        const frustum_aabb_classification c = classify_faces(a, min_b, max_b);
+
+        if (c != frustum_aabb_classification::intersecting)
+        {
+            return c;
+        }
+
+        frustum_pair_axes p;
+
+        make_pair_axes(a, b, p);
+
+        for (auto i = 0U; i < p.m_count; ++i)
+        {
+            const float3 n = { p.m_x[i], p.m_y[i], p.m_z[i] };
+
+            project(a.m_points, n, p.m_min_a[i], p.m_max_a[i]);
+            project(b.m_points, n, p.m_min_b[i], p.m_max_b[i]);
+        }
+
+        return classify_axes(p);
+    }
+
+    void classify(const frustum_separating_axes& a, const frustum* frusta, uint32_t count, frustum_aabb_classification* r)
+    {
+        //the six faces of a in one register, the last two lanes repeat a face
+        const __m256 fx = _mm256_setr_ps(a.m_axes[0].m_x, a.m_axes[1].m_x, a.m_axes[2].m_x, a.m_axes[3].m_x, a.m_axes[4].m_x, a.m_axes[5].m_x, a.m_axes[5].m_x, a.m_axes[5].m_x);
+        const __m256 fy = _mm256_setr_ps(a.m_axes[0].m_y, a.m_axes[1].m_y, a.m_axes[2].m_y, a.m_axes[3].m_y, a.m_axes[4].m_y, a.m_axes[5].m_y, a.m_axes[5].m_y, a.m_axes[5].m_y);
+        const __m256 fz = _mm256_setr_ps(a.m_axes[0].m_z, a.m_axes[1].m_z, a.m_axes[2].m_z, a.m_axes[3].m_z, a.m_axes[4].m_z, a.m_axes[5].m_z, a.m_axes[5].m_z, a.m_axes[5].m_z);
+
+        //~4kb of axes and intervals, built per frustum in the same storage
+        frustum_pair_axes p;
+
+        for (auto i = 0U; i < count; ++i)
+        {
+            const frustum& b = frusta[i];
+
+            alignas(32) float min_b[8];
+            alignas(32) float max_b[8];
+
+            __m256 min;
+            __m256 max;
+
+            project8(b.m_points, fx, fy, fz, min, max);
+            _mm256_store_ps(min_b, min);
+            _mm256_store_ps(max_b, max);
+
+            r[i] = classify_faces(a, min_b, max_b);
+
+            if (r[i] != frustum_aabb_classification::intersecting)
+            {
+                continue;
+            }
+
+            make_pair_axes(a, b, p);
+
+            //eight axes at a time
+            for (auto j = 0U; j < p.m_count; j += 8)
+            {
+                const __m256 nx = _mm256_load_ps(p.m_x + j);
+                const __m256 ny = _mm256_load_ps(p.m_y + j);
+                const __m256 nz = _mm256_load_ps(p.m_z + j);
+
+                project8(a.m_points, nx, ny, nz, min, max);
+                _mm256_store_ps(p.m_min_a + j, min);
+                _mm256_store_ps(p.m_max_a + j, max);
+
+                project8(b.m_points, nx, ny, nz, min, max);
+                _mm256_store_ps(p.m_min_b + j, min);
+                _mm256_store_ps(p.m_max_b + j, max);
+            }
+
+            r[i] = classify_axes(p);
+        }
     }
 
     namespace
@@ -885,7 +1663,7 @@ namespace computational_geometry
 
         r.reserve(24);
 
-        std::unordered_set<float3> s;
+        fixed_vector<float3, 12 * 6 * 4> s;
 
         for (auto i = 0U; i < 12; ++i)
         {
@@ -910,32 +1688,37 @@ namespace computational_geometry
                     v2 = v2 - d;
                     v3 = v3 - d;
 
-                    s.insert(v0);
+                    s.push_back(v0);
                     r.push_back(v0);
 
                     if (clipped > 1)
                     {
-                        s.insert(v1);
+                        s.push_back(v1);
                         r.push_back(v1);
                     }
 
                     if (clipped > 2)
                     {
-                        s.insert(v2);
+                        s.push_back(v2);
                         r.push_back(v2);
                     }
 
                     if (clipped > 3)
                     {
-                        s.insert(v3);
+                        s.push_back(v3);
                         r.push_back(v3);
                     }
                 }
             }
         }
         r.clear();
-        for (auto&& s0 : s)
+
+        const uint32_t size = weld(s.begin(), s.size(), weld_epsilon(b));
+
+        for (auto i = 0U; i < size; ++i)
         {
+            const float3 s0 = s[i];
+
             bool inside = true;
 
             for (auto j = 0U; j < 6; ++j)
@@ -1,11 +1,20 @@
 #pragma once
 
+#if defined(_MSC_VER)
 #include <intrin.h>
+#else
+#include <immintrin.h>
+#define __assume(x) ((x) ? (void)0 : __builtin_unreachable())
+#endif
+
 #include <cstdint>
+#include <math.h>
 #include <vector>
 #include <array>
 #include <optional>
 
+#include "fixed_vector.h"
+
 namespace computational_geometry
 {
     struct float3
@@ -25,7 +34,7 @@ namespace computational_geometry
             return { m_z, m_x, m_y };
         }
 
-        template <uint32 i> float index() const
+        template <uint32_t i> float index() const
         {
             switch (i)
             {
@@ -240,10 +249,11 @@ namespace computational_geometry
         //Consistency check, these planes should be like the other ones
         plane  near0 = make_plane(f.m_points[frustum_points::NearTopRight], f.m_points[frustum_points::NearBottomLeft], f.m_points[frustum_points::NearBottomRight]);
         plane  far0 = make_plane(f.m_points[frustum_points::FarTopRight], f.m_points[frustum_points::FarBottomRight], f.m_points[frustum_points::FarBottomLeft]);
-        plane  left0 = make_plane(f.m_points[frustum_points::FarTopLeft], f.m_points[frustum_points::NearBottomLeft], f.m_points[frustum_points::NearTopLeft]);
-        plane  right0 = make_plane(f.m_points[frustum_points::FarTopRight], f.m_points[frustum_points::NearBottomRight], f.m_points[frustum_points::FarBottomRight]);
-        plane  top0 = make_plane(f.m_points[frustum_points::FarTopLeft], f.m_points[frustum_points::NearTopRight], f.m_points[frustum_points::FarTopRight]);
-        plane  bottom0 = make_plane(f.m_points[frustum_points::FarBottomLeft], f.m_points[frustum_points::NearBottomRight], f.m_points[frustum_points::NearBottomLeft]);
+        //the side planes span a near edge and a side edge from a near corner, two long edges from a far corner cancel for far planes at 1e5 and more
+        plane  left0 = make_plane(f.m_points[frustum_points::NearBottomLeft], f.m_points[frustum_points::NearTopLeft], f.m_points[frustum_points::FarBottomLeft]);
+        plane  right0 = make_plane(f.m_points[frustum_points::NearBottomRight], f.m_points[frustum_points::FarBottomRight], f.m_points[frustum_points::NearTopRight]);
+        plane  top0 = make_plane(f.m_points[frustum_points::NearTopLeft], f.m_points[frustum_points::NearTopRight], f.m_points[frustum_points::FarTopLeft]);
+        plane  bottom0 = make_plane(f.m_points[frustum_points::NearBottomLeft], f.m_points[frustum_points::FarBottomLeft], f.m_points[frustum_points::NearBottomRight]);
 
         r[frustum_planes::Left] = left0;
         r[frustum_planes::Right] = right0;
@@ -280,8 +290,72 @@ namespace computational_geometry
         return r;
     }
 
+    aabb make_aabb(const frustum& f);
     std::vector< float3 > intersection(const frustum& f, const aabb& b);
 
+    //merges points closer than epsilon in every component, in place, without allocations. returns the new count
+    //the kept points are sorted and do not depend on the input order
+    uint32_t weld(float3* points, uint32_t count, float epsilon);
+
+    enum class frustum_aabb_classification : uint8_t
+    {
+        outside         = 0,
+        inside          = 1,
+        intersecting    = 2
+    };
+
+    //plane tests of many boxes against the frustum, four boxes at a time
+    //conservative: a box reported as intersecting can still be outside, when it straddles the extension of a face plane
+    void classify(const frustum& f, const aabb* boxes, uint32_t count, frustum_aabb_classification* r);
+
+    //separating axes of a frustum against axis aligned boxes, built once per frustum and shared by the batch tests
+    //the first 6 axes are the inward face normals, then the 3 box axes, then the box axes crossed with the distinct frustum edge directions
+    struct frustum_separating_axes
+    {
+        static constexpr uint32_t max_edges = 12;
+        static constexpr uint32_t max_axes  = 6 + 3 + 3 * max_edges;
+
+        float3      m_points[8];            //the frustum, projected on the axes which depend on the other body
+        float3      m_edges[max_edges];     //distinct edge directions
+        uint32_t    m_edges_count = 0;
+
+        float3      m_axes[max_axes];
+        float3      m_abs_axes[max_axes];
+        float       m_min[max_axes];        //projection interval of the frustum on the axis
+        float       m_max[max_axes];
+        uint32_t    m_count = 0;
+    };
+
+    frustum_separating_axes make_separating_axes(const frustum& f);
+
+    //exact separating axis test, the scalar reference
+    frustum_aabb_classification classify(const frustum_separating_axes& a, const aabb& b);
+
+    //avx2, eight boxes at a time. agrees exactly with the scalar reference
+    void classify(const frustum_separating_axes& a, const aabb* boxes, uint32_t count, frustum_aabb_classification* r);
+
+    //oriented box, rotated props are tested without growing them to a world aabb
+    struct obb
+    {
+        float3 m_center;
+        float3 m_axes[3];       //orthonormal
+        float3 m_extents;       //half sizes along the axes
+    };
+
+    //exact separating axis test of an oriented box: the frustum face normals, the box axes and the box axes crossed with the frustum edges.
+    //27 axes against a perspective frustum, 18 against a box shaped one. axes of parallel edges are skipped
+    frustum_aabb_classification classify(const frustum_separating_axes& a, const obb& b);
+
+    //avx2, eight boxes at a time. agrees exactly with the scalar reference
+    void classify(const frustum_separating_axes& a, const obb* boxes, uint32_t count, frustum_aabb_classification* r);
+
+    //exact separating axis test of two frusta: the face normals of both and their edges crossed, 48 axes for two perspective frusta.
+    //inside means that b is inside of a
+    frustum_aabb_classification classify(const frustum_separating_axes& a, const frustum& b);
+
+    //avx2, projects eight axes at a time. agrees exactly with the scalar reference
+    void classify(const frustum_separating_axes& a, const frustum* frusta, uint32_t count, frustum_aabb_classification* r);
+
     struct convex_polyhedron
     {
         struct polygon
@@ -293,7 +367,7 @@ namespace computational_geometry
         std::vector<polygon>    m_faces;
     };
     
-    struct convex_triangulated_polyhedron : convex_polyhedron
+    struct convex_triangulated_polyhedron
     {
         struct polygon
         {
@@ -304,15 +378,164 @@ namespace computational_geometry
         std::vector<polygon>    m_faces;
     };
 
+    //fixed capacity polyhedron for the per frame paths, which must not allocate
+    //faces are ranges in one flat index list
+    struct fixed_convex_polyhedron
+    {
+        static constexpr uint32_t max_points    = 64;
+        static constexpr uint32_t max_faces     = 32;
+        static constexpr uint32_t max_indices   = 192;
+
+        struct polygon
+        {
+            uint32_t m_offset = 0;
+            uint32_t m_size   = 0;
+        };
+
+        fixed_vector<float3,   max_points>      m_points;
+        fixed_vector<polygon,  max_faces>       m_faces;
+        fixed_vector<uint32_t, max_indices>     m_indices;
+    };
+
+    //uniform access to the topology of both polyhedron representations
+    inline uint32_t point_count(const convex_polyhedron& p)
+    {
+        return static_cast<uint32_t>(p.m_points.size());
+    }
+
+    inline uint32_t face_count(const convex_polyhedron& p)
+    {
+        return static_cast<uint32_t>(p.m_faces.size());
+    }
+
+    inline uint32_t face_size(const convex_polyhedron& p, uint32_t face)
+    {
+        return static_cast<uint32_t>(p.m_faces[face].m_indices.size());
+    }
+
+    inline uint32_t face_index(const convex_polyhedron& p, uint32_t face, uint32_t i)
+    {
+        return p.m_faces[face].m_indices[i];
+    }
+
+    inline uint32_t point_count(const fixed_convex_polyhedron& p)
+    {
+        return p.m_points.size();
+    }
+
+    inline uint32_t face_count(const fixed_convex_polyhedron& p)
+    {
+        return p.m_faces.size();
+    }
+
+    inline uint32_t face_size(const fixed_convex_polyhedron& p, uint32_t face)
+    {
+        return p.m_faces[face].m_size;
+    }
+
+    inline uint32_t face_index(const fixed_convex_polyhedron& p, uint32_t face, uint32_t i)
+    {
+        return p.m_indices[p.m_faces[face].m_offset + i];
+    }
+
+    convex_polyhedron make_convex_polyhedron(const fixed_convex_polyhedron& p);
+
+    //no polyhedron if the intersection is empty. a clip beyond the fixed storage of the clipper,
+    //256 vertices, 256 edges, 64 faces of at most 32 edges, an output of 64 points and 32 faces, is redone on the heap
     std::optional< convex_polyhedron > clip(const frustum& f, const aabb& b);
     std::optional< convex_polyhedron > clip(const convex_polyhedron& f, const aabb& b);
 
-    //move vector facing polygons along the vector up to the clip_body. alpha is the diagonal of the clip_body
-    convex_polyhedron convex_hull_with_direction(const convex_polyhedron& body, const float3& vector);
-    convex_polyhedron convex_hull_with_point(const convex_polyhedron& body, const float3& point);
-    convex_polyhedron convex_hull_with_direction(const convex_polyhedron& body, const float3& vector, const aabb& clip_body);
+    //allocation free variants, return false if the intersection is empty or does not fit the fixed storage
+    bool clip(const frustum& f, const aabb& b, fixed_convex_polyhedron& r);
+    bool clip(const fixed_convex_polyhedron& f, const aabb& b, fixed_convex_polyhedron& r);
+
+    //flat output of a batch of clips, reuse it between the frames to keep the capacity
+    struct clip_batch
+    {
+        struct polyhedron
+        {
+            uint32_t m_box              = 0;    //index of the box in the batch input
+            uint32_t m_points_offset    = 0;
+            uint32_t m_points_size      = 0;
+            uint32_t m_faces_offset     = 0;
+            uint32_t m_faces_size       = 0;
+        };
 
+        std::vector<float3>                             m_points;
+        std::vector<fixed_convex_polyhedron::polygon>   m_faces;    //ranges in m_indices
+        std::vector<uint32_t>                           m_indices;  //relative to m_points_offset of the polyhedron
+        std::vector<polyhedron>                         m_polyhedra;
+
+        void clear()
+        {
+            m_points.clear();
+            m_faces.clear();
+            m_indices.clear();
+            m_polyhedra.clear();
+        }
+    };
+
+    //clips the frustum with every box and appends the non empty results to r.
+    //boxes fully inside the frustum are emitted directly, only the intersecting ones go through the clipper.
+    void clip(const frustum& f, const aabb* boxes, uint32_t count, clip_batch& r);
+
+    //a job of the batch, clips the boxes [first, first + count) and indexes the results in the whole batch.
+    //the clipper state is per thread and the axes are read only, so jobs of disjoint ranges run on different threads into different batches
+    void clip(const frustum& f, const frustum_separating_axes& axes, const aabb* boxes, uint32_t first, uint32_t count, clip_batch& r);
+
+    //outward face planes and edge adjacency of a body. compute it once and share it between the extrusions of the body, one per cascade
+    struct convex_polyhedron_adjacency
+    {
+        plane       m_planes[fixed_convex_polyhedron::max_faces];       //outward normals
+        bool        m_reversed[fixed_convex_polyhedron::max_faces];     //the face is wound clockwise seen from outside
+        uint32_t    m_offsets[fixed_convex_polyhedron::max_faces];      //first edge of the face in m_neighbors
+        uint8_t     m_neighbors[fixed_convex_polyhedron::max_indices];  //face across the edge from vertex i to i + 1 of the outward winding
+        float3      m_center;
+        float       m_extent = 0.0f;                                    //diagonal of the bounding box
+    };
+
+    //returns false if the body does not fit the fixed storage or is not closed
+    bool make_adjacency(const fixed_convex_polyhedron& body, convex_polyhedron_adjacency& r);
+
+    //move vector facing polygons along the vector up to the clip_body. alpha is the diagonal of the clip_body.
+    //no polyhedron if the body is not closed or the extrusion does not fit the fixed storage of the allocation free variants below
+    std::optional< convex_polyhedron > convex_hull_with_direction(const convex_polyhedron& body, const float3& vector);
+
+    //extrusion of the body along the vector, the caster volume of a directional light. faces are wound counter clockwise seen from outside.
+    //returns false if the result does not fit the fixed storage
+    bool convex_hull_with_direction(const fixed_convex_polyhedron& body, const float3& vector, fixed_convex_polyhedron& r);
+    bool convex_hull_with_direction(const fixed_convex_polyhedron& body, const convex_polyhedron_adjacency& adjacency, const float3& vector, fixed_convex_polyhedron& r);
+    std::optional< convex_polyhedron > convex_hull_with_point(const convex_polyhedron& body, const float3& point);
+
+    //convex hull of the body and a point light or a spot light apex, the caster volume of the light.
+    //faces are wound counter clockwise seen from outside. returns false, or no polyhedron, if the hull does not fit the fixed storage.
+    bool convex_hull_with_point(const fixed_convex_polyhedron& body, const float3& point, fixed_convex_polyhedron& r);
+    std::optional< convex_polyhedron > convex_hull_with_direction(const convex_polyhedron& body, const float3& vector, const aabb& clip_body);
+
+    //triangles ordered for the vertex cache like the triangle list below. polyhedra with more than 256 points or 64 faces
+    //or a face of more than 32 points do not fit its storage, they are split into fans in their own point order
     convex_triangulated_polyhedron triangulate(const convex_polyhedron& p);
+    convex_triangulated_polyhedron triangulate(const fixed_convex_polyhedron& p);
+
+    //gpu ready triangle list in one contiguous span: float3 positions at offset 0, followed by 16 bit indices.
+    //the same buffer can be bound as vertex buffer and index buffer at m_indices_offset.
+    //triangles are ordered for post transform vertex cache reuse, positions are in the order of first use.
+    struct triangle_list_layout
+    {
+        uint32_t m_vertex_count     = 0;
+        uint32_t m_index_count      = 0;
+        uint32_t m_indices_offset   = 0;    //bytes
+        uint32_t m_size             = 0;    //bytes, a multiple of 4
+    };
+
+    triangle_list_layout make_triangle_list_layout(const convex_polyhedron& p);
+    triangle_list_layout make_triangle_list_layout(const fixed_convex_polyhedron& p);
+
+    //writes the triangle list to destination, which must hold make_triangle_list_layout(p).m_size bytes.
+    //the span is written once front to back and never read, so it can be a mapped write combined upload buffer.
+    //returns an empty layout if the polyhedron does not fit.
+    triangle_list_layout triangulate(const convex_polyhedron& p, void* destination, uint32_t size);
+    triangle_list_layout triangulate(const fixed_convex_polyhedron& p, void* destination, uint32_t size);
 
 
 
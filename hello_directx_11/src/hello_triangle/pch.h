@@ -5,6 +5,9 @@
 
 #pragma once
 
+//the geometry sources also build on linux for the harness in geometry_benchmark, without the platform headers
+#if defined(_WIN32)
+
 #define NOMINMAX                        // Exclude windows header macro
 
 #include <SDKDDKVer.h>
@@ -26,6 +29,8 @@
 #include <winrt/Windows.ApplicationModel.Activation.h>
 #include <winrt/Windows.UI.ViewManagement.h>
 
+#endif
+
 
 
 
@@ -0,0 +1,175 @@
+#include "pch.h"
+#include "depth_analysis.h"
+
+#include <algorithm>
+
+namespace lispsm
+{
+    namespace
+    {
+        struct min_op
+        {
+            static __m128 apply(__m128 a, __m128 b) { return _mm_min_ps(a, b); }
+            static float  apply(float a, float b)   { return std::min(a, b); }
+            static float  empty()                   { return INFINITY; }
+        };
+
+        struct max_op
+        {
+            static __m128 apply(__m128 a, __m128 b) { return _mm_max_ps(a, b); }
+            static float  apply(float a, float b)   { return std::max(a, b); }
+            static float  empty()                   { return -INFINITY; }
+        };
+
+        //texels equal to ignore become empty. a nan ignores nothing
+        template <typename op> inline __m128 load(__m128 v, __m128 keep)
+        {
+            return _mm_or_ps(_mm_and_ps(keep, v), _mm_andnot_ps(keep, _mm_set1_ps(op::empty())));
+        }
+
+        template <typename op> inline float load(const float* p, float ignore)
+        {
+            return *p != ignore ? *p : op::empty();
+        }
+
+        //two rows of eight texels to four
+        template <typename op> inline __m128 reduce(__m128 a0, __m128 b0, __m128 a1, __m128 b1)
+        {
+            const __m128 a      = op::apply(a0, a1);
+            const __m128 b      = op::apply(b0, b1);
+            const __m128 even   = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            const __m128 odd    = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+
+            return op::apply(even, odd);
+        }
+
+        template <typename op> inline float reduce(const float* row0, const float* row1, uint32_t x0, uint32_t x1, float ignore)
+        {
+            const float a = op::apply(load<op>(row0 + x0, ignore), load<op>(row1 + x0, ignore));
+            const float b = op::apply(load<op>(row0 + x1, ignore), load<op>(row1 + x1, ignore));
+
+            return op::apply(a, b);
+        }
+
+        //2 x 2 texels to one, the last row and column repeat for odd sizes. the min and the max sources are the same buffer for
+        //the depth buffer, the one pass reads it once
+        void reduce(const float* min_source, const float* max_source, uint32_t width, uint32_t height, uint32_t stride, float ignore, float* r_min, float* r_max)
+        {
+            const uint32_t  r_width     = (width + 1) / 2;
+            const uint32_t  r_height    = (height + 1) / 2;
+            const __m128    ignore_4    = _mm_set1_ps(ignore);
+
+            for (auto y = 0U; y < r_height; ++y)
+            {
+                const uint32_t  row0    = 2 * y * stride;
+                const uint32_t  row1    = 2 * y + 1 < height ? row0 + stride : row0;
+                uint32_t        x       = 0;
+
+                for (; 2 * x + 8 <= width; x += 4)
+                {
+                    const __m128 min_a0 = _mm_loadu_ps(min_source + row0 + 2 * x);
+                    const __m128 min_b0 = _mm_loadu_ps(min_source + row0 + 2 * x + 4);
+                    const __m128 min_a1 = _mm_loadu_ps(min_source + row1 + 2 * x);
+                    const __m128 min_b1 = _mm_loadu_ps(min_source + row1 + 2 * x + 4);
+
+                    const __m128 max_a0 = _mm_loadu_ps(max_source + row0 + 2 * x);
+                    const __m128 max_b0 = _mm_loadu_ps(max_source + row0 + 2 * x + 4);
+                    const __m128 max_a1 = _mm_loadu_ps(max_source + row1 + 2 * x);
+                    const __m128 max_b1 = _mm_loadu_ps(max_source + row1 + 2 * x + 4);
+
+                    const __m128 keep_a0 = _mm_cmpneq_ps(min_a0, ignore_4);
+                    const __m128 keep_b0 = _mm_cmpneq_ps(min_b0, ignore_4);
+                    const __m128 keep_a1 = _mm_cmpneq_ps(min_a1, ignore_4);
+                    const __m128 keep_b1 = _mm_cmpneq_ps(min_b1, ignore_4);
+
+                    _mm_storeu_ps(r_min + y * r_width + x, reduce<min_op>(load<min_op>(min_a0, keep_a0), load<min_op>(min_b0, keep_b0), load<min_op>(min_a1, keep_a1), load<min_op>(min_b1, keep_b1)));
+                    _mm_storeu_ps(r_max + y * r_width + x, reduce<max_op>(load<max_op>(max_a0, keep_a0), load<max_op>(max_b0, keep_b0), load<max_op>(max_a1, keep_a1), load<max_op>(max_b1, keep_b1)));
+                }
+
+                for (; x < r_width; ++x)
+                {
+                    const uint32_t x0 = 2 * x;
+                    const uint32_t x1 = std::min(2 * x + 1, width - 1);
+
+                    r_min[y * r_width + x] = reduce<min_op>(min_source + row0, min_source + row1, x0, x1, ignore);
+                    r_max[y * r_width + x] = reduce<max_op>(max_source + row0, max_source + row1, x0, x1, ignore);
+                }
+            }
+        }
+
+        void resize(depth_level& l, uint32_t width, uint32_t height)
+        {
+            l.m_width   = width;
+            l.m_height  = height;
+            l.m_min.resize(width * height);
+            l.m_max.resize(width * height);
+        }
+    }
+
+    void make_depth_pyramid(const float* depth, uint32_t width, uint32_t height, uint32_t stride, float background, depth_pyramid& r)
+    {
+        //a minimized window has no depth buffer
+        if (width == 0 || height == 0)
+        {
+            r.m_levels.clear();
+            return;
+        }
+
+        uint32_t count = 1;
+
+        for (auto w = (width + 1) / 2, h = (height + 1) / 2; w > 1 || h > 1; w = (w + 1) / 2, h = (h + 1) / 2)
+        {
+            ++count;
+        }
+
+        r.m_levels.resize(count);
+        resize(r.m_levels[0], (width + 1) / 2, (height + 1) / 2);
+
+        reduce(depth, depth, width, height, stride, background, r.m_levels[0].m_min.data(), r.m_levels[0].m_max.data());
+
+        for (auto i = 1U; i < count; ++i)
+        {
+            const depth_level&  s = r.m_levels[i - 1];
+            depth_level&        l = r.m_levels[i];
+
+            resize(l, (s.m_width + 1) / 2, (s.m_height + 1) / 2);
+
+            reduce(s.m_min.data(), s.m_max.data(), s.m_width, s.m_height, s.m_width, NAN, l.m_min.data(), l.m_max.data());
+        }
+    }
+
+    bool depth_range(const depth_pyramid& p, float& min, float& max)
+    {
+        if (p.m_levels.empty() || p.m_levels.back().m_min.empty())
+        {
+            return false;
+        }
+
+        min = p.m_levels.back().m_min[0];
+        max = p.m_levels.back().m_max[0];
+
+        return min <= max;
+    }
+
+    void make_depth_splits(const depth_pyramid& p, float projection_near, float projection_far, uint32_t count, float lambda, float* splits)
+    {
+        float min;
+        float max;
+
+        if (!depth_range(p, min, max))
+        {
+            make_splits(std::min(projection_near, projection_far), std::max(projection_near, projection_far), count, lambda, splits);
+            return;
+        }
+
+        //a reversed depth buffer has the far end at its minimum
+        const float a = view_depth(min, projection_near, projection_far);
+        const float b = view_depth(max, projection_near, projection_far);
+
+        //a flat range, like a wall in front of the camera, still gets cascades with some depth
+        const float z_near  = std::min(a, b);
+        const float z_far   = std::max(std::max(a, b), z_near * 1.001f);
+
+        make_splits(z_near, z_far, count, lambda, splits);
+    }
+}
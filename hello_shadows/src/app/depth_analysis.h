@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "lispsm.h"
+
+//sample distribution of the depth buffer for the cascade splits. a min / max pyramid of the depths of the frame gives the depth range,
+//which is really visible, and the splits are placed in it instead of between the near and the far plane of the camera
+namespace lispsm
+{
+    //texel (x, y) of a level is at y * m_width + x. texels without depths have min +infinity and max -infinity
+    struct depth_level
+    {
+        uint32_t            m_width     = 0;
+        uint32_t            m_height    = 0;
+        std::vector<float>  m_min;
+        std::vector<float>  m_max;
+    };
+
+    //level 0 has half the size of the depth buffer, every level halves the one below, the last one is 1 x 1
+    struct depth_pyramid
+    {
+        std::vector<depth_level> m_levels;
+    };
+
+    //depth is a float buffer of width x height with rows stride floats apart, as it was read back. texels equal to background were
+    //not drawn and do not count. the levels keep their memory between frames of the same size. a buffer of width or height 0 has no levels
+    void            make_depth_pyramid(const float* depth, uint32_t width, uint32_t height, uint32_t stride, float background, depth_pyramid& r);
+
+    //false, when no texel was drawn or the pyramid has no levels
+    bool            depth_range(const depth_pyramid& p, float& min, float& max);
+
+    //the camera depth of a depth buffer value. projection_near and projection_far are the planes given to the projection matrix,
+    //swapped for a reversed depth buffer
+    inline float view_depth(float depth, float projection_near, float projection_far)
+    {
+        const float range = projection_far / (projection_far - projection_near);
+        return range * projection_near / (range - depth);
+    }
+
+    //count + 1 splits over the visible camera depths, lambda blends the logarithmic (1) and the uniform (0) split schemes.
+    //without visible depths the splits cover the whole projection
+    void            make_depth_splits(const depth_pyramid& p, float projection_near, float projection_far, uint32_t count, float lambda, float* splits);
+}
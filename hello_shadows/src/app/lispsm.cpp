@@ -0,0 +1,325 @@
+#include "pch.h"
+#include "lispsm.h"
+
+#include <algorithm>
+
+namespace lispsm
+{
+    view_transform make_view_transform(const camera& c)
+    {
+        matrix44 r;
+
+        vector3 right_      = right(c);
+        vector3 up_         = up(c);
+        vector3 forward_    = forward(c);
+
+        //the axes are the columns, the translation moves the camera to the origin
+        r.r[0] = float4(right_.m_value.x, up_.m_value.x, forward_.m_value.x, 0.0f);
+        r.r[1] = float4(right_.m_value.y, up_.m_value.y, forward_.m_value.y, 0.0f);
+        r.r[2] = float4(right_.m_value.z, up_.m_value.z, forward_.m_value.z, 0.0f);
+        r.r[3] = float4(-project(right_, position(c)), -project(up_, position(c)), -project(forward_, position(c)), 1.0f);
+
+        view_transform t;
+        t.m_matrix = r;
+        return t;
+    }
+
+    matrix44 perspective_matrix(const perspective_camera& c)
+    {
+        matrix44 r;
+
+        float sinFov    = sinf(c.m_fov_y.m_value / 2.0f);
+        float cosFov    = cosf(c.m_fov_y.m_value / 2.0f);
+
+        float height    = cosFov / sinFov;
+        float width     = height / c.m_aspect.m_value;
+        float nearz     = c.m_near.m_value;
+        float farz      = c.m_far.m_value;
+        float range     = farz / (farz - nearz);
+
+        r.r[0] = float4(width, 0, 0, 0);
+        r.r[1] = float4(0, height, 0, 0);
+        r.r[2] = float4(0, 0, range, 1);
+        r.r[3] = float4(0, 0, -range * nearz, 0);
+
+        return r;
+    }
+
+    perspective_transform make_perspective_transform(const perspective_camera& c)
+    {
+        perspective_transform t;
+        t.m_matrix = perspective_matrix(c);
+        return t;
+    }
+
+    matrix44 perspective_matrix(const ortho_camera& c)
+    {
+        matrix44 r;
+
+        float width     = 1.0f / (c.m_right - c.m_left);
+        float height    = 1.0f / (c.m_top - c.m_bottom);
+        float range     = 1.0f / (c.m_far.m_value - c.m_near.m_value);
+
+        r.r[0] = float4(2.0f * width, 0, 0, 0);
+        r.r[1] = float4(0, 2.0f * height, 0, 0);
+        r.r[2] = float4(0, 0, range, 0);
+        r.r[3] = float4(-(c.m_left + c.m_right) * width, -(c.m_top + c.m_bottom) * height, -range * c.m_near.m_value, 1);
+
+        return r;
+    }
+
+    point4 transform_point(const view_transform& m, point4 p)
+    {
+        return point4(store(mul(load(p.m_value), m.m_matrix)));
+    }
+
+    point3 transform(const matrix44& m, point3 p)
+    {
+        const __m128 v = mul(load(p), m);
+        const float4 r = store(_mm_div_ps(v, splat<3>(v)));
+
+        return point3(r.x, r.y, r.z);
+    }
+
+    point3 get_closest_point(const point3 frustum_points_ws[8], point3 camera_position_ws)
+    {
+        vector3 min_difference      = sub(camera_position_ws, frustum_points_ws[0]);
+        float   min_norm_squared    = dot(min_difference, min_difference);
+        point3  min_point           = frustum_points_ws[0];
+
+        for (uint32_t i = 1U; i < 8; ++i)
+        {
+            vector3 difference      = sub(camera_position_ws, frustum_points_ws[i]);
+            float   norm_squared    = dot(difference, difference);
+
+            if (norm_squared < min_norm_squared)
+            {
+                min_norm_squared    = norm_squared;
+                min_point           = frustum_points_ws[i];
+            }
+        }
+
+        return min_point;
+    }
+
+    void frustum_points(const perspective_camera& c, float z_near, float z_far, point3 r[8])
+    {
+        const float     tan_y   = tanf(c.m_fov_y.m_value / 2.0f);
+        const float     tan_x   = c.m_aspect.m_value * tan_y;
+
+        const vector3   x       = right(c);
+        const vector3   y       = up(c);
+        const vector3   z       = forward(c);
+
+        const float     depth[2] = { z_near, z_far };
+
+        for (auto i = 0U; i < 2; ++i)
+        {
+            const point3  center = add(position(c), mul(z, depth[i]));
+            const vector3 h      = mul(x, tan_x * depth[i]);
+            const vector3 v      = mul(y, tan_y * depth[i]);
+
+            r[4 * i + 0] = add(center, negate(add(h, v)));
+            r[4 * i + 1] = add(center, subtract(h, v));
+            r[4 * i + 2] = add(center, add(h, v));
+            r[4 * i + 3] = add(center, subtract(v, h));
+        }
+    }
+
+    void make_splits(float z_near, float z_far, uint32_t count, float lambda, float* splits)
+    {
+        splits[0]       = z_near;
+        splits[count]   = z_far;
+
+        for (auto i = 1U; i < count; ++i)
+        {
+            const float t               = static_cast<float>(i) / static_cast<float>(count);
+            const float logarithmic     = z_near * powf(z_far / z_near, t);
+            const float uniform         = z_near + (z_far - z_near) * t;
+
+            splits[i] = lambda * logarithmic + (1.0f - lambda) * uniform;
+        }
+    }
+
+    namespace
+    {
+        //the points of the slice and their extrusions towards the light up to the casters, which can shadow the slice.
+        //points behind the casters move along the light rays to their far end, this keeps them in place in the shadow map
+        uint32_t make_body(const point3 slice[8], vector3 light, light_depth_range casters, point3 body[16])
+        {
+            uint32_t count = 0;
+
+            for (auto i = 0U; i < 8; ++i)
+            {
+                const float   depth = project(light, slice[i]);
+                const point3  p     = depth > casters.m_far ? add(slice[i], mul(light, casters.m_far - depth)) : slice[i];
+
+                body[count++] = p;
+
+                if (std::min(depth, casters.m_far) > casters.m_near)
+                {
+                    body[count++] = add(slice[i], mul(light, casters.m_near - depth));
+                }
+            }
+
+            return count;
+        }
+
+        struct bounds
+        {
+            __m128 m_min;
+            __m128 m_max;
+        };
+
+        //bounds of the points after the transform and the perspective divide
+        bounds transform_bounds(const matrix44& m, const point3* points, uint32_t count)
+        {
+            bounds r = { _mm_set1_ps(INFINITY), _mm_set1_ps(-INFINITY) };
+
+            for (auto i = 0U; i < count; ++i)
+            {
+                const __m128 v = mul(load(points[i]), m);
+                const __m128 p = _mm_div_ps(v, splat<3>(v));
+
+                r.m_min = _mm_min_ps(r.m_min, p);
+                r.m_max = _mm_max_ps(r.m_max, p);
+            }
+
+            return r;
+        }
+
+        //scale and translation of the bounds to x, y in [-1, 1] and z in [0, 1]
+        matrix44 fit(const bounds& b)
+        {
+            const float4 min    = store(b.m_min);
+            const float4 max    = store(b.m_max);
+
+            const float  x      = 1.0f / std::max(max.x - min.x, 1e-6f);
+            const float  y      = 1.0f / std::max(max.y - min.y, 1e-6f);
+            const float  z      = 1.0f / std::max(max.z - min.z, 1e-6f);
+
+            matrix44 r;
+
+            r.r[0] = float4(2.0f * x, 0, 0, 0);
+            r.r[1] = float4(0, 2.0f * y, 0, 0);
+            r.r[2] = float4(0, 0, z, 0);
+            r.r[3] = float4(-(min.x + max.x) * x, -(min.y + max.y) * y, -min.z * z, 1);
+
+            return r;
+        }
+    }
+
+    light_depth_range make_light_depth_range(vector3 light, const aabb& b)
+    {
+        const vector3   center  = mul(add(vector3(b.m_max), vector3(b.m_min)), 0.5f);
+        const vector3   extents = mul(subtract(vector3(b.m_max), vector3(b.m_min)), 0.5f);
+        const float     radius  = fabsf(light.m_value.x) * extents.m_value.x + fabsf(light.m_value.y) * extents.m_value.y + fabsf(light.m_value.z) * extents.m_value.z;
+
+        return { dot(light, center) - radius, dot(light, center) + radius };
+    }
+
+    shadow_cascade make_cascade(const point3 slice[8], const camera& c, vector3 light, const aabb& casters)
+    {
+        //only the near end of the box, all receivers keep their depth
+        return make_cascade(slice, c, light, { make_light_depth_range(light, casters).m_near, INFINITY });
+    }
+
+    shadow_cascade make_cascade(const point3 slice[8], const camera& c, vector3 light, light_depth_range casters)
+    {
+        const vector3   view        = forward(c);
+        const float     cos_gamma   = dot(view, light);
+        const float     sin_gamma   = sqrtf(std::max(0.0f, 1.0f - cos_gamma * cos_gamma));
+
+        //the perspective axis is the view direction in the shadow plane. along the light there is none, any direction in the plane will do
+        vector3 axis = sin_gamma > 1e-3f ? view : up(c);
+
+        //twice, the first pass leaves the rounding of a direction close to the light
+        axis = normalize(subtract(axis, mul(light, dot(axis, light))));
+        axis = normalize(subtract(axis, mul(light, dot(axis, light))));
+
+        //light space: z along the light rays, y along the perspective axis
+        camera l;
+
+        l.m_position    = zero();
+        l.m_direction   = light;
+        l.m_up          = axis;
+        l.m_near        = { 0.0f };
+        l.m_far         = { 0.0f };
+
+        point3          body[16];
+        const uint32_t  count   = make_body(slice, light, casters, body);
+
+        view_transform  v       = make_view_transform(l);
+        const bounds    b       = transform_bounds(v.m_matrix, body, count);
+        const float4    min     = store(b.m_min);
+        const float4    max     = store(b.m_max);
+
+        //the distance of the slice from the camera decides the optimal perspective
+        const float     z_near  = std::max(project(view, get_closest_point(slice, position(c))) - project(view, position(c)), 1e-3f);
+        const float     d       = max.y - min.y;
+
+        matrix44        p       = identity();
+        float           n       = 0.0f;
+
+        if (sin_gamma > 1e-3f)
+        {
+            const float z_n     = z_near / sin_gamma;
+            const float z_f     = z_n + d * sin_gamma;
+            n                   = (z_n + sqrtf(z_f * z_n)) / sin_gamma;
+        }
+
+        //a perspective farther away than 100 depths of the body changes the density by less than 1%, and loses precision
+        const bool      perspective = n > 0.0f && n < 100.0f * d;
+
+        if (perspective)
+        {
+            const float f = n + d;
+
+            //y' = (a y + b) / y maps [n, f] to [-1, 1]
+            p.r[1] = float4(0, (f + n) / (f - n), 0, 1);
+            p.r[3] = float4(0, -2.0f * f * n / (f - n), 0, 0);
+        }
+
+        //the origin is the center of the perspective, n in front of the body
+        v.m_matrix.r[3].x -= (min.x + max.x) * 0.5f;
+        v.m_matrix.r[3].y -= min.y - n;
+        v.m_matrix.r[3].z -= min.z;
+
+        shadow_cascade r;
+
+        r.m_view        = v.m_matrix;
+        //the depth z / y of the perspective covers the whole box of the body, casters beside the slice do not leave [0, 1]
+        bounds          fitted  = transform_bounds(mul(v.m_matrix, p), body, count);
+        float4          f_min   = store(fitted.m_min);
+        float4          f_max   = store(fitted.m_max);
+
+        f_min.z         = 0.0f;
+        f_max.z         = (max.z - min.z) / (perspective ? n : 1.0f);
+        fitted.m_min    = load(f_min);
+        fitted.m_max    = load(f_max);
+
+        r.m_projection  = mul(p, fit(fitted));
+        r.m_near        = z_near;
+        r.m_far         = z_near;
+
+        for (auto i = 0U; i < 8; ++i)
+        {
+            r.m_far = std::max(r.m_far, project(view, slice[i]) - project(view, position(c)));
+        }
+
+        return r;
+    }
+
+    void make_cascades(const perspective_camera& c, vector3 light, const aabb& casters, const float* splits, uint32_t count, shadow_cascade* r)
+    {
+        for (auto i = 0U; i < count; ++i)
+        {
+            point3 slice[8];
+
+            frustum_points(c, splits[i], splits[i + 1], slice);
+            r[i]        = make_cascade(slice, c, light, casters);
+            r[i].m_near = splits[i];
+            r[i].m_far  = splits[i + 1];
+        }
+    }
+}
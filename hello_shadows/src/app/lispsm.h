@@ -0,0 +1,400 @@
+#pragma once
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+#include <cstdint>
+#include <math.h>
+
+//light space perspective shadow maps for the cascades of a directional light.
+//row vectors and left handed spaces like directxmath, sse2 only and without directxmath, so it builds on linux
+namespace lispsm
+{
+    inline float Pi()
+    {
+        return 3.14159265358979323846f;
+    }
+
+    inline float radians(float degrees)
+    {
+        return ((degrees) / 180.0f) * Pi();
+    }
+
+    struct alignas(16) float4
+    {
+        float x;
+        float y;
+        float z;
+        float w;
+
+        float4()
+        {
+
+        }
+
+        float4(float v0, float v1, float v2, float v3)
+        {
+            x = v0;
+            y = v1;
+            z = v2;
+            w = v3;
+        }
+    };
+
+    //rows, a point is transformed as p * m
+    struct alignas(16) matrix44
+    {
+        float4 r[4];
+    };
+
+    struct float3
+    {
+        float x;
+        float y;
+        float z;
+
+        float3()
+        {
+
+        }
+
+        float3(float v0, float v1, float v2)
+        {
+            x = v0;
+            y = v1;
+            z = v2;
+        }
+    };
+
+    struct float2
+    {
+        float x;
+        float y;
+
+        float2()
+        {
+
+        }
+
+        float2(float v0, float v1)
+        {
+            x = v0;
+            y = v1;
+        }
+    };
+
+    struct vector3
+    {
+        float3 m_value;
+
+        vector3() {}
+        vector3(float  v0, float  v1, float  v2) { m_value.x = v0; m_value.y = v1; m_value.z = v2; }
+        vector3(float3 v) { m_value = v; }
+    };
+
+    struct point3
+    {
+        float3 m_value;
+
+        point3() {}
+        point3(float  v0, float  v1, float  v2) { m_value.x = v0; m_value.y = v1; m_value.z = v2; }
+        point3(float3 v) { m_value = v; }
+    };
+
+    struct point4
+    {
+        float4 m_value;
+
+        point4() {}
+        point4(float  v0, float  v1, float  v2, float  v3) { m_value.x = v0; m_value.y = v1; m_value.z = v2; m_value.w = v3; }
+        point4(float4 v) { m_value = v; }
+        point4(point3 v) { m_value.x = v.m_value.x; m_value.y = v.m_value.y; m_value.z = v.m_value.z; m_value.w = 1.0f; }
+    };
+
+    //simd
+    inline __m128 load(const float4& v)
+    {
+        return _mm_load_ps(&v.x);
+    }
+
+    inline __m128 load(point3 p)
+    {
+        return _mm_setr_ps(p.m_value.x, p.m_value.y, p.m_value.z, 1.0f);
+    }
+
+    inline float4 store(__m128 v)
+    {
+        float4 r;
+        _mm_store_ps(&r.x, v);
+        return r;
+    }
+
+    template <uint32_t i> inline __m128 splat(__m128 v)
+    {
+        return _mm_shuffle_ps(v, v, _MM_SHUFFLE(i, i, i, i));
+    }
+
+    //row vector times matrix, ((x r0 + y r1) + z r2) + w r3
+    inline __m128 mul(__m128 v, const matrix44& m)
+    {
+        __m128 r = _mm_mul_ps(splat<0>(v), load(m.r[0]));
+        r = _mm_add_ps(r, _mm_mul_ps(splat<1>(v), load(m.r[1])));
+        r = _mm_add_ps(r, _mm_mul_ps(splat<2>(v), load(m.r[2])));
+        r = _mm_add_ps(r, _mm_mul_ps(splat<3>(v), load(m.r[3])));
+        return r;
+    }
+
+    inline matrix44 mul(const matrix44& a, const matrix44& b)
+    {
+        matrix44 r;
+
+        r.r[0] = store(mul(load(a.r[0]), b));
+        r.r[1] = store(mul(load(a.r[1]), b));
+        r.r[2] = store(mul(load(a.r[2]), b));
+        r.r[3] = store(mul(load(a.r[3]), b));
+
+        return r;
+    }
+
+    inline matrix44 identity()
+    {
+        matrix44 r;
+
+        r.r[0] = float4(1.0f, 0.0f, 0.0f, 0.0f);
+        r.r[1] = float4(0.0f, 1.0f, 0.0f, 0.0f);
+        r.r[2] = float4(0.0f, 0.0f, 1.0f, 0.0f);
+        r.r[3] = float4(0.0f, 0.0f, 0.0f, 1.0f);
+
+        return r;
+    }
+
+    //for the upload to the shaders, which use column vectors
+    inline matrix44 transpose(const matrix44& m)
+    {
+        __m128 r0 = load(m.r[0]);
+        __m128 r1 = load(m.r[1]);
+        __m128 r2 = load(m.r[2]);
+        __m128 r3 = load(m.r[3]);
+
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+        matrix44 r;
+
+        r.r[0] = store(r0);
+        r.r[1] = store(r1);
+        r.r[2] = store(r2);
+        r.r[3] = store(r3);
+
+        return r;
+    }
+
+    inline vector3 unit_x()
+    {
+        return vector3(1.0f, 0.0f, 0.0f);
+    }
+
+    inline vector3 unit_y()
+    {
+        return vector3(0.0f, 1.0f, 0.0f);
+    }
+
+    inline vector3 unit_z()
+    {
+        return vector3(0.0f, 0.0f, 1.0f);
+    }
+
+    //the vector3 functions stay scalar. vector3 is three floats, an sse2 version loads them into a register and stores them
+    //back on every call, which made a cascade of lispsm_benchmark 10% slower. the simd is in the matrix products above
+    inline vector3 mul(vector3 v, float scalar)
+    {
+        return vector3(v.m_value.x * scalar, v.m_value.y * scalar, v.m_value.z * scalar);
+    }
+
+    inline vector3 add(vector3 v0, vector3 v1)
+    {
+        return vector3(v0.m_value.x + v1.m_value.x, v0.m_value.y + v1.m_value.y, v0.m_value.z + v1.m_value.z);
+    }
+
+    inline point3 add(point3 v0, vector3 v1)
+    {
+        return point3(v0.m_value.x + v1.m_value.x, v0.m_value.y + v1.m_value.y, v0.m_value.z + v1.m_value.z);
+    }
+
+    inline vector3 sub(point3 v0, point3 v1)
+    {
+        return vector3(v0.m_value.x - v1.m_value.x, v0.m_value.y - v1.m_value.y, v0.m_value.z - v1.m_value.z);
+    }
+
+    inline vector3 negate(vector3 v0)
+    {
+        return vector3(-v0.m_value.x, -v0.m_value.y, -v0.m_value.z);
+    }
+
+    inline vector3 subtract(vector3 v0, vector3 v1)
+    {
+        return add(v0, negate(v1));
+    }
+
+    inline float dot(vector3 v0, vector3 v1)
+    {
+        return v0.m_value.x * v1.m_value.x + v0.m_value.y * v1.m_value.y + v0.m_value.z * v1.m_value.z;
+    }
+
+    inline float length(vector3 v)
+    {
+        return sqrtf(dot(v, v));
+    }
+
+    inline vector3 normalize(vector3 v)
+    {
+        return mul(v, 1.0f / length(v));
+    }
+
+    inline vector3 cross(vector3 v0, vector3 v1)
+    {
+        float ax = v0.m_value.x;
+        float ay = v0.m_value.y;
+        float az = v0.m_value.z;
+
+        float bx = v1.m_value.x;
+        float by = v1.m_value.y;
+        float bz = v1.m_value.z;
+
+        return vector3(ay * bz - az * by, az * bx - ax * bz, ax * by - ay * bx);
+    }
+
+    inline point3 zero()
+    {
+        return point3(0.0f, 0.0f, 0.0f);
+    }
+
+    struct aabb
+    {
+        float3 m_min;
+        float3 m_max;
+    };
+
+    struct distance
+    {
+        float m_value;
+    };
+
+    struct radian
+    {
+        float m_value;
+    };
+
+    struct ratio
+    {
+        float m_value;
+    };
+
+    //direction and up are normalized and orthogonal
+    struct camera
+    {
+        point3      m_position;
+        distance    m_near;
+        vector3     m_direction;
+        distance    m_far;
+        vector3     m_up;
+    };
+
+    struct ortho_camera : camera
+    {
+        float m_left;
+        float m_right;
+        float m_top;
+        float m_bottom;
+    };
+
+    struct perspective_camera : camera
+    {
+        ratio  m_aspect;
+        radian m_fov_y;
+    };
+
+    inline vector3 up(const camera& c)
+    {
+        return c.m_up;
+    }
+
+    inline vector3 forward(const camera& c)
+    {
+        return c.m_direction;
+    }
+
+    //left handed, x = y cross z
+    inline vector3 right(const camera& c)
+    {
+        return cross(up(c), forward(c));
+    }
+
+    inline point3 position(const camera& c)
+    {
+        return c.m_position;
+    }
+
+    inline float project(vector3 v, point3 p)
+    {
+        return dot(v, vector3(p.m_value));
+    }
+
+    struct view_transform
+    {
+        matrix44 m_matrix;
+    };
+
+    struct perspective_transform
+    {
+        matrix44 m_matrix;
+    };
+
+    view_transform          make_view_transform(const camera& c);
+
+    //depth 0 at the near and 1 at the far plane
+    matrix44                perspective_matrix(const perspective_camera& c);
+    matrix44                perspective_matrix(const ortho_camera& c);
+    perspective_transform   make_perspective_transform(const perspective_camera& c);
+
+    //transform with the perspective divide
+    point3                  transform(const matrix44& m, point3 p);
+    point4                  transform_point(const view_transform& m, point4 p);
+
+    point3                  get_closest_point(const point3 frustum_points_ws[8], point3 camera_position_ws);
+
+    //the corners of the camera frustum between two depths. near face first, counter clockwise from bottom left seen from the camera
+    void                    frustum_points(const perspective_camera& c, float z_near, float z_far, point3 r[8]);
+
+    //count + 1 split depths, lambda blends the logarithmic (1) and the uniform (0) split schemes
+    void                    make_splits(float z_near, float z_far, uint32_t count, float lambda, float* splits);
+
+    struct shadow_cascade
+    {
+        matrix44 m_view;            //light view, the origin is the center of the lispsm perspective
+        matrix44 m_projection;      //lispsm perspective, fitted to x, y in [-1, 1] and depth in [0, 1]
+        float    m_near;            //the camera depths covered by the cascade
+        float    m_far;
+    };
+
+    //depths along the light rays, dot(light, p)
+    struct light_depth_range
+    {
+        float m_near;
+        float m_far;
+    };
+
+    light_depth_range       make_light_depth_range(vector3 light, const aabb& b);
+
+    //the shadow matrices for the points of a slice of the camera frustum. casters between the slice and the light are included.
+    //light is the normalized direction of the light rays. a light along the camera direction falls back to a uniform shadow map
+    shadow_cascade          make_cascade(const point3 slice[8], const camera& c, vector3 light, const aabb& casters);
+
+    //the same with the depth range of the casters. receivers behind the last caster are lit, their depth is clamped to the far end
+    shadow_cascade          make_cascade(const point3 slice[8], const camera& c, vector3 light, light_depth_range casters);
+
+    //all cascades of a light in one call, splits has count + 1 depths
+    void                    make_cascades(const perspective_camera& c, vector3 light, const aabb& casters, const float* splits, uint32_t count, shadow_cascade* r);
+}
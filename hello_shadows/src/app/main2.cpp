@@ -1,8 +1,12 @@
 #include "pch.h"
 #include <cstdint>
+#include <thread>
 #include "build_window_environment.h"
 
 #include "d3dx12.h"
+#include "lispsm.h"
+#include "triangle_clipper.h"
+#include "shadow_casters.h"
 
 
 using namespace winrt::Windows::UI::Input;
@@ -34,19 +38,6 @@ struct FrameConstants
     XMVECTOR m_position;
 };
 
-namespace lispsm
-{
-    float Pi()
-    {
-        return 3.14159265358979323846f;
-    }
-
-    float radians(float degrees)
-    {
-        return ((degrees) / 180.0f) * Pi();
-    }
-}
-
 void triangulate_aabb(const AABB aabb, XMVECTOR* points);
 void aabb_points(const AABB aabb, XMVECTOR* points);
 
@@ -1370,131 +1361,66 @@ XMMATRIX light_view_matrix( XMVECTOR camera_direction_ws, XMVECTOR camera_positi
 
 namespace
 {
-    bool above0(int32_t mask)
-    {
-        return (mask & 0x1) != 0;
-    }
-
-    bool above1(int32_t mask)
-    {
-        return (mask & 0x2) != 0;
-    }
-
-    bool above2(int32_t mask)
-    {
-        return (mask & 0x4) != 0;
-    }
-
-    bool above3(int32_t mask)
+    lispsm::point3 to_point3(XMVECTOR v)
     {
-        return (mask & 0x8) != 0;
+        return lispsm::point3(XMVectorGetX(v), XMVectorGetY(v), XMVectorGetZ(v));
     }
 }
 
-void clip3(XMVECTOR n, XMVECTOR v0, XMVECTOR v1, XMVECTOR v2, XMVECTOR* clipped_frustum, uint32_t* clipped_frustum_count )
+//the parts of the triangles inside the frustum planes as a triangle list, at most clipped_frustum_capacity points.
+//the planes are (n, d) with dot(n, p) + d >= 0 inside. returns false when the clipped triangles did not fit
+bool compute_clipped_frustum(const XMVECTOR* triangles, uint32_t triangle_count, const XMVECTOR frustumPlanes[6], XMVECTOR* clipped_frustum, uint32_t clipped_frustum_capacity, uint32_t* clipped_frustum_count)
 {
-    //Distances to the plane (this is an array parallel // to v[], stored as a vec3)
-    //XMVECTOR dist = vec3(dot(v0, n), dot(v1, n), dot(v2, n));
+    using namespace lispsm;
 
-    XMVECTOR v3;
-    XMVECTOR d0             = XMVector3Dot(n, v0);
-    XMVECTOR d1             = XMVector3Dot(n, v1);
-    XMVECTOR d2             = XMVector3Dot(n, v2);
+    //the buffers grow outside of the clipping, each plane can split a triangle in two
+    thread_local triangle_soa input;
+    thread_local triangle_soa scratch;
+    thread_local triangle_soa output;
 
-    XMVECTOR clipEpsilon    = XMVectorNegate(XMVectorReplicate(0.00001f));
-    XMVECTOR clipEpsilon2   = XMVectorReplicate(0.01f);
-    
-    XMVECTOR r0             = d0;
-    XMVECTOR r1             = XMVectorSelect(r0, d1, g_XMSelect0111);
-    XMVECTOR r2             = XMVectorSelect(r1, d2, g_XMSelect0011);
-    XMVECTOR r3             = XMVectorSelect(r2, g_XMZero, g_XMSelect1110);
-    XMVECTOR dist           = r3;
-
-    //all clipped
-    if (!XMComparisonAnyTrue(XMVector3GreaterOrEqualR(dist, clipEpsilon2)))
-    {
-        return;
-    }
+    const uint32_t capacity = clipped_frustum_capacity / 3;
 
-    //none clipped
-    if (XMComparisonAllTrue(XMVector3GreaterOrEqualR(dist, clipEpsilon)))
+    if (input.m_capacity < triangle_count)
     {
-        *clipped_frustum++ = v0;
-        *clipped_frustum++ = v1;
-        *clipped_frustum++ = v2;
-        *clipped_frustum_count += 3;
+        input = make_triangle_soa(triangle_count);
     }
 
-    // There are either 1 or 2 vertices above the clipping plane .
-    XMVECTOR abovex  = XMVectorGreaterOrEqual(r3, g_XMZero);
-    int32_t  above   = _mm_movemask_ps(abovex);
-    bool nextIsAbove;
-
-    // Find the CCW - most vertex above the plane .
-    if (above1(above) && !above0(above) )
+    if (output.m_capacity != capacity)
     {
-        // Cycle once CCW . Use v3 as a temp
-        nextIsAbove = above2(above);
-        v3 = v0; v0 = v1; v1 = v2; v2 = v3;
+        scratch = make_triangle_soa(capacity);
+        output  = make_triangle_soa(capacity);
+    }
 
-        //dist = dist.yzx;
-        dist = XMVectorSwizzle<1, 2, 0, 3>(dist);
+    clear(input);
 
-        XMVECTOR temp = d0;
-        d0 = d1;
-        d1 = d2;
-        d2 = temp;
-        
-    } else if (above2(above) && !above1(above))
-    {
-        // Cycle once CW . Use v3 as a temp .
-        nextIsAbove = above0(above);
-        v3 = v2; v2 = v1; v1 = v0; v0 = v3;
-        //dist = dist.zxy;
-        dist = XMVectorSwizzle<2, 0, 1, 3>(dist);
-
-        XMVECTOR temp = d0;
-        d0 = d2;
-        d2 = d1;
-        d1 = temp;
-    }
-    else
+    for (auto i = 0U; i < triangle_count; ++i)
     {
-        nextIsAbove = above1(above);
+        push_back(input, to_point3(triangles[3 * i]), to_point3(triangles[3 * i + 1]), to_point3(triangles[3 * i + 2]));
     }
 
-    v3 = XMVectorLerpV(v0, v2, XMVectorDivide(d0, XMVectorSubtract(d0, d2)));
+    plane planes[6];
 
-    if (nextIsAbove)
+    for (auto i = 0U; i < 6; ++i)
     {
-        v2 = XMVectorLerpV(v1, v2, XMVectorDivide(d1, XMVectorSubtract(d1, d2)));
+        XMFLOAT4 p;
+        XMStoreFloat4(&p, frustumPlanes[i]);
 
-        *clipped_frustum++ = v0;
-        *clipped_frustum++ = v1;
-        *clipped_frustum++ = v2;
-        *clipped_frustum++ = v3;
-        *clipped_frustum_count += 4;
-
-        //4 points
+        planes[i].m_n = vector3(p.x, p.y, p.z);
+        planes[i].m_d = p.w;
     }
-    else
+
+    const bool complete = clip(input, planes, 6, scratch, output);
+
+    for (auto i = 0U; i < output.m_size; ++i)
     {
-        v1 = XMVectorLerpV(v0, v1, XMVectorDivide(d0, XMVectorSubtract(d0, d1)));
-        v2 = v3;
-        v3 = v0;
-
-        *clipped_frustum++ = v0;
-        *clipped_frustum++ = v1;
-        *clipped_frustum++ = v2;
-        *clipped_frustum_count += 3;
-        //3 points
+        for (auto k = 0U; k < 3; ++k)
+        {
+            clipped_frustum[3 * i + k] = XMVectorSet(output.m_x[k][i], output.m_y[k][i], output.m_z[k][i], 1.0f);
+        }
     }
-}
-
-void compute_clipped_frustum(const XMVECTOR* triangles, uint32_t triangle_count, const XMVECTOR frustumPlanes[6], XMVECTOR* clipped_frustum, uint32_t* clipped_frustum_count)
-{
-    *clipped_frustum_count = 0;
 
+    *clipped_frustum_count = 3 * output.m_size;
+    return complete;
 }
 
 void triangulate_aabb( const AABB aabb, XMVECTOR* points )
@@ -1612,516 +1538,58 @@ void aabb_points(const AABB aabb, XMVECTOR* points)
     }
 }
 
-void compute_clipped_frustum(const AABB shadowCasters, const XMVECTOR frustumPlanes[6], XMVECTOR* clipped_frustum, uint32_t* clipped_frustum_count)
+bool compute_clipped_frustum(const AABB shadowCasters, const XMVECTOR frustumPlanes[6], XMVECTOR* clipped_frustum, uint32_t clipped_frustum_capacity, uint32_t* clipped_frustum_count)
 {
-    *clipped_frustum_count = 0;
+    XMVECTOR points[36];
+    triangulate_aabb(shadowCasters, &points[0]);
+    return compute_clipped_frustum(points, 12, frustumPlanes, clipped_frustum, clipped_frustum_capacity, clipped_frustum_count);
 }
 
-void include_light_volume( AABB shadowCasters, XMVECTOR light_direction_ws, XMVECTOR* clipped_frustum, uint32_t* clipped_frustum_count)
+//the casters of the scene sorted into the cascades of the camera, instead of one box around all of them. every cascade is fitted
+//to the depths of its own casters and renders only the casters in its list
+void include_light_volume(const AABB* shadowCasters, uint32_t shadow_caster_count, const lispsm::perspective_camera& camera, XMVECTOR light_direction_ws, const float* splits, uint32_t cascade_count, lispsm::shadow_cascade* cascades, lispsm::cascade_casters* cascade_casters)
 {
-    
-}
-
-XMMATRIX compute_light_projection( XMMATRIX light_view, AABB shadowCasters, XMVECTOR frustumPlanes[6] )
-{
-    //allocate buffer here
-    //XMVECTOR clipped_frustum[512];
-    //XMVECTOR clipped_frustum_count;
-}
-
-
-
-
-
-
-
+    using namespace lispsm;
 
+    thread_local aabb_soa           casters;
+    thread_local cascade_workers    workers(std::thread::hardware_concurrency());
 
-
-
-
-
-
-namespace lispsm1
-{
-    struct float4
-    {
-        float x;
-        float y;
-        float z;
-        float w;
-
-        float4()
-        {
-
-        }
-
-        float4(float v0, float v1, float v2, float v3)
-        {
-            x = v0;
-            y = v1;
-            z = v2;
-            w = v3;
-        }
-    };
-
-    struct matrix44
+    if (casters.m_capacity < shadow_caster_count)
     {
-        float4 r[4];
-    };
-
-
-    struct float3
-    {
-        float x;
-        float y;
-        float z;
-
-        float3()
-        {
-
-        }
-
-        float3(float v0, float v1, float v2)
-        {
-            x = v0;
-            y = v1;
-            z = v2;
-        }
-    };
-
-    struct float2
-    {
-        float x;
-        float y;
-
-        float2()
-        {
-
-        }
-
-        float2(float v0, float v1)
-        {
-            x = v0;
-            y = v1;
-        }
-    };
-
-    struct vector4
-    {
-        float4 m_value;
-
-        vector4() {}
-        vector4(float  v0, float  v1, float  v2, float  v3) { m_value.x = v0; m_value.y = v1; m_value.z = v2; m_value.w = v3; }
-        vector4(float4 v) { m_value = v; }
-        vector4(float3 v)
-        {
-            m_value.x = v.x;
-            m_value.y = v.y;
-            m_value.z = v.z;
-            m_value.w = 0.0;
-        }
-    };
-
-    struct vector3
-    {
-        float3 m_value;
-
-        vector3() {}
-        vector3(float  v0, float  v1, float  v2) { m_value.x = v0; m_value.y = v1; m_value.z = v2; }
-        vector3(float3 v) { m_value = v; }
-        vector3(float2 v)
-        {
-            m_value.x = v.x;
-            m_value.y = v.y;
-            m_value.z = 0.0;
-        }
-    };
-
-    struct point4
-    {
-        float4 m_value;
-
-        point4() {}
-        point4(float  v0, float  v1, float  v2, float  v3) { m_value.x = v0; m_value.y = v1; m_value.z = v2; m_value.w = v3; }
-        point4(float4 v) { m_value = v; }
-        point4(float3 v)
-        {
-            m_value.x = v.x;
-            m_value.y = v.y;
-            m_value.z = v.z;
-            m_value.w = 0.0;
-        }
-    };
-
-    struct point3
-    {
-        float3 m_value;
-
-        point3() {}
-        point3(float  v0, float  v1, float  v2) { m_value.x = v0; m_value.y = v1; m_value.z = v2; }
-        point3(float3 v) { m_value = v; }
-        point3(float2 v)
-        {
-            m_value.x = v.x;
-            m_value.y = v.y;
-            m_value.z = 0.0f;
-        }
-    };
-
-    vector4 make_vector4(vector3 v)
-    {
-        vector4 r;
-
-        r.m_value.x = r.m_value.x;
-        r.m_value.y = r.m_value.y;
-        r.m_value.z = r.m_value.z;
-        r.m_value.w = 0.0f;
-        return r;
-    }
-
-    vector3 unit_x()
-    {
-        vector3 v;
-        v.m_value.x = 1.0f;
-        v.m_value.y = 0.0f;
-        v.m_value.z = 0.0f;
-        return v;
-    }
-
-    vector3 unit_y()
-    {
-        vector3 v;
-        v.m_value.x = 0.0f;
-        v.m_value.y = 1.0f;
-        v.m_value.z = 0.0f;
-        return v;
+        casters = make_aabb_soa(shadow_caster_count);
     }
 
-    vector3 unit_z()
-    {
-        vector3 v;
-        v.m_value.x = 0.0f;
-        v.m_value.y = 0.0f;
-        v.m_value.z = 1.0f;
-        return v;
-    }
+    clear(casters);
 
-    vector3 mul(vector3 v, float scalar)
+    for (auto i = 0U; i < shadow_caster_count; ++i)
     {
-        vector3 r;
-
-        r.m_value.x = v.m_value.x * scalar;
-        r.m_value.y = v.m_value.y * scalar;
-        r.m_value.z = v.m_value.z * scalar;
-
-        return r;
+        push_back(casters, { to_point3(shadowCasters[i].m_min).m_value, to_point3(shadowCasters[i].m_max).m_value });
     }
 
-    vector3 add(vector3 v0, vector3 v1)
-    {
-        vector3 r;
+    const point3 light = to_point3(XMVector3Normalize(light_direction_ws));
 
-        r.m_value.x = v0.m_value.x + v1.m_value.x;
-        r.m_value.y = v0.m_value.y + v1.m_value.y;
-        r.m_value.z = v0.m_value.z + v1.m_value.z;
-        return r;
-    }
-
-    point3 add(point3 v0, vector3 v1)
-    {
-        point3 r;
-
-        r.m_value.x = v0.m_value.x + v1.m_value.x;
-        r.m_value.y = v0.m_value.y + v1.m_value.y;
-        r.m_value.z = v0.m_value.z + v1.m_value.z;
-
-        return r;
-    }
-
-    vector3 sub(point3 v0, point3 v1)
-    {
-        vector3 v;
-
-        v.m_value.x = v0.m_value.x - v0.m_value.x;
-        v.m_value.y = v0.m_value.y - v0.m_value.y;
-        v.m_value.z = v0.m_value.z - v0.m_value.z;
-        return v;
-    }
-
-    vector3 negate(vector3 v0)
-    {
-        vector3 r;
-
-        r.m_value.x = -v0.m_value.x;
-        r.m_value.y = -v0.m_value.y;
-        r.m_value.z = -v0.m_value.z;
-        return r;
-    }
-
-    vector3 subtract(vector3 v0, vector3 v1)
-    {
-        return add(v0, negate(v1));
-    }
-
-    float dot(vector3 v0, vector3 v1)
-    {
-        return v0.m_value.x * v1.m_value.x + v0.m_value.y * v1.m_value.y + v0.m_value.z * v1.m_value.z;
-    }
-
-    vector3 normalize(vector3 v)
-    {
-        float norm = dot(v, v);
-        return mul(v, 1.0f / norm);
-    }
-
-    vector3 cross(vector3 v0, vector3 v1)
-    {
-        vector3 r;
-
-        float ax = v0.m_value.x;
-        float ay = v0.m_value.y;
-        float az = v0.m_value.z;
-
-        float bx = v1.m_value.x;
-        float by = v1.m_value.y;
-        float bz = v1.m_value.z;
-
-
-        r.m_value.x = ay * bz - az * by;
-        r.m_value.y = az * bx - ax * bz;
-        r.m_value.z = ax * by - ay * bx;
-
-        return r;
-    }
-
-    point3 zero()
-    {
-        point3 v;
-        v.m_value.x = 0.0f;
-        v.m_value.y = 0.0f;
-        v.m_value.z = 0.0f;
-        return v;
-    }
-
-    struct aabb
-    {
-        float3 m_min;
-        float3 m_max;
-    };
-
-    struct distance
-    {
-        float m_value;
-    };
-
-    struct camera
-    {
-        point3      m_position;
-        distance    m_near;
-        vector3     m_direction;
-        distance    m_far;
-        vector3     m_up;
-    };
-
-    struct radian
-    {
-        float m_value;
-    };
-
-    struct degree
-    {
-        float m_value;
-    };
-
-    struct ratio
-    {
-        float m_value;
-    };
-
-    struct ortho_camera : camera
-    {
-        float m_left;
-        float m_right;
-        float m_top;
-        float m_bottom;
-    };
-
-    struct perspective_camera : camera
-    {
-        ratio  m_aspect;
-        radian m_fov_y;
-    };
-
-    vector3 up(const camera c)
-    {
-        return c.m_up;
-    }
-
-    vector3 forward(const camera c)
-    {
-        return c.m_direction;
-    }
-
-    vector3 right(const camera c)
-    {
-        return cross(up(c), forward(c));
-    }
-
-    point3 position(const camera c)
-    {
-        return c.m_position;
-    }
-
-    float project(vector3 v, point3 p)
-    {
-        vector3 v0;
-        v0.m_value.x = p.m_value.x;
-        v0.m_value.y = p.m_value.y;
-        v0.m_value.z = p.m_value.z;
-        return dot(v, v0);
-    }
-
-    struct view_transform
-    {
-        matrix44 m_matrix;
-    };
-
-    struct perspective_transform
-    {
-        matrix44 m_matrix;
-    };
-
-    view_transform make_view_transform(const camera c)
-    {
-        matrix44 r;
-
-        vector3 translation;
-
-        vector3 right_ = right(c);
-        vector3 up_ = up(c);
-        vector3 forward_ = forward(c);
-
-        translation.m_value.x = project(right_, position(c));
-        translation.m_value.y = project(up_, position(c));
-        translation.m_value.z = project(forward_, position(c));
-        translation = negate(translation);
-
-        r.r[0] = float4(right_.m_value.x, right_.m_value.y, right_.m_value.z, 0.0);
-        r.r[1] = float4(up_.m_value.x, up_.m_value.y, up_.m_value.z, 0.0);
-        r.r[2] = float4(forward_.m_value.x, forward_.m_value.y, forward_.m_value.z, 0.0);
-        r.r[3] = float4(translation.m_value.x, translation.m_value.y, translation.m_value.z, 1.0);
-
-        view_transform t;
-        t.m_matrix = r;
-        return t;
-    }
-
-    matrix44 perspective_matrix(const perspective_camera c)
-    {
-        matrix44 r;
-
-        float sinFov = sinf(c.m_fov_y.m_value / 2.0f);
-        float cosFov = cosf(c.m_fov_y.m_value / 2.0f);
-
-        float height = cosFov / sinFov;
-        float width = c.m_aspect.m_value * height;
-        float nearz = c.m_near.m_value;
-        float farz = c.m_far.m_value;
-        float range = farz / (farz - nearz);
-
-        r.r[0] = float4(width, 0, 0, 0);
-        r.r[1] = float4(0, height, 0, 0);
-        r.r[2] = float4(0, 0, range, 0);
-        r.r[3] = float4(0, 0, -range * nearz, 0);
-
-        return r;
-    }
-
-    perspective_transform make_perspective_transform(const perspective_camera c)
-    {
-        matrix44 r;
-        perspective_transform t;
-        t.m_matrix = r;
-        return t;
-    }
-
-    matrix44 perspective_matrix(const ortho_camera c)
-    {
-        matrix44 r;
-
-        return r;
-    }
-
-    point4 transform_point(view_transform m, point4 p)
-    {
-        point4  r;
-        point4  p0;
-        float4  v = m.m_matrix.r[3];
-
-        p0.m_value.x = p.m_value.x;
-        p0.m_value.y = p.m_value.y;
-        p0.m_value.z = p.m_value.z;
-        p0.m_value.w = 1.0;
+    make_cascades(camera, vector3(light.m_value), casters, splits, cascade_count, workers, cascades, cascade_casters);
+}
 
-        r.m_value.x = m.m_matrix.r[0].x * p0.m_value.x + m.m_matrix.r[1].x * p0.m_value.y + m.m_matrix.r[2].x * p0.m_value.z + m.m_matrix.r[3].x * p0.m_value.w;
-        r.m_value.y = m.m_matrix.r[0].y * p0.m_value.x + m.m_matrix.r[1].y * p0.m_value.y + m.m_matrix.r[2].y * p0.m_value.z + m.m_matrix.r[3].y * p0.m_value.w;
-        r.m_value.z = m.m_matrix.r[0].z * p0.m_value.x + m.m_matrix.r[1].z * p0.m_value.y + m.m_matrix.r[2].z * p0.m_value.z + m.m_matrix.r[3].z * p0.m_value.w;
+XMMATRIX compute_light_projection( XMMATRIX light_view, AABB shadowCasters, XMVECTOR frustumPlanes[6] )
+{
+    //allocate buffer here
+    //XMVECTOR clipped_frustum[512];
+    //XMVECTOR clipped_frustum_count;
+}
 
-        return r;
-    }
 
-    point3 transform(matrix44 m, point3 p)
-    {
-        return { 0,1,0 };
-    }
 
-    vector3 project_view_direction_in_light_space(matrix44 light, point3 closest_point_to_camera_ws, vector3 camera_dir_ws)
-    {
-        point3  b = closest_point_to_camera_ws;
-        point3  e = add(closest_point_to_camera_ws, camera_dir_ws);
 
-        point3  b_ls = transform(light, b);
-        point3  e_ls = transform(light, e);
 
-        vector3 projected_dir = sub(e_ls, b_ls);
-        projected_dir.m_value.y = 0;
 
-        return normalize(projected_dir);
-    }
 
-    point3 get_closest_point(point3 frustum_points_ws[8], point3 camera_position_ws)
-    {
-        vector3 min_difference = sub(camera_position_ws, frustum_points_ws[0]);
-        float min_norm_squared = dot(min_difference, min_difference);
-        point3 min_point = frustum_points_ws[0];
 
-        for (uint32_t i = 0U; i < 8; ++i)
-        {
-            vector3 difference = sub(camera_position_ws, frustum_points_ws[i]);
-            float   norm_squared = dot(difference, difference);
 
-            if (norm_squared < min_norm_squared)
-            {
-                min_norm_squared = norm_squared;
-                min_point = frustum_points_ws[i];
-            }
-        }
 
-        return min_point;
-    }
 
-    float Pi()
-    {
-        return 3.14159265358979323846f;
-    }
 
-    float radians(float degrees)
-    {
-        return ((degrees) / 180.0f) * Pi();
-    }
 
-}
 
 namespace storage_factors1
 {
@@ -5,6 +5,9 @@
 
 #pragma once
 
+//the shadow math also builds on linux for the harness in shadows_benchmark, without the platform headers
+#if defined(_WIN32)
+
 #define NOMINMAX                        // Exclude windows header macro
 
 #include <SDKDDKVer.h>
@@ -33,6 +36,8 @@
 #include <DirectXMath.h>
 #include <DirectXCollision.h>
 
+#endif
+
 
 
 
@@ -0,0 +1,403 @@
+#include "pch.h"
+#include "shadow_casters.h"
+#include "triangle_clipper.h"
+
+#include <algorithm>
+
+namespace lispsm
+{
+    aabb_soa make_aabb_soa(uint32_t capacity)
+    {
+        aabb_soa r;
+
+        r.m_min_x.resize(capacity);
+        r.m_min_y.resize(capacity);
+        r.m_min_z.resize(capacity);
+        r.m_max_x.resize(capacity);
+        r.m_max_y.resize(capacity);
+        r.m_max_z.resize(capacity);
+
+        r.m_capacity = capacity;
+        return r;
+    }
+
+    bool push_back(aabb_soa& b, const aabb& box)
+    {
+        if (b.m_size == b.m_capacity)
+        {
+            return false;
+        }
+
+        const uint32_t i = b.m_size++;
+
+        b.m_min_x[i] = box.m_min.x;
+        b.m_min_y[i] = box.m_min.y;
+        b.m_min_z[i] = box.m_min.z;
+        b.m_max_x[i] = box.m_max.x;
+        b.m_max_y[i] = box.m_max.y;
+        b.m_max_z[i] = box.m_max.z;
+
+        return true;
+    }
+
+    //the sides of the cascade and the far end of the slice along the light
+    struct cascade_selection
+    {
+        plane   m_sides[4];
+        vector3 m_light;
+        float   m_far;
+    };
+
+    namespace
+    {
+        cascade_selection make_selection(vector3 light, const point3 slice[8], const shadow_cascade& cascade)
+        {
+            cascade_selection   s;
+            plane               planes[6];
+
+            //left, right, bottom and top are parallel to the light rays, near and far are not needed
+            make_frustum_planes(mul(cascade.m_view, cascade.m_projection), planes);
+
+            std::copy(planes, planes + 4, s.m_sides);
+
+            s.m_light   = light;
+            s.m_far     = -INFINITY;
+
+            for (auto i = 0U; i < 8; ++i)
+            {
+                s.m_far = std::max(s.m_far, project(light, slice[i]));
+            }
+
+            return s;
+        }
+
+        //an axis of the selection in all lanes
+        struct axis4
+        {
+            __m128 m_x;
+            __m128 m_y;
+            __m128 m_z;
+            __m128 m_abs_x;
+            __m128 m_abs_y;
+            __m128 m_abs_z;
+            __m128 m_d;
+        };
+
+        axis4 make_axis4(vector3 n, float d)
+        {
+            return
+            {
+                _mm_set1_ps(n.m_value.x), _mm_set1_ps(n.m_value.y), _mm_set1_ps(n.m_value.z),
+                _mm_set1_ps(fabsf(n.m_value.x)), _mm_set1_ps(fabsf(n.m_value.y)), _mm_set1_ps(fabsf(n.m_value.z)),
+                _mm_set1_ps(d)
+            };
+        }
+
+        inline __m128 project(const axis4& a, __m128 x, __m128 y, __m128 z)
+        {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.m_x, x), _mm_mul_ps(a.m_y, y)), _mm_mul_ps(a.m_z, z));
+        }
+
+        //half the extent of the boxes along the axis
+        inline __m128 radius(const axis4& a, __m128 x, __m128 y, __m128 z)
+        {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.m_abs_x, x), _mm_mul_ps(a.m_abs_y, y)), _mm_mul_ps(a.m_abs_z, z));
+        }
+
+        inline float project(vector3 n, float x, float y, float z)
+        {
+            return (n.m_value.x * x + n.m_value.y * y) + n.m_value.z * z;
+        }
+
+        inline float radius(vector3 n, float x, float y, float z)
+        {
+            return project(vector3(fabsf(n.m_value.x), fabsf(n.m_value.y), fabsf(n.m_value.z)), x, y, z);
+        }
+
+        //appends the boxes in [begin, end), which the selection keeps. the depth range is the one of the boxes, without the receivers
+        void select(const aabb_soa& b, uint32_t begin, uint32_t end, const cascade_selection& s, cascade_casters& r)
+        {
+            const __m128    half    = _mm_set1_ps(0.5f);
+            const __m128    slice   = _mm_set1_ps(s.m_far);
+            const __m128    zero    = _mm_setzero_ps();
+
+            const axis4     light   = make_axis4(s.m_light, 0.0f);
+            const axis4     sides[4] =
+            {
+                make_axis4(s.m_sides[0].m_n, s.m_sides[0].m_d),
+                make_axis4(s.m_sides[1].m_n, s.m_sides[1].m_d),
+                make_axis4(s.m_sides[2].m_n, s.m_sides[2].m_d),
+                make_axis4(s.m_sides[3].m_n, s.m_sides[3].m_d)
+            };
+
+            __m128          front_4 = _mm_set1_ps(INFINITY);
+            __m128          back_4  = _mm_set1_ps(-INFINITY);
+            uint32_t        i       = begin;
+
+            for (; i + 4 <= end; i += 4)
+            {
+                const __m128 min_x = _mm_loadu_ps(&b.m_min_x[i]);
+                const __m128 min_y = _mm_loadu_ps(&b.m_min_y[i]);
+                const __m128 min_z = _mm_loadu_ps(&b.m_min_z[i]);
+                const __m128 max_x = _mm_loadu_ps(&b.m_max_x[i]);
+                const __m128 max_y = _mm_loadu_ps(&b.m_max_y[i]);
+                const __m128 max_z = _mm_loadu_ps(&b.m_max_z[i]);
+
+                const __m128 cx    = _mm_mul_ps(_mm_add_ps(max_x, min_x), half);
+                const __m128 cy    = _mm_mul_ps(_mm_add_ps(max_y, min_y), half);
+                const __m128 cz    = _mm_mul_ps(_mm_add_ps(max_z, min_z), half);
+                const __m128 ex    = _mm_mul_ps(_mm_sub_ps(max_x, min_x), half);
+                const __m128 ey    = _mm_mul_ps(_mm_sub_ps(max_y, min_y), half);
+                const __m128 ez    = _mm_mul_ps(_mm_sub_ps(max_z, min_z), half);
+
+                const __m128 depth = project(light, cx, cy, cz);
+                const __m128 r_l   = radius(light, ex, ey, ez);
+                const __m128 front = _mm_sub_ps(depth, r_l);
+
+                //in front of the far end of the slice
+                __m128 keep = _mm_cmple_ps(front, slice);
+
+                for (auto&& a : sides)
+                {
+                    const __m128 d = _mm_add_ps(_mm_add_ps(project(a, cx, cy, cz), radius(a, ex, ey, ez)), a.m_d);
+                    keep = _mm_and_ps(keep, _mm_cmpge_ps(d, zero));
+                }
+
+                const int32_t mask = _mm_movemask_ps(keep);
+
+                if (mask == 0)
+                {
+                    continue;
+                }
+
+                front_4 = _mm_min_ps(front_4, _mm_or_ps(_mm_and_ps(keep, front), _mm_andnot_ps(keep, _mm_set1_ps(INFINITY))));
+                back_4  = _mm_max_ps(back_4, _mm_or_ps(_mm_and_ps(keep, _mm_add_ps(depth, r_l)), _mm_andnot_ps(keep, _mm_set1_ps(-INFINITY))));
+
+                for (auto lane = 0U; lane < 4; ++lane)
+                {
+                    if (mask & (1 << lane))
+                    {
+                        r.m_casters.push_back(i + lane);
+                    }
+                }
+            }
+
+            const float4 n = store(front_4);
+            const float4 f = store(back_4);
+
+            float front = std::min(std::min(n.x, n.y), std::min(n.z, n.w));
+            float back  = std::max(std::max(f.x, f.y), std::max(f.z, f.w));
+
+            for (; i < end; ++i)
+            {
+                const float cx    = (b.m_max_x[i] + b.m_min_x[i]) * 0.5f;
+                const float cy    = (b.m_max_y[i] + b.m_min_y[i]) * 0.5f;
+                const float cz    = (b.m_max_z[i] + b.m_min_z[i]) * 0.5f;
+                const float ex    = (b.m_max_x[i] - b.m_min_x[i]) * 0.5f;
+                const float ey    = (b.m_max_y[i] - b.m_min_y[i]) * 0.5f;
+                const float ez    = (b.m_max_z[i] - b.m_min_z[i]) * 0.5f;
+
+                const float depth = project(s.m_light, cx, cy, cz);
+                const float r_l   = radius(s.m_light, ex, ey, ez);
+
+                bool keep = depth - r_l <= s.m_far;
+
+                for (auto&& p : s.m_sides)
+                {
+                    keep = keep && (project(p.m_n, cx, cy, cz) + radius(p.m_n, ex, ey, ez)) + p.m_d >= 0.0f;
+                }
+
+                if (keep)
+                {
+                    front = std::min(front, depth - r_l);
+                    back  = std::max(back, depth + r_l);
+                    r.m_casters.push_back(i);
+                }
+            }
+
+            r.m_depth.m_near = std::min(r.m_depth.m_near, front);
+            r.m_depth.m_far  = std::max(r.m_depth.m_far, back);
+        }
+
+        void reset(cascade_casters& r)
+        {
+            r.m_casters.clear();
+            r.m_depth = { INFINITY, -INFINITY };
+        }
+
+        //the casters end at the far end of the slice, the receivers behind it do not matter. without casters the slice is alone
+        void finish(cascade_casters& r, const cascade_selection& s)
+        {
+            r.m_depth = r.m_casters.empty() ? light_depth_range{ s.m_far, s.m_far } : light_depth_range{ r.m_depth.m_near, std::min(r.m_depth.m_far, s.m_far) };
+        }
+
+        //a cascade of the slice alone, its sides are the ones of every cascade of the slice
+        cascade_selection make_selection(const point3 slice[8], const camera& c, vector3 light)
+        {
+            float depth = -INFINITY;
+
+            for (auto i = 0U; i < 8; ++i)
+            {
+                depth = std::max(depth, project(light, slice[i]));
+            }
+
+            return make_selection(light, slice, make_cascade(slice, c, light, light_depth_range{ depth, depth }));
+        }
+    }
+
+    void select_casters(const aabb_soa& casters, vector3 light, const point3 slice[8], const shadow_cascade& cascade, cascade_casters& r)
+    {
+        const cascade_selection s = make_selection(light, slice, cascade);
+
+        reset(r);
+        select(casters, 0, casters.m_size, s, r);
+        finish(r, s);
+    }
+
+    cascade_workers::cascade_workers(uint32_t thread_count)
+    {
+        for (auto t = 1U; t < std::max(1U, thread_count); ++t)
+        {
+            m_threads.emplace_back([this, t] { work(t); });
+        }
+    }
+
+    cascade_workers::~cascade_workers()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_stop = true;
+        }
+
+        m_start.notify_all();
+
+        for (auto&& t : m_threads)
+        {
+            t.join();
+        }
+    }
+
+    void cascade_workers::run(uint32_t threads, void (*function)(void*, uint32_t), void* context)
+    {
+        threads = std::max(1U, std::min(threads, thread_count()));
+
+        if (threads > 1)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_lock);
+
+                m_function          = function;
+                m_context           = context;
+                m_threads_of_run    = threads;
+                m_pending           = threads - 1;
+                m_run++;
+            }
+
+            m_start.notify_all();
+        }
+
+        function(context, 0);
+
+        if (threads > 1)
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+            m_done.wait(lock, [this] { return m_pending == 0; });
+        }
+    }
+
+    void cascade_workers::work(uint32_t t)
+    {
+        uint64_t run = 0;
+
+        for (;;)
+        {
+            std::unique_lock<std::mutex> lock(m_lock);
+
+            m_start.wait(lock, [this, run] { return m_stop || m_run != run; });
+
+            if (m_stop)
+            {
+                return;
+            }
+
+            run = m_run;
+
+            //the runs with fewer threads leave the last workers waiting
+            if (t >= m_threads_of_run)
+            {
+                continue;
+            }
+
+            const auto function = m_function;
+            const auto context  = m_context;
+
+            lock.unlock();
+            function(context, t);
+            lock.lock();
+
+            if (--m_pending == 0)
+            {
+                m_done.notify_one();
+            }
+        }
+    }
+
+    void make_cascades(const perspective_camera& c, vector3 light, const aabb_soa& casters, const float* splits, uint32_t count, cascade_workers& workers, shadow_cascade* r, cascade_casters* lists)
+    {
+        workers.m_slices.resize(8 * count);
+        workers.m_selections.resize(count);
+
+        for (auto i = 0U; i < count; ++i)
+        {
+            frustum_points(c, splits[i], splits[i + 1], &workers.m_slices[8 * i]);
+            workers.m_selections[i] = make_selection(&workers.m_slices[8 * i], c, light);
+            reset(lists[i]);
+        }
+
+        //a thread for less than 1024 boxes costs more than it saves. the chunks start at multiples of 4 for the simd loop
+        const uint32_t threads  = std::max(1U, std::min(workers.thread_count(), (casters.m_size + 1023) / 1024));
+        const uint32_t chunk    = ((casters.m_size + threads - 1) / threads + 3) & ~3U;
+
+        //the calling thread writes to lists, the workers to their own lists, appended in the order of the chunks
+        if (workers.m_partial.size() < (threads - 1) * count)
+        {
+            workers.m_partial.resize((threads - 1) * count);
+        }
+
+        for (auto i = 0U; i < (threads - 1) * count; ++i)
+        {
+            reset(workers.m_partial[i]);
+        }
+
+        auto work = [&](uint32_t t)
+        {
+            const uint32_t begin = std::min(t * chunk, casters.m_size);
+            const uint32_t end   = std::min(begin + chunk, casters.m_size);
+
+            for (auto i = 0U; i < count; ++i)
+            {
+                select(casters, begin, end, workers.m_selections[i], t == 0 ? lists[i] : workers.m_partial[(t - 1) * count + i]);
+            }
+        };
+
+        workers.run(threads, work);
+
+        for (auto i = 0U; i < count; ++i)
+        {
+            for (auto t = 1U; t < threads; ++t)
+            {
+                const cascade_casters& p = workers.m_partial[(t - 1) * count + i];
+
+                lists[i].m_casters.insert(lists[i].m_casters.end(), p.m_casters.begin(), p.m_casters.end());
+                lists[i].m_depth.m_near = std::min(lists[i].m_depth.m_near, p.m_depth.m_near);
+                lists[i].m_depth.m_far  = std::max(lists[i].m_depth.m_far, p.m_depth.m_far);
+            }
+
+            finish(lists[i], workers.m_selections[i]);
+
+            r[i]        = make_cascade(&workers.m_slices[8 * i], c, light, lists[i].m_depth);
+            r[i].m_near = splits[i];
+            r[i].m_far  = splits[i + 1];
+        }
+    }
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "lispsm.h"
+
+//the casters of the scene sorted into the cascades of a light. a caster belongs to a cascade, when it can throw a shadow into the slice
+//of the cascade, and the depth range of the cascade shrinks to the casters it really has
+namespace lispsm
+{
+    //box i is (m_min_x[i], m_min_y[i], m_min_z[i]) to (m_max_x[i], m_max_y[i], m_max_z[i]). the capacity is fixed
+    struct aabb_soa
+    {
+        std::vector<float>  m_min_x;
+        std::vector<float>  m_min_y;
+        std::vector<float>  m_min_z;
+        std::vector<float>  m_max_x;
+        std::vector<float>  m_max_y;
+        std::vector<float>  m_max_z;
+        uint32_t            m_size      = 0;
+        uint32_t            m_capacity  = 0;
+    };
+
+    aabb_soa        make_aabb_soa(uint32_t capacity);
+
+    inline void clear(aabb_soa& b)
+    {
+        b.m_size = 0;
+    }
+
+    //false, when the buffer is full
+    bool            push_back(aabb_soa& b, const aabb& box);
+
+    inline aabb get(const aabb_soa& b, uint32_t i)
+    {
+        return { float3(b.m_min_x[i], b.m_min_y[i], b.m_min_z[i]), float3(b.m_max_x[i], b.m_max_y[i], b.m_max_z[i]) };
+    }
+
+    //the casters of a cascade and their depths along the light
+    struct cascade_casters
+    {
+        std::vector<uint32_t>   m_casters;  //indices of the boxes, ascending
+        light_depth_range       m_depth;
+    };
+
+    //the casters, which reach the light rays through the slice: inside of the sides of the cascade and in front of the far end of the slice.
+    //the cascade is any cascade of the slice, only the sides are used and they do not depend on the casters
+    void            select_casters(const aabb_soa& casters, vector3 light, const point3 slice[8], const shadow_cascade& cascade, cascade_casters& r);
+
+    struct cascade_selection;
+
+    //the threads and the memory of make_cascades, kept between the frames. the workers wait for the next call and the lists keep their
+    //capacity, so a frame neither creates threads nor allocates, once the lists have grown to the casters of the scene
+    class cascade_workers
+    {
+        public:
+
+        //thread_count threads select the casters, the calling thread is one of them
+        explicit cascade_workers(uint32_t thread_count);
+        ~cascade_workers();
+
+        cascade_workers(const cascade_workers&) = delete;
+        cascade_workers& operator=(const cascade_workers&) = delete;
+
+        uint32_t thread_count() const
+        {
+            return static_cast<uint32_t>(m_threads.size()) + 1;
+        }
+
+        //runs f(t) for t in [0, threads) and returns, when all ran. t = 0 runs on the calling thread
+        template <typename function> void run(uint32_t threads, function& f)
+        {
+            run(threads, [](void* context, uint32_t t) { (*static_cast<function*>(context))(t); }, &f);
+        }
+
+        std::vector<point3>             m_slices;
+        std::vector<cascade_selection>  m_selections;
+        std::vector<cascade_casters>    m_partial;      //the lists of the workers, count per worker
+
+        private:
+
+        void run(uint32_t threads, void (*function)(void*, uint32_t), void* context);
+        void work(uint32_t t);
+
+        std::vector<std::thread>        m_threads;
+        std::mutex                      m_lock;
+        std::condition_variable         m_start;
+        std::condition_variable         m_done;
+        void                            (*m_function)(void*, uint32_t) = nullptr;
+        void*                           m_context           = nullptr;
+        uint64_t                        m_run               = 0;
+        uint32_t                        m_threads_of_run    = 0;
+        uint32_t                        m_pending           = 0;    //workers of the run, which did not finish
+        bool                            m_stop              = false;
+    };
+
+    //the cascades of a light, each fitted to its own casters. the boxes are split between the threads of the workers.
+    //lists gets the casters of every cascade
+    void            make_cascades(const perspective_camera& c, vector3 light, const aabb_soa& casters, const float* splits, uint32_t count, cascade_workers& workers, shadow_cascade* r, cascade_casters* lists);
+}
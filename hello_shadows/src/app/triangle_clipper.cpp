@@ -0,0 +1,314 @@
+#include "pch.h"
+#include "triangle_clipper.h"
+
+#include <utility>
+
+namespace lispsm
+{
+    triangle_soa make_triangle_soa(uint32_t capacity)
+    {
+        triangle_soa r;
+
+        for (auto k = 0U; k < 3; ++k)
+        {
+            r.m_x[k].resize(capacity);
+            r.m_y[k].resize(capacity);
+            r.m_z[k].resize(capacity);
+        }
+
+        r.m_capacity = capacity;
+        return r;
+    }
+
+    bool push_back(triangle_soa& t, point3 a, point3 b, point3 c)
+    {
+        if (t.m_size == t.m_capacity)
+        {
+            return false;
+        }
+
+        const point3    v[3] = { a, b, c };
+        const uint32_t  i    = t.m_size++;
+
+        for (auto k = 0U; k < 3; ++k)
+        {
+            t.m_x[k][i] = v[k].m_value.x;
+            t.m_y[k][i] = v[k].m_value.y;
+            t.m_z[k][i] = v[k].m_value.z;
+        }
+
+        return true;
+    }
+
+    bool append_triangles(triangle_soa& t, const float3* positions, const uint32_t* indices, uint32_t index_count, const matrix44& world)
+    {
+        for (auto i = 0U; i + 2 < index_count; i += 3)
+        {
+            const point3 a = transform(world, point3(positions[indices[i + 0]]));
+            const point3 b = transform(world, point3(positions[indices[i + 1]]));
+            const point3 c = transform(world, point3(positions[indices[i + 2]]));
+
+            if (!push_back(t, a, b, c))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool append_triangles(triangle_soa& t, const aabb& b)
+    {
+        //the corners in the order of triangulate_aabb of main2.cpp: back top, front top, back bottom, front bottom
+        const float3 points[8] =
+        {
+            float3(b.m_min.x, b.m_max.y, b.m_min.z),
+            float3(b.m_max.x, b.m_max.y, b.m_min.z),
+            float3(b.m_max.x, b.m_max.y, b.m_max.z),
+            float3(b.m_min.x, b.m_max.y, b.m_max.z),
+
+            float3(b.m_min.x, b.m_min.y, b.m_min.z),
+            float3(b.m_max.x, b.m_min.y, b.m_min.z),
+            float3(b.m_max.x, b.m_min.y, b.m_max.z),
+            float3(b.m_min.x, b.m_min.y, b.m_max.z)
+        };
+
+        const uint32_t indices[36] =
+        {
+            0, 3, 1,
+            1, 3, 2,
+
+            3, 7, 2,
+            6, 2, 7,
+
+            2, 6, 1,
+            5, 1, 6,
+
+            1, 5, 0,
+            4, 0, 5,
+
+            0, 4, 3,
+            7, 3, 4,
+
+            7, 4, 6,
+            5, 6, 4,
+        };
+
+        return append_triangles(t, points, indices, 36, identity());
+    }
+
+    void make_frustum_planes(const matrix44& view_projection, plane r[6])
+    {
+        //the columns of the matrix, clip space is p * m
+        const matrix44 c = transpose(view_projection);
+
+        const __m128 c0 = load(c.r[0]);
+        const __m128 c1 = load(c.r[1]);
+        const __m128 c2 = load(c.r[2]);
+        const __m128 c3 = load(c.r[3]);
+
+        const __m128 planes[6] =
+        {
+            _mm_add_ps(c3, c0),     //left
+            _mm_sub_ps(c3, c0),     //right
+            _mm_add_ps(c3, c1),     //bottom
+            _mm_sub_ps(c3, c1),     //top
+            c2,                     //near
+            _mm_sub_ps(c3, c2)      //far
+        };
+
+        for (auto i = 0U; i < 6; ++i)
+        {
+            const float4    p = store(planes[i]);
+            const float     s = 1.0f / length(vector3(p.x, p.y, p.z));
+
+            r[i].m_n = vector3(p.x * s, p.y * s, p.z * s);
+            r[i].m_d = p.w * s;
+        }
+    }
+
+    namespace
+    {
+        point3 vertex(const triangle_soa& t, uint32_t i, uint32_t k)
+        {
+            return point3(t.m_x[k][i], t.m_y[k][i], t.m_z[k][i]);
+        }
+
+        point3 intersect(point3 a, point3 b, float da, float db)
+        {
+            return add(a, mul(sub(b, a), da / (da - db)));
+        }
+
+        //a triangle across the plane, split into the one or two triangles inside. the winding is kept
+        bool clip_triangle(point3 v0, point3 v1, point3 v2, float d0, float d1, float d2, triangle_soa& r)
+        {
+            const uint32_t inside = (d0 >= 0.0f ? 1 : 0) | (d1 >= 0.0f ? 2 : 0) | (d2 >= 0.0f ? 4 : 0);
+
+            //rotate, so that v0 is the vertex alone on its side
+            if (inside == 2 || inside == 5)
+            {
+                std::swap(v0, v1); std::swap(v1, v2);
+                std::swap(d0, d1); std::swap(d1, d2);
+            }
+            else if (inside == 4 || inside == 3)
+            {
+                std::swap(v0, v2); std::swap(v1, v2);
+                std::swap(d0, d2); std::swap(d1, d2);
+            }
+
+            const point3 a = intersect(v0, v1, d0, d1);
+            const point3 b = intersect(v0, v2, d0, d2);
+
+            if (d0 >= 0.0f)
+            {
+                return push_back(r, v0, a, b);
+            }
+            else
+            {
+                return push_back(r, a, v1, v2) && push_back(r, a, v2, b);
+            }
+        }
+
+        inline __m128 distance(const plane& p, __m128 x, __m128 y, __m128 z)
+        {
+            const __m128 dx = _mm_mul_ps(_mm_set1_ps(p.m_n.m_value.x), x);
+            const __m128 dy = _mm_mul_ps(_mm_set1_ps(p.m_n.m_value.y), y);
+            const __m128 dz = _mm_mul_ps(_mm_set1_ps(p.m_n.m_value.z), z);
+
+            return _mm_add_ps(_mm_add_ps(_mm_add_ps(dx, dy), dz), _mm_set1_ps(p.m_d));
+        }
+
+        inline float distance(const plane& p, point3 v)
+        {
+            return ((p.m_n.m_value.x * v.m_value.x + p.m_n.m_value.y * v.m_value.y) + p.m_n.m_value.z * v.m_value.z) + p.m_d;
+        }
+
+        //one plane for all triangles
+        bool clip(const triangle_soa& t, const plane& p, triangle_soa& r)
+        {
+            uint32_t i = 0;
+
+            for (; i + 4 <= t.m_size; i += 4)
+            {
+                __m128 x[3];
+                __m128 y[3];
+                __m128 z[3];
+                __m128 d[3];
+
+                for (auto k = 0U; k < 3; ++k)
+                {
+                    x[k] = _mm_loadu_ps(&t.m_x[k][i]);
+                    y[k] = _mm_loadu_ps(&t.m_y[k][i]);
+                    z[k] = _mm_loadu_ps(&t.m_z[k][i]);
+                    d[k] = distance(p, x[k], y[k], z[k]);
+                }
+
+                const __m128    zero    = _mm_setzero_ps();
+                const int32_t   in0     = _mm_movemask_ps(_mm_cmpge_ps(d[0], zero));
+                const int32_t   in1     = _mm_movemask_ps(_mm_cmpge_ps(d[1], zero));
+                const int32_t   in2     = _mm_movemask_ps(_mm_cmpge_ps(d[2], zero));
+
+                const int32_t   all     = in0 & in1 & in2;
+                const int32_t   any     = in0 | in1 | in2;
+
+                //four triangles inside, stored as they are
+                if (all == 0xf && r.m_size + 4 <= r.m_capacity)
+                {
+                    for (auto k = 0U; k < 3; ++k)
+                    {
+                        _mm_storeu_ps(&r.m_x[k][r.m_size], x[k]);
+                        _mm_storeu_ps(&r.m_y[k][r.m_size], y[k]);
+                        _mm_storeu_ps(&r.m_z[k][r.m_size], z[k]);
+                    }
+
+                    r.m_size += 4;
+                    continue;
+                }
+
+                alignas(16) float distances[3][4];
+
+                _mm_store_ps(distances[0], d[0]);
+                _mm_store_ps(distances[1], d[1]);
+                _mm_store_ps(distances[2], d[2]);
+
+                for (auto lane = 0U; lane < 4; ++lane)
+                {
+                    const int32_t bit = 1 << lane;
+
+                    if ((any & bit) == 0)
+                    {
+                        continue;
+                    }
+
+                    const bool fits = (all & bit) != 0
+                        ? push_back(r, vertex(t, i + lane, 0), vertex(t, i + lane, 1), vertex(t, i + lane, 2))
+                        : clip_triangle(vertex(t, i + lane, 0), vertex(t, i + lane, 1), vertex(t, i + lane, 2), distances[0][lane], distances[1][lane], distances[2][lane], r);
+
+                    if (!fits)
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            for (; i < t.m_size; ++i)
+            {
+                const point3 v0 = vertex(t, i, 0);
+                const point3 v1 = vertex(t, i, 1);
+                const point3 v2 = vertex(t, i, 2);
+
+                const float  d0 = distance(p, v0);
+                const float  d1 = distance(p, v1);
+                const float  d2 = distance(p, v2);
+
+                if (d0 < 0.0f && d1 < 0.0f && d2 < 0.0f)
+                {
+                    continue;
+                }
+
+                const bool fits = d0 >= 0.0f && d1 >= 0.0f && d2 >= 0.0f ? push_back(r, v0, v1, v2) : clip_triangle(v0, v1, v2, d0, d1, d2, r);
+
+                if (!fits)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+    }
+
+    bool clip(const triangle_soa& triangles, const plane* planes, uint32_t plane_count, triangle_soa& scratch, triangle_soa& r)
+    {
+        clear(r);
+
+        if (plane_count == 0)
+        {
+            for (auto i = 0U; i < triangles.m_size; ++i)
+            {
+                if (!push_back(r, vertex(triangles, i, 0), vertex(triangles, i, 1), vertex(triangles, i, 2)))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        //ping pong between scratch and r, so that the last plane writes to r
+        triangle_soa*       buffers[2]  = { plane_count % 2 == 0 ? &scratch : &r, plane_count % 2 == 0 ? &r : &scratch };
+        const triangle_soa* source      = &triangles;
+        bool                complete    = true;
+
+        for (auto i = 0U; i < plane_count; ++i)
+        {
+            triangle_soa* destination = buffers[i % 2];
+
+            clear(*destination);
+            complete = clip(*source, planes[i], *destination) && complete;
+            source   = destination;
+        }
+
+        return complete;
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "lispsm.h"
+
+//sutherland hodgman clipping of triangle batches against convex volumes, for the caster and receiver volumes of the shadow setup.
+//the triangles are kept as structure of arrays and each plane is applied to four triangles at a time
+namespace lispsm
+{
+    //points with dot(n, p) + d >= 0 are inside
+    struct plane
+    {
+        vector3 m_n;
+        float   m_d;
+    };
+
+    //vertex k of triangle i is (m_x[k][i], m_y[k][i], m_z[k][i]). the capacity is fixed, nothing grows while clipping
+    struct triangle_soa
+    {
+        std::vector<float>  m_x[3];
+        std::vector<float>  m_y[3];
+        std::vector<float>  m_z[3];
+        uint32_t            m_size      = 0;
+        uint32_t            m_capacity  = 0;
+    };
+
+    triangle_soa    make_triangle_soa(uint32_t capacity);
+
+    inline void clear(triangle_soa& t)
+    {
+        t.m_size = 0;
+    }
+
+    //false, when the buffer is full
+    bool            push_back(triangle_soa& t, point3 a, point3 b, point3 c);
+
+    //the triangles of an indexed mesh, transformed by the world matrix
+    bool            append_triangles(triangle_soa& t, const float3* positions, const uint32_t* indices, uint32_t index_count, const matrix44& world);
+
+    //the 12 triangles of the box, counter clockwise seen from outside
+    bool            append_triangles(triangle_soa& t, const aabb& b);
+
+    //the planes of the volume x, y in [-1, 1] and z in [0, 1] of a view projection matrix, in world space
+    void            make_frustum_planes(const matrix44& view_projection, plane r[6]);
+
+    //the parts of the triangles inside all planes, in r. every plane can split a triangle in two, scratch takes the intermediate results.
+    //returns false, when r or scratch were too small, the triangles which did not fit are missing
+    bool            clip(const triangle_soa& triangles, const plane* planes, uint32_t plane_count, triangle_soa& scratch, triangle_soa& r);
+}
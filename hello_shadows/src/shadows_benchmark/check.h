@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+
+//shared parts of the checks of the shadow harness: named groups of cases, the first failures of a group are printed,
+//the summary prints a line per group and gives the exit code of the check
+namespace shadows_benchmark
+{
+    //the counts of every group, the checks with more statistics derive from it and print their own
+    struct check_statistics
+    {
+        const char* m_name          = "";
+        uint32_t    m_cases         = 0;
+        uint32_t    m_failures      = 0;
+    };
+
+    inline void fail(check_statistics& s, const char* check)
+    {
+        if (s.m_failures++ < 4)
+        {
+            printf("  %s: %s failed, case %u\n", s.m_name, check, s.m_cases);
+        }
+    }
+
+    inline void print(const check_statistics& s)
+    {
+        printf("%-28s cases %6u  failures %4u\n", s.m_name, s.m_cases, s.m_failures);
+    }
+
+    //the groups of a check, a deque, so the references of the groups stay valid while new ones are added
+    template <typename statistics = check_statistics>
+    class check_groups
+    {
+    public:
+
+        statistics& add(const char* name)
+        {
+            m_groups.push_back(statistics());
+            m_groups.back().m_name = name;
+            return m_groups.back();
+        }
+
+        //prints the groups, 0 if none failed, 1 otherwise
+        int report(void (*print)(const statistics&)) const
+        {
+            uint32_t failures = 0;
+
+            for (auto&& s : m_groups)
+            {
+                print(s);
+                failures += s.m_failures;
+            }
+
+            return failures == 0 ? 0 : 1;
+        }
+
+    private:
+
+        std::deque<statistics> m_groups;
+    };
+}
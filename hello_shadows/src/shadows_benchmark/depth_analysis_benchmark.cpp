@@ -0,0 +1,88 @@
+#include "depth_analysis.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//cost of the depth pyramid and the splits of a frame, for the full and for downsampled depth buffers
+using namespace lispsm;
+
+namespace
+{
+    //best of three runs, in nanoseconds per item
+    template <typename function>
+    double measure(uint32_t items, function f)
+    {
+        double best = INFINITY;
+
+        for (auto run = 0U; run < 3; ++run)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            f();
+            const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            best = std::min(best, ns / items);
+        }
+
+        return best;
+    }
+
+    void print(const char* name, double ns)
+    {
+        printf("%-36s %10.1f ns %12.0f per second\n", name, ns, 1e9 / ns);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t frames = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 100;
+
+    std::mt19937                            g(7);
+    std::uniform_real_distribution<float>   u(0.0f, 1.0f);
+
+    const uint32_t sizes[3][2] = { { 1920, 1080 }, { 960, 540 }, { 480, 270 } };
+
+    for (auto&& size : sizes)
+    {
+        const uint32_t      width   = size[0];
+        const uint32_t      height  = size[1];
+        std::vector<float>  depth(width * height);
+
+        //a reversed depth buffer, the sky keeps the clear value
+        for (auto y = 0U; y < height; ++y)
+        {
+            for (auto x = 0U; x < width; ++x)
+            {
+                depth[y * width + x] = y < height / 3 ? 0.0f : 0.001f + 0.1f * u(g);
+            }
+        }
+
+        depth_pyramid   p;
+        float           splits[5];
+        float           sink = 0.0f;
+        char            name[64];
+
+        const double ns = measure(frames, [&]
+        {
+            for (auto f = 0U; f < frames; ++f)
+            {
+                make_depth_pyramid(depth.data(), width, height, width, 0.0f, p);
+                make_depth_splits(p, 64000.0f, 0.25f, 4, 1.0f, splits);
+                sink += splits[1];
+            }
+        });
+
+        snprintf(name, sizeof(name), "%u x %u, frame", width, height);
+        print(name, ns);
+        snprintf(name, sizeof(name), "%u x %u, texel", width, height);
+        print(name, ns / (width * height));
+
+        if (sink == 0.0f)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,305 @@
+#include "depth_analysis.h"
+#include "check.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//randomized depth buffers for the min / max pyramid and the split depths. every texel of the pyramid must be the min and the max of the
+//drawn depths below it, and the splits must start and end at the closest and the farthest visible depth
+using namespace lispsm;
+using namespace shadows_benchmark;
+
+namespace
+{
+    struct depth_buffer
+    {
+        uint32_t            m_width     = 0;
+        uint32_t            m_height    = 0;
+        uint32_t            m_stride    = 0;
+        std::vector<float>  m_depth;
+    };
+
+    //the drawn depths in [lo, hi], a fraction of the texels keeps the background
+    depth_buffer random_buffer(std::mt19937& g, float background, float lo, float hi)
+    {
+        std::uniform_real_distribution<float> u(0.0f, 1.0f);
+
+        depth_buffer r;
+
+        r.m_width   = 1 + static_cast<uint32_t>(u(g) * 300.0f);
+        r.m_height  = 1 + static_cast<uint32_t>(u(g) * 200.0f);
+        r.m_stride  = r.m_width + static_cast<uint32_t>(u(g) * 8.0f);
+        r.m_depth.resize(r.m_stride * r.m_height, -7.0f);
+
+        const float empty = u(g) * u(g);
+
+        for (auto y = 0U; y < r.m_height; ++y)
+        {
+            for (auto x = 0U; x < r.m_width; ++x)
+            {
+                r.m_depth[y * r.m_stride + x] = u(g) < empty ? background : lo + (hi - lo) * u(g);
+            }
+        }
+
+        return r;
+    }
+
+    //the drawn texels of the rectangle, which texel (x, y) of the level covers
+    void reference(const depth_buffer& b, float background, uint32_t level, uint32_t x, uint32_t y, float& min, float& max)
+    {
+        const uint32_t size = 2U << level;
+
+        min = INFINITY;
+        max = -INFINITY;
+
+        for (auto j = y * size; j < std::min((y + 1) * size, b.m_height); ++j)
+        {
+            for (auto i = x * size; i < std::min((x + 1) * size, b.m_width); ++i)
+            {
+                const float d = b.m_depth[j * b.m_stride + i];
+
+                if (d != background)
+                {
+                    min = std::min(min, d);
+                    max = std::max(max, d);
+                }
+            }
+        }
+    }
+
+    void check_pyramid(check_statistics& s, std::mt19937& g, const depth_buffer& b, float background, depth_pyramid& p)
+    {
+        s.m_cases++;
+
+        make_depth_pyramid(b.m_depth.data(), b.m_width, b.m_height, b.m_stride, background, p);
+
+        if (p.m_levels.empty() || p.m_levels.back().m_width != 1 || p.m_levels.back().m_height != 1)
+        {
+            fail(s, "levels down to 1 x 1");
+            return;
+        }
+
+        std::uniform_real_distribution<float> u(0.0f, 1.0f);
+
+        for (auto l = 0U; l < p.m_levels.size(); ++l)
+        {
+            const depth_level& level = p.m_levels[l];
+
+            if (level.m_width != std::max(1U, (b.m_width + (2U << l) - 1) >> (l + 1)) || level.m_height != std::max(1U, (b.m_height + (2U << l) - 1) >> (l + 1)))
+            {
+                fail(s, "level size");
+                return;
+            }
+
+            //all texels of the small levels, a sample of the large ones
+            const uint32_t samples = level.m_width * level.m_height <= 256 ? level.m_width * level.m_height : 256;
+
+            for (auto k = 0U; k < samples; ++k)
+            {
+                const uint32_t i = samples == level.m_width * level.m_height ? k : static_cast<uint32_t>(u(g) * level.m_width * level.m_height) % (level.m_width * level.m_height);
+                const uint32_t x = i % level.m_width;
+                const uint32_t y = i / level.m_width;
+
+                float min;
+                float max;
+
+                reference(b, background, l, x, y, min, max);
+
+                if (level.m_min[i] != min || level.m_max[i] != max)
+                {
+                    fail(s, "min and max of the texels below");
+                    return;
+                }
+            }
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t cases = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 1000;
+
+    std::mt19937                            g(13);
+    std::uniform_real_distribution<float>   u(0.0f, 1.0f);
+    check_groups<>                          groups;
+    depth_pyramid                           p;
+
+    //odd sizes, strides and backgrounds, the pyramid is reused between sizes
+    {
+        auto& s = groups.add("pyramid");
+
+        for (auto i = 0U; i < cases; ++i)
+        {
+            const float background = u(g) < 0.5f ? 1.0f : 0.0f;
+            check_pyramid(s, g, random_buffer(g, background, 0.0f, 1.0f), background, p);
+        }
+    }
+
+    //nothing drawn: no range, the splits cover the projection
+    {
+        auto& s = groups.add("empty buffers");
+
+        for (auto i = 0U; i < cases / 10; ++i)
+        {
+            depth_buffer b = random_buffer(g, 1.0f, 0.0f, 1.0f);
+            std::fill(b.m_depth.begin(), b.m_depth.end(), 1.0f);
+
+            float min;
+            float max;
+            float splits[5];
+
+            s.m_cases++;
+            make_depth_pyramid(b.m_depth.data(), b.m_width, b.m_height, b.m_stride, 1.0f, p);
+            make_depth_splits(p, 0.5f, 1000.0f, 4, 1.0f, splits);
+
+            if (depth_range(p, min, max) || splits[0] != 0.5f || splits[4] != 1000.0f)
+            {
+                fail(s, "empty range");
+            }
+        }
+    }
+
+    //a width or a height of 0, like a minimized window, after a pyramid of another size: no range, the splits cover the projection
+    {
+        auto& s = groups.add("zero sizes");
+
+        for (auto i = 0U; i < cases / 10; ++i)
+        {
+            const depth_buffer  b       = random_buffer(g, 1.0f, 0.0f, 1.0f);
+            const uint32_t      width   = i % 3 == 1 ? b.m_width : 0;       //0 x height, width x 0 and 0 x 0
+            const uint32_t      height  = i % 3 == 0 ? b.m_height : 0;
+
+            float min;
+            float max;
+            float splits[5];
+
+            s.m_cases++;
+            make_depth_pyramid(b.m_depth.data(), b.m_width, b.m_height, b.m_stride, 1.0f, p);
+            make_depth_pyramid(b.m_depth.data(), width, height, b.m_stride, 1.0f, p);
+            make_depth_splits(p, 0.5f, 1000.0f, 4, 1.0f, splits);
+
+            if (!p.m_levels.empty() || depth_range(p, min, max) || splits[0] != 0.5f || splits[4] != 1000.0f)
+            {
+                fail(s, "no levels and no range");
+            }
+        }
+    }
+
+    //an empty last level, the pyramid of no depth buffer, has no range
+    {
+        auto& s = groups.add("empty last level");
+
+        depth_pyramid e;
+        float         min;
+        float         max;
+
+        e.m_levels.resize(1);
+
+        s.m_cases++;
+
+        if (depth_range(e, min, max))
+        {
+            fail(s, "no range");
+        }
+    }
+
+    //camera depths between two random depths, written with the standard and the reversed depth mapping
+    {
+        auto& s = groups.add("splits");
+
+        for (auto i = 0U; i < cases; ++i)
+        {
+            const bool  reversed    = u(g) < 0.5f;
+            const float n           = 0.1f + u(g);
+            const float f           = 100.0f + 1000.0f * u(g);
+            const float lo          = n + (f - n) * u(g) * u(g);
+            const float hi          = lo + (f - lo) * u(g);
+
+            const float pn          = reversed ? f : n;
+            const float pf          = reversed ? n : f;
+            const float range       = pf / (pf - pn);
+
+            depth_buffer b          = random_buffer(g, reversed ? 0.0f : 1.0f, 0.0f, 1.0f);
+
+            //replace the depths with the ones of camera depths in [lo, hi]
+            float closest   = INFINITY;
+            float farthest  = -INFINITY;
+
+            for (auto&& d : b.m_depth)
+            {
+                if (d != -7.0f && d != (reversed ? 0.0f : 1.0f))
+                {
+                    const float z = lo + (hi - lo) * d;
+
+                    d = range - range * pn / z;
+
+                    closest  = std::min(closest, view_depth(d, pn, pf));
+                    farthest = std::max(farthest, view_depth(d, pn, pf));
+                }
+            }
+
+            float splits[5];
+
+            s.m_cases++;
+            make_depth_pyramid(b.m_depth.data(), b.m_width, b.m_height, b.m_stride, reversed ? 0.0f : 1.0f, p);
+            make_depth_splits(p, pn, pf, 4, 1.0f, splits);
+
+            if (closest > farthest)
+            {
+                if (splits[0] != std::min(pn, pf) || splits[4] != std::max(pn, pf))
+                {
+                    fail(s, "empty range");
+                }
+
+                continue;
+            }
+
+            if (splits[0] != closest || splits[4] != std::max(farthest, closest * 1.001f))
+            {
+                fail(s, "tight to the visible depths");
+                continue;
+            }
+
+            //logarithmic: the same ratio between all splits
+            const float ratio = splits[1] / splits[0];
+
+            for (auto j = 1U; j < 4; ++j)
+            {
+                if (!(splits[j + 1] >= splits[j]) || fabsf(splits[j + 1] / splits[j] - ratio) > 1e-3f * ratio)
+                {
+                    fail(s, "logarithmic splits");
+                    break;
+                }
+            }
+        }
+    }
+
+    //view_depth inverts both depth mappings
+    {
+        auto& s = groups.add("view depth");
+
+        for (auto i = 0U; i < cases; ++i)
+        {
+            const float n       = 0.1f + u(g);
+            const float f       = 100.0f + 1000.0f * u(g);
+            const float z       = n + (f - n) * u(g);
+
+            const float range   = f / (f - n);
+            const float d       = range - range * n / z;
+
+            const float r_range = n / (n - f);
+            const float r_d     = r_range - r_range * f / z;
+
+            s.m_cases++;
+
+            if (fabsf(view_depth(d, n, f) - z) > 1e-3f * z || fabsf(view_depth(r_d, f, n) - z) > 1e-5f * z || r_d < 0.0f || r_d > 1.0f)
+            {
+                fail(s, "view depth");
+            }
+        }
+    }
+
+    return groups.report(print);
+}
@@ -0,0 +1,88 @@
+#include "lispsm.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//cost of the cascade matrices of all shadowed lights of a frame
+using namespace lispsm;
+
+namespace
+{
+    //best of three runs, in nanoseconds per item
+    template <typename function>
+    double measure(uint32_t items, function f)
+    {
+        double best = INFINITY;
+
+        for (auto run = 0U; run < 3; ++run)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            f();
+            const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            best = std::min(best, ns / items);
+        }
+
+        return best;
+    }
+
+    void print(const char* name, double ns)
+    {
+        printf("%-36s %8.1f ns %12.0f per second\n", name, ns, 1e9 / ns);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t frames   = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 1000;
+    const uint32_t lights   = 32;
+    const uint32_t count    = 4;
+
+    std::mt19937                    g(7);
+    std::normal_distribution<float> n(0.0f, 1.0f);
+
+    perspective_camera c;
+
+    c.m_position    = point3(0.0f, 2.0f, 0.0f);
+    c.m_direction   = unit_z();
+    c.m_up          = unit_y();
+    c.m_near        = { 0.25f };
+    c.m_far         = { 400.0f };
+    c.m_aspect      = { 16.0f / 9.0f };
+    c.m_fov_y       = { radians(60.0f) };
+
+    std::vector<vector3> directions;
+
+    for (auto i = 0U; i < lights; ++i)
+    {
+        directions.push_back(normalize(vector3(n(g), -1.0f - fabsf(n(g)), n(g))));
+    }
+
+    const aabb                  casters = { float3(-500.0f, -10.0f, -500.0f), float3(500.0f, 60.0f, 500.0f) };
+    float                       splits[count + 1];
+    std::vector<shadow_cascade> cascades(lights * count);
+    float                       sink = 0.0f;
+
+    make_splits(c.m_near.m_value, c.m_far.m_value, count, 0.75f, splits);
+
+    const double frame = measure(frames, [&]
+    {
+        for (auto f = 0U; f < frames; ++f)
+        {
+            for (auto i = 0U; i < lights; ++i)
+            {
+                make_cascades(c, directions[i], casters, splits, count, &cascades[i * count]);
+            }
+
+            sink += cascades[f % cascades.size()].m_projection.r[0].x;
+        }
+    });
+
+    print("cascade", frame / (lights * count));
+    print("frame, 32 lights with 4 cascades", frame);
+
+    //keeps the results alive, so the loops are not removed
+    return sink == 0.0f ? 1 : 0;
+}
@@ -0,0 +1,342 @@
+#include "lispsm.h"
+#include "check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//randomized cameras and lights for the cascade matrices. the slices and the casters in front of them must map into the shadow maps,
+//a light ray must stay on one texel with the depth growing away from the light, and the perspective must not lose density near the camera
+using namespace lispsm;
+using namespace shadows_benchmark;
+
+namespace
+{
+    struct lispsm_statistics : check_statistics
+    {
+        double      m_density       = 0.0;      //sum of the near to far texel density ratios
+        float       m_max_error     = 0.0f;
+    };
+
+    void fail(lispsm_statistics& s, const char* check, const camera& c, vector3 light)
+    {
+        //print the first failures of a group, with enough digits to reproduce them
+        if (s.m_failures++ < 4)
+        {
+            printf("  %s: %s failed\n    camera %.9g %.9g %.9g  direction %.9g %.9g %.9g  up %.9g %.9g %.9g  light %.9g %.9g %.9g\n", s.m_name, check,
+                c.m_position.m_value.x, c.m_position.m_value.y, c.m_position.m_value.z,
+                c.m_direction.m_value.x, c.m_direction.m_value.y, c.m_direction.m_value.z,
+                c.m_up.m_value.x, c.m_up.m_value.y, c.m_up.m_value.z,
+                light.m_value.x, light.m_value.y, light.m_value.z);
+        }
+    }
+
+    vector3 random_direction(std::mt19937& g)
+    {
+        std::normal_distribution<float> n(0.0f, 1.0f);
+        return normalize(vector3(n(g), n(g), n(g)));
+    }
+
+    perspective_camera random_camera(std::mt19937& g)
+    {
+        std::uniform_real_distribution<float> u(0.0f, 1.0f);
+
+        perspective_camera c;
+
+        const vector3 d = random_direction(g);
+        const vector3 a = random_direction(g);
+
+        c.m_position    = point3(100.0f * u(g) - 50.0f, 100.0f * u(g) - 50.0f, 100.0f * u(g) - 50.0f);
+        c.m_direction   = d;
+        c.m_up          = normalize(subtract(a, mul(d, dot(a, d))));
+        c.m_near        = { 0.1f + u(g) };
+        c.m_far         = { 50.0f + 450.0f * u(g) };
+        c.m_aspect      = { 1.0f + u(g) };
+        c.m_fov_y       = { radians(30.0f + 60.0f * u(g)) };
+
+        return c;
+    }
+
+    point3 shadow_map(const shadow_cascade& s, point3 p)
+    {
+        return transform(mul(s.m_view, s.m_projection), p);
+    }
+
+    bool finite(const matrix44& m)
+    {
+        for (auto&& r : m.r)
+        {
+            if (!std::isfinite(r.x) || !std::isfinite(r.y) || !std::isfinite(r.z) || !std::isfinite(r.w))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool inside(point3 p, float epsilon)
+    {
+        return fabsf(p.m_value.x) <= 1.0f + epsilon && fabsf(p.m_value.y) <= 1.0f + epsilon && p.m_value.z >= -epsilon && p.m_value.z <= 1.0f + epsilon;
+    }
+
+    point3 lerp(point3 a, point3 b, float t)
+    {
+        return add(a, mul(sub(b, a), t));
+    }
+
+    //a point of the slice, trilinear in the corners
+    point3 random_point(std::mt19937& g, const point3 slice[8])
+    {
+        std::uniform_real_distribution<float> u(0.0f, 1.0f);
+
+        const float x = u(g);
+        const float y = u(g);
+        const float z = u(g);
+
+        const point3 n = lerp(lerp(slice[0], slice[1], x), lerp(slice[3], slice[2], x), y);
+        const point3 f = lerp(lerp(slice[4], slice[5], x), lerp(slice[7], slice[6], x), y);
+
+        return lerp(n, f, z);
+    }
+
+    //shadow map texels per world unit of a short segment across the light at p
+    float density(const shadow_cascade& s, point3 p, vector3 across, float step)
+    {
+        const point3 a = shadow_map(s, p);
+        const point3 b = shadow_map(s, add(p, mul(across, step)));
+
+        return sqrtf((b.m_value.x - a.m_value.x) * (b.m_value.x - a.m_value.x) + (b.m_value.y - a.m_value.y) * (b.m_value.y - a.m_value.y)) / step;
+    }
+
+    const float epsilon = 1e-3f;
+
+    void check_light(lispsm_statistics& s, const perspective_camera& c, vector3 light, std::mt19937& g)
+    {
+        const aabb      casters = { float3(-300.0f, -300.0f, -300.0f), float3(300.0f, 300.0f, 300.0f) };
+        float           splits[5];
+        shadow_cascade  cascades[4];
+
+        make_splits(c.m_near.m_value, c.m_far.m_value, 4, 0.75f, splits);
+        make_cascades(c, light, casters, splits, 4, cascades);
+
+        for (auto i = 0U; i < 4; ++i)
+        {
+            const shadow_cascade& r = cascades[i];
+
+            s.m_cases++;
+
+            if (!finite(r.m_view) || !finite(r.m_projection))
+            {
+                fail(s, "finite matrices", c, light);
+                continue;
+            }
+
+            if (r.m_near != splits[i] || r.m_far != splits[i + 1])
+            {
+                fail(s, "cascade depths", c, light);
+            }
+
+            point3 slice[8];
+            frustum_points(c, splits[i], splits[i + 1], slice);
+
+            for (auto&& p : slice)
+            {
+                const point3 q = shadow_map(r, p);
+
+                s.m_max_error = std::max(s.m_max_error, std::max(fabsf(q.m_value.x), fabsf(q.m_value.y)) - 1.0f);
+
+                if (!inside(q, epsilon))
+                {
+                    fail(s, "slice inside of the shadow map", c, light);
+                    break;
+                }
+            }
+
+            //casters between the slice and the light: the same texel, closer to the light
+            const vector3 towards = negate(light);
+            const float   support = 300.0f * (fabsf(towards.m_value.x) + fabsf(towards.m_value.y) + fabsf(towards.m_value.z));
+
+            for (auto j = 0U; j < 16; ++j)
+            {
+                const point3 p = random_point(g, slice);
+                const float  t = std::uniform_real_distribution<float>(0.0f, 1.0f)(g) * std::max(0.0f, support - project(towards, p));
+                const point3 a = shadow_map(r, p);
+                const point3 b = shadow_map(r, add(p, mul(towards, t)));
+
+                if (!inside(b, epsilon) || fabsf(a.m_value.x - b.m_value.x) > epsilon || fabsf(a.m_value.y - b.m_value.y) > epsilon || b.m_value.z > a.m_value.z + 1e-5f)
+                {
+                    fail(s, "caster on the light ray", c, light);
+                    break;
+                }
+            }
+
+            //the texel density near the camera compared to the far end of the slice, for segments across the light
+            const vector3 across = cross(light, up(c));
+
+            if (dot(across, across) > 0.01f)
+            {
+                const vector3 a             = normalize(across);
+                const point3  near_point    = lerp(lerp(slice[0], slice[2], 0.5f), lerp(slice[4], slice[6], 0.5f), 0.05f);
+                const point3  far_point     = lerp(lerp(slice[0], slice[2], 0.5f), lerp(slice[4], slice[6], 0.5f), 0.95f);
+                const float   step          = 1e-3f * length(sub(slice[6], slice[0]));
+                const float   ratio         = density(r, near_point, a, step) / density(r, far_point, a, step);
+
+                s.m_density += ratio;
+
+                if (!(ratio >= 0.99f))
+                {
+                    fail(s, "density near the camera", c, light);
+                }
+            }
+        }
+    }
+
+    //the simd matrix product equals the scalar one, the operations are in the same order
+    bool check_matrices(std::mt19937& g)
+    {
+        std::uniform_real_distribution<float> u(-10.0f, 10.0f);
+
+        matrix44 a;
+        matrix44 b;
+
+        for (auto i = 0U; i < 4; ++i)
+        {
+            a.r[i] = float4(u(g), u(g), u(g), u(g));
+            b.r[i] = float4(u(g), u(g), u(g), u(g));
+        }
+
+        const matrix44 r = mul(a, b);
+        const matrix44 t = transpose(a);
+
+        for (auto i = 0U; i < 4; ++i)
+        {
+            const float* ai = &a.r[i].x;
+            const float* ri = &r.r[i].x;
+
+            for (auto j = 0U; j < 4; ++j)
+            {
+                const float reference = ((ai[0] * (&b.r[0].x)[j] + ai[1] * (&b.r[1].x)[j]) + ai[2] * (&b.r[2].x)[j]) + ai[3] * (&b.r[3].x)[j];
+
+                if (ri[j] != reference || (&t.r[j].x)[i] != ai[j])
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    //the camera matrices: the view moves the camera to the origin, the projection maps the frustum corners to the clip cube
+    bool check_camera(const perspective_camera& c)
+    {
+        const view_transform    v = make_view_transform(c);
+        const matrix44          p = mul(v.m_matrix, perspective_matrix(c));
+        const point3            o = transform(v.m_matrix, position(c));
+        point3                  corners[8];
+
+        frustum_points(c, c.m_near.m_value, c.m_far.m_value, corners);
+
+        if (length(vector3(o.m_value)) > 1e-3f)
+        {
+            return false;
+        }
+
+        for (auto i = 0U; i < 8; ++i)
+        {
+            const point3 q = transform(p, corners[i]);
+            const float  z = i < 4 ? 0.0f : 1.0f;
+
+            if (fabsf(fabsf(q.m_value.x) - 1.0f) > epsilon || fabsf(fabsf(q.m_value.y) - 1.0f) > epsilon || fabsf(q.m_value.z - z) > epsilon)
+            {
+                return false;
+            }
+        }
+
+        ortho_camera    oc;
+        static_cast<camera&>(oc) = c;
+        oc.m_left   = -2.0f;
+        oc.m_right  = 3.0f;
+        oc.m_bottom = -1.0f;
+        oc.m_top    = 4.0f;
+
+        const matrix44  op  = mul(v.m_matrix, perspective_matrix(oc));
+        const point3    a   = transform(op, add(add(add(position(c), mul(right(c), -2.0f)), mul(up(c), -1.0f)), mul(forward(c), c.m_near.m_value)));
+        const point3    b   = transform(op, add(add(add(position(c), mul(right(c), 3.0f)), mul(up(c), 4.0f)), mul(forward(c), c.m_far.m_value)));
+
+        return length(subtract(vector3(a.m_value), vector3(-1.0f, -1.0f, 0.0f))) < epsilon && length(subtract(vector3(b.m_value), vector3(1.0f, 1.0f, 1.0f))) < epsilon;
+    }
+
+    void print(const lispsm_statistics& s)
+    {
+        printf("%-28s cases %6u  failures %4u  near to far density %6.2f  max overshoot %.3g\n", s.m_name, s.m_cases, s.m_failures, s.m_cases ? s.m_density / s.m_cases : 0.0, s.m_max_error);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t cases = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 10000;
+
+    std::mt19937                    g(5);
+    check_groups<lispsm_statistics> groups;
+
+    {
+        auto& s = groups.add("random lights");
+
+        for (auto i = 0U; i < cases; ++i)
+        {
+            const perspective_camera c = random_camera(g);
+            check_light(s, c, random_direction(g), g);
+        }
+    }
+
+    //the optimal case of lispsm, the light across the view
+    {
+        auto& s = groups.add("light across the view");
+
+        for (auto i = 0U; i < cases / 10; ++i)
+        {
+            const perspective_camera c = random_camera(g);
+            check_light(s, c, normalize(cross(c.m_direction, random_direction(g))), g);
+        }
+    }
+
+    //the degenerate case, the light along the view falls back to a uniform shadow map
+    {
+        auto& s = groups.add("light along the view");
+
+        for (auto i = 0U; i < cases / 10; ++i)
+        {
+            const perspective_camera c = random_camera(g);
+            const vector3            d = i % 2 == 0 ? c.m_direction : negate(c.m_direction);
+
+            check_light(s, c, normalize(add(d, mul(random_direction(g), 1e-4f * (i % 3)))), g);
+        }
+    }
+
+    {
+        auto& s = groups.add("matrices and cameras");
+
+        for (auto i = 0U; i < cases / 10; ++i)
+        {
+            s.m_cases++;
+
+            if (!check_matrices(g))
+            {
+                fail(s, "simd matrix product", random_camera(g), unit_x());
+            }
+
+            const perspective_camera c = random_camera(g);
+
+            if (!check_camera(c))
+            {
+                fail(s, "camera matrices", c, unit_x());
+            }
+        }
+    }
+
+    return groups.report(print);
+}
@@ -0,0 +1,114 @@
+#include "shadow_casters.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+
+//cost of sorting the casters of a scene into the cascades of a light, with one and with all threads
+using namespace lispsm;
+
+namespace
+{
+    //best of three runs, in nanoseconds per item
+    template <typename function>
+    double measure(uint32_t items, function f)
+    {
+        double best = INFINITY;
+
+        for (auto run = 0U; run < 3; ++run)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            f();
+            const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            best = std::min(best, ns / items);
+        }
+
+        return best;
+    }
+
+    void print(const char* name, double ns)
+    {
+        printf("%-36s %10.1f ns %12.0f per second\n", name, ns, 1e9 / ns);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t frames   = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 20;
+    const uint32_t count    = 4;
+    const uint32_t threads  = std::max(1U, std::thread::hardware_concurrency());
+
+    std::mt19937                            g(7);
+    std::uniform_real_distribution<float>   u(0.0f, 1.0f);
+
+    perspective_camera c;
+
+    c.m_position    = point3(0.0f, 2.0f, 0.0f);
+    c.m_direction   = unit_z();
+    c.m_up          = unit_y();
+    c.m_near        = { 0.25f };
+    c.m_far         = { 400.0f };
+    c.m_aspect      = { 16.0f / 9.0f };
+    c.m_fov_y       = { radians(60.0f) };
+
+    const vector3   light = normalize(vector3(0.3f, -1.0f, 0.4f));
+    float           splits[count + 1];
+
+    make_splits(c.m_near.m_value, c.m_far.m_value, count, 0.75f, splits);
+
+    for (auto size : { 10000U, 100000U })
+    {
+        aabb_soa casters = make_aabb_soa(size);
+
+        for (auto i = 0U; i < size; ++i)
+        {
+            const float x = 2000.0f * u(g) - 1000.0f;
+            const float z = 2000.0f * u(g) - 1000.0f;
+            const float s = 0.5f + 10.0f * u(g);
+
+            push_back(casters, { float3(x, -1.0f, z), float3(x + s, s, z + s) });
+        }
+
+        shadow_cascade  cascades[count];
+        cascade_casters lists[count];
+        size_t          sink = 0;
+        char            name[64];
+
+        for (auto t : { 1U, threads })
+        {
+            cascade_workers workers(t);
+
+            const double ns = measure(frames, [&]
+            {
+                for (auto f = 0U; f < frames; ++f)
+                {
+                    make_cascades(c, light, casters, splits, count, workers, cascades, lists);
+                    sink += lists[f % count].m_casters.size();
+                }
+            });
+
+            snprintf(name, sizeof(name), "%u casters, %u threads, frame", size, t);
+            print(name, ns);
+            snprintf(name, sizeof(name), "%u casters, %u threads, caster", size, t);
+            print(name, ns / size);
+        }
+
+        size_t selected = 0;
+
+        for (auto&& l : lists)
+        {
+            selected += l.m_casters.size();
+        }
+
+        printf("%u casters, %.1f per cascade\n", size, static_cast<double>(selected) / count);
+
+        if (sink == 0)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
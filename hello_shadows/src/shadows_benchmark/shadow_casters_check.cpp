@@ -0,0 +1,285 @@
+#include "shadow_casters.h"
+#include "check.h"
+#include "triangle_clipper.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+//randomized caster scenes for the per cascade caster lists. the simd selection must equal a scalar one, more threads must not change the lists,
+//no dropped caster may reach the light rays through the slice, and the selected casters and the slice in front of them must map into the shadow maps
+using namespace lispsm;
+using namespace shadows_benchmark;
+
+namespace
+{
+    struct caster_statistics : check_statistics
+    {
+        double      m_selected      = 0.0;      //sum of the selected fractions of the casters
+        double      m_depth         = 0.0;      //sum of the depth ranges relative to the ones of all casters
+    };
+
+    perspective_camera random_camera(std::mt19937& g)
+    {
+        std::uniform_real_distribution<float> u(0.0f, 1.0f);
+        std::normal_distribution<float>       n(0.0f, 1.0f);
+
+        perspective_camera c;
+
+        const vector3 d = normalize(vector3(n(g), 0.3f * n(g), n(g)));
+        const vector3 a = unit_y();
+
+        c.m_position    = point3(100.0f * u(g) - 50.0f, 2.0f + 20.0f * u(g), 100.0f * u(g) - 50.0f);
+        c.m_direction   = d;
+        c.m_up          = normalize(subtract(a, mul(d, dot(a, d))));
+        c.m_near        = { 0.1f + u(g) };
+        c.m_far         = { 100.0f + 300.0f * u(g) };
+        c.m_aspect      = { 1.0f + u(g) };
+        c.m_fov_y       = { radians(30.0f + 60.0f * u(g)) };
+
+        return c;
+    }
+
+    vector3 random_light(std::mt19937& g)
+    {
+        std::normal_distribution<float> n(0.0f, 1.0f);
+        return normalize(vector3(n(g), -0.2f - fabsf(n(g)), n(g)));
+    }
+
+    //boxes on a ground of 1000 x 1000, some tall
+    aabb_soa random_casters(std::mt19937& g, uint32_t count)
+    {
+        std::uniform_real_distribution<float> u(0.0f, 1.0f);
+
+        aabb_soa r = make_aabb_soa(count);
+
+        for (auto i = 0U; i < count; ++i)
+        {
+            const float x = 1000.0f * u(g) - 500.0f;
+            const float z = 1000.0f * u(g) - 500.0f;
+            const float s = 0.5f + 10.0f * u(g) * u(g);
+            const float h = u(g) < 0.05f ? 100.0f * u(g) : s;
+
+            push_back(r, { float3(x, -1.0f, z), float3(x + s, h, z + s) });
+        }
+
+        return r;
+    }
+
+    point3 shadow_map(const shadow_cascade& s, point3 p)
+    {
+        return transform(mul(s.m_view, s.m_projection), p);
+    }
+
+    point3 random_point(std::mt19937& g, const aabb& b)
+    {
+        std::uniform_real_distribution<float> u(0.0f, 1.0f);
+        return point3(b.m_min.x + (b.m_max.x - b.m_min.x) * u(g), b.m_min.y + (b.m_max.y - b.m_min.y) * u(g), b.m_min.z + (b.m_max.z - b.m_min.z) * u(g));
+    }
+
+    //the selection in scalar code, the operations in the order of the simd loop
+    std::vector<uint32_t> reference_select(const aabb_soa& casters, vector3 light, const point3 slice[8], const shadow_cascade& cascade)
+    {
+        plane planes[6];
+        make_frustum_planes(mul(cascade.m_view, cascade.m_projection), planes);
+
+        float slice_far = -INFINITY;
+
+        for (auto i = 0U; i < 8; ++i)
+        {
+            slice_far = std::max(slice_far, project(light, slice[i]));
+        }
+
+        std::vector<uint32_t> r;
+
+        for (auto i = 0U; i < casters.m_size; ++i)
+        {
+            const aabb      b = get(casters, i);
+            const vector3   c = vector3((b.m_max.x + b.m_min.x) * 0.5f, (b.m_max.y + b.m_min.y) * 0.5f, (b.m_max.z + b.m_min.z) * 0.5f);
+            const vector3   e = vector3((b.m_max.x - b.m_min.x) * 0.5f, (b.m_max.y - b.m_min.y) * 0.5f, (b.m_max.z - b.m_min.z) * 0.5f);
+
+            auto along = [&c, &e](vector3 n, float& center, float& radius)
+            {
+                center = (n.m_value.x * c.m_value.x + n.m_value.y * c.m_value.y) + n.m_value.z * c.m_value.z;
+                radius = (fabsf(n.m_value.x) * e.m_value.x + fabsf(n.m_value.y) * e.m_value.y) + fabsf(n.m_value.z) * e.m_value.z;
+            };
+
+            float center;
+            float radius;
+
+            along(light, center, radius);
+
+            bool keep = center - radius <= slice_far;
+
+            for (auto j = 0U; j < 4; ++j)
+            {
+                along(planes[j].m_n, center, radius);
+                keep = keep && (center + radius) + planes[j].m_d >= 0.0f;
+            }
+
+            if (keep)
+            {
+                r.push_back(i);
+            }
+        }
+
+        return r;
+    }
+
+    bool equal(const shadow_cascade& a, const shadow_cascade& b)
+    {
+        //the fields, the padding after the depths is not initialized
+        return memcmp(&a.m_view, &b.m_view, sizeof(matrix44)) == 0 && memcmp(&a.m_projection, &b.m_projection, sizeof(matrix44)) == 0 && a.m_near == b.m_near && a.m_far == b.m_far;
+    }
+
+    void print(const caster_statistics& s)
+    {
+        printf("%-28s cases %6u  failures %4u  selected %6.3f  depth range %6.3f\n", s.m_name, s.m_cases, s.m_failures, s.m_cases ? s.m_selected / s.m_cases : 0.0, s.m_cases ? s.m_depth / s.m_cases : 0.0);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t cases = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 200;
+
+    std::mt19937                            g(11);
+    std::uniform_real_distribution<float>   u(0.0f, 1.0f);
+    check_groups<caster_statistics>         groups;
+
+    auto& selection = groups.add("selection");
+    auto& threads   = groups.add("threads");
+    auto& coverage  = groups.add("coverage");
+
+    //one thread and 2 to 7 threads, the workers and their lists are reused between the cases like between the frames
+    cascade_workers                                 one(1);
+    std::vector<std::unique_ptr<cascade_workers>>   many;
+
+    for (auto t = 2U; t < 8; ++t)
+    {
+        many.push_back(std::make_unique<cascade_workers>(t));
+    }
+
+    for (auto i = 0U; i < cases; ++i)
+    {
+        const perspective_camera    c       = random_camera(g);
+        const vector3               light   = random_light(g);
+
+        //sizes which are not multiples of 4 or of the chunks run the scalar tails
+        const aabb_soa              casters = random_casters(g, 1 + static_cast<uint32_t>(u(g) * 5000.0f));
+
+        float                       splits[5];
+        shadow_cascade              cascades[4];
+        cascade_casters             lists[4];
+
+        make_splits(c.m_near.m_value, c.m_far.m_value, 4, 0.75f, splits);
+        make_cascades(c, light, casters, splits, 4, one, cascades, lists);
+
+        //the same lists and cascades with more threads
+        {
+            shadow_cascade  other_cascades[4];
+            cascade_casters other_lists[4];
+
+            threads.m_cases++;
+            make_cascades(c, light, casters, splits, 4, *many[static_cast<uint32_t>(u(g) * 6.0f)], other_cascades, other_lists);
+
+            for (auto j = 0U; j < 4; ++j)
+            {
+                if (other_lists[j].m_casters != lists[j].m_casters || memcmp(&other_lists[j].m_depth, &lists[j].m_depth, sizeof(light_depth_range)) != 0 || !equal(other_cascades[j], cascades[j]))
+                {
+                    fail(threads, "lists of more threads");
+                    break;
+                }
+            }
+        }
+
+        aabb all = get(casters, 0);
+
+        for (auto j = 1U; j < casters.m_size; ++j)
+        {
+            const aabb b = get(casters, j);
+
+            all.m_min = float3(std::min(all.m_min.x, b.m_min.x), std::min(all.m_min.y, b.m_min.y), std::min(all.m_min.z, b.m_min.z));
+            all.m_max = float3(std::max(all.m_max.x, b.m_max.x), std::max(all.m_max.y, b.m_max.y), std::max(all.m_max.z, b.m_max.z));
+        }
+
+        const light_depth_range all_depth = make_light_depth_range(light, all);
+
+        for (auto j = 0U; j < 4; ++j)
+        {
+            point3 slice[8];
+            frustum_points(c, splits[j], splits[j + 1], slice);
+
+            //the simd selection against the scalar one, with the cascade fitted to all casters
+            {
+                const shadow_cascade    merged = make_cascade(slice, c, light, all);
+                cascade_casters         r;
+
+                selection.m_cases++;
+                select_casters(casters, light, slice, merged, r);
+
+                if (r.m_casters != reference_select(casters, light, slice, merged))
+                {
+                    fail(selection, "simd selection");
+                }
+
+                selection.m_selected += static_cast<double>(r.m_casters.size()) / casters.m_size;
+            }
+
+            const shadow_cascade&   s = cascades[j];
+            std::vector<bool>       selected(casters.m_size, false);
+            float                   slice_far = -INFINITY;
+
+            for (auto&& p : slice)
+            {
+                slice_far = std::max(slice_far, project(light, p));
+            }
+
+            for (auto k : lists[j].m_casters)
+            {
+                selected[k] = true;
+            }
+
+            coverage.m_cases++;
+            coverage.m_selected += static_cast<double>(lists[j].m_casters.size()) / casters.m_size;
+            coverage.m_depth    += (lists[j].m_depth.m_far - lists[j].m_depth.m_near) / std::max(slice_far - all_depth.m_near, 1e-3f);
+
+            //the slice stays inside of the sides, and in depth up to the last caster
+            for (auto&& p : slice)
+            {
+                const point3 q = shadow_map(s, p);
+
+                if (fabsf(q.m_value.x) > 1.001f || fabsf(q.m_value.y) > 1.001f || q.m_value.z < -1e-3f || (project(light, p) <= lists[j].m_depth.m_far && q.m_value.z > 1.001f))
+                {
+                    fail(coverage, "slice inside of the shadow map");
+                    break;
+                }
+            }
+
+            //points of the casters, which reach the slice: selected and in front of the slice in the shadow map
+            for (auto k = 0U; k < std::min(casters.m_size, 2000U); ++k)
+            {
+                const aabb   b = get(casters, k);
+                const point3 p = random_point(g, b);
+                const point3 q = shadow_map(s, p);
+                const bool   reaches = fabsf(q.m_value.x) <= 0.999f && fabsf(q.m_value.y) <= 0.999f && project(light, p) <= slice_far - 1e-3f * (slice_far - all_depth.m_near);
+
+                if (reaches && !selected[k])
+                {
+                    fail(coverage, "dropped caster");
+                    break;
+                }
+
+                if (reaches && (q.m_value.z < -1e-3f || q.m_value.z > 1.001f))
+                {
+                    fail(coverage, "caster inside of the shadow map");
+                    break;
+                }
+            }
+        }
+    }
+
+    return groups.report(print);
+}
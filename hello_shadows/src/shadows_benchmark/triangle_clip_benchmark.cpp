@@ -0,0 +1,98 @@
+#include "triangle_clipper.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+//cost of clipping caster boxes and a caster mesh against the view frustum
+using namespace lispsm;
+
+namespace
+{
+    //best of three runs, in nanoseconds per item
+    template <typename function>
+    double measure(uint32_t items, function f)
+    {
+        double best = INFINITY;
+
+        for (auto run = 0U; run < 3; ++run)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            f();
+            const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            best = std::min(best, ns / items);
+        }
+
+        return best;
+    }
+
+    void print(const char* name, double ns)
+    {
+        printf("%-36s %8.1f ns %12.0f per second\n", name, ns, 1e9 / ns);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t iterations = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 10000;
+
+    std::mt19937                            g(7);
+    std::uniform_real_distribution<float>   u(0.0f, 1.0f);
+
+    perspective_camera c;
+
+    c.m_position    = point3(0.0f, 2.0f, 0.0f);
+    c.m_direction   = unit_z();
+    c.m_up          = unit_y();
+    c.m_near        = { 0.25f };
+    c.m_far         = { 100.0f };
+    c.m_aspect      = { 16.0f / 9.0f };
+    c.m_fov_y       = { radians(60.0f) };
+
+    plane planes[6];
+
+    make_frustum_planes(mul(make_view_transform(c).m_matrix, perspective_matrix(c)), planes);
+
+    //the caster box of the scene, larger than the frustum
+    triangle_soa box = make_triangle_soa(12);
+
+    append_triangles(box, aabb{ float3(-50.0f, -10.0f, -20.0f), float3(50.0f, 60.0f, 150.0f) });
+
+    //a mesh of 10000 small triangles around the frustum, most of them inside or outside, some across the planes
+    const uint32_t  mesh_size = 10000;
+    triangle_soa    mesh      = make_triangle_soa(mesh_size);
+
+    for (auto i = 0U; i < mesh_size; ++i)
+    {
+        const point3 o = point3(200.0f * u(g) - 100.0f, 100.0f * u(g) - 50.0f, 150.0f * u(g) - 25.0f);
+        push_back(mesh, o, add(o, vector3(2.0f * u(g), 2.0f * u(g), 2.0f * u(g))), add(o, vector3(2.0f * u(g), 2.0f * u(g), 2.0f * u(g))));
+    }
+
+    triangle_soa    scratch = make_triangle_soa(4 * mesh_size);
+    triangle_soa    r       = make_triangle_soa(4 * mesh_size);
+    uint32_t        sink    = 0;
+
+    print("box, 12 triangles", measure(iterations, [&]
+    {
+        for (auto i = 0U; i < iterations; ++i)
+        {
+            clip(box, planes, 6, scratch, r);
+            sink += r.m_size;
+        }
+    }));
+
+    const uint32_t meshes = std::max(iterations / 100, 1U);
+
+    print("mesh triangle", measure(meshes * mesh_size, [&]
+    {
+        for (auto i = 0U; i < meshes; ++i)
+        {
+            clip(mesh, planes, 6, scratch, r);
+            sink += r.m_size;
+        }
+    }));
+
+    //keeps the results alive, so the loops are not removed
+    return sink == 0 ? 1 : 0;
+}
@@ -0,0 +1,349 @@
+#include "triangle_clipper.h"
+#include "check.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+//randomized triangle batches against camera frusta. the clipped triangles must cover the same area and the same vector area as a
+//polygon clipper in double precision, stay inside of the planes, and a full output buffer must be reported, not overrun
+using namespace lispsm;
+using namespace shadows_benchmark;
+
+namespace
+{
+    struct clip_statistics : check_statistics
+    {
+        uint32_t    m_triangles     = 0;    //clipped triangles
+        double      m_max_error     = 0.0;  //area, relative to the input area
+    };
+
+    struct double3
+    {
+        double x = 0.0;
+        double y = 0.0;
+        double z = 0.0;
+    };
+
+    double3 operator+(double3 a, double3 b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+    double3 operator-(double3 a, double3 b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+    double3 operator*(double3 a, double s)  { return { a.x * s, a.y * s, a.z * s }; }
+
+    double3 cross(double3 a, double3 b)
+    {
+        return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+    }
+
+    double length(double3 a)
+    {
+        return sqrt(a.x * a.x + a.y * a.y + a.z * a.z);
+    }
+
+    double3 to_double(point3 p)
+    {
+        return { p.m_value.x, p.m_value.y, p.m_value.z };
+    }
+
+    //twice the vector area of the polygon
+    double3 vector_area(const std::vector<double3>& polygon)
+    {
+        double3 r;
+
+        for (auto i = 1U; i + 1 < polygon.size(); ++i)
+        {
+            r = r + cross(polygon[i] - polygon[0], polygon[i + 1] - polygon[0]);
+        }
+
+        return r;
+    }
+
+    //the reference: one polygon per triangle, clipped in double precision
+    void reference_clip(const triangle_soa& t, const plane* planes, uint32_t plane_count, double& area, double3& vector)
+    {
+        area    = 0.0;
+        vector  = double3();
+
+        for (auto i = 0U; i < t.m_size; ++i)
+        {
+            std::vector<double3> polygon;
+
+            for (auto k = 0U; k < 3; ++k)
+            {
+                polygon.push_back({ t.m_x[k][i], t.m_y[k][i], t.m_z[k][i] });
+            }
+
+            for (auto j = 0U; j < plane_count && !polygon.empty(); ++j)
+            {
+                const plane&            p = planes[j];
+                std::vector<double3>    r;
+
+                auto d = [&p](double3 v)
+                {
+                    return p.m_n.m_value.x * v.x + p.m_n.m_value.y * v.y + p.m_n.m_value.z * v.z + p.m_d;
+                };
+
+                for (auto k = 0U; k < polygon.size(); ++k)
+                {
+                    const double3 a  = polygon[k];
+                    const double3 b  = polygon[(k + 1) % polygon.size()];
+                    const double  da = d(a);
+                    const double  db = d(b);
+
+                    if (da >= 0.0)
+                    {
+                        r.push_back(a);
+                    }
+
+                    if ((da >= 0.0) != (db >= 0.0))
+                    {
+                        r.push_back(a + (b - a) * (da / (da - db)));
+                    }
+                }
+
+                polygon = r;
+            }
+
+            if (polygon.size() >= 3)
+            {
+                const double3 v = vector_area(polygon);
+
+                area   += length(v);
+                vector  = vector + v;
+            }
+        }
+    }
+
+    perspective_camera random_camera(std::mt19937& g)
+    {
+        std::uniform_real_distribution<float> u(0.0f, 1.0f);
+        std::normal_distribution<float>       n(0.0f, 1.0f);
+
+        perspective_camera c;
+
+        const vector3 d = normalize(vector3(n(g), n(g), n(g)));
+        const vector3 a = normalize(vector3(n(g), n(g), n(g)));
+
+        c.m_position    = point3(10.0f * u(g) - 5.0f, 10.0f * u(g) - 5.0f, 10.0f * u(g) - 5.0f);
+        c.m_direction   = d;
+        c.m_up          = normalize(subtract(a, mul(d, dot(a, d))));
+        c.m_near        = { 0.1f + u(g) };
+        c.m_far         = { 5.0f + 50.0f * u(g) };
+        c.m_aspect      = { 1.0f + u(g) };
+        c.m_fov_y       = { radians(30.0f + 60.0f * u(g)) };
+
+        return c;
+    }
+
+    void make_planes(const perspective_camera& c, plane planes[6])
+    {
+        make_frustum_planes(mul(make_view_transform(c).m_matrix, perspective_matrix(c)), planes);
+    }
+
+    void check_clip(clip_statistics& s, const triangle_soa& t, const plane planes[6], float scale)
+    {
+        triangle_soa scratch = make_triangle_soa(4 * t.m_size + 64);
+        triangle_soa r       = make_triangle_soa(4 * t.m_size + 64);
+
+        s.m_cases++;
+
+        if (!clip(t, planes, 6, scratch, r))
+        {
+            fail(s, "capacity");
+            return;
+        }
+
+        s.m_triangles += r.m_size;
+
+        double  input = 0.0;
+        double  area  = 0.0;
+        double3 vector;
+
+        for (auto i = 0U; i < t.m_size; ++i)
+        {
+            input += length(cross(double3{ t.m_x[1][i] - t.m_x[0][i], t.m_y[1][i] - t.m_y[0][i], t.m_z[1][i] - t.m_z[0][i] }, double3{ t.m_x[2][i] - t.m_x[0][i], t.m_y[2][i] - t.m_y[0][i], t.m_z[2][i] - t.m_z[0][i] }));
+        }
+
+        for (auto i = 0U; i < r.m_size; ++i)
+        {
+            std::vector<double3> triangle;
+
+            for (auto k = 0U; k < 3; ++k)
+            {
+                const point3 p = point3(r.m_x[k][i], r.m_y[k][i], r.m_z[k][i]);
+
+                for (auto j = 0U; j < 6; ++j)
+                {
+                    if (dot(planes[j].m_n, vector3(p.m_value)) + planes[j].m_d < -1e-4f * scale)
+                    {
+                        fail(s, "inside of the planes");
+                        return;
+                    }
+                }
+
+                triangle.push_back(to_double(p));
+            }
+
+            const double3 v = vector_area(triangle);
+
+            area   += length(v);
+            vector  = vector + v;
+        }
+
+        double  reference_area;
+        double3 reference_vector;
+
+        reference_clip(t, planes, 6, reference_area, reference_vector);
+
+        const double error = std::max(fabs(area - reference_area), length(vector - reference_vector)) / std::max(input, 1e-12);
+
+        s.m_max_error = std::max(s.m_max_error, error);
+
+        if (error > 1e-4)
+        {
+            fail(s, "area");
+        }
+    }
+
+    void print(const clip_statistics& s)
+    {
+        printf("%-28s cases %6u  clipped triangles %8u  failures %4u  max error %.3g\n", s.m_name, s.m_cases, s.m_triangles, s.m_failures, s.m_max_error);
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t cases = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 2000;
+
+    std::mt19937                            g(9);
+    std::uniform_real_distribution<float>   u(0.0f, 1.0f);
+    check_groups<clip_statistics>           groups;
+
+    //triangle soups of all sizes, to cover the four wide batches and the scalar tails
+    {
+        auto& s = groups.add("random triangles");
+
+        for (auto i = 0U; i < cases; ++i)
+        {
+            const perspective_camera c = random_camera(g);
+            plane                    planes[6];
+
+            make_planes(c, planes);
+
+            const uint32_t  count = 1 + static_cast<uint32_t>(u(g) * 200.0f);
+            triangle_soa    t     = make_triangle_soa(count);
+            const float     size  = 60.0f * powf(10.0f, -2.0f * u(g));
+
+            for (auto j = 0U; j < count; ++j)
+            {
+                const point3 o = point3(120.0f * u(g) - 60.0f, 120.0f * u(g) - 60.0f, 120.0f * u(g) - 60.0f);
+                push_back(t, o, add(o, vector3(size * u(g), size * u(g), size * u(g))), add(o, vector3(size * u(g), size * u(g), size * u(g))));
+            }
+
+            check_clip(s, t, planes, 60.0f);
+        }
+    }
+
+    //the 12 triangles of caster boxes around the camera
+    {
+        auto& s = groups.add("boxes");
+
+        for (auto i = 0U; i < cases; ++i)
+        {
+            const perspective_camera c = random_camera(g);
+            plane                    planes[6];
+
+            make_planes(c, planes);
+
+            const float3    a = float3(30.0f * u(g) - 15.0f, 30.0f * u(g) - 15.0f, 30.0f * u(g) - 15.0f);
+            const float     e = 20.0f * u(g) + 0.01f;
+            triangle_soa    t = make_triangle_soa(12);
+
+            append_triangles(t, aabb{ a, float3(a.x + e * u(g) + 0.01f, a.y + e * u(g) + 0.01f, a.z + e) });
+            check_clip(s, t, planes, 60.0f);
+        }
+    }
+
+    //the winding of the box, and the planes through the frustum corners
+    {
+        auto& s = groups.add("boxes and planes");
+
+        for (auto i = 0U; i < cases / 10; ++i)
+        {
+            s.m_cases++;
+
+            const aabb      b = { float3(-1.0f - u(g), -1.0f - u(g), -1.0f - u(g)), float3(1.0f + u(g), 1.0f + u(g), 1.0f + u(g)) };
+            triangle_soa    t = make_triangle_soa(12);
+
+            append_triangles(t, b);
+
+            for (auto j = 0U; j < t.m_size; ++j)
+            {
+                const double3 p0 = { t.m_x[0][j], t.m_y[0][j], t.m_z[0][j] };
+                const double3 p1 = { t.m_x[1][j], t.m_y[1][j], t.m_z[1][j] };
+                const double3 p2 = { t.m_x[2][j], t.m_y[2][j], t.m_z[2][j] };
+                const double3 n  = cross(p1 - p0, p2 - p0);
+                const double3 o  = (p0 + p1 + p2) * (1.0 / 3.0) - double3{ (b.m_min.x + b.m_max.x) * 0.5, (b.m_min.y + b.m_max.y) * 0.5, (b.m_min.z + b.m_max.z) * 0.5 };
+
+                if (n.x * o.x + n.y * o.y + n.z * o.z <= 0.0)
+                {
+                    fail(s, "box winding");
+                    break;
+                }
+            }
+
+            const perspective_camera c = random_camera(g);
+            plane                    planes[6];
+            point3                   corners[8];
+
+            make_planes(c, planes);
+            frustum_points(c, c.m_near.m_value, c.m_far.m_value, corners);
+
+            for (auto&& p : corners)
+            {
+                for (auto j = 0U; j < 6; ++j)
+                {
+                    if (dot(planes[j].m_n, vector3(p.m_value)) + planes[j].m_d < -1e-3f * c.m_far.m_value)
+                    {
+                        fail(s, "frustum corners inside of the planes");
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    //full buffers are reported, the buffers are never overrun
+    {
+        auto& s = groups.add("bounded buffers");
+
+        for (auto i = 0U; i < cases / 10; ++i)
+        {
+            const perspective_camera c = random_camera(g);
+            plane                    planes[6];
+
+            make_planes(c, planes);
+
+            triangle_soa t = make_triangle_soa(64);
+
+            for (auto j = 0U; j < 64; ++j)
+            {
+                const point3 o = add(position(c), mul(forward(c), c.m_far.m_value * u(g)));
+                push_back(t, add(o, vector3(-100.0f, -100.0f, 0.0f)), add(o, vector3(100.0f, -100.0f, 10.0f)), add(o, vector3(0.0f, 100.0f, -10.0f)));
+            }
+
+            const uint32_t  capacity    = 1 + static_cast<uint32_t>(u(g) * 32.0f);
+            triangle_soa    scratch     = make_triangle_soa(capacity);
+            triangle_soa    r           = make_triangle_soa(capacity);
+
+            s.m_cases++;
+
+            if (clip(t, planes, 6, scratch, r) || r.m_size > capacity || scratch.m_size > capacity)
+            {
+                fail(s, "full buffer");
+            }
+        }
+    }
+
+    return groups.report(print);
+}
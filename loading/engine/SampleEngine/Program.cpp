@@ -6,6 +6,13 @@
 #include <uc/lip/lip.h>
 #include <uc/lip/tools_time_utils.h>
 
+#include <chrono>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include "reloc_offset.h"
+
 
 using namespace winrt;
 
@@ -45,11 +52,51 @@ namespace uc
 			LIP_DECLARE_RTTI()
 		};
 
+		//a node of the graph benchmark. reloc_pointer owns its target, so the edges are indices into reloc_graph::m_nodes
+		struct reloc_node
+		{
+			uint32_t						m_value;
+			reloc_array< uint32_t >			m_edges;
+
+			reloc_node()
+			{
+
+			}
+
+			explicit reloc_node(const lip::load_context& c) : m_edges(c)
+			{
+
+			}
+
+			LIP_DECLARE_RTTI()
+		};
+
+		struct reloc_graph
+		{
+			reloc_array< reloc_node >		m_nodes;
+
+			reloc_graph()
+			{
+
+			}
+
+			explicit reloc_graph(const lip::load_context& c) : m_nodes(c)
+			{
+
+			}
+
+			LIP_DECLARE_RTTI()
+		};
+
 		LIP_DECLARE_TYPE_ID(uc::lip::fish)
 		LIP_DECLARE_TYPE_ID(uc::lip::animal)
 		LIP_DECLARE_TYPE_ID(uc::lip::animals)
 		LIP_DECLARE_TYPE_ID(uc::lip::reloc_array < animal >)
 		LIP_DECLARE_TYPE_ID(uc::lip::reloc_pointer< fish > )
+		LIP_DECLARE_TYPE_ID(uc::lip::reloc_node)
+		LIP_DECLARE_TYPE_ID(uc::lip::reloc_graph)
+		LIP_DECLARE_TYPE_ID(uc::lip::reloc_array < uint32_t >)
+		LIP_DECLARE_TYPE_ID(uc::lip::reloc_array < reloc_node >)
 
 			
 
@@ -66,6 +113,15 @@ namespace uc
 		LIP_BEGIN_DEFINE_RTTI(fish)
 			LIP_RTTI_MEMBER(fish, m_eyes)
 		LIP_END_DEFINE_RTTI(fish)
+
+		LIP_BEGIN_DEFINE_RTTI(reloc_node)
+			LIP_RTTI_MEMBER(reloc_node, m_value)
+			LIP_RTTI_MEMBER(reloc_node, m_edges)
+		LIP_END_DEFINE_RTTI(reloc_node)
+
+		LIP_BEGIN_DEFINE_RTTI(reloc_graph)
+			LIP_RTTI_MEMBER(reloc_graph, m_nodes)
+		LIP_END_DEFINE_RTTI(reloc_graph)
 	}
 }
 
@@ -97,10 +153,204 @@ namespace
 
 		return binarize_object(&as);
 	}
+
+	//Graph traversal: a lip blob, loaded with placement_new which fixes up a full pointer per reloc_array on x64,
+	//against self relative 32 bit offsets used in place
+	constexpr uint32_t graph_edges = 2;
+
+	struct offset_node
+	{
+		uint32_t									m_value;
+		offset_array< offset_pointer<offset_node> > m_edges;
+	};
+
+	//nodes are interleaved with their edges. an edge can point to any node, so the whole node block must fit in the int32_t
+	//offsets: node_count * offset_node_stride <= INT32_MAX. at 20 bytes per node that is 107M nodes, the 100M node run
+	//(2.0e9 bytes) is just under 2^31
+	constexpr size_t offset_node_stride = sizeof(offset_node) + graph_edges * sizeof(offset_pointer<offset_node>);
+	static_assert(offset_node_stride % alignof(offset_node) == 0, "nodes must stay aligned");
+
+	constexpr size_t max_offset_graph_nodes = static_cast<size_t>(std::numeric_limits<int32_t>::max()) / offset_node_stride;
+
+	struct random_sequence
+	{
+		uint64_t m_state;
+
+		uint32_t next()
+		{
+			m_state = m_state * 6364136223846793005ULL + 1442695040888963407ULL;
+			return static_cast<uint32_t>(m_state >> 33);
+		}
+	};
+
+	//the same random graph as make_offset_graph, binarized. the graph in memory is gone when the blob is returned
+	std::vector<uint8_t> make_reloc_graph(size_t node_count)
+	{
+		reloc_graph		g;
+		random_sequence	r = { 1 };
+
+		for (size_t i = 0; i < node_count; ++i)
+		{
+			g.m_nodes.push_back(reloc_node());
+		}
+
+		for (size_t i = 0; i < node_count; ++i)
+		{
+			reloc_node& n	= g.m_nodes[i];
+			n.m_value		= r.next();
+
+			for (uint32_t e = 0; e < graph_edges; ++e)
+			{
+				n.m_edges.push_back(static_cast<uint32_t>(r.next() % node_count));
+			}
+		}
+
+		return binarize_object(&g);
+	}
+
+	std::vector<uint8_t> make_offset_graph(size_t node_count)
+	{
+		//every link is checked when it is set, this rejects a graph too large for the offsets before it is built
+		if (node_count > max_offset_graph_nodes)
+		{
+			throw std::overflow_error("offset graph does not fit in 32 bit offsets");
+		}
+
+		offset_writer	w;
+		random_sequence r = { 1 };
+
+		const size_t base = w.allocate<uint32_t>((node_count * offset_node_stride) / sizeof(uint32_t));
+
+		auto node = [&w, base](size_t i)
+		{
+			return w.get<offset_node>(base + i * offset_node_stride);
+		};
+
+		for (size_t i = 0; i < node_count; ++i)
+		{
+			offset_node* n							= node(i);
+			offset_pointer<offset_node>* edges		= reinterpret_cast<offset_pointer<offset_node>*>(n + 1);
+
+			n->m_value = r.next();
+			n->m_edges.set(edges, graph_edges);
+
+			for (uint32_t e = 0; e < graph_edges; ++e)
+			{
+				edges[e].set(node(r.next() % node_count));
+			}
+		}
+
+		return w.detach();
+	}
+
+	template <typename node_t, typename edge_t> uint64_t walk(const node_t* n, size_t steps, edge_t edge)
+	{
+		uint64_t sum = 0;
+
+		for (size_t i = 0; i < steps; ++i)
+		{
+			sum += n->m_value;
+			n = edge(n, n->m_value % graph_edges);
+		}
+
+		return sum;
+	}
+
+	template <typename f> double measure_ms(f function, uint64_t& result)
+	{
+		auto start	= std::chrono::high_resolution_clock::now();
+		result		= function();
+		auto end	= std::chrono::high_resolution_clock::now();
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	}
+
+	void benchmark_graph(size_t node_count)
+	{
+		std::wcout << "Graph benchmark, nodes: " << node_count << "\n";
+
+		const size_t steps = node_count;
+
+		{
+			std::vector<uint8_t> blob = make_reloc_graph(node_count);
+
+			//the fixup of the pointers is part of the cost, the offset graph has none
+			reloc_graph* g			= nullptr;
+			uint64_t	 load_sum	= 0;
+
+			double load_ms = measure_ms([&]()
+			{
+				load_context ctx = make_load_context(&blob[0]);
+				g = placement_new<reloc_graph>(ctx);
+				return static_cast<uint64_t>(g->m_nodes.size());
+			}, load_sum);
+
+			const reloc_node* nodes = &g->m_nodes[0];
+
+			uint64_t walk_sum	= 0;
+			uint64_t sweep_sum	= 0;
+
+			double walk_ms = measure_ms([&]()
+			{
+				return walk(nodes, steps, [nodes](const reloc_node* n, uint32_t e) { return &nodes[n->m_edges[e]]; });
+			}, walk_sum);
+
+			double sweep_ms = measure_ms([&]()
+			{
+				uint64_t sum = 0;
+				for (auto&& n : g->m_nodes)
+				{
+					for (auto&& e : n.m_edges)
+					{
+						sum += nodes[e].m_value;
+					}
+				}
+				return sum;
+			}, sweep_sum);
+
+			std::wcout << "Reloc:    " << blob.size() / (1024 * 1024) << " MB, load: " << load_ms << " ms, walk: " << walk_ms << " ms, sweep: " << sweep_ms << " ms, checksum: " << (walk_sum ^ sweep_sum) << "\n";
+
+			g->~reloc_graph();
+		}
+
+		{
+			std::vector<uint8_t> blob = make_offset_graph(node_count);
+
+			//from here on the data is only read, as it would be from a read-only mapped file
+			const offset_node* nodes = offset_root<offset_node>(&blob[0]);
+
+			auto node = [nodes](size_t i)
+			{
+				return reinterpret_cast<const offset_node*>(reinterpret_cast<const uint8_t*>(nodes) + i * offset_node_stride);
+			};
+
+			uint64_t walk_sum	= 0;
+			uint64_t sweep_sum	= 0;
+
+			double walk_ms = measure_ms([&]()
+			{
+				return walk(nodes, steps, [](const offset_node* n, uint32_t e) { return n->m_edges[e].get(); });
+			}, walk_sum);
+
+			double sweep_ms = measure_ms([&]()
+			{
+				uint64_t sum = 0;
+				for (size_t i = 0; i < node_count; ++i)
+				{
+					for (auto&& e : node(i)->m_edges)
+					{
+						sum += e->m_value;
+					}
+				}
+				return sum;
+			}, sweep_sum);
+
+			std::wcout << "Offsets:  " << blob.size() / (1024 * 1024) << " MB, walk: " << walk_ms << " ms, sweep: " << sweep_ms << " ms, checksum: " << (walk_sum ^ sweep_sum) << "\n";
+		}
+	}
 }
 
 
-int main()
+int main(int argc, char* argv[])
 {
 	std::wcout << "Packaging Animals..." << "\n";
 	std::vector<uint8_t> blob = package_animals();
@@ -117,5 +367,19 @@ int main()
 		bs->~animals();
 	}
 
+	{
+		//pass 100000000 for the full size graph, it needs several GB: the reloc graph and its blob are both alive while binarizing.
+		//the offset graph takes at most max_offset_graph_nodes
+		const size_t node_count = argc > 1 ? std::stoull(argv[1]) : 1000000;
+
+		if (node_count > max_offset_graph_nodes)
+		{
+			std::wcout << "Graph benchmark, at most " << max_offset_graph_nodes << " nodes fit in 32 bit offsets" << "\n";
+			return 1;
+		}
+
+		benchmark_graph(node_count);
+	}
+
 	return 0;
 }
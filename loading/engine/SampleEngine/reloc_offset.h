@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace uc
+{
+	namespace lip
+	{
+		//Self-relative alternative to reloc_pointer / reloc_array.
+		//The target is stored as a signed 32 bit byte distance from the field itself, so the blob needs no fixup pass after load.
+		//It can be mapped read-only and shared between processes, and every link costs 4 bytes instead of 8.
+		//Offset 0 encodes nullptr, so a field can not point to itself.
+
+		inline int32_t make_self_relative_offset(const void* field, const void* target)
+		{
+			if (target == nullptr)
+			{
+				return 0;
+			}
+
+			//would read back as nullptr
+			if (target == field)
+			{
+				throw std::invalid_argument("self relative offset can not target its own field");
+			}
+
+			const ptrdiff_t d = reinterpret_cast<const uint8_t*>(target) - reinterpret_cast<const uint8_t*>(field);
+
+			if (d < std::numeric_limits<int32_t>::min() || d > std::numeric_limits<int32_t>::max())
+			{
+				throw std::overflow_error("self relative offset does not fit in 32 bits");
+			}
+
+			return static_cast<int32_t>(d);
+		}
+
+		template <typename T> class offset_pointer
+		{
+			public:
+
+			offset_pointer() = default;
+
+			//the encoding depends on the address of the field, copying would silently retarget it
+			offset_pointer(const offset_pointer&) = delete;
+			offset_pointer& operator=(const offset_pointer&) = delete;
+
+			const T* get() const
+			{
+				return m_offset != 0 ? reinterpret_cast<const T*>(reinterpret_cast<const uint8_t*>(this) + m_offset) : nullptr;
+			}
+
+			T* get()
+			{
+				return m_offset != 0 ? reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(this) + m_offset) : nullptr;
+			}
+
+			void set(const T* target)
+			{
+				m_offset = make_self_relative_offset(this, target);
+			}
+
+			const T* operator->() const
+			{
+				return get();
+			}
+
+			T* operator->()
+			{
+				return get();
+			}
+
+			const T& operator*() const
+			{
+				return *get();
+			}
+
+			explicit operator bool() const
+			{
+				return m_offset != 0;
+			}
+
+			private:
+			int32_t m_offset = 0;
+		};
+
+		template <typename T> class offset_array
+		{
+			public:
+
+			offset_array() = default;
+
+			offset_array(const offset_array&) = delete;
+			offset_array& operator=(const offset_array&) = delete;
+
+			const T* begin() const
+			{
+				return m_offset != 0 ? reinterpret_cast<const T*>(reinterpret_cast<const uint8_t*>(this) + m_offset) : nullptr;
+			}
+
+			const T* end() const
+			{
+				return begin() + m_size;
+			}
+
+			T* begin()
+			{
+				return m_offset != 0 ? reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(this) + m_offset) : nullptr;
+			}
+
+			T* end()
+			{
+				return begin() + m_size;
+			}
+
+			const T& operator[](size_t i) const
+			{
+				return begin()[i];
+			}
+
+			T& operator[](size_t i)
+			{
+				return begin()[i];
+			}
+
+			uint32_t size() const
+			{
+				return m_size;
+			}
+
+			bool empty() const
+			{
+				return m_size == 0;
+			}
+
+			void set(const T* first, uint32_t size)
+			{
+				m_offset = size != 0 ? make_self_relative_offset(this, first) : 0;
+				m_size   = size;
+			}
+
+			private:
+			int32_t  m_offset = 0;
+			uint32_t m_size   = 0;
+		};
+
+		//Builds a blob of offset_pointer / offset_array linked data.
+		//Allocations return positions, since the storage may move while the blob grows; link once everything is allocated (or reserve up front).
+		class offset_writer
+		{
+			public:
+
+			void reserve(size_t bytes)
+			{
+				m_data.reserve(bytes);
+			}
+
+			template <typename T> size_t allocate(size_t count = 1)
+			{
+				static_assert(std::is_trivially_destructible<T>::value, "offset blobs are never destroyed");
+
+				const size_t alignment	= alignof(T);
+				const size_t position	= (m_data.size() + alignment - 1) & ~(alignment - 1);
+				m_data.resize(position + sizeof(T) * count);
+				return position;
+			}
+
+			template <typename T> T* get(size_t position)
+			{
+				return reinterpret_cast<T*>(&m_data[position]);
+			}
+
+			size_t size() const
+			{
+				return m_data.size();
+			}
+
+			std::vector<uint8_t> detach()
+			{
+				return std::move(m_data);
+			}
+
+			private:
+			std::vector<uint8_t> m_data;
+		};
+
+		//No placement_new or load_context: the blob is used in place, it can be a read-only mapped view.
+		template <typename T> const T* offset_root(const void* blob)
+		{
+			return reinterpret_cast<const T*>(blob);
+		}
+	}
+}
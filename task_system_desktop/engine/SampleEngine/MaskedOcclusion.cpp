@@ -0,0 +1,572 @@
+﻿#include "pch.h"
+#include "MaskedOcclusion.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <emmintrin.h>
+
+namespace
+{
+	//r = a * b
+	void Multiply(const float a[16], const float b[16], float r[16])
+	{
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			for (uint32_t j = 0; j < 4; ++j)
+			{
+				r[4 * i + j] = a[4 * i + 0] * b[0 + j] + a[4 * i + 1] * b[4 + j] + a[4 * i + 2] * b[8 + j] + a[4 * i + 3] * b[12 + j];
+			}
+		}
+	}
+
+	//the point (x, y, z, 1) in clip space
+	inline __m128 TransformPoint(float x, float y, float z, const float m[16])
+	{
+		const __m128 r0 = _mm_mul_ps(_mm_set1_ps(x), _mm_loadu_ps(m + 0));
+		const __m128 r1 = _mm_mul_ps(_mm_set1_ps(y), _mm_loadu_ps(m + 4));
+		const __m128 r2 = _mm_mul_ps(_mm_set1_ps(z), _mm_loadu_ps(m + 8));
+
+		return _mm_add_ps(_mm_add_ps(r0, r1), _mm_add_ps(r2, _mm_loadu_ps(m + 12)));
+	}
+
+	const float MinW = 1e-6f;
+
+	//false for triangles crossing the near plane and for triangles without pixels
+	bool SetupTriangle(const __m128 clip[3], float width, float height, OcclusionTriangle* t)
+	{
+		float x[3];
+		float y[3];
+		float z[3];
+
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			alignas(16) float c[4];
+			_mm_store_ps(c, clip[i]);
+
+			if (!(c[3] > MinW) || c[2] < 0.0f)
+			{
+				return false;
+			}
+
+			x[i] = (c[0] / c[3] * 0.5f + 0.5f) * width;
+			y[i] = (0.5f - c[1] / c[3] * 0.5f) * height;
+			z[i] = c[2] / c[3];
+		}
+
+		float area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+
+		if (!(fabsf(area) > 1e-8f))
+		{
+			return false;
+		}
+
+		//the occluders have no back faces, all triangles are turned to a positive area. the back faces of closed meshes fill the
+		//masks of the silhouette tiles, which culls more than the time they take
+		if (area < 0.0f)
+		{
+			std::swap(x[1], x[2]);
+			std::swap(y[1], y[2]);
+			std::swap(z[1], z[2]);
+			area = -area;
+		}
+
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			const uint32_t j = (i + 1) % 3;
+
+			t->m_a[i] = -(y[j] - y[i]);
+			t->m_b[i] = x[j] - x[i];
+			t->m_c[i] = -(t->m_a[i] * x[i] + t->m_b[i] * y[i]);
+		}
+
+		t->m_x0 = static_cast<int32_t>(std::max(0.0f, floorf(std::min(std::min(x[0], x[1]), x[2]))));
+		t->m_y0 = static_cast<int32_t>(std::max(0.0f, floorf(std::min(std::min(y[0], y[1]), y[2]))));
+		t->m_x1 = static_cast<int32_t>(std::min(width, ceilf(std::max(std::max(x[0], x[1]), x[2]))));
+		t->m_y1 = static_cast<int32_t>(std::min(height, ceilf(std::max(std::max(y[0], y[1]), y[2]))));
+
+		if (t->m_x0 >= t->m_x1 || t->m_y0 >= t->m_y1)
+		{
+			return false;
+		}
+
+		const float dx1 = x[1] - x[0];
+		const float dy1 = y[1] - y[0];
+		const float dz1 = z[1] - z[0];
+		const float dx2 = x[2] - x[0];
+		const float dy2 = y[2] - y[0];
+		const float dz2 = z[2] - z[0];
+
+		t->m_zx		= (dz1 * dy2 - dy1 * dz2) / area;
+		t->m_zy		= (dx1 * dz2 - dz1 * dx2) / area;
+		t->m_zc		= z[0] - t->m_zx * x[0] - t->m_zy * y[0];
+		t->m_z_max	= std::max(std::max(z[0], z[1]), z[2]);
+
+		return true;
+	}
+
+	//the bits of the pixels first to last of a tile row, both included
+	inline uint32_t SpanMask(int32_t first, int32_t last)
+	{
+		if (first > last || last < 0 || first > 31)
+		{
+			return 0;
+		}
+
+		first	= std::max(first, 0);
+		last	= std::min(last, 31);
+
+		return (0xffffffffu >> (31 - last)) & (0xffffffffu << first);
+	}
+
+	void Merge(OcclusionTile* tile, const uint32_t mask[4], float z)
+	{
+		if (!(z < tile->m_z0))
+		{
+			return;
+		}
+
+		//a triangle closer to the reference depth than to the working layer starts a new working layer
+		if (z - tile->m_z1 > tile->m_z0 - z)
+		{
+			tile->m_mask[0] = tile->m_mask[1] = tile->m_mask[2] = tile->m_mask[3] = 0;
+			tile->m_z1 = 0.0f;
+		}
+
+		tile->m_z1 = std::max(tile->m_z1, z);
+
+		for (uint32_t r = 0; r < 4; ++r)
+		{
+			tile->m_mask[r] |= mask[r];
+		}
+
+		//all pixels are covered, the working layer becomes the reference
+		if ((tile->m_mask[0] & tile->m_mask[1] & tile->m_mask[2] & tile->m_mask[3]) == 0xffffffffu)
+		{
+			tile->m_z0 = std::min(tile->m_z0, tile->m_z1);
+			tile->m_z1 = 0.0f;
+			tile->m_mask[0] = tile->m_mask[1] = tile->m_mask[2] = tile->m_mask[3] = 0;
+		}
+	}
+
+	//ceil and floor of small floats, the conversion truncates towards zero
+	inline __m128i Ceil(__m128 v)
+	{
+		const __m128i t = _mm_cvttps_epi32(v);
+		return _mm_sub_epi32(t, _mm_castps_si128(_mm_cmplt_ps(_mm_cvtepi32_ps(t), v)));
+	}
+
+	inline __m128i Floor(__m128 v)
+	{
+		const __m128i t = _mm_cvttps_epi32(v);
+		return _mm_add_epi32(t, _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(t), v)));
+	}
+
+	//the tiles of the triangle in the tile rows [row_begin, row_end)
+	void RasterizeTriangle(OcclusionBuffer* b, const OcclusionTriangle& t, int32_t row_begin, int32_t row_end)
+	{
+		const int32_t	ty0		= std::max(t.m_y0 / 4, row_begin);
+		const int32_t	ty1		= std::min((t.m_y1 + 3) / 4, row_end);
+
+		//an edge bounds the rows at x = y * slope + offset, on the left for a > 0 and on the right for a < 0
+		__m128			slope[3];
+		__m128			offset[3];
+
+		for (uint32_t e = 0; e < 3; ++e)
+		{
+			const float inv = t.m_a[e] != 0.0f ? -1.0f / t.m_a[e] : 0.0f;
+
+			slope[e]	= _mm_set1_ps(t.m_b[e] * inv);
+			offset[e]	= _mm_set1_ps(t.m_c[e] * inv);
+		}
+
+		//the pixel centers clamped to the bounds, so the spans stay in the triangle bounds
+		const __m128	lo		= _mm_set1_ps(static_cast<float>(t.m_x0));
+		const __m128	hi		= _mm_set1_ps(static_cast<float>(t.m_x1 - 1));
+		const __m128	half	= _mm_set1_ps(0.5f);
+
+		for (int32_t ty = ty0; ty < ty1; ++ty)
+		{
+			const __m128 y = _mm_add_ps(_mm_set1_ps(ty * 4 + 0.5f), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+
+			__m128 left		= _mm_set1_ps(-1e30f);
+			__m128 right	= _mm_set1_ps(1e30f);
+
+			for (uint32_t e = 0; e < 3; ++e)
+			{
+				const __m128 x = _mm_add_ps(_mm_mul_ps(slope[e], y), offset[e]);
+
+				if (t.m_a[e] > 0.0f)
+				{
+					left = _mm_max_ps(left, x);
+				}
+				else if (t.m_a[e] < 0.0f)
+				{
+					right = _mm_min_ps(right, x);
+				}
+				else
+				{
+					//a horizontal edge, the rows outside of it are empty
+					const __m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(t.m_b[e]), y), _mm_set1_ps(t.m_c[e]));
+					left = _mm_or_ps(_mm_and_ps(_mm_cmplt_ps(s, _mm_setzero_ps()), _mm_set1_ps(1e30f)), _mm_andnot_ps(_mm_cmplt_ps(s, _mm_setzero_ps()), left));
+				}
+			}
+
+			//the covered pixels of the rows, first > last for an empty row
+			alignas(16) int32_t first[4];
+			alignas(16) int32_t last[4];
+
+			_mm_store_si128(reinterpret_cast<__m128i*>(first), Ceil(_mm_min_ps(_mm_max_ps(_mm_sub_ps(left, half), lo), _mm_add_ps(hi, _mm_set1_ps(1.0f)))));
+			_mm_store_si128(reinterpret_cast<__m128i*>(last), Floor(_mm_max_ps(_mm_min_ps(_mm_sub_ps(right, half), hi), _mm_sub_ps(lo, _mm_set1_ps(1.0f)))));
+
+			//the rows of the tile outside of the triangle bounds
+			for (int32_t i = 0; i < 4; ++i)
+			{
+				if (ty * 4 + i < t.m_y0 || ty * 4 + i >= t.m_y1)
+				{
+					first[i]	= t.m_x1;
+					last[i]		= t.m_x0 - 1;
+				}
+			}
+
+			const int32_t span_first	= std::min(std::min(first[0], first[1]), std::min(first[2], first[3]));
+			const int32_t span_last		= std::max(std::max(last[0], last[1]), std::max(last[2], last[3]));
+
+			if (span_first > span_last)
+			{
+				continue;
+			}
+
+			//the pixel centers of the rows inside of the triangle bounds, for the depth
+			const float y_lo = std::max(ty * 4, t.m_y0) + 0.5f;
+			const float y_hi = std::min(ty * 4 + 4, t.m_y1) - 0.5f;
+			const float z_y  = std::max(t.m_zy * y_lo, t.m_zy * y_hi) + t.m_zc;
+
+			for (int32_t tx = span_first / 32; tx <= span_last / 32; ++tx)
+			{
+				uint32_t mask[4];
+
+				for (uint32_t i = 0; i < 4; ++i)
+				{
+					mask[i] = SpanMask(first[i] - tx * 32, last[i] - tx * 32);
+				}
+
+				//the plane is largest at a corner of the covered pixels, the vertices bound it too
+				const float x_lo	= std::max(tx * 32, span_first) + 0.5f;
+				const float x_hi	= std::min(tx * 32 + 31, span_last) + 0.5f;
+				const float z		= std::min(std::max(t.m_zx * x_lo, t.m_zx * x_hi) + z_y, t.m_z_max);
+
+				Merge(&b->m_tiles[ty * b->m_tiles_x + tx], mask, z);
+			}
+		}
+	}
+}
+
+OcclusionWorkers::OcclusionWorkers(uint32_t thread_count)
+{
+	for (uint32_t t = 1; t < std::max(1U, thread_count); ++t)
+	{
+		m_threads.emplace_back([this, t] { Work(t); });
+	}
+}
+
+OcclusionWorkers::~OcclusionWorkers()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_stop = true;
+	}
+
+	m_start.notify_all();
+
+	for (auto& t : m_threads)
+	{
+		t.join();
+	}
+}
+
+void OcclusionWorkers::Run(uint32_t threads, void (*function)(void*, uint32_t), void* context)
+{
+	threads = std::max(1U, std::min(threads, ThreadCount()));
+
+	if (threads > 1)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+
+			m_function			= function;
+			m_context			= context;
+			m_threads_of_run	= threads;
+			m_pending			= threads - 1;
+			m_run++;
+		}
+
+		m_start.notify_all();
+	}
+
+	function(context, 0);
+
+	if (threads > 1)
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		m_done.wait(lock, [this] { return m_pending == 0; });
+	}
+}
+
+void OcclusionWorkers::Work(uint32_t t)
+{
+	uint64_t run = 0;
+
+	for (;;)
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+
+		m_start.wait(lock, [this, run] { return m_stop || m_run != run; });
+
+		if (m_stop)
+		{
+			return;
+		}
+
+		run = m_run;
+
+		//the runs with fewer threads leave the last workers waiting
+		if (t >= m_threads_of_run)
+		{
+			continue;
+		}
+
+		const auto function	= m_function;
+		const auto context	= m_context;
+
+		lock.unlock();
+		function(context, t);
+		lock.lock();
+
+		if (--m_pending == 0)
+		{
+			m_done.notify_one();
+		}
+	}
+}
+
+OcclusionBuffer MakeOcclusionBuffer(uint32_t width, uint32_t height)
+{
+	OcclusionBuffer b;
+
+	b.m_width	= width;
+	b.m_height	= height;
+	b.m_tiles_x	= width / 32;
+	b.m_tiles_y	= height / 4;
+	b.m_tiles.resize(b.m_tiles_x * b.m_tiles_y);
+
+	ClearOcclusionBuffer(&b);
+	return b;
+}
+
+void ClearOcclusionBuffer(OcclusionBuffer* b)
+{
+	for (auto& t : b->m_tiles)
+	{
+		t.m_mask[0] = t.m_mask[1] = t.m_mask[2] = t.m_mask[3] = 0;
+		t.m_z0 = 1.0f;
+		t.m_z1 = 0.0f;
+	}
+}
+
+void RenderOccluders(OcclusionBuffer* b, const OccluderMesh* meshes, uint32_t mesh_count, const float view_projection[16], OcclusionWorkers& workers)
+{
+	//a slot for every triangle, the ones of a mesh start at its offset. skipped triangles have empty bounds
+	std::vector<uint32_t> offsets(mesh_count + 1, 0);
+
+	for (uint32_t i = 0; i < mesh_count; ++i)
+	{
+		offsets[i + 1] = offsets[i] + meshes[i].m_index_count / 3;
+	}
+
+	b->m_triangles.resize(offsets[mesh_count]);
+
+	const uint32_t	threads	= std::max(1U, std::min(workers.ThreadCount(), b->m_tiles_y));
+	const float		width	= static_cast<float>(b->m_width);
+	const float		height	= static_cast<float>(b->m_height);
+
+	auto setup = [&](uint32_t t)
+	{
+		for (uint32_t i = t; i < mesh_count; i += threads)
+		{
+			const OccluderMesh& m = meshes[i];
+			float				world_view_projection[16];
+
+			Multiply(m.m_world, view_projection, world_view_projection);
+
+			for (uint32_t j = 0; j + 2 < m.m_index_count; j += 3)
+			{
+				__m128 clip[3];
+
+				for (uint32_t k = 0; k < 3; ++k)
+				{
+					const float* p = m.m_positions + 3 * m.m_indices[j + k];
+					clip[k] = TransformPoint(p[0], p[1], p[2], world_view_projection);
+				}
+
+				OcclusionTriangle& r = b->m_triangles[offsets[i] + j / 3];
+
+				if (!SetupTriangle(clip, width, height, &r))
+				{
+					r.m_x0 = r.m_x1 = r.m_y0 = r.m_y1 = 0;
+				}
+			}
+		}
+	};
+
+	//every thread owns a band of tile rows, the triangles merge in the same order as with one thread
+	auto rasterize = [&](uint32_t t)
+	{
+		const int32_t row_begin	= static_cast<int32_t>(t * b->m_tiles_y / threads);
+		const int32_t row_end	= static_cast<int32_t>((t + 1) * b->m_tiles_y / threads);
+
+		for (const auto& triangle : b->m_triangles)
+		{
+			if (triangle.m_y1 > row_begin * 4 && triangle.m_y0 < row_end * 4 && triangle.m_x0 < triangle.m_x1)
+			{
+				RasterizeTriangle(b, triangle, row_begin, row_end);
+			}
+		}
+	};
+
+	workers.Run(threads, setup);
+	workers.Run(threads, rasterize);
+}
+
+bool IsVisible(const OcclusionBuffer* b, const Aabb& box, const float view_projection[16])
+{
+	//the corners four at a time, the lanes are (min x, min y), (max x, min y), (min x, max y), (max x, max y)
+	const __m128	x	= _mm_set_ps(box.m_max[0], box.m_min[0], box.m_max[0], box.m_min[0]);
+	const __m128	y	= _mm_set_ps(box.m_max[1], box.m_max[1], box.m_min[1], box.m_min[1]);
+
+	__m128			min[3];
+	__m128			max[3];
+
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		const __m128 z = _mm_set1_ps(i == 0 ? box.m_min[2] : box.m_max[2]);
+		__m128		 c[4];
+
+		for (uint32_t j = 0; j < 4; ++j)
+		{
+			c[j] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(view_projection[j])), _mm_mul_ps(y, _mm_set1_ps(view_projection[4 + j]))), _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(view_projection[8 + j])), _mm_set1_ps(view_projection[12 + j])));
+		}
+
+		if (_mm_movemask_ps(_mm_cmpgt_ps(c[3], _mm_set1_ps(MinW))) != 0xf)
+		{
+			return true;
+		}
+
+		const __m128 inv_w = _mm_div_ps(_mm_set1_ps(1.0f), c[3]);
+
+		for (uint32_t j = 0; j < 3; ++j)
+		{
+			const __m128 p = _mm_mul_ps(c[j], inv_w);
+
+			min[j] = i == 0 ? p : _mm_min_ps(min[j], p);
+			max[j] = i == 0 ? p : _mm_max_ps(max[j], p);
+		}
+	}
+
+	float lo[3];
+	float hi[3];
+
+	for (uint32_t j = 0; j < 3; ++j)
+	{
+		__m128 a = _mm_min_ps(min[j], _mm_shuffle_ps(min[j], min[j], _MM_SHUFFLE(1, 0, 3, 2)));
+		__m128 b = _mm_max_ps(max[j], _mm_shuffle_ps(max[j], max[j], _MM_SHUFFLE(1, 0, 3, 2)));
+
+		lo[j] = _mm_cvtss_f32(_mm_min_ss(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1))));
+		hi[j] = _mm_cvtss_f32(_mm_max_ss(b, _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1))));
+	}
+
+	//in front of the near plane
+	if (lo[2] < 0.0f)
+	{
+		return true;
+	}
+
+	const float		width	= static_cast<float>(b->m_width);
+	const float		height	= static_cast<float>(b->m_height);
+
+	//the pixels the box touches, y goes down
+	const int32_t	x0		= static_cast<int32_t>(std::max(0.0f, floorf((lo[0] * 0.5f + 0.5f) * width)));
+	const int32_t	x1		= static_cast<int32_t>(std::min(width, ceilf((hi[0] * 0.5f + 0.5f) * width)));
+	const int32_t	y0		= static_cast<int32_t>(std::max(0.0f, floorf((0.5f - hi[1] * 0.5f) * height)));
+	const int32_t	y1		= static_cast<int32_t>(std::min(height, ceilf((0.5f - lo[1] * 0.5f) * height)));
+
+	//outside of the screen, left to the frustum culling
+	if (x0 >= x1 || y0 >= y1)
+	{
+		return true;
+	}
+
+	const float z = lo[2];
+
+	for (int32_t ty = y0 / 4; ty < (y1 + 3) / 4; ++ty)
+	{
+		for (int32_t tx = x0 / 32; tx < (x1 + 31) / 32; ++tx)
+		{
+			const OcclusionTile& tile = b->m_tiles[ty * b->m_tiles_x + tx];
+
+			if (z > tile.m_z0)
+			{
+				continue;
+			}
+
+			//the pixels of the box in the tile must all be in the working layer
+			if (z > tile.m_z1)
+			{
+				const uint32_t	row		= SpanMask(x0 - tx * 32, x1 - 1 - tx * 32);
+				uint32_t		outside	= 0;
+
+				for (int32_t r = 0; r < 4; ++r)
+				{
+					const int32_t y = ty * 4 + r;
+
+					if (y >= y0 && y < y1)
+					{
+						outside |= row & ~tile.m_mask[r];
+					}
+				}
+
+				if (outside == 0)
+				{
+					continue;
+				}
+			}
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void CullOccluded(const OcclusionBuffer* b, const Aabb* boxes, uint32_t box_count, const float view_projection[16], uint64_t view_mask, uint64_t* visible_masks, OcclusionWorkers& workers)
+{
+	//a thread for less than 256 boxes costs more than it saves
+	const uint32_t threads	= std::max(1U, std::min(workers.ThreadCount(), (box_count + 255) / 256));
+	const uint32_t chunk	= (box_count + threads - 1) / threads;
+
+	auto cull = [&](uint32_t t)
+	{
+		const uint32_t begin	= std::min(t * chunk, box_count);
+		const uint32_t end		= std::min(begin + chunk, box_count);
+
+		for (uint32_t i = begin; i < end; ++i)
+		{
+			if ((visible_masks[i] & view_mask) != 0 && !IsVisible(b, boxes[i], view_projection))
+			{
+				visible_masks[i] &= ~view_mask;
+			}
+		}
+	};
+
+	workers.Run(threads, cull);
+}
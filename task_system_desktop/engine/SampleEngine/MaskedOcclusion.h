@@ -0,0 +1,119 @@
+﻿#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+	Masked software occlusion culling.
+
+	The occluders are rasterized at low resolution into tiles of 32 x 4 pixels. A tile does not keep a depth per pixel, it keeps a coverage
+	mask and two depths: every pixel of the tile is at most m_z0 far, the pixels in the mask are at most m_z1 far. A triangle merges into the
+	mask, when the mask is full the tile moves m_z0 closer. The boxes of the objects are then tested against the tiles they cover.
+
+	Depths are the ones of a d3d projection, z / w in [0, 1] with 0 at the near plane. Matrices are row major for row vectors, p * m.
+	The rasterization is split between threads by rows of tiles, every thread owns its tiles.
+*/
+
+struct Aabb
+{
+	float	m_min[3];
+	float	m_max[3];
+};
+
+struct OccluderMesh
+{
+	const float*	m_positions;		//x, y, z per vertex
+	const uint32_t*	m_indices;			//three per triangle
+	uint32_t		m_index_count;
+	float			m_world[16];
+};
+
+struct OcclusionTile
+{
+	uint32_t		m_mask[4];			//bit i of row r is pixel (i, r) of the tile
+	float			m_z0;
+	float			m_z1;
+};
+
+//a triangle in pixels, inside where a * x + b * y + c >= 0 for all edges. the depth is the plane z = zx * x + zy * y + zc
+struct OcclusionTriangle
+{
+	float			m_a[3];
+	float			m_b[3];
+	float			m_c[3];
+	float			m_zx;
+	float			m_zy;
+	float			m_zc;
+	float			m_z_max;
+	int32_t			m_x0;				//pixel bounds, the end is excluded
+	int32_t			m_y0;
+	int32_t			m_x1;
+	int32_t			m_y1;
+};
+
+struct OcclusionBuffer
+{
+	uint32_t						m_width		= 0;
+	uint32_t						m_height	= 0;
+	uint32_t						m_tiles_x	= 0;
+	uint32_t						m_tiles_y	= 0;
+	std::vector<OcclusionTile>		m_tiles;
+	std::vector<OcclusionTriangle>	m_triangles;		//scratch of RenderOccluders, kept between frames
+};
+
+//threads kept between the frames, RenderOccluders and CullOccluded split their work between them
+class OcclusionWorkers
+{
+	public:
+
+	//thread_count threads run the work, the calling thread is one of them
+	explicit OcclusionWorkers(uint32_t thread_count);
+	~OcclusionWorkers();
+
+	OcclusionWorkers(const OcclusionWorkers&) = delete;
+	OcclusionWorkers& operator=(const OcclusionWorkers&) = delete;
+
+	uint32_t ThreadCount() const
+	{
+		return static_cast<uint32_t>(m_threads.size()) + 1;
+	}
+
+	//runs f(t) for t in [0, threads) and returns, when all ran. t = 0 runs on the calling thread
+	template <typename F> void Run(uint32_t threads, F& f)
+	{
+		Run(threads, [](void* context, uint32_t t) { (*static_cast<F*>(context))(t); }, &f);
+	}
+
+	private:
+
+	void Run(uint32_t threads, void (*function)(void*, uint32_t), void* context);
+	void Work(uint32_t t);
+
+	std::vector<std::thread>		m_threads;
+	std::mutex						m_lock;
+	std::condition_variable			m_start;
+	std::condition_variable			m_done;
+	void							(*m_function)(void*, uint32_t) = nullptr;
+	void*							m_context			= nullptr;
+	uint64_t						m_run				= 0;
+	uint32_t						m_threads_of_run	= 0;
+	uint32_t						m_pending			= 0;	//workers of the run, which did not finish
+	bool							m_stop				= false;
+};
+
+//width is a multiple of 32, height a multiple of 4
+OcclusionBuffer	MakeOcclusionBuffer(uint32_t width = 256, uint32_t height = 128);
+
+void			ClearOcclusionBuffer(OcclusionBuffer* b);
+
+//triangles crossing the near plane are skipped, an occluder can only hide less
+void			RenderOccluders(OcclusionBuffer* b, const OccluderMesh* meshes, uint32_t mesh_count, const float view_projection[16], OcclusionWorkers& workers);
+
+//false, when the box is behind the occluders everywhere on the screen. boxes crossing the near plane are visible
+bool			IsVisible(const OcclusionBuffer* b, const Aabb& box, const float view_projection[16]);
+
+//clears view_mask in visible_masks of the occluded boxes
+void			CullOccluded(const OcclusionBuffer* b, const Aabb* boxes, uint32_t box_count, const float view_projection[16], uint64_t view_mask, uint64_t* visible_masks, OcclusionWorkers& workers);
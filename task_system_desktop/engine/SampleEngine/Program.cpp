@@ -2,6 +2,8 @@
 #include <iostream>
 #include <fstream>
 
+#include "MaskedOcclusion.h"
+
 struct Transform
 {
 	float	m_Rotation[4];
@@ -30,10 +32,12 @@ struct VisiblityObject
 struct VisiblityObjects
 {
 	std::vector<Transform>				m_transforms_static;
+	std::vector<Aabb>					m_bounds_static;						//world bounds for the occlusion culling
 	std::vector<uint64_t>				m_visible_masks_static;
 	std::vector < VisiblityObject*>		m_objects_static;
 
 	std::vector<Transform>				m_transforms;
+	std::vector<Aabb>					m_bounds;
 	std::vector<uint64_t>				m_visible_masks;
 	std::vector < VisiblityObject*>		m_object;
 };
@@ -49,7 +53,7 @@ struct RenderObjects
 
 struct View
 {
-	float		m_view[16];
+	float		m_view[16];				//view projection, row vectors
 	uint32_t	m_view_mask;			//mask for views
 };
 
@@ -85,6 +89,17 @@ void ComputeVisibility(const VisiblityObjects* o, const View* views, const uint3
 	*/
 }
 
+//runs after the frustum visibility, clears the view bit of the objects behind the occluders of the view
+void ComputeOcclusionStatic(const OcclusionBuffer* b, const View* view, VisiblityObjects* o, OcclusionWorkers& workers)
+{
+	CullOccluded(b, o->m_bounds_static.data(), static_cast<uint32_t>(o->m_bounds_static.size()), view->m_view, view->m_view_mask, o->m_visible_masks_static.data(), workers);
+}
+
+void ComputeOcclusionDynamic(const OcclusionBuffer* b, const View* view, VisiblityObjects* o, OcclusionWorkers& workers)
+{
+	CullOccluded(b, o->m_bounds.data(), static_cast<uint32_t>(o->m_bounds.size()), view->m_view, view->m_view_mask, o->m_visible_masks.data(), workers);
+}
+
 //Frame allocator
 
 
@@ -100,6 +115,7 @@ int main()
 
 	//Simulate
 	//ComputevisibilityStatic
+	//RenderOccluders, ComputeOcclusionStatic, ComputeOcclusionDynamic
 
 
 
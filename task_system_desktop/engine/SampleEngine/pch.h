@@ -3,6 +3,11 @@
 
 #pragma once
 
+#if defined(_WIN32)
+#define NOMINMAX
 #include <Windows.h>
+#endif
+
+#include <cstdint>
 #include <vector>
 
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+
+//shared parts of the checks of the occlusion harness: named groups of cases, the first failures of a group are printed,
+//the summary prints a line per group and gives the exit code of the check
+namespace occlusion_benchmark
+{
+	struct CheckStatistics
+	{
+		const char*	m_name		= "";
+		uint32_t	m_cases		= 0;
+		uint32_t	m_failures	= 0;
+	};
+
+	inline void Fail(CheckStatistics& s, const char* check)
+	{
+		if (s.m_failures++ < 4)
+		{
+			printf("  %s: %s failed, case %u\n", s.m_name, check, s.m_cases);
+		}
+	}
+
+	inline void Print(const CheckStatistics& s)
+	{
+		printf("%-28s cases %6u  failures %4u\n", s.m_name, s.m_cases, s.m_failures);
+	}
+
+	//the groups of a check, a deque, so the references of the groups stay valid while new ones are added
+	class CheckGroups
+	{
+		public:
+
+		CheckStatistics& Add(const char* name)
+		{
+			m_groups.push_back(CheckStatistics());
+			m_groups.back().m_name = name;
+			return m_groups.back();
+		}
+
+		//prints the groups, 0 if none failed, 1 otherwise
+		int Report() const
+		{
+			uint32_t failures = 0;
+
+			for (auto&& s : m_groups)
+			{
+				Print(s);
+				failures += s.m_failures;
+			}
+
+			return failures == 0 ? 0 : 1;
+		}
+
+		private:
+
+		std::deque<CheckStatistics> m_groups;
+	};
+}
@@ -0,0 +1,192 @@
+#include "MaskedOcclusion.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+//cost of the occlusion culling of a frame: a room of walls and pillars as occluders and the boxes of the objects behind them
+namespace
+{
+	//best of three runs, in nanoseconds per item
+	template <typename F>
+	double Measure(uint32_t items, F f)
+	{
+		double best = INFINITY;
+
+		for (uint32_t run = 0; run < 3; ++run)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			f();
+			const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			best = std::min(best, ns / items);
+		}
+
+		return best;
+	}
+
+	void Print(const char* name, double ns)
+	{
+		printf("%-36s %10.1f ns %12.0f per second\n", name, ns, 1e9 / ns);
+	}
+
+	//r = a * b
+	void Multiply(const float a[16], const float b[16], float r[16])
+	{
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			for (uint32_t j = 0; j < 4; ++j)
+			{
+				r[4 * i + j] = a[4 * i + 0] * b[0 + j] + a[4 * i + 1] * b[4 + j] + a[4 * i + 2] * b[8 + j] + a[4 * i + 3] * b[12 + j];
+			}
+		}
+	}
+
+	//a camera at eye height looking along z, left handed with a d3d projection
+	void MakeViewProjection(float r[16])
+	{
+		const float view[16] =
+		{
+			1.0f,	0.0f,	0.0f,	0.0f,
+			0.0f,	1.0f,	0.0f,	0.0f,
+			0.0f,	0.0f,	1.0f,	0.0f,
+			0.0f,	-1.7f,	0.0f,	1.0f
+		};
+
+		const float n	= 0.25f;
+		const float f	= 1000.0f;
+		const float ys	= 1.0f / tanf(0.5f);
+		const float xs	= ys * 9.0f / 16.0f;
+		const float q	= f / (f - n);
+
+		const float projection[16] =
+		{
+			xs,		0.0f,	0.0f,		0.0f,
+			0.0f,	ys,		0.0f,		0.0f,
+			0.0f,	0.0f,	q,			1.0f,
+			0.0f,	0.0f,	-q * n,		0.0f
+		};
+
+		Multiply(view, projection, r);
+	}
+
+	const float CubePositions[24] =
+	{
+		0, 0, 0,	1, 0, 0,	0, 1, 0,	1, 1, 0,
+		0, 0, 1,	1, 0, 1,	0, 1, 1,	1, 1, 1
+	};
+
+	const uint32_t CubeIndices[36] =
+	{
+		0, 2, 1,	1, 2, 3,	4, 5, 6,	5, 7, 6,
+		0, 1, 4,	1, 5, 4,	2, 6, 3,	3, 6, 7,
+		0, 4, 2,	2, 4, 6,	1, 3, 5,	3, 7, 5
+	};
+
+	OccluderMesh MakeCube(float x, float y, float z, float sx, float sy, float sz)
+	{
+		OccluderMesh m = {};
+
+		m.m_positions	= CubePositions;
+		m.m_indices		= CubeIndices;
+		m.m_index_count	= 36;
+		m.m_world[0]	= sx;
+		m.m_world[5]	= sy;
+		m.m_world[10]	= sz;
+		m.m_world[12]	= x;
+		m.m_world[13]	= y;
+		m.m_world[14]	= z;
+		m.m_world[15]	= 1.0f;
+
+		return m;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t frames = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 100;
+
+	std::mt19937							g(7);
+	std::uniform_real_distribution<float>	u(0.0f, 1.0f);
+	std::vector<OccluderMesh>				meshes;
+	std::vector<Aabb>						boxes;
+	float									view_projection[16];
+
+	MakeViewProjection(view_projection);
+
+	//rooms of 20 x 20 behind each other, a wall with a door between them and pillars inside
+	for (uint32_t room = 0; room < 10; ++room)
+	{
+		const float z = 10.0f + room * 20.0f;
+
+		meshes.push_back(MakeCube(-60.0f, 0.0f, z, 55.0f, 6.0f, 0.5f));
+		meshes.push_back(MakeCube(5.0f, 0.0f, z, 55.0f, 6.0f, 0.5f));
+
+		for (uint32_t pillar = 0; pillar < 28; ++pillar)
+		{
+			meshes.push_back(MakeCube(-60.0f + 120.0f * u(g), 0.0f, z + 1.0f + 18.0f * u(g), 0.5f + u(g), 6.0f, 0.5f + u(g)));
+		}
+	}
+
+	for (uint32_t i = 0; i < 10000; ++i)
+	{
+		const float x = -60.0f + 120.0f * u(g);
+		const float y = 3.0f * u(g);
+		const float z = 2.0f + 200.0f * u(g);
+		const float s = 0.2f + u(g);
+
+		boxes.push_back({ { x, y, z }, { x + s, y + s, z + s } });
+	}
+
+	std::vector<uint64_t>	masks(boxes.size());
+	OcclusionBuffer			b = MakeOcclusionBuffer(256, 128);
+	const uint32_t			hardware = std::max(1U, std::thread::hardware_concurrency());
+	uint32_t				visible = 0;
+	char					name[64];
+
+	printf("%zu occluders, %zu triangles, %zu boxes\n", meshes.size(), meshes.size() * 12, boxes.size());
+
+	for (uint32_t threads : { 1U, std::min(4U, hardware), hardware })
+	{
+		OcclusionWorkers workers(threads);
+
+		const double render = Measure(frames, [&]
+		{
+			for (uint32_t f = 0; f < frames; ++f)
+			{
+				ClearOcclusionBuffer(&b);
+				RenderOccluders(&b, meshes.data(), static_cast<uint32_t>(meshes.size()), view_projection, workers);
+			}
+		});
+
+		const double cull = Measure(frames, [&]
+		{
+			for (uint32_t f = 0; f < frames; ++f)
+			{
+				std::fill(masks.begin(), masks.end(), 1);
+				CullOccluded(&b, boxes.data(), static_cast<uint32_t>(boxes.size()), view_projection, 1, masks.data(), workers);
+			}
+		});
+
+		snprintf(name, sizeof(name), "%u threads, render occluders", threads);
+		Print(name, render);
+		snprintf(name, sizeof(name), "%u threads, cull boxes", threads);
+		Print(name, cull);
+		snprintf(name, sizeof(name), "%u threads, frame", threads);
+		Print(name, render + cull);
+		printf("%-36s %s\n", "", render + cull < 1e6 ? "under the 1 ms budget at 256 x 128" : "over the 1 ms budget at 256 x 128");
+	}
+
+	for (auto m : masks)
+	{
+		visible += static_cast<uint32_t>(m);
+	}
+
+	printf("%u of %zu boxes visible\n", visible, boxes.size());
+
+	return visible == 0 || visible == boxes.size() ? 1 : 0;
+}
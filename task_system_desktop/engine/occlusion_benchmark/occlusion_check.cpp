@@ -0,0 +1,408 @@
+#include "MaskedOcclusion.h"
+#include "check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+//random box scenes against a brute force depth buffer of the same occluders. a culled box must be behind the reference depth on
+//all pixels it touches, the tiles must not depend on the thread count, and boxes crossing the near plane stay visible
+using namespace occlusion_benchmark;
+
+namespace
+{
+	const uint32_t Width	= 256;
+	const uint32_t Height	= 128;
+	const float Near		= 0.5f;
+	const float Far			= 500.0f;
+
+	//r = a * b
+	void Multiply(const float a[16], const float b[16], float r[16])
+	{
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			for (uint32_t j = 0; j < 4; ++j)
+			{
+				r[4 * i + j] = a[4 * i + 0] * b[0 + j] + a[4 * i + 1] * b[4 + j] + a[4 * i + 2] * b[8 + j] + a[4 * i + 3] * b[12 + j];
+			}
+		}
+	}
+
+	//a camera one above the origin looking along z, left handed with a d3d projection
+	void MakeViewProjection(float r[16])
+	{
+		//moved down by one, the boxes are not centered on the screen
+		const float view[16] =
+		{
+			1.0f,	0.0f,	0.0f,	0.0f,
+			0.0f,	1.0f,	0.0f,	0.0f,
+			0.0f,	0.0f,	1.0f,	0.0f,
+			0.0f,	-1.0f,	0.0f,	1.0f
+		};
+
+		const float ys = 1.0f / tanf(0.5f);
+		const float xs = ys * Height / Width;
+		const float q  = Far / (Far - Near);
+
+		const float projection[16] =
+		{
+			xs,		0.0f,	0.0f,		0.0f,
+			0.0f,	ys,		0.0f,		0.0f,
+			0.0f,	0.0f,	q,			1.0f,
+			0.0f,	0.0f,	-q * Near,	0.0f
+		};
+
+		Multiply(view, projection, r);
+	}
+
+	//the unit cube [0, 1]^3, scaled and moved by the world matrix of the meshes
+	const float CubePositions[24] =
+	{
+		0, 0, 0,	1, 0, 0,	0, 1, 0,	1, 1, 0,
+		0, 0, 1,	1, 0, 1,	0, 1, 1,	1, 1, 1
+	};
+
+	const uint32_t CubeIndices[36] =
+	{
+		0, 2, 1,	1, 2, 3,	4, 5, 6,	5, 7, 6,
+		0, 1, 4,	1, 5, 4,	2, 6, 3,	3, 6, 7,
+		0, 4, 2,	2, 4, 6,	1, 3, 5,	3, 7, 5
+	};
+
+	OccluderMesh MakeCube(const Aabb& box)
+	{
+		OccluderMesh m = {};
+
+		m.m_positions	= CubePositions;
+		m.m_indices		= CubeIndices;
+		m.m_index_count	= 36;
+		m.m_world[0]	= box.m_max[0] - box.m_min[0];
+		m.m_world[5]	= box.m_max[1] - box.m_min[1];
+		m.m_world[10]	= box.m_max[2] - box.m_min[2];
+		m.m_world[12]	= box.m_min[0];
+		m.m_world[13]	= box.m_min[1];
+		m.m_world[14]	= box.m_min[2];
+		m.m_world[15]	= 1.0f;
+
+		return m;
+	}
+
+	Aabb MakeBox(float x, float y, float z, float sx, float sy, float sz)
+	{
+		return { { x, y, z }, { x + sx, y + sy, z + sz } };
+	}
+
+	//a box in front of the camera of size up to size, depth in [z0, z1]
+	Aabb RandomBox(std::mt19937& g, float z0, float z1, float size)
+	{
+		std::uniform_real_distribution<float> u(0.0f, 1.0f);
+
+		const float z = z0 + (z1 - z0) * u(g);
+		return MakeBox((u(g) * 2.0f - 1.0f) * z, (u(g) * 2.0f - 1.0f) * z * 0.5f, z, size * u(g) + 0.01f, size * u(g) + 0.01f, size * u(g) + 0.01f);
+	}
+
+	//the closest depth of the occluders at every pixel center, 1 where nothing is drawn. pixels on an edge count as covered
+	std::vector<double> ReferenceDepth(const std::vector<OccluderMesh>& meshes, const float view_projection[16])
+	{
+		std::vector<double> depth(Width * Height, 1.0);
+
+		for (const auto& m : meshes)
+		{
+			float world_view_projection[16];
+			Multiply(m.m_world, view_projection, world_view_projection);
+
+			for (uint32_t i = 0; i < m.m_index_count; i += 3)
+			{
+				double	x[3];
+				double	y[3];
+				double	z[3];
+				bool	skip = false;
+
+				for (uint32_t k = 0; k < 3; ++k)
+				{
+					const float*	p = m.m_positions + 3 * m.m_indices[i + k];
+					double			c[4];
+
+					for (uint32_t j = 0; j < 4; ++j)
+					{
+						c[j] = p[0] * world_view_projection[j] + p[1] * world_view_projection[4 + j] + p[2] * world_view_projection[8 + j] + world_view_projection[12 + j];
+					}
+
+					skip |= !(c[3] > 1e-6) || c[2] < 0.0;
+
+					x[k] = (c[0] / c[3] * 0.5 + 0.5) * Width;
+					y[k] = (0.5 - c[1] / c[3] * 0.5) * Height;
+					z[k] = c[2] / c[3];
+				}
+
+				const double area = (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]);
+
+				if (skip || fabs(area) < 1e-8)
+				{
+					continue;
+				}
+
+				const int32_t x0 = std::max(0, static_cast<int32_t>(floor(std::min({ x[0], x[1], x[2] }))));
+				const int32_t x1 = std::min(static_cast<int32_t>(Width), static_cast<int32_t>(ceil(std::max({ x[0], x[1], x[2] }))));
+				const int32_t y0 = std::max(0, static_cast<int32_t>(floor(std::min({ y[0], y[1], y[2] }))));
+				const int32_t y1 = std::min(static_cast<int32_t>(Height), static_cast<int32_t>(ceil(std::max({ y[0], y[1], y[2] }))));
+
+				for (int32_t py = y0; py < y1; ++py)
+				{
+					for (int32_t px = x0; px < x1; ++px)
+					{
+						const double	cx = px + 0.5;
+						const double	cy = py + 0.5;
+						double			b[3];
+
+						for (uint32_t k = 0; k < 3; ++k)
+						{
+							const uint32_t k1 = (k + 1) % 3;
+							const uint32_t k2 = (k + 2) % 3;
+
+							b[k] = ((x[k2] - x[k1]) * (cy - y[k1]) - (y[k2] - y[k1]) * (cx - x[k1])) / area;
+						}
+
+						//a margin of a thousandth of a pixel, the reference covers more than the tiles
+						if (b[0] >= -1e-3 && b[1] >= -1e-3 && b[2] >= -1e-3)
+						{
+							const double d = b[0] * z[0] + b[1] * z[1] + b[2] * z[2];
+							depth[py * Width + px] = std::min(depth[py * Width + px], d);
+						}
+					}
+				}
+			}
+		}
+
+		return depth;
+	}
+
+	//the pixel centers and the closest depth of the box, the rectangle may be empty. false for boxes crossing the near plane or off screen
+	bool ScreenBounds(const Aabb& box, const float view_projection[16], int32_t r[4], double& z)
+	{
+		double lo[3] = { INFINITY, INFINITY, INFINITY };
+		double hi[3] = { -INFINITY, -INFINITY, -INFINITY };
+
+		for (uint32_t i = 0; i < 8; ++i)
+		{
+			const float p[3] = { i & 1 ? box.m_max[0] : box.m_min[0], i & 2 ? box.m_max[1] : box.m_min[1], i & 4 ? box.m_max[2] : box.m_min[2] };
+			double		c[4];
+
+			for (uint32_t j = 0; j < 4; ++j)
+			{
+				c[j] = p[0] * view_projection[j] + p[1] * view_projection[4 + j] + p[2] * view_projection[8 + j] + view_projection[12 + j];
+			}
+
+			if (!(c[3] > 1e-6) || c[2] < 0.0)
+			{
+				return false;
+			}
+
+			for (uint32_t j = 0; j < 3; ++j)
+			{
+				lo[j] = std::min(lo[j], c[j] / c[3]);
+				hi[j] = std::max(hi[j], c[j] / c[3]);
+			}
+		}
+
+		//the pixels with their centers in the box, the tiles test the pixels the box touches
+		r[0] = std::max(0, static_cast<int32_t>(ceil((lo[0] * 0.5 + 0.5) * Width - 0.5)));
+		r[1] = std::max(0, static_cast<int32_t>(ceil((0.5 - hi[1] * 0.5) * Height - 0.5)));
+		r[2] = std::min(static_cast<int32_t>(Width), static_cast<int32_t>(floor((hi[0] * 0.5 + 0.5) * Width - 0.5)) + 1);
+		r[3] = std::min(static_cast<int32_t>(Height), static_cast<int32_t>(floor((0.5 - lo[1] * 0.5) * Height - 0.5)) + 1);
+		z	 = lo[2];
+
+		//a box between pixel centers has no pixels, but is still on the screen
+		return hi[0] > -1.0 && lo[0] < 1.0 && hi[1] > -1.0 && lo[1] < 1.0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t cases = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 200;
+
+	std::mt19937							g(17);
+	std::uniform_real_distribution<float>	u(0.0f, 1.0f);
+	CheckGroups								groups;
+	OcclusionBuffer							b = MakeOcclusionBuffer(Width, Height);
+	OcclusionBuffer							b_threads = MakeOcclusionBuffer(Width, Height);
+	std::vector<std::unique_ptr<OcclusionWorkers>>	workers;		//workers[t - 1] has t threads
+
+	for (uint32_t t = 1; t <= 8; ++t)
+	{
+		workers.push_back(std::make_unique<OcclusionWorkers>(t));
+	}
+
+	auto& conservative	= groups.Add("conservative");
+	auto& culled		= groups.Add("culled some");
+	auto& threads		= groups.Add("threads");
+	auto& in_front		= groups.Add("in front of occluders");
+	auto& near_plane	= groups.Add("near plane");
+
+	uint32_t culled_boxes	= 0;
+	uint32_t tested_boxes	= 0;
+
+	for (uint32_t i = 0; i < cases; ++i)
+	{
+		float view_projection[16];
+		MakeViewProjection(view_projection);
+
+		std::vector<Aabb>			occluders;
+		std::vector<OccluderMesh>	meshes;
+
+		for (uint32_t j = 1 + static_cast<uint32_t>(u(g) * 40.0f); j > 0; --j)
+		{
+			occluders.push_back(RandomBox(g, 2.0f, 60.0f, 15.0f));
+			meshes.push_back(MakeCube(occluders.back()));
+		}
+
+		ClearOcclusionBuffer(&b);
+		RenderOccluders(&b, meshes.data(), static_cast<uint32_t>(meshes.size()), view_projection, *workers[0]);
+
+		ClearOcclusionBuffer(&b_threads);
+		RenderOccluders(&b_threads, meshes.data(), static_cast<uint32_t>(meshes.size()), view_projection, *workers[i % 7]);
+
+		threads.m_cases++;
+
+		if (memcmp(b.m_tiles.data(), b_threads.m_tiles.data(), b.m_tiles.size() * sizeof(OcclusionTile)) != 0)
+		{
+			Fail(threads, "same tiles with threads");
+		}
+
+		const std::vector<double> reference = ReferenceDepth(meshes, view_projection);
+
+		//culled boxes are behind the reference depth everywhere
+		for (uint32_t j = 0; j < 200; ++j)
+		{
+			const Aabb	box = RandomBox(g, 1.0f, 120.0f, 4.0f);
+			int32_t		r[4];
+			double		z;
+
+			conservative.m_cases++;
+			tested_boxes++;
+
+			if (!ScreenBounds(box, view_projection, r, z))
+			{
+				if (!IsVisible(&b, box, view_projection))
+				{
+					Fail(conservative, "visible off screen");
+				}
+
+				continue;
+			}
+
+			if (IsVisible(&b, box, view_projection))
+			{
+				continue;
+			}
+
+			culled_boxes++;
+
+			bool hidden = true;
+
+			for (int32_t y = r[1]; y < r[3] && hidden; ++y)
+			{
+				for (int32_t x = r[0]; x < r[2] && hidden; ++x)
+				{
+					hidden = reference[y * Width + x] <= z + 1e-6;
+				}
+			}
+
+			if (!hidden)
+			{
+				Fail(conservative, "culled box behind the reference depth");
+			}
+		}
+
+		//boxes closer than every occluder vertex
+		float closest = INFINITY;
+
+		for (const auto& o : occluders)
+		{
+			closest = std::min(closest, o.m_min[2]);
+		}
+
+		for (uint32_t j = 0; j < 20 && closest > 1.1f; ++j)
+		{
+			const Aabb box = RandomBox(g, 0.6f, closest - 0.5f, 0.4f);
+
+			in_front.m_cases++;
+
+			if (box.m_max[2] < closest && !IsVisible(&b, box, view_projection))
+			{
+				Fail(in_front, "in front is visible");
+			}
+		}
+
+		//boxes crossing the near plane, even behind a wall
+		for (uint32_t j = 0; j < 20; ++j)
+		{
+			const Aabb box = MakeBox((u(g) * 2.0f - 1.0f) * 3.0f, (u(g) * 2.0f - 1.0f) * 3.0f, -2.0f * u(g) - 0.1f, 1.0f, 1.0f, 1.0f + 5.0f * u(g));
+
+			near_plane.m_cases++;
+
+			if (box.m_max[2] > Near && !IsVisible(&b, box, view_projection))
+			{
+				Fail(near_plane, "crossing the near plane is visible");
+			}
+		}
+	}
+
+	//behind a wall filling the screen everything is culled, with every thread count
+	{
+		float view_projection[16];
+		MakeViewProjection(view_projection);
+
+		const OccluderMesh wall = MakeCube(MakeBox(-100.0f, -100.0f, 10.0f, 200.0f, 200.0f, 1.0f));
+
+		for (uint32_t t = 1; t <= 8; ++t)
+		{
+			ClearOcclusionBuffer(&b);
+			RenderOccluders(&b, &wall, 1, view_projection, *workers[t - 1]);
+
+			std::vector<Aabb>		boxes;
+			std::vector<uint64_t>	masks;
+
+			for (uint32_t j = 0; j < 1000; ++j)
+			{
+				boxes.push_back(RandomBox(g, 12.0f, 100.0f, 3.0f));
+				masks.push_back(0x5);
+			}
+
+			culled.m_cases++;
+			CullOccluded(&b, boxes.data(), static_cast<uint32_t>(boxes.size()), view_projection, 0x4, masks.data(), *workers[t - 1]);
+
+			for (uint32_t j = 0; j < masks.size(); ++j)
+			{
+				int32_t r[4];
+				double	z;
+
+				//boxes off screen are left to the frustum culling
+				if (ScreenBounds(boxes[j], view_projection, r, z) && masks[j] != 0x1)
+				{
+					Fail(culled, "behind a wall is culled, other views are kept");
+					break;
+				}
+			}
+		}
+	}
+
+	//the random scenes must cull something, or the conservative check checks nothing
+	culled.m_cases++;
+
+	if (culled_boxes < tested_boxes / 20)
+	{
+		Fail(culled, "random scenes cull");
+	}
+
+	const int result = groups.Report();
+
+	printf("culled %u of %u random boxes\n", culled_boxes, tested_boxes);
+
+	return result;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+#include "residency_types.h"
+
+//shared parts of the checks of the residency harness: named groups of cases, the first failures of a group are printed,
+//the summary prints a line per group and gives the exit code of the check. the tilings of the test textures are shared
+//with the benchmarks
+namespace residency_benchmark
+{
+	struct CheckStatistics
+	{
+		const char*	m_name		= "";
+		uint32_t	m_cases		= 0;
+		uint32_t	m_failures	= 0;
+	};
+
+	inline void Fail(CheckStatistics& s, const char* check)
+	{
+		if (s.m_failures++ < 4)
+		{
+			printf("  %s: %s failed, case %u\n", s.m_name, check, s.m_cases);
+		}
+	}
+
+	inline void Print(const CheckStatistics& s)
+	{
+		printf("%-28s cases %6u  failures %4u\n", s.m_name, s.m_cases, s.m_failures);
+	}
+
+	//the groups of a check, a deque, so the references of the groups stay valid while new ones are added
+	class CheckGroups
+	{
+		public:
+
+		CheckStatistics& Add(const char* name)
+		{
+			m_groups.push_back(CheckStatistics());
+			m_groups.back().m_name = name;
+			return m_groups.back();
+		}
+
+		//prints the groups, 0 if none failed, 1 otherwise
+		int Report() const
+		{
+			uint32_t failures = 0;
+
+			for (auto&& s : m_groups)
+			{
+				Print(s);
+				failures += s.m_failures;
+			}
+
+			return failures == 0 ? 0 : 1;
+		}
+
+		private:
+
+		std::deque<CheckStatistics> m_groups;
+	};
+
+	//the mips of the faces one after the other, like the tilings of a cube texture, they halve from width x height tiles down to one
+	inline std::vector<D3D12_SUBRESOURCE_TILING> MakeTilings(uint32_t width, uint32_t height, uint32_t mips, uint32_t faces = 6)
+	{
+		std::vector<D3D12_SUBRESOURCE_TILING> r;
+
+		for (uint32_t face = 0; face < faces; ++face)
+		{
+			for (uint32_t mip = 0; mip < mips; ++mip)
+			{
+				D3D12_SUBRESOURCE_TILING t = {};
+
+				t.WidthInTiles	= std::max(1U, width >> mip);
+				t.HeightInTiles	= static_cast<uint16_t>(std::max(1U, height >> mip));
+				t.DepthInTiles	= 1;
+				r.push_back(t);
+			}
+		}
+
+		return r;
+	}
+}
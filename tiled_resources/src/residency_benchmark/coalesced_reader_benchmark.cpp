@@ -0,0 +1,179 @@
+#include "coalesced_tile_reader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <vector>
+
+//cost of the tile reads of a frame: batches of 64 kB tiles around a window of a file, like the loads of a view, read one pread
+//per tile, through the coalesced reader with one thread and with the queue depth of the sample, and the whole file read in
+//one sequential pass for the bandwidth the reads could reach. the file was just written, so the reads come from the page
+//cache: the numbers are the cost of the calls and the copies, a cold disk adds its seeks to the per tile reads
+using namespace sample;
+
+namespace
+{
+	//best of three runs, in nanoseconds per item
+	template <typename F>
+	double Measure(uint32_t items, F f)
+	{
+		double best = INFINITY;
+
+		for (uint32_t run = 0; run < 3; ++run)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			f();
+			const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			best = std::min(best, ns / items);
+		}
+
+		return best;
+	}
+
+	void Print(const char* name, double ns)
+	{
+		printf("%-36s %10.1f ns %12.0f per second\n", name, ns, 1e9 / ns);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t frames = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 50;
+
+	const uint32_t					tileSize	= 65536;
+	const uint64_t					fileTiles	= 2048;
+	const std::filesystem::path		path		= std::filesystem::temp_directory_path() / "coalesced_reader_benchmark.tiles";
+
+	{
+		FILE* f = fopen(path.string().c_str(), "wb");
+
+		if (f == nullptr)
+		{
+			printf("cannot write %s\n", path.string().c_str());
+			return 1;
+		}
+
+		std::vector<uint8_t> data(tileSize);
+
+		for (uint64_t t = 0; t < fileTiles; ++t)
+		{
+			std::fill(data.begin(), data.end(), static_cast<uint8_t>(t));
+			fwrite(data.data(), 1, data.size(), f);
+		}
+
+		fclose(f);
+	}
+
+	//the batches of the frames: 32 tiles within a window of 256 tiles, the window moves with the frames. the tiles of a view
+	//come in runs along the rows of a mip, the runs are 1 to 8 tiles long
+	std::mt19937						g(29);
+	std::vector<std::vector<uint64_t>>	batches(frames);
+	uint32_t							tiles = 0;
+
+	for (uint32_t f = 0; f < frames; ++f)
+	{
+		const uint64_t base = (f * 37ULL) % (fileTiles - 256);
+
+		while (batches[f].size() < 32)
+		{
+			const uint64_t	first	= base + g() % 248;
+			const uint32_t	run		= 1 + g() % 8;
+
+			for (uint32_t i = 0; i < run && batches[f].size() < 32; ++i)
+			{
+				batches[f].push_back(first + i);
+			}
+		}
+
+		tiles += 32;
+	}
+
+	printf("%u frames of 32 tiles of %u kB, from the page cache\n", frames, tileSize / 1024);
+
+	{
+		TileFile file;
+		file.Open(path);
+
+		std::vector<uint8_t> data(tileSize);
+
+		const double ns = Measure(tiles, [&]
+		{
+			for (auto&& b : batches)
+			{
+				for (auto tile : b)
+				{
+					file.Read(tile * tileSize, data.data(), data.size());
+				}
+			}
+		});
+
+		Print("pread per tile, tile", ns);
+	}
+
+	const uint32_t depths[2] = { 1, 4 };
+	const uint32_t sizes[2] = { 1, 16 };
+
+	for (auto depth : depths)
+	{
+		for (auto size : sizes)
+		{
+			CoalescedTileReaderSettings settings;
+			settings.m_tileSizeInBytes		= tileSize;
+			settings.m_queueDepth			= depth;
+			settings.m_maxReadSizeInTiles	= size;
+
+			CoalescedTileReader reader(settings);
+			reader.Open(path);
+
+			std::atomic<uint32_t> delivered(0);
+
+			const double ns = Measure(tiles, [&]
+			{
+				for (auto&& b : batches)
+				{
+					for (auto tile : b)
+					{
+						reader.Request(tile, [&delivered](std::vector<uint8_t>) { delivered++; });
+					}
+
+					reader.Flush();
+				}
+
+				reader.Wait();
+			});
+
+			const CoalescedReadStatistics r = reader.Statistics();
+
+			char name[64];
+			snprintf(name, sizeof(name), "depth %u, %2u tiles per read, tile", depth, size);
+			Print(name, ns);
+			printf("  %.1f tiles %.1f requests per read\n", static_cast<double>(r.m_bytesRead) / tileSize / r.m_reads,
+				static_cast<double>(r.m_requests) / r.m_reads);
+		}
+	}
+
+	{
+		TileFile file;
+		file.Open(path);
+
+		std::vector<uint8_t> data(16 * static_cast<size_t>(tileSize));
+
+		const double ns = Measure(static_cast<uint32_t>(fileTiles), [&]
+		{
+			for (uint64_t t = 0; t < fileTiles; t += 16)
+			{
+				file.Read(t * tileSize, data.data(), data.size());
+			}
+		});
+
+		Print("sequential file, tile", ns);
+	}
+
+	std::filesystem::remove(path);
+	return 0;
+}
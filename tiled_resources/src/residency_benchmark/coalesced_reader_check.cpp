@@ -0,0 +1,396 @@
+#include "coalesced_tile_reader.h"
+#include "check.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <mutex>
+#include <random>
+#include <set>
+#include <vector>
+
+//the coalesced tile reader against reference models: the plan of random batches must cover every request once, with reads
+//of at most the read size, which start and end with a requested tile and which could not merge with the next one. the reader
+//must deliver every request once, with the bytes of its tile of a patterned file, and keep at most the queue depth of reads
+//in flight. the file layout must give every tile of the resource its own place in the file, the tiles of a row one after the other
+using namespace sample;
+using namespace residency_benchmark;
+
+namespace
+{
+	//the bytes of the patterned file, every byte depends on its tile and its place in the tile
+	uint8_t Pattern(uint64_t tile, size_t i)
+	{
+		return static_cast<uint8_t>((tile * 2654435761ULL + i * 31) >> 3);
+	}
+
+	bool HasPattern(const std::vector<uint8_t>& data, uint64_t tile, size_t size)
+	{
+		if (data.size() != size)
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			if (data[i] != Pattern(tile, i))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool WritePatternFile(const std::filesystem::path& path, uint64_t tiles, size_t size)
+	{
+		FILE* f = fopen(path.string().c_str(), "wb");
+
+		if (f == nullptr)
+		{
+			return false;
+		}
+
+		std::vector<uint8_t> data(size);
+
+		for (uint64_t t = 0; t < tiles; ++t)
+		{
+			for (size_t i = 0; i < size; ++i)
+			{
+				data[i] = Pattern(t, i);
+			}
+
+			fwrite(data.data(), 1, size, f);
+		}
+
+		return fclose(f) == 0;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t cases = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 200;
+
+	std::mt19937					g(53);
+	CheckGroups						groups;
+
+	{
+		auto& s = groups.Add("plan");
+
+		std::vector<TileReadRequest>	requests;
+		std::vector<CoalescedRead>		reads;
+
+		for (s.m_cases = 0; s.m_cases < 20 * cases; ++s.m_cases)
+		{
+			CoalescedTileReaderSettings settings;
+			settings.m_maxReadSizeInTiles	= 1 + g() % 16;
+			settings.m_maxGapInTiles		= g() % 4;
+
+			//few distinct tiles give duplicates and runs, many give single tiles
+			const uint32_t n		= g() % 64;
+			const uint32_t range	= 1 + g() % 256;
+
+			requests.clear();
+
+			for (uint32_t i = 0; i < n; ++i)
+			{
+				requests.push_back({ g() % range, i });
+			}
+
+			PlanCoalescedReads(requests, settings, reads);
+
+			std::vector<uint32_t>	covered(n, 0);
+			std::set<uint64_t>		tiles;
+			uint32_t				next = 0;
+
+			for (auto&& r : requests)
+			{
+				tiles.insert(r.m_tile);
+			}
+
+			for (size_t k = 0; k < reads.size(); ++k)
+			{
+				const CoalescedRead& r = reads[k];
+
+				if (r.m_tiles == 0 || r.m_tiles > settings.m_maxReadSizeInTiles)
+				{
+					Fail(s, "read size");
+				}
+
+				if (r.m_firstRequest != next || r.m_requests == 0)
+				{
+					Fail(s, "requests in order");
+				}
+
+				next = r.m_firstRequest + r.m_requests;
+
+				for (uint32_t i = r.m_firstRequest; i < std::min(next, n); ++i)
+				{
+					const TileReadRequest& q = requests[i];
+
+					if (q.m_tile < r.m_firstTile || q.m_tile >= r.m_firstTile + r.m_tiles)
+					{
+						Fail(s, "request in its read");
+					}
+
+					covered[q.m_request]++;
+				}
+
+				if (tiles.count(r.m_firstTile) == 0 || tiles.count(r.m_firstTile + r.m_tiles - 1) == 0)
+				{
+					Fail(s, "read ends on requested tiles");
+				}
+
+				//the gaps inside a read are at most the gap of the settings
+				uint64_t last = r.m_firstTile;
+
+				for (auto t = tiles.lower_bound(r.m_firstTile); t != tiles.end() && *t < r.m_firstTile + r.m_tiles; ++t)
+				{
+					if (*t - last > settings.m_maxGapInTiles + 1)
+					{
+						Fail(s, "gap within a read");
+					}
+
+					last = *t;
+				}
+
+				//the next read could not have been merged
+				if (k + 1 < reads.size())
+				{
+					const CoalescedRead&	b		= reads[k + 1];
+					const uint64_t			end		= r.m_firstTile + r.m_tiles;
+
+					if (b.m_firstTile < end)
+					{
+						Fail(s, "reads overlap");
+					}
+					else if (b.m_firstTile - end <= settings.m_maxGapInTiles && b.m_firstTile + 1 - r.m_firstTile <= settings.m_maxReadSizeInTiles)
+					{
+						Fail(s, "mergeable reads");
+					}
+				}
+			}
+
+			if (next != n)
+			{
+				Fail(s, "every request planned");
+			}
+
+			if (std::any_of(covered.begin(), covered.end(), [](uint32_t c) { return c != 1; }))
+			{
+				Fail(s, "every request once");
+			}
+		}
+	}
+
+	const size_t					tileSize	= 4096;
+	const uint64_t					fileTiles	= 512;
+	const std::filesystem::path		path		= std::filesystem::temp_directory_path() / "coalesced_reader_check.tiles";
+
+	if (!WritePatternFile(path, fileTiles, tileSize))
+	{
+		printf("cannot write %s\n", path.string().c_str());
+		return 1;
+	}
+
+	{
+		auto& s = groups.Add("reader");
+
+		for (s.m_cases = 0; s.m_cases < cases; ++s.m_cases)
+		{
+			CoalescedTileReaderSettings settings;
+			settings.m_tileSizeInBytes		= static_cast<uint32_t>(tileSize);
+			settings.m_queueDepth			= 1 + g() % 4;
+			settings.m_maxReadSizeInTiles	= 1 + g() % 16;
+			settings.m_maxGapInTiles		= g() % 3;
+
+			CoalescedTileReader reader(settings);
+
+			if (!reader.Open(path) || reader.File().Size() != fileTiles * tileSize)
+			{
+				Fail(s, "open");
+				continue;
+			}
+
+			std::mutex				lock;
+			std::vector<uint32_t>	delivered;
+			std::atomic<uint32_t>	wrong(0);
+			uint32_t				requests = 0;
+
+			//a few frames, each a batch around a window of the file, like the tiles of a view
+			for (uint32_t frame = 0; frame < 4; ++frame)
+			{
+				const uint64_t	base	= g() % (fileTiles - 64);
+				const uint32_t	n		= g() % 48;
+
+				for (uint32_t i = 0; i < n; ++i)
+				{
+					const uint64_t	tile	= base + g() % 64;
+					const uint32_t	request	= requests++;
+
+					{
+						std::lock_guard<std::mutex> l(lock);
+						delivered.push_back(0);
+					}
+
+					reader.Request(tile, [&, tile, request](std::vector<uint8_t> data)
+					{
+						if (!HasPattern(data, tile, tileSize))
+						{
+							wrong++;
+						}
+
+						std::lock_guard<std::mutex> l(lock);
+						delivered[request]++;
+					});
+				}
+
+				reader.Flush();
+			}
+
+			reader.Wait();
+
+			const CoalescedReadStatistics r = reader.Statistics();
+
+			if (wrong.load() != 0)
+			{
+				Fail(s, "tile data");
+			}
+
+			if (std::any_of(delivered.begin(), delivered.end(), [](uint32_t c) { return c != 1; }))
+			{
+				Fail(s, "every request delivered once");
+			}
+
+			if (r.m_requests != requests || r.m_failedReads != 0 || r.m_reads > requests)
+			{
+				Fail(s, "statistics");
+			}
+
+			if (r.m_maxReadsInFlight > settings.m_queueDepth)
+			{
+				Fail(s, "reads in flight");
+			}
+
+			if (r.m_bytesRead > static_cast<uint64_t>(requests) * (settings.m_maxGapInTiles + 1) * tileSize)
+			{
+				Fail(s, "bytes read");
+			}
+		}
+	}
+
+	{
+		auto& s = groups.Add("failed reads");
+
+		for (s.m_cases = 0; s.m_cases < cases / 10; ++s.m_cases)
+		{
+			CoalescedTileReaderSettings settings;
+			settings.m_tileSizeInBytes		= static_cast<uint32_t>(tileSize);
+			settings.m_maxReadSizeInTiles	= 8;
+
+			CoalescedTileReader reader(settings);
+			reader.Open(path);
+
+			//the last tiles of the file and tiles past its end, the read of the run fails, its tiles are zeros
+			std::atomic<uint32_t> delivered(0);
+			std::atomic<uint32_t> zeros(0);
+
+			for (uint64_t tile = fileTiles - 2; tile < fileTiles + 2; ++tile)
+			{
+				reader.Request(tile, [&](std::vector<uint8_t> data)
+				{
+					delivered++;
+
+					if (data.size() == tileSize && std::all_of(data.begin(), data.end(), [](uint8_t b) { return b == 0; }))
+					{
+						zeros++;
+					}
+				});
+			}
+
+			reader.Flush();
+			reader.Wait();
+
+			if (delivered.load() != 4 || zeros.load() != 4 || reader.Statistics().m_failedReads != 1)
+			{
+				Fail(s, "zeros for the tiles of a failed read");
+			}
+		}
+	}
+
+	std::filesystem::remove(path);
+
+	{
+		auto& s = groups.Add("layout");
+
+		for (s.m_cases = 0; s.m_cases < cases; ++s.m_cases)
+		{
+			//the faces of a cube are square, the tiles of the formats at most twice as wide as high
+			const uint32_t	width		= 1U << (g() % 7);
+			const uint32_t	height		= width << (g() % 2);
+			uint32_t		fileMips	= 1;
+
+			//the file has every mip down to one tile, the resource may leave the last ones to the packed mips
+			for (uint64_t tiles = static_cast<uint64_t>(width) * height; tiles > 1; tiles /= 4)
+			{
+				fileMips++;
+			}
+
+			const uint32_t	mips		= 1 + g() % fileMips;
+			const auto		tilings		= MakeTilings(width, height, mips);
+			uint64_t		tilesInFile	= 0;
+
+			for (uint32_t mip = 0, tiles = width * height; mip < fileMips; ++mip, tiles = std::max(1U, tiles / 4))
+			{
+				tilesInFile += 6 * tiles;
+			}
+
+			TileFileLayout layout;
+			layout.Create(tilings.data(), static_cast<uint32_t>(tilings.size()), tilesInFile);
+
+			std::set<uint64_t> seen;
+
+			for (uint32_t subresource = 0; subresource < tilings.size(); ++subresource)
+			{
+				const auto& t = tilings[subresource];
+
+				for (uint32_t y = 0; y < t.HeightInTiles; ++y)
+				{
+					for (uint32_t x = 0; x < t.WidthInTiles; ++x)
+					{
+						D3D12_TILED_RESOURCE_COORDINATE c = {};
+						c.Subresource	= subresource;
+						c.X				= x;
+						c.Y				= y;
+
+						const uint64_t index = layout.TileIndex(c);
+
+						if (index >= tilesInFile)
+						{
+							Fail(s, "tile in the file");
+						}
+
+						if (!seen.insert(index).second)
+						{
+							Fail(s, "tiles in their own place");
+						}
+
+						if (x > 0)
+						{
+							c.X = x - 1;
+
+							if (layout.TileIndex(c) + 1 != index)
+							{
+								Fail(s, "rows one after the other");
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	return groups.Report();
+}
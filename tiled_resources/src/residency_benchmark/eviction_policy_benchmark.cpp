@@ -0,0 +1,123 @@
+#include "eviction_policy.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+//cost of the eviction policies with a full pool: every frame touches a tenth of the mapped tiles and replaces a hundredth of
+//them, each replacement names a victim, evicts it and inserts a new tile. the cost of an operation must not grow with the pool
+using namespace sample;
+
+namespace
+{
+	//best of three runs, in nanoseconds per item
+	template <typename F>
+	double Measure(uint32_t items, F f)
+	{
+		double best = INFINITY;
+
+		for (uint32_t run = 0; run < 3; ++run)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			f();
+			const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			best = std::min(best, ns / items);
+		}
+
+		return best;
+	}
+
+	void Print(const char* name, double ns)
+	{
+		printf("%-36s %10.1f ns %12.0f per second\n", name, ns, 1e9 / ns);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t frames = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 200;
+
+	const EvictionPolicyType	types[4]	= { EvictionPolicyType::LeastRecentlyUsed, EvictionPolicyType::Clock, EvictionPolicyType::AdaptiveReplacement, EvictionPolicyType::CostAware };
+	const uint32_t				pools[2]	= { 1024, 16384 };
+
+	for (auto capacity : pools)
+	{
+		printf("pool %u tiles\n", capacity);
+
+		for (auto type : types)
+		{
+			EvictionPolicySettings settings;
+			settings.m_type = type;
+
+			std::mt19937				g(19);
+			auto						policy	= CreateEvictionPolicy(settings, capacity);
+			TileTable<TrackedTile>		table(2 * capacity);
+			std::vector<TrackedTile*>	mapped;
+			uint32_t					frame	= 1;
+			uint32_t					next	= 0;
+
+			for (; next < capacity; ++next)
+			{
+				TrackedTile* t = table.insert(MakeTileKey(0, 0, next, 0));
+
+				t->m_mipLevel	= static_cast<uint16_t>(g() % 7);
+				t->m_lastSeen	= frame;
+				t->m_physicalTileOffset = next;
+				policy->Insert(t);
+				mapped.push_back(t);
+			}
+
+			const uint32_t touches		= capacity / 10;
+			const uint32_t replacements	= capacity / 100;
+
+			const double ns = Measure(frames * (touches + replacements), [&]
+			{
+				for (uint32_t f = 0; f < frames; ++f)
+				{
+					++frame;
+
+					//a window of the tiles is seen again
+					for (uint32_t i = 0; i < touches; ++i)
+					{
+						TrackedTile* t = mapped[(frame * 31 + i) % mapped.size()];
+
+						if (t->m_lastSeen != frame)
+						{
+							policy->Touch(t, frame);
+						}
+					}
+
+					for (uint32_t i = 0; i < replacements; ++i)
+					{
+						TrackedTile* victim = policy->Victim();
+
+						policy->Evict(victim);
+
+						//the new tile takes the physical tile of the victim and its place in the window
+						const uint32_t slot = victim->m_physicalTileOffset;
+
+						table.erase(victim);
+
+						TrackedTile* t = table.insert(MakeTileKey(0, 0, next++, 0));
+
+						t->m_mipLevel	= static_cast<uint16_t>(g() % 7);
+						t->m_lastSeen	= frame;
+						t->m_physicalTileOffset = slot;
+						policy->Insert(t);
+						mapped[slot] = t;
+					}
+				}
+			});
+
+			char name[64];
+			snprintf(name, sizeof(name), "%s, touch or replacement", EvictionPolicyName(type));
+			Print(name, ns);
+		}
+	}
+
+	return 0;
+}
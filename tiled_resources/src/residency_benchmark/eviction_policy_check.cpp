@@ -0,0 +1,239 @@
+#include "eviction_policy.h"
+#include "check.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <vector>
+
+//the eviction policies against reference models: random frames insert, touch and evict tiles of several mips. every policy
+//must name a mapped tile as the victim and count the hits, the misses and the thrashes. the least recently used victim must
+//be the least recently seen tile, more detailed first, the cost aware victim the one with the least age credit, the clock
+//victim a tile, which was not touched since the hand passed it
+using namespace sample;
+using namespace residency_benchmark;
+
+namespace
+{
+	//the reference order of the least recently used policy and of the cost aware one, the cost of mip m is credit[m]
+	bool Before(const TrackedTile* a, const TrackedTile* b, const std::vector<uint32_t>& credit)
+	{
+		const uint64_t va = a->m_lastSeen + static_cast<uint64_t>(credit[a->m_mipLevel]);
+		const uint64_t vb = b->m_lastSeen + static_cast<uint64_t>(credit[b->m_mipLevel]);
+
+		if (va != vb) return va < vb;
+		return a->m_mipLevel < b->m_mipLevel;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t cases = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 100;
+
+	std::mt19937					g(41);
+	CheckGroups						groups;
+
+	const EvictionPolicyType types[4] = { EvictionPolicyType::LeastRecentlyUsed, EvictionPolicyType::Clock, EvictionPolicyType::AdaptiveReplacement, EvictionPolicyType::CostAware };
+
+	for (auto type : types)
+	{
+		auto& s = groups.Add(EvictionPolicyName(type));
+
+		EvictionPolicySettings settings;
+		settings.m_type = type;
+
+		//the credits of the cost aware policy for the reference, the least recently used policy has none
+		std::vector<uint32_t> credit(16, 0);
+
+		if (type == EvictionPolicyType::CostAware)
+		{
+			float cost = static_cast<float>(settings.m_reloadCostInFrames);
+
+			for (auto&& c : credit)
+			{
+				c		= static_cast<uint32_t>(cost);
+				cost	*= settings.m_mipWeight;
+			}
+		}
+
+		for (uint32_t i = 0; i < cases; ++i)
+		{
+			const uint32_t	capacity	= 4 + g() % 200;
+			auto			policy		= CreateEvictionPolicy(settings, capacity);
+
+			TileTable<TrackedTile>		table;
+			std::set<TrackedTile*>		mapped;
+			uint64_t					touches		= 0;
+			uint64_t					inserts		= 0;
+			bool						failed		= false;
+
+			s.m_cases++;
+
+			//the keys of a small universe, so evicted tiles come back
+			const uint32_t universe = capacity * 3;
+
+			for (uint32_t frame = 1; frame <= 100 && !failed; ++frame)
+			{
+				//touch some of the mapped tiles
+				for (auto&& t : mapped)
+				{
+					if (g() % 3 == 0)
+					{
+						policy->Touch(t, frame);
+						touches++;
+
+						if (t->m_lastSeen != frame)
+						{
+							Fail(s, "last seen of the touched tile");
+							failed = true;
+						}
+					}
+				}
+
+				//map tiles, which are not mapped, evicting the victims of the full pool
+				for (uint32_t k = 0; k < capacity / 4 + 1 && !failed; ++k)
+				{
+					const TileKey key = MakeTileKey(0, 0, g() % universe, 0);
+
+					if (table.find(key) != nullptr)
+					{
+						continue;
+					}
+
+					if (mapped.size() == capacity)
+					{
+						TrackedTile* victim = policy->Victim();
+
+						if (mapped.count(victim) == 0)
+						{
+							Fail(s, "victim is mapped");
+							failed = true;
+							break;
+						}
+
+						for (auto&& t : mapped)
+						{
+							if ((type == EvictionPolicyType::LeastRecentlyUsed || type == EvictionPolicyType::CostAware) && Before(t, victim, credit))
+							{
+								Fail(s, "victim of the reference order");
+								failed = true;
+								break;
+							}
+						}
+
+						if (type == EvictionPolicyType::Clock && victim->m_evictionState != 0)
+						{
+							Fail(s, "victim was not touched");
+							failed = true;
+						}
+
+						policy->Evict(victim);
+						mapped.erase(victim);
+						table.erase(victim);
+					}
+
+					TrackedTile* t = table.insert(key);
+
+					t->m_mipLevel	= static_cast<uint16_t>(g() % 7);
+					t->m_lastSeen	= frame;
+					t->m_state		= TileState::Mapped;
+
+					policy->Insert(t);
+					mapped.insert(t);
+					inserts++;
+				}
+
+				if (policy->size() != mapped.size())
+				{
+					Fail(s, "size of the policy");
+					failed = true;
+				}
+			}
+
+			const EvictionStatistics& e = policy->Statistics();
+
+			if (!failed && (e.m_hits != touches || e.m_misses != inserts || e.m_evictions != inserts - mapped.size() || e.m_thrashes > e.m_misses))
+			{
+				Fail(s, "hits, misses and evictions");
+			}
+		}
+	}
+
+	//a tile mapped again within a pool of evictions is a thrash, after more than a pool of evictions it is not
+	{
+		auto& s = groups.Add("thrashes");
+
+		for (auto type : types)
+		{
+			EvictionPolicySettings settings;
+			settings.m_type = type;
+
+			const uint32_t				capacity	= 8;
+			auto						policy		= CreateEvictionPolicy(settings, capacity);
+			TileTable<TrackedTile>		table;
+			uint32_t					next		= 0;
+
+			s.m_cases++;
+
+			auto map = [&](TileKey key)
+			{
+				if (policy->size() == capacity)
+				{
+					TrackedTile* victim = policy->Victim();
+
+					policy->Evict(victim);
+					table.erase(victim);
+				}
+
+				TrackedTile* t = table.insert(key);
+				t->m_lastSeen = next;
+				policy->Insert(t);
+			};
+
+			for (; next < capacity; ++next)
+			{
+				map(MakeTileKey(0, 0, next, 0));
+			}
+
+			//the first tile is evicted by the next one and comes back at once
+			const TileKey first = MakeTileKey(0, 0, 0, 0);
+
+			for (uint32_t k = 0; k < capacity && table.find(first) != nullptr; ++k)
+			{
+				map(MakeTileKey(0, 0, next++, 0));
+			}
+
+			map(first);
+
+			if (policy->Statistics().m_thrashes != 1)
+			{
+				Fail(s, "thrash within a pool of evictions");
+			}
+
+			//a pool of evictions later, a tile evicted before them is no thrash
+			const uint64_t thrashes = policy->Statistics().m_thrashes;
+			TileKey evicted = 0;
+
+			for (uint32_t k = 0; k < 3 * capacity; ++k)
+			{
+				if (k == capacity)
+				{
+					evicted = policy->Victim()->m_key;
+				}
+
+				map(MakeTileKey(0, 0, next++, 0));
+			}
+
+			map(evicted);
+
+			if (policy->Statistics().m_thrashes != thrashes)
+			{
+				Fail(s, "no thrash after a pool of evictions");
+			}
+		}
+	}
+
+	return groups.Report();
+}
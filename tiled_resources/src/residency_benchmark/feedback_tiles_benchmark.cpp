@@ -0,0 +1,154 @@
+#include "feedback_tiles.h"
+#include "check.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+//cost of the tile updates of a frame of 1080p feedback (240 x 135 samples): the mip walk and a table lookup per sample against
+//the unique tiles of CollectSampledTiles
+using namespace sample;
+using namespace residency_benchmark;
+
+namespace
+{
+	//best of three runs, in nanoseconds per item
+	template <typename F>
+	double Measure(uint32_t items, F f)
+	{
+		double best = INFINITY;
+
+		for (uint32_t run = 0; run < 3; ++run)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			f();
+			const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			best = std::min(best, ns / items);
+		}
+
+		return best;
+	}
+
+	void Print(const char* name, double ns)
+	{
+		printf("%-36s %10.1f ns %12.0f per second\n", name, ns, 1e9 / ns);
+	}
+
+	struct Tile
+	{
+		TileKey		m_key		= 0;
+		Tile*		m_prev		= nullptr;
+		Tile*		m_next		= nullptr;
+		uint32_t	m_lastSeen	= 0;
+	};
+
+	void Touch(TileTable<Tile>& table, TileKey key, uint32_t frame)
+	{
+		Tile* t = table.find(key);
+
+		if (t == nullptr)
+		{
+			t = table.insert(key);
+		}
+
+		t->m_lastSeen = frame;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t frames = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 20;
+
+	std::mt19937							g(9);
+	std::uniform_real_distribution<float>	u(0.0f, 1.0f);
+
+	//the diffuse and the normal texture
+	const std::vector<D3D12_SUBRESOURCE_TILING>	tilings[2]	= { MakeTilings(32, 64, 6), MakeTilings(64, 64, 7) };
+	const uint32_t								mips[2]		= { 6, 7 };
+
+	//a view of the ground: the texture coordinates change smoothly over the screen, the mip grows with the distance
+	std::vector<DecodedSample> samples;
+
+	for (uint32_t y = 0; y < 135; ++y)
+	{
+		for (uint32_t x = 0; x < 240; ++x)
+		{
+			const float distance = 1.0f + 20.0f * y / 135.0f;
+
+			DecodedSample s;
+			s.u		= 0.4f + (x / 240.0f - 0.5f) * 0.02f * distance;
+			s.v		= 0.3f + 0.01f * distance;
+			s.mip	= static_cast<short>(std::min(14.0f, log2f(distance) + u(g)));
+			s.face	= 2;
+			samples.push_back(s);
+		}
+	}
+
+	TileTable<Tile>			table;
+	std::vector<TileKey>	keys;
+	std::vector<TileKey>	scratch;
+	uint32_t				frame		= 0;
+	size_t					lookups		= 0;
+	size_t					tiles		= 0;
+
+	const double walk = Measure(frames, [&]
+	{
+		lookups = 0;
+
+		for (uint32_t f = 0; f < frames; ++f)
+		{
+			++frame;
+
+			for (auto&& sample : samples)
+			{
+				for (uint32_t r = 0; r < 2; ++r)
+				{
+					int16_t m = std::max<int16_t>(0, std::min<int16_t>(static_cast<int16_t>(mips[r]) - 1, sample.mip));
+
+					for (; m < static_cast<int16_t>(mips[r]); ++m)
+					{
+						const uint32_t	sub		= m + sample.face * mips[r];
+						const auto&		t		= tilings[r][sub];
+						const float		tileX	= std::min<float>(t.WidthInTiles - 1.0f, std::max<float>(t.WidthInTiles * sample.u, 0.0f));
+						const float		tileY	= std::min<float>(t.HeightInTiles - 1.0f, std::max<float>(t.HeightInTiles * sample.v, 0.0f));
+
+						Touch(table, MakeTileKey(r, sub, static_cast<uint32_t>(tileX), static_cast<uint32_t>(tileY)), frame);
+						lookups++;
+					}
+				}
+			}
+		}
+	});
+
+	const double unique = Measure(frames, [&]
+	{
+		tiles = 0;
+
+		for (uint32_t f = 0; f < frames; ++f)
+		{
+			++frame;
+
+			for (uint32_t r = 0; r < 2; ++r)
+			{
+				CollectSampledTiles(samples, r, tilings[r].data(), mips[r], keys, scratch);
+
+				for (auto&& k : keys)
+				{
+					Touch(table, k, frame);
+				}
+
+				tiles += keys.size();
+			}
+		}
+	});
+
+	printf("%zu samples, %zu lookups of the mip walk, %zu unique tiles\n", samples.size(), lookups / frames, tiles / frames);
+	Print("mip walk per sample, frame", walk);
+	Print("unique tiles, frame", unique);
+
+	return 0;
+}
@@ -0,0 +1,131 @@
+#include "feedback_tiles.h"
+#include "check.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <vector>
+
+//the sorted and unique tiles of a frame of samples against the tiles of the mip walk per sample, which ProcessSamples did before.
+//the radix sort must agree with std::sort
+using namespace sample;
+using namespace residency_benchmark;
+
+namespace
+{
+	//the tiles of the samples with the walk over all mips of every sample
+	std::set<TileKey> Reference(const std::vector<DecodedSample>& samples, uint32_t resource, const std::vector<D3D12_SUBRESOURCE_TILING>& tilings, uint32_t mips)
+	{
+		std::set<TileKey> r;
+
+		for (auto&& sample : samples)
+		{
+			int16_t actualMip = std::max<int16_t>(0, std::min<int16_t>(static_cast<int16_t>(mips) - 1, sample.mip));
+
+			for (auto mip = actualMip; mip < static_cast<int16_t>(mips); ++mip)
+			{
+				uint32_t subResource = mip + sample.face * mips;
+
+				const auto& t = tilings[subResource];
+
+				float tileX = std::max<float>(t.WidthInTiles * sample.u, 0.0f);
+				tileX = std::min<float>(t.WidthInTiles - 1.0f, tileX);
+
+				float tileY = std::max<float>(t.HeightInTiles * sample.v, 0.0f);
+				tileY = std::min<float>(t.HeightInTiles - 1.0f, tileY);
+
+				r.insert(MakeTileKey(resource, subResource, static_cast<uint32_t>(tileX), static_cast<uint32_t>(tileY)));
+			}
+		}
+
+		return r;
+	}
+
+	//samples around a few points, out of range coordinates and mips included
+	std::vector<DecodedSample> RandomSamples(std::mt19937& g, uint32_t count)
+	{
+		std::uniform_real_distribution<float>	u(0.0f, 1.0f);
+		std::vector<DecodedSample>				r;
+		const float								spread = u(g) * u(g);
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			DecodedSample s;
+
+			s.u		= u(g) < 0.02f ? 1.5f * u(g) - 0.25f : 0.5f + spread * (u(g) - 0.5f);
+			s.v		= u(g) < 0.02f ? 1.5f * u(g) - 0.25f : 0.5f + spread * (u(g) - 0.5f);
+			s.mip	= static_cast<short>(u(g) * 16.0f) - 1;
+			s.face	= static_cast<short>(g() % 6);
+			r.push_back(s);
+		}
+
+		return r;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t cases = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 500;
+
+	std::mt19937					g(11);
+	CheckGroups						groups;
+	std::vector<TileKey>			keys;
+	std::vector<TileKey>			scratch;
+
+	//random keys, with bytes equal in all keys and with duplicates
+	{
+		auto& s = groups.Add("radix sort");
+
+		for (uint32_t i = 0; i < cases; ++i)
+		{
+			const uint64_t			mask = (static_cast<uint64_t>(g()) << 32 | g()) | (i % 2 ? 0 : 0xFF);
+			std::vector<TileKey>	reference;
+
+			keys.clear();
+
+			for (uint32_t j = g() % 3000; j > 0; --j)
+			{
+				keys.push_back((static_cast<uint64_t>(g()) << 32 | g()) & mask);
+			}
+
+			reference = keys;
+			std::sort(reference.begin(), reference.end());
+
+			s.m_cases++;
+			SortTileKeys(keys, scratch);
+
+			if (keys != reference)
+			{
+				Fail(s, "same as std::sort");
+			}
+		}
+	}
+
+	//the tilings of the diffuse (32 x 64 tiles, 6 mips) and the normal (64 x 64, 7 mips) textures and small ones
+	{
+		auto& s = groups.Add("sampled tiles");
+
+		const uint32_t sizes[4][3] = { { 32, 64, 6 }, { 64, 64, 7 }, { 4, 2, 3 }, { 1, 1, 1 } };
+
+		for (uint32_t i = 0; i < cases; ++i)
+		{
+			const auto&							size		= sizes[i % 4];
+			const auto							tilings		= MakeTilings(size[0], size[1], size[2]);
+			const std::vector<DecodedSample>	samples		= RandomSamples(g, i % 10 == 0 ? 0 : g() % 5000);
+			const uint32_t						resource	= i % 2;
+			const std::set<TileKey>				reference	= Reference(samples, resource, tilings, size[2]);
+
+			s.m_cases++;
+			CollectSampledTiles(samples, resource, tilings.data(), size[2], keys, scratch);
+
+			if (keys != std::vector<TileKey>(reference.begin(), reference.end()))
+			{
+				Fail(s, "the tiles of the mip walk, once and sorted");
+			}
+		}
+	}
+
+	return groups.Report();
+}
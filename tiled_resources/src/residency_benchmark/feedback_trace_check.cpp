@@ -0,0 +1,228 @@
+#include "feedback_trace.h"
+#include "check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+//traces of random frames and of camera flights with still stretches, which must replay bit exact, and cut and damaged
+//traces, which must stop with a failure instead of reading past the end
+using namespace sample;
+using namespace residency_benchmark;
+
+namespace
+{
+	bool Equal(const DecodedSample& a, const DecodedSample& b)
+	{
+		return std::memcmp(&a.u, &b.u, sizeof(float)) == 0 && std::memcmp(&a.v, &b.v, sizeof(float)) == 0 && a.mip == b.mip && a.face == b.face;
+	}
+
+	bool Equal(const FeedbackTraceFrame& a, const FeedbackTraceFrame& b)
+	{
+		return a.m_frame == b.m_frame && std::memcmp(&a.m_pose, &b.m_pose, sizeof(CameraPose)) == 0 && a.m_samples.size() == b.m_samples.size() &&
+			std::equal(a.m_samples.begin(), a.m_samples.end(), b.m_samples.begin(), [](const DecodedSample& x, const DecodedSample& y) { return Equal(x, y); });
+	}
+
+	//a view of the ground, which moves, stops and turns. a part of the frames is the previous frame again
+	std::vector<FeedbackTraceFrame> MakeFlight(std::mt19937& g, uint32_t frames, bool random)
+	{
+		std::uniform_real_distribution<float>	u(0.0f, 1.0f);
+		std::vector<FeedbackTraceFrame>			r(frames);
+		uint32_t								frame = g() % 1000;
+
+		for (uint32_t f = 0; f < frames; ++f)
+		{
+			FeedbackTraceFrame& t = r[f];
+
+			frame += 1 + (g() % 8 == 0 ? g() % 5 : 0);
+			t.m_frame = frame;
+
+			if (f > 0 && g() % 4 == 0)
+			{
+				t.m_pose	= r[f - 1].m_pose;
+				t.m_samples	= r[f - 1].m_samples;
+
+				//a few samples change in a still frame
+				for (uint32_t k = g() % 3; k > 0 && !t.m_samples.empty(); --k)
+				{
+					t.m_samples[g() % t.m_samples.size()].mip ^= 1;
+				}
+
+				continue;
+			}
+
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				t.m_pose.m_position[i] = random ? u(g) * 100.0f - 50.0f : 0.01f * f * (i + 1);
+			}
+
+			for (uint32_t i = 0; i < 4; ++i)
+			{
+				t.m_pose.m_orientation[i] = random ? u(g) * 2.0f - 1.0f : cosf(0.001f * f + i);
+			}
+
+			const uint32_t width	= random ? g() % 40 : 60;
+			const uint32_t height	= random ? g() % 30 : 34;
+
+			for (uint32_t y = 0; y < height; ++y)
+			{
+				for (uint32_t x = 0; x < width; ++x)
+				{
+					const float distance = 1.0f + 20.0f * y / 34.0f;
+
+					DecodedSample s;
+
+					if (random)
+					{
+						s.u		= g() % 16 == 0 ? -u(g) : u(g);
+						s.v		= u(g);
+						s.mip	= static_cast<short>(g() % 15);
+						s.face	= static_cast<short>(g() % 6);
+					}
+					else
+					{
+						s.u		= 0.4f + 0.001f * f + (x / 60.0f - 0.5f) * 0.02f * distance;
+						s.v		= 0.3f + 0.01f * distance;
+						s.mip	= static_cast<short>(std::min(14.0f, log2f(distance) + u(g)));
+						s.face	= static_cast<short>(f / 50 % 6);
+					}
+
+					t.m_samples.push_back(s);
+				}
+			}
+		}
+
+		return r;
+	}
+
+	FeedbackTraceWriter Record(const std::vector<FeedbackTraceFrame>& frames)
+	{
+		FeedbackTraceWriter w;
+
+		for (auto&& f : frames)
+		{
+			w.Write(f.m_frame, f.m_pose, f.m_samples);
+		}
+
+		return w;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t cases = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 100;
+
+	std::mt19937					g(29);
+	CheckGroups						groups;
+
+	size_t flightBytes		= 0;
+	size_t flightSamples	= 0;
+
+	{
+		auto& s = groups.Add("replay");
+
+		for (uint32_t i = 0; i < cases; ++i)
+		{
+			const bool	random	= i % 2 == 0;
+			const auto	frames	= MakeFlight(g, 1 + g() % 60, random);
+			const auto	w		= Record(frames);
+
+			FeedbackTraceReader	reader(w.Data().data(), w.Data().size());
+			FeedbackTraceFrame	frame;
+			size_t				read = 0;
+
+			s.m_cases++;
+
+			while (reader.Next(frame))
+			{
+				if (read >= frames.size() || !Equal(frame, frames[read]))
+				{
+					Fail(s, "frames of the trace");
+					break;
+				}
+
+				read++;
+			}
+
+			if (reader.Failed() || read != frames.size() || w.Frames() != frames.size())
+			{
+				Fail(s, "all frames read");
+			}
+
+			if (!random)
+			{
+				flightBytes += w.Data().size();
+
+				for (auto&& f : frames)
+				{
+					flightSamples += f.m_samples.size();
+				}
+			}
+		}
+	}
+
+	{
+		auto& s = groups.Add("damaged traces");
+
+		for (uint32_t i = 0; i < cases; ++i)
+		{
+			const auto				frames	= MakeFlight(g, 1 + g() % 8, i % 2 == 0);
+			const auto				w		= Record(frames);
+			std::vector<uint8_t>	data	= w.Data();
+
+			s.m_cases++;
+
+			//cut, the data is copied to a buffer of its size, so reads past the end show up under a sanitizer
+			{
+				const size_t			size = g() % data.size();
+				std::vector<uint8_t>	cut(data.begin(), data.begin() + size);
+				FeedbackTraceReader		reader(cut.data(), cut.size());
+				FeedbackTraceFrame		frame;
+				size_t					read = 0;
+
+				while (reader.Next(frame))
+				{
+					read++;
+				}
+
+				//a cut between two frames is a shorter trace
+				if (read > frames.size() || (!reader.Failed() && (read == frames.size() || size < 4)))
+				{
+					Fail(s, "cut trace");
+				}
+			}
+
+			//damaged bytes, the reader must stop in the data
+			{
+				for (uint32_t k = 1 + g() % 4; k > 0; --k)
+				{
+					data[g() % data.size()] ^= static_cast<uint8_t>(1 + g() % 255);
+				}
+
+				FeedbackTraceReader	reader(data.data(), data.size());
+				FeedbackTraceFrame	frame;
+				size_t				read = 0;
+
+				while (reader.Next(frame) && read < 1000)
+				{
+					read++;
+				}
+
+				if (read >= 1000)
+				{
+					Fail(s, "damaged trace ends");
+				}
+			}
+		}
+	}
+
+	const int result = groups.Report();
+
+	printf("camera flights: %.2f bytes per sample\n", flightSamples ? static_cast<double>(flightBytes) / flightSamples : 0.0);
+
+	return result;
+}
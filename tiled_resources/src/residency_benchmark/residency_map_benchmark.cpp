@@ -0,0 +1,187 @@
+#include "residency_map.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+//cost of the residency updates of a frame with a burst of evictions and maps: the residency map with the rebuild of the dirty
+//rectangles against the loops over the covered tiles per mapped and evicted tile, which UpdateTiles did before. then the uploads
+//of a frame with a few maps: the boxes of the changed faces against the six faces, which were uploaded every frame
+using namespace sample;
+
+namespace
+{
+	//best of three runs, in nanoseconds per item
+	template <typename F>
+	double Measure(uint32_t items, F f)
+	{
+		double best = INFINITY;
+
+		for (uint32_t run = 0; run < 3; ++run)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			f();
+			const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			best = std::min(best, ns / items);
+		}
+
+		return best;
+	}
+
+	void Print(const char* name, double ns)
+	{
+		printf("%-36s %10.1f ns %12.0f per second\n", name, ns, 1e9 / ns);
+	}
+
+	struct Change
+	{
+		uint32_t	m_face;
+		uint32_t	m_mip;
+		uint32_t	m_x;
+		uint32_t	m_y;
+		bool		m_map;
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t changes	= argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 200;
+	const uint32_t frames	= 50;
+	const uint32_t mips		= 7;
+
+	std::mt19937 g(23);
+
+	//the normal texture, 64 x 64 tiles and 7 mips. half of the changes are evictions, the less detailed mips are the most common
+	std::vector<D3D12_SUBRESOURCE_TILING> tilings;
+
+	for (uint32_t mip = 0; mip < mips; ++mip)
+	{
+		D3D12_SUBRESOURCE_TILING t = {};
+
+		t.WidthInTiles	= 64 >> mip;
+		t.HeightInTiles	= static_cast<uint16_t>(64 >> mip);
+		t.DepthInTiles	= 1;
+		tilings.push_back(t);
+	}
+
+	std::vector<std::vector<Change>> bursts(frames);
+
+	for (auto&& b : bursts)
+	{
+		for (uint32_t i = 0; i < changes; ++i)
+		{
+			const uint32_t mip = std::min(mips - 1, 2 + static_cast<uint32_t>(g() % 6));
+
+			b.push_back({ static_cast<uint32_t>(g() % 6), mip, static_cast<uint32_t>(g() % tilings[mip].WidthInTiles), static_cast<uint32_t>(g() % tilings[mip].HeightInTiles), i % 2 == 0 });
+		}
+	}
+
+	ResidencyMap			map;
+	std::vector<uint8_t>	shadow[6];
+
+	map.Create(tilings.data(), mips);
+
+	for (auto&& s : shadow)
+	{
+		s.assign(64 * 64, 0xFF);
+	}
+
+	const double map_ns = Measure(frames, [&]
+	{
+		for (auto&& b : bursts)
+		{
+			for (auto&& c : b)
+			{
+				if (c.m_map)
+				{
+					map.Map(c.m_face, c.m_mip, c.m_x, c.m_y);
+				}
+				else
+				{
+					map.Unmap(c.m_face, c.m_mip, c.m_x, c.m_y);
+				}
+			}
+
+			map.Update();
+		}
+	});
+
+	const double loops_ns = Measure(frames, [&]
+	{
+		for (auto&& b : bursts)
+		{
+			for (auto&& c : b)
+			{
+				const uint32_t cw = 64 / tilings[c.m_mip].WidthInTiles;
+				const uint32_t ch = 64 / tilings[c.m_mip].HeightInTiles;
+
+				for (uint32_t y = 0; y < ch; ++y)
+				{
+					for (uint32_t x = 0; x < cw; ++x)
+					{
+						uint8_t* value = &shadow[c.m_face][(c.m_y * ch + y) * 64 + c.m_x * cw + x];
+						*value = c.m_map ? std::min<uint8_t>(c.m_mip * 16, *value) : std::max<uint8_t>((c.m_mip + 1) * 16, *value);
+					}
+				}
+			}
+		}
+	});
+
+	//a frame with a few maps of the most detailed mips, the common case once the view settled
+	std::vector<ResidencyUpload>	uploads;
+	std::vector<uint8_t>			buffer(6 * 256 * 64);
+	uint64_t						box_bytes	= 0;
+	uint32_t						frame		= 0;
+
+	map.CollectUploads(64, uploads);
+
+	const double boxes_ns = Measure(frames, [&]
+	{
+		box_bytes = 0;
+
+		for (uint32_t f = 0; f < frames; ++f, ++frame)
+		{
+			for (uint32_t i = 0; i < 4; ++i)
+			{
+				map.Map((frame + i) % 6, i % 2, (frame * 7 + i * 5) % tilings[i % 2].WidthInTiles, (frame * 3 + i) % tilings[i % 2].HeightInTiles);
+			}
+
+			box_bytes += map.CollectUploads(64, uploads);
+
+			for (auto&& u : uploads)
+			{
+				map.WriteUpload(u, 64, buffer.data());
+			}
+		}
+	});
+
+	const double faces_ns = Measure(frames, [&]
+	{
+		for (uint32_t f = 0; f < frames; ++f)
+		{
+			for (uint32_t face = 0; face < 6; ++face)
+			{
+				for (uint32_t y = 0; y < 64; ++y)
+				{
+					for (uint32_t x = 0; x < 64; ++x)
+					{
+						buffer[face * 256 * 64 + y * 256 + x] = map.Face(face)[y * 64 + x];
+					}
+				}
+			}
+		}
+	});
+
+	printf("%u maps and evictions per frame\n", changes);
+	Print("residency map, frame", map_ns);
+	Print("covered tile loops, frame", loops_ns);
+	printf("4 maps per frame, %.0f upload bytes in boxes, %u in faces\n", static_cast<double>(box_bytes) / frames, 5 * 256 * 64 + 256 * 63 + 64);
+	Print("changed boxes upload, frame", boxes_ns);
+	Print("six faces upload, frame", faces_ns);
+
+	return 0;
+}
@@ -0,0 +1,196 @@
+#include "residency_map.h"
+#include "check.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+//random maps and unmaps of the residency map against the faces computed from the mapped tiles: every tile of the most detailed
+//mip holds 16 times the most detailed mapped mip over it, 0xFF for none. updates in between must leave no stale rectangles.
+//a texture, which receives the uploaded boxes only, must stay equal to the faces stretched to the texture
+using namespace sample;
+using namespace residency_benchmark;
+
+namespace
+{
+	uint8_t Reference(const ResidencyMap& map, const std::vector<D3D12_SUBRESOURCE_TILING>& tilings, uint32_t face, uint32_t x, uint32_t y)
+	{
+		for (uint32_t mip = 0; mip < tilings.size(); ++mip)
+		{
+			const uint32_t cw = tilings[0].WidthInTiles / tilings[mip].WidthInTiles;
+			const uint32_t ch = tilings[0].HeightInTiles / tilings[mip].HeightInTiles;
+
+			if (map.IsMapped(face, mip, x / cw, y / ch))
+			{
+				return static_cast<uint8_t>(mip * 16);
+			}
+		}
+
+		return 0xFF;
+	}
+
+	//a map or an unmap, mostly of the less detailed mips
+	void RandomChange(std::mt19937& g, ResidencyMap& map, const std::vector<D3D12_SUBRESOURCE_TILING>& tilings)
+	{
+		const uint32_t	mips	= static_cast<uint32_t>(tilings.size());
+		const uint32_t	mip		= mips - 1 - std::min(mips - 1, static_cast<uint32_t>(g() % (mips + 2)));
+		const uint32_t	face	= g() % 6;
+		const auto&		t		= tilings[mip];
+		const uint32_t	x		= g() % t.WidthInTiles;
+		const uint32_t	y		= g() % t.HeightInTiles;
+
+		if (g() % 3 == 0)
+		{
+			map.Unmap(face, mip, x, y);
+		}
+		else
+		{
+			map.Map(face, mip, x, y);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t cases = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 300;
+
+	std::mt19937					g(19);
+	CheckGroups						groups;
+
+	//the tilings of the diffuse (32 x 64 tiles, 6 mips) and the normal (64 x 64, 7 mips) textures and small ones
+	{
+		auto& s = groups.Add("faces");
+
+		const uint32_t sizes[4][3] = { { 32, 64, 6 }, { 64, 64, 7 }, { 4, 2, 3 }, { 1, 1, 1 } };
+
+		for (uint32_t i = 0; i < cases; ++i)
+		{
+			const auto&		size	= sizes[i % 4];
+			const auto		tilings	= MakeTilings(size[0], size[1], size[2], 1);
+			ResidencyMap	map;
+
+			map.Create(tilings.data(), size[2]);
+			s.m_cases++;
+
+			bool failed = false;
+
+			for (uint32_t j = 0; j < 20 && !failed; ++j)
+			{
+				for (uint32_t k = g() % 200; k > 0; --k)
+				{
+					RandomChange(g, map, tilings);
+				}
+
+				map.Update();
+
+				for (uint32_t face = 0; face < 6 && !failed; ++face)
+				{
+					for (uint32_t y = 0; y < map.Height() && !failed; ++y)
+					{
+						for (uint32_t x = 0; x < map.Width() && !failed; ++x)
+						{
+							if (map.Face(face)[y * map.Width() + x] != Reference(map, tilings, face, x, y))
+							{
+								Fail(s, "most detailed mapped mip");
+								failed = true;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	//the boxes of the changed faces, copied into a texture like CopyTextureRegion with the placed footprints
+	{
+		auto& s = groups.Add("uploads");
+
+		const uint32_t sizes[4][3] = { { 32, 64, 6 }, { 64, 64, 7 }, { 4, 2, 3 }, { 1, 1, 1 } };
+
+		for (uint32_t i = 0; i < cases; ++i)
+		{
+			const auto&						size		= sizes[i % 4];
+			const auto						tilings		= MakeTilings(size[0], size[1], size[2], 1);
+			const uint32_t					dimension	= std::max(size[0], size[1]);
+			ResidencyMap					map;
+			std::vector<ResidencyUpload>	uploads;
+			std::vector<uint8_t>			buffer;
+			std::vector<uint8_t>			texture(6 * dimension * dimension, 0);
+
+			map.Create(tilings.data(), size[2]);
+			map.Invalidate();
+			s.m_cases++;
+
+			bool failed = false;
+
+			for (uint32_t j = 0; j < 20 && !failed; ++j)
+			{
+				const uint64_t	bytes	= map.CollectUploads(dimension, uploads);
+				uint64_t		end		= 0;
+
+				buffer.assign(static_cast<size_t>(bytes), 0);
+
+				for (auto&& u : uploads)
+				{
+					if (u.m_offset % D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT != 0 || u.m_rowPitch % D3D12_TEXTURE_DATA_PITCH_ALIGNMENT != 0 || u.m_offset < end ||
+						u.m_left >= u.m_right || u.m_top >= u.m_bottom || u.m_right > dimension || u.m_bottom > dimension || u.m_rowPitch < u.m_right - u.m_left)
+					{
+						Fail(s, "aligned boxes in the texture and the buffer");
+						failed = true;
+						break;
+					}
+
+					end = u.m_offset + static_cast<uint64_t>(u.m_rowPitch) * (u.m_bottom - u.m_top - 1) + (u.m_right - u.m_left);
+
+					if (end > bytes)
+					{
+						Fail(s, "boxes in the returned size");
+						failed = true;
+						break;
+					}
+
+					map.WriteUpload(u, dimension, buffer.data());
+
+					for (uint32_t y = u.m_top; y < u.m_bottom; ++y)
+					{
+						for (uint32_t x = u.m_left; x < u.m_right; ++x)
+						{
+							texture[(u.m_face * dimension + y) * dimension + x] = buffer[u.m_offset + (y - u.m_top) * u.m_rowPitch + x - u.m_left];
+						}
+					}
+				}
+
+				//the texture of the previous upload, nothing else may change
+				for (uint32_t face = 0; face < 6 && !failed; ++face)
+				{
+					for (uint32_t y = 0; y < dimension && !failed; ++y)
+					{
+						for (uint32_t x = 0; x < dimension && !failed; ++x)
+						{
+							if (texture[(face * dimension + y) * dimension + x] != map.Face(face)[(y * map.Height() / dimension) * map.Width() + x * map.Width() / dimension])
+							{
+								Fail(s, "texture of the uploads");
+								failed = true;
+							}
+						}
+					}
+				}
+
+				if (!failed && map.CollectUploads(dimension, uploads) != 0)
+				{
+					Fail(s, "no uploads without changes");
+					failed = true;
+				}
+
+				for (uint32_t k = j % 4 == 0 ? 0 : g() % (j % 2 ? 4 : 100); k > 0; --k)
+				{
+					RandomChange(g, map, tilings);
+				}
+			}
+		}
+	}
+
+	return groups.Report();
+}
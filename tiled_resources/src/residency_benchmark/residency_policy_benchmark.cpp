@@ -0,0 +1,107 @@
+#include "residency_policy.h"
+#include "simulated_residency_backend.h"
+#include "check.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+//cpu time of a frame of the residency policy on the simulated backend, a flight over the ground with 1080p feedback
+//(240 x 135 samples) and a pool of 128 tiles, which evicts on every turn, and the bytes the d3d12 backend would read and upload per frame
+using namespace sample;
+using namespace residency_benchmark;
+
+namespace
+{
+	//best of three runs, in nanoseconds per item
+	template <typename F>
+	double Measure(uint32_t items, F f)
+	{
+		double best = INFINITY;
+
+		for (uint32_t run = 0; run < 3; ++run)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			f();
+			const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			best = std::min(best, ns / items);
+		}
+
+		return best;
+	}
+
+	void Print(const char* name, double ns)
+	{
+		printf("%-36s %10.1f ns %12.0f per second\n", name, ns, 1e9 / ns);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t frames = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 500;
+
+	std::mt19937							g(9);
+	std::uniform_real_distribution<float>	noise(0.0f, 1.0f);
+
+	//the diffuse and the normal texture
+	const std::vector<D3D12_SUBRESOURCE_TILING>	tilings[2]	= { MakeTilings(32, 64, 6), MakeTilings(64, 64, 7) };
+	const uint32_t								mips[2]		= { 6, 7 };
+
+	//the samples of the frames: a view of the ground, which moves over a face and turns to the next one every 100 frames
+	std::vector<std::vector<DecodedSample>> flight(frames);
+
+	for (uint32_t f = 0; f < frames; ++f)
+	{
+		for (uint32_t y = 0; y < 135; ++y)
+		{
+			for (uint32_t x = 0; x < 240; ++x)
+			{
+				const float distance = 1.0f + 20.0f * y / 135.0f;
+
+				DecodedSample s;
+				s.u		= 0.2f + 0.001f * (f % 100) + (x / 240.0f - 0.5f) * 0.02f * distance;
+				s.v		= 0.3f + 0.01f * distance;
+				s.mip	= static_cast<short>(std::min(14.0f, log2f(distance) + noise(g)));
+				s.face	= static_cast<short>(f / 100 % 6);
+				flight[f].push_back(s);
+			}
+		}
+	}
+
+	SimulatedResidencyStatistics	simulated;
+	ResidencyPolicyStatistics		policy;
+
+	const double frame = Measure(frames, [&]
+	{
+		ResidencyPolicySettings		settings;
+		settings.m_poolSizeInTiles = 128;
+
+		SimulatedResidencyBackend	b(settings.m_poolSizeInTiles, settings.m_reservedTiles, 65536, 2);
+		ResidencyPolicy				p(&b, settings);
+
+		p.AddResource(tilings[0].data(), mips[0]);
+		p.AddResource(tilings[1].data(), mips[1]);
+
+		for (uint32_t f = 0; f < frames; ++f)
+		{
+			p.Update(flight[f], f + 1);
+		}
+
+		simulated	= b.Statistics();
+		policy		= p.Statistics();
+	});
+
+	printf("%u frames, %llu loads %llu maps %llu evictions %llu discards, %llu errors\n", frames,
+		static_cast<unsigned long long>(policy.m_loads), static_cast<unsigned long long>(policy.m_maps),
+		static_cast<unsigned long long>(policy.m_evictions), static_cast<unsigned long long>(policy.m_discards),
+		static_cast<unsigned long long>(simulated.m_errors));
+	printf("per frame %.1f KB read, %.1f KB tiles uploaded, %.2f KB residency uploaded\n", simulated.m_bytesRead / 1024.0 / frames,
+		simulated.m_bytesUploaded / 1024.0 / frames, simulated.m_residencyBytesUploaded / 1024.0 / frames);
+	Print("policy update, frame", frame);
+
+	return 0;
+}
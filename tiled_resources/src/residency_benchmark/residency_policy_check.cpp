@@ -0,0 +1,269 @@
+#include "residency_policy.h"
+#include "simulated_residency_backend.h"
+#include "feedback_tiles.h"
+#include "check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+//the residency policy on the simulated backend, camera flights over the ground with several pool sizes and load latencies.
+//the simulator must see no invalid calls, the policy and the simulator must agree on the mapped tiles and their number, the
+//residency maps must hold the mapped tiles, and, with a pool, which holds the tiles of a frame, the less detailed tile over a
+//mapped one must be mapped, whichever eviction policy runs. a camera, which stops, must get all its tiles mapped, if the pool is large enough
+using namespace sample;
+using namespace residency_benchmark;
+
+namespace
+{
+	//a view of the ground around u, v of a face: the texture coordinates change smoothly over the screen, the mip grows with
+	//the distance
+	void MakeSamples(std::mt19937& g, float u, float v, uint32_t face, std::vector<DecodedSample>& samples)
+	{
+		std::uniform_real_distribution<float> noise(0.0f, 1.0f);
+
+		samples.clear();
+
+		for (uint32_t y = 0; y < 34; ++y)
+		{
+			for (uint32_t x = 0; x < 60; ++x)
+			{
+				const float distance = 1.0f + 20.0f * y / 34.0f;
+
+				DecodedSample s;
+				s.u		= u + (x / 60.0f - 0.5f) * 0.02f * distance;
+				s.v		= v + 0.01f * distance;
+				s.mip	= static_cast<short>(std::min(14.0f, log2f(distance) + noise(g)));
+				s.face	= static_cast<short>(face);
+				samples.push_back(s);
+			}
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t cases = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 24;
+
+	std::mt19937					g(23);
+	CheckGroups						groups;
+
+	//the diffuse (32 x 64 tiles, 6 mips) and the normal (64 x 64, 7 mips) textures
+	const std::vector<D3D12_SUBRESOURCE_TILING>	tilings[2]	= { MakeTilings(32, 64, 6), MakeTilings(64, 64, 7) };
+	const uint32_t								mips[2]		= { 6, 7 };
+
+	//flights, which turn to another face every 50 frames, small pools evict every frame
+	{
+		auto& s = groups.Add("flights");
+
+		const uint32_t pools[4]		= { 8, 64, 300, 1024 };
+		const uint32_t latencies[3]	= { 0, 1, 4 };
+
+		for (uint32_t i = 0; i < cases; ++i)
+		{
+			ResidencyPolicySettings settings;
+			settings.m_poolSizeInTiles	= pools[i % 4];
+			settings.m_eviction.m_type	= static_cast<EvictionPolicyType>((i / 4) % 4);
+
+			SimulatedResidencyBackend	backend(settings.m_poolSizeInTiles, settings.m_reservedTiles, 65536, latencies[i % 3]);
+			ResidencyPolicy				policy(&backend, settings);
+
+			policy.AddResource(tilings[0].data(), mips[0]);
+			policy.AddResource(tilings[1].data(), mips[1]);
+			s.m_cases++;
+
+			std::uniform_real_distribution<float>	start(0.2f, 0.6f);
+			std::vector<DecodedSample>				samples;
+			float									u		= start(g);
+			float									v		= start(g);
+			const float								du		= (g() % 2 ? 1 : -1) * 0.0005f * (1 + g() % 8);
+			bool									failed	= false;
+
+			for (uint32_t frame = 1; frame <= 300 && !failed; ++frame)
+			{
+				MakeSamples(g, u + du * frame, v, (frame / 50 + i) % 6, samples);
+				policy.Update(samples, frame);
+
+				if (backend.Statistics().m_errors != 0)
+				{
+					Fail(s, "valid backend calls");
+					failed = true;
+				}
+
+				if (policy.MappedTiles() != backend.MappedTiles() || policy.MappedTiles() + settings.m_reservedTiles > settings.m_poolSizeInTiles)
+				{
+					Fail(s, "mapped tiles in the pool");
+					failed = true;
+				}
+
+				backend.ForEachMapped([&](uint32_t resource, uint32_t sub, uint32_t x, uint32_t y)
+				{
+					if (!failed && !policy.Residency(resource).IsMapped(sub / mips[resource], sub % mips[resource], x, y))
+					{
+						Fail(s, "residency map of the mapped tiles");
+						failed = true;
+					}
+
+					const uint32_t mip = sub % mips[resource];
+
+					if (!failed && settings.m_poolSizeInTiles >= 300 && mip + 1 < mips[resource] && !policy.Residency(resource).IsMapped(sub / mips[resource], mip + 1, x / 2, y / 2))
+					{
+						Fail(s, "less detailed tile mapped");
+						failed = true;
+					}
+				});
+
+				//the residency maps hold no tiles, which the simulator has not mapped
+				for (uint32_t k = 0; k < 64 && !failed; ++k)
+				{
+					const uint32_t	resource	= g() % 2;
+					const uint32_t	sub			= g() % (6 * mips[resource]);
+					const auto&		t			= tilings[resource][sub];
+					D3D12_TILED_RESOURCE_COORDINATE c = {};
+
+					c.Subresource	= sub;
+					c.X				= g() % t.WidthInTiles;
+					c.Y				= g() % t.HeightInTiles;
+
+					if (policy.Residency(resource).IsMapped(sub / mips[resource], sub % mips[resource], c.X, c.Y) != backend.IsMapped(resource, c))
+					{
+						Fail(s, "mapped tiles of the residency map");
+						failed = true;
+					}
+				}
+			}
+		}
+	}
+
+	//a camera, which stops: every tile it samples is mapped after the loads of the latency
+	{
+		auto& s = groups.Add("steady camera");
+
+		const uint32_t latencies[3] = { 0, 1, 4 };
+
+		for (uint32_t i = 0; i < cases; ++i)
+		{
+			ResidencyPolicySettings		settings;
+			SimulatedResidencyBackend	backend(settings.m_poolSizeInTiles, settings.m_reservedTiles, 65536, latencies[i % 3]);
+			ResidencyPolicy				policy(&backend, settings);
+
+			policy.AddResource(tilings[0].data(), mips[0]);
+			policy.AddResource(tilings[1].data(), mips[1]);
+			s.m_cases++;
+
+			std::uniform_real_distribution<float>	start(0.2f, 0.6f);
+			std::vector<DecodedSample>				samples;
+			std::vector<TileKey>					keys;
+			std::vector<TileKey>					scratch;
+			const float								u		= start(g);
+			const float								v		= start(g);
+			const uint32_t							face	= g() % 6;
+			uint32_t								frame	= 1;
+
+			//a flight to the place, then a still view
+			for (; frame <= 100; ++frame)
+			{
+				MakeSamples(g, u - 0.002f * (100 - frame), v, face, samples);
+				policy.Update(samples, frame);
+			}
+
+			std::vector<DecodedSample> still;
+			MakeSamples(g, u, v, face, still);
+
+			for (; frame <= 300; ++frame)
+			{
+				policy.Update(still, frame);
+			}
+
+			bool failed = false;
+
+			for (uint32_t resource = 0; resource < 2 && !failed; ++resource)
+			{
+				CollectSampledTiles(still, resource, tilings[resource].data(), mips[resource], keys, scratch);
+
+				for (auto&& k : keys)
+				{
+					D3D12_TILED_RESOURCE_COORDINATE c = {};
+
+					c.Subresource	= TileKeySubresource(k);
+					c.X				= TileKeyX(k);
+					c.Y				= TileKeyY(k);
+
+					if (!backend.IsMapped(resource, c))
+					{
+						Fail(s, "sampled tiles mapped");
+						failed = true;
+						break;
+					}
+				}
+			}
+
+			if (!failed && backend.Statistics().m_errors != 0)
+			{
+				Fail(s, "valid backend calls");
+			}
+		}
+	}
+
+	//flights with the feedback of the frames ahead as the prediction
+	{
+		auto& s = groups.Add("prefetch");
+
+		const uint32_t pools[3]		= { 64, 300, 1024 };
+		const uint32_t latencies[3]	= { 0, 1, 4 };
+
+		for (uint32_t i = 0; i < cases; ++i)
+		{
+			ResidencyPolicySettings settings;
+			settings.m_poolSizeInTiles			= pools[i % 3];
+			settings.m_maxPrefetchLoadsPerFrame	= 1 + i % 4;
+
+			SimulatedResidencyBackend	backend(settings.m_poolSizeInTiles, settings.m_reservedTiles, 65536, latencies[(i / 3) % 3]);
+			ResidencyPolicy				policy(&backend, settings);
+
+			policy.AddResource(tilings[0].data(), mips[0]);
+			policy.AddResource(tilings[1].data(), mips[1]);
+			s.m_cases++;
+
+			std::uniform_real_distribution<float>	start(0.2f, 0.6f);
+			std::vector<DecodedSample>				samples;
+			std::vector<DecodedSample>				predicted;
+			const float								u		= start(g);
+			const float								v		= start(g);
+			const uint32_t							face	= g() % 6;
+			const float								du		= 0.0005f * (1 + g() % 8);
+			bool									failed	= false;
+
+			for (uint32_t frame = 1; frame <= 200 && !failed; ++frame)
+			{
+				const uint64_t prefetches = policy.Statistics().m_prefetches;
+
+				MakeSamples(g, u + du * frame, v, face, samples);
+				MakeSamples(g, u + du * (frame + 8), v, face, predicted);
+				policy.Update(samples, predicted, frame);
+
+				if (policy.Statistics().m_prefetches - prefetches > settings.m_maxPrefetchLoadsPerFrame)
+				{
+					Fail(s, "prefetch budget of the frame");
+					failed = true;
+				}
+
+				if (backend.Statistics().m_errors != 0 || policy.MappedTiles() != backend.MappedTiles())
+				{
+					Fail(s, "valid backend calls");
+					failed = true;
+				}
+			}
+
+			if (!failed && (policy.Statistics().m_prefetches == 0 || policy.Statistics().m_prefetchesSeen > policy.Statistics().m_prefetches))
+			{
+				Fail(s, "predicted tiles seen");
+			}
+		}
+	}
+
+	return groups.Report();
+}
@@ -0,0 +1,364 @@
+#include "feedback_trace.h"
+#include "feedback_tiles.h"
+#include "residency_policy.h"
+#include "simulated_residency_backend.h"
+#include "tile_prefetcher.h"
+#include "check.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+//replays a feedback trace through the residency policy on the simulated backend and reports, how well the policy follows
+//the camera: the samples, whose mip is mapped, the mips the samples miss, the frames from a tile being needed to it being
+//mapped, the bytes read and the cpu time of a frame. the settings are arguments, so they can be tuned on the same trace. the
+//prefetch predicts the feedback from the camera poses of the trace, the eviction policy is chosen by name
+//
+//  residency_replay trace [pool tiles] [loads in flight] [maps per frame] [load latency in frames] [prefetch frames ahead] [prefetch loads per frame] [eviction lru|clock|arc|cost]
+//  residency_replay --record trace [frames]		records a synthetic camera flight
+using namespace sample;
+using namespace residency_benchmark;
+
+namespace
+{
+	//the tiles of the file of a cube texture, every face with its mips down to one tile, the packed ones too
+	uint64_t TilesInFile(uint32_t width, uint32_t height)
+	{
+		uint64_t tiles = 0;
+
+		for (uint64_t mip = static_cast<uint64_t>(width) * height; ; mip = std::max<uint64_t>(1, mip / 4))
+		{
+			tiles += mip;
+
+			if (mip == 1)
+			{
+				break;
+			}
+		}
+
+		return 6 * tiles;
+	}
+
+	bool ReadFile(const char* name, std::vector<uint8_t>& data)
+	{
+		FILE* f = fopen(name, "rb");
+
+		if (f == nullptr)
+		{
+			return false;
+		}
+
+		uint8_t buffer[65536];
+		size_t	read;
+
+		while ((read = fread(buffer, 1, sizeof(buffer), f)) > 0)
+		{
+			data.insert(data.end(), buffer, buffer + read);
+		}
+
+		fclose(f);
+		return true;
+	}
+
+	bool WriteFile(const char* name, const std::vector<uint8_t>& data)
+	{
+		FILE* f = fopen(name, "wb");
+
+		if (f == nullptr)
+		{
+			return false;
+		}
+
+		const bool written = fwrite(data.data(), 1, data.size(), f) == data.size();
+		return fclose(f) == 0 && written;
+	}
+
+	//a flight low over the planet at the sampling resolution of 1080p (240 x 135), the samples are projected from the camera like
+	//the sampling pass writes them. every 400 frames it hovers and looks left and right, which sees the same ground again and
+	//again, flies slowly, then fast and turns in the last quarter
+	int Record(const char* name, uint32_t frames)
+	{
+		FeedbackTraceWriter			writer;
+		std::vector<DecodedSample>	samples;
+		float						angle	= 0.0f;
+		float						heading	= 0.0f;
+
+		for (uint32_t f = 0; f < frames; ++f)
+		{
+			const uint32_t	leg	= f % 400;
+			const float		yaw	= leg < 100 ? 1.4f * sinf(2.0f * 3.14159265f * leg / 50.0f) : 0.0f;
+
+			angle	+= leg < 100 ? 0.0f : leg < 200 ? 0.002f : 0.006f;
+			heading	+= leg < 300 ? 0.0f : 0.004f;
+
+			//the camera circles the planet on a great circle, which the heading turns
+			const float e1[3]	= { cosf(heading), 0.0f, sinf(heading) };
+			const float c		= cosf(angle);
+			const float sn		= sinf(angle);
+			const float n[3]	= { c * e1[0], sn, c * e1[2] };
+			const float ahead[3]	= { -sn * e1[0], c, -sn * e1[2] };
+			const float side[3]	= { n[1] * ahead[2] - n[2] * ahead[1], n[2] * ahead[0] - n[0] * ahead[2], n[0] * ahead[1] - n[1] * ahead[0] };
+
+			float eye[3];
+			float at[3];
+
+			for (uint32_t i = 0; i < 3; ++i)
+			{
+				eye[i]	= 1.06f * n[i];
+				at[i]	= eye[i] + 0.08f * (cosf(yaw) * ahead[i] + sinf(yaw) * side[i]) - 0.05f * n[i];
+			}
+
+			const CameraPose pose = LookAt(eye, at, n);
+
+			ProjectFeedback(pose, FeedbackProjection(), 240, 135, samples);
+			writer.Write(f, pose, samples);
+		}
+
+		if (!WriteFile(name, writer.Data()))
+		{
+			printf("cannot write %s\n", name);
+			return 1;
+		}
+
+		printf("%u frames, %.1f KB\n", frames, writer.Data().size() / 1024.0);
+		return 0;
+	}
+
+	struct PendingTile
+	{
+		uint32_t	m_needed;				//first frame of the current stretch, in which the tile was needed and not mapped
+		uint32_t	m_lastNeeded;
+	};
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc > 2 && strcmp(argv[1], "--record") == 0)
+	{
+		return Record(argv[2], argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : 1800);
+	}
+
+	if (argc < 2)
+	{
+		printf("residency_replay trace [pool tiles] [loads in flight] [maps per frame] [load latency in frames] [prefetch frames ahead] [prefetch loads per frame] [eviction lru|clock|arc|cost] [tiles per read]\n");
+		printf("residency_replay --record trace [frames]\n");
+		return 1;
+	}
+
+	std::vector<uint8_t> data;
+
+	if (!ReadFile(argv[1], data))
+	{
+		printf("cannot read %s\n", argv[1]);
+		return 1;
+	}
+
+	ResidencyPolicySettings settings;
+
+	settings.m_poolSizeInTiles				= argc > 2 ? static_cast<uint32_t>(atoi(argv[2])) : settings.m_poolSizeInTiles;
+	settings.m_maxSimultaneousFileLoadTasks	= argc > 3 ? static_cast<uint32_t>(atoi(argv[3])) : settings.m_maxSimultaneousFileLoadTasks;
+	settings.m_maxTilesLoadedPerFrame		= argc > 4 ? static_cast<uint32_t>(atoi(argv[4])) : settings.m_maxTilesLoadedPerFrame;
+
+	settings.m_maxPrefetchLoadsPerFrame		= argc > 7 ? static_cast<uint32_t>(atoi(argv[7])) : settings.m_maxPrefetchLoadsPerFrame;
+
+	if (argc > 8 && !EvictionPolicyFromName(argv[8], settings.m_eviction.m_type))
+	{
+		printf("unknown eviction policy %s\n", argv[8]);
+		return 1;
+	}
+
+	const uint32_t latency = argc > 5 ? static_cast<uint32_t>(atoi(argv[5])) : 2;
+
+	TilePrefetchSettings prefetch;
+	prefetch.m_framesAhead = argc > 6 ? static_cast<uint32_t>(atoi(argv[6])) : 0;
+
+	TilePrefetcher prefetcher(prefetch);
+
+	//the diffuse and the normal texture
+	const std::vector<D3D12_SUBRESOURCE_TILING>	tilings[2]	= { MakeTilings(32, 64, 6), MakeTilings(64, 64, 7) };
+	const uint32_t								mips[2]		= { 6, 7 };
+
+	//the loads of a frame are merged into reads of the tiles, which follow each other in the files
+	CoalescedTileReaderSettings read;
+	read.m_maxReadSizeInTiles = argc > 9 ? static_cast<uint32_t>(atoi(argv[9])) : read.m_maxReadSizeInTiles;
+
+	std::vector<TileFileLayout> layouts(2);
+	layouts[0].Create(tilings[0].data(), static_cast<uint32_t>(tilings[0].size()), TilesInFile(32, 64));
+	layouts[1].Create(tilings[1].data(), static_cast<uint32_t>(tilings[1].size()), TilesInFile(64, 64));
+
+	SimulatedResidencyBackend	backend(settings.m_poolSizeInTiles, settings.m_reservedTiles, 65536, latency);
+	ResidencyPolicy				policy(&backend, settings);
+
+	backend.SetFileLayouts(layouts, read);
+
+	policy.AddResource(tilings[0].data(), mips[0]);
+	policy.AddResource(tilings[1].data(), mips[1]);
+
+	FeedbackTraceReader								reader(data.data(), data.size());
+	FeedbackTraceFrame								frame;
+	std::vector<TileKey>							keys;
+	std::vector<TileKey>							scratch;
+	std::unordered_map<TileKey, PendingTile>		pending;
+	std::vector<uint32_t>							popIns;			//frames, once per tile, which was not mapped when it was needed
+	std::vector<double>								times;
+	uint64_t										lookups		= 0;
+	uint64_t										hits		= 0;
+	uint64_t										deficit		= 0;
+	float											travel		= 0.0f;
+	CameraPose										previous;
+	uint32_t										frames		= 0;
+
+	while (reader.Next(frame))
+	{
+		const auto start = std::chrono::steady_clock::now();
+		policy.Update(frame.m_samples, prefetcher.Predict(frame.m_pose), frame.m_frame);
+		times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+		//the mip each sample gets from the residency map, against the mip it asked for
+		for (uint32_t r = 0; r < 2; ++r)
+		{
+			const ResidencyMap& map = policy.Residency(r);
+
+			for (auto&& s : frame.m_samples)
+			{
+				const uint32_t	x			= std::min<uint32_t>(map.Width() - 1, static_cast<uint32_t>(std::max(0.0f, s.u * map.Width())));
+				const uint32_t	y			= std::min<uint32_t>(map.Height() - 1, static_cast<uint32_t>(std::max(0.0f, s.v * map.Height())));
+				const uint8_t	value		= map.Face(s.face)[y * map.Width() + x];
+				const int32_t	resident	= value == 0xFF ? static_cast<int32_t>(mips[r]) : value / 16;
+				const int32_t	requested	= std::max(0, std::min(static_cast<int32_t>(mips[r]) - 1, static_cast<int32_t>(s.mip)));
+
+				lookups++;
+				hits	+= resident <= requested ? 1 : 0;
+				deficit	+= static_cast<uint64_t>(std::max(0, resident - requested));
+			}
+		}
+
+		//the tiles the frame needs, which are not mapped yet. a tile, which leaves the view, starts over when it is needed again
+		for (uint32_t r = 0; r < 2; ++r)
+		{
+			CollectSampledTiles(frame.m_samples, r, tilings[r].data(), mips[r], keys, scratch);
+
+			for (auto&& k : keys)
+			{
+				D3D12_TILED_RESOURCE_COORDINATE c = {};
+
+				c.Subresource	= TileKeySubresource(k);
+				c.X				= TileKeyX(k);
+				c.Y				= TileKeyY(k);
+
+				auto i = pending.find(k);
+
+				if (backend.IsMapped(r, c))
+				{
+					if (i != pending.end())
+					{
+						if (i->second.m_lastNeeded + 1 >= frame.m_frame)
+						{
+							popIns.push_back(frame.m_frame - i->second.m_needed);
+						}
+
+						pending.erase(i);
+					}
+				}
+				else if (i == pending.end())
+				{
+					pending[k] = { frame.m_frame, frame.m_frame };
+				}
+				else
+				{
+					if (i->second.m_lastNeeded + 1 < frame.m_frame)
+					{
+						i->second.m_needed = frame.m_frame;
+					}
+
+					i->second.m_lastNeeded = frame.m_frame;
+				}
+			}
+		}
+
+		if (frames > 0)
+		{
+			const float dx = frame.m_pose.m_position[0] - previous.m_position[0];
+			const float dy = frame.m_pose.m_position[1] - previous.m_position[1];
+			const float dz = frame.m_pose.m_position[2] - previous.m_position[2];
+
+			travel += sqrtf(dx * dx + dy * dy + dz * dz);
+		}
+
+		previous = frame.m_pose;
+		frames++;
+	}
+
+	if (reader.Failed())
+	{
+		printf("%s is damaged after frame %u\n", argv[1], frames);
+		return 1;
+	}
+
+	if (frames == 0)
+	{
+		printf("%s has no frames\n", argv[1]);
+		return 1;
+	}
+
+	std::sort(popIns.begin(), popIns.end());
+	std::sort(times.begin(), times.end());
+
+	double popInSum = 0.0;
+
+	for (auto p : popIns)
+	{
+		popInSum += p;
+	}
+
+	double timeSum = 0.0;
+
+	for (auto t : times)
+	{
+		timeSum += t;
+	}
+
+	const auto& p = policy.Statistics();
+	const auto& b = backend.Statistics();
+	const auto& e = policy.Eviction().Statistics();
+
+	printf("%u frames, %.1f KB trace, camera travel %.2f\n", frames, data.size() / 1024.0, travel);
+	printf("pool %u tiles, %u loads in flight, %u maps per frame, %u frames load latency\n", settings.m_poolSizeInTiles,
+		settings.m_maxSimultaneousFileLoadTasks, settings.m_maxTilesLoadedPerFrame, latency);
+	printf("hit rate %.2f%%, mip deficit %.3f per sample\n", lookups ? 100.0 * hits / lookups : 0.0, lookups ? static_cast<double>(deficit) / lookups : 0.0);
+
+	if (!popIns.empty())
+	{
+		printf("pop-in %zu tiles, mean %.1f p95 %u max %u frames, %zu never mapped\n", popIns.size(), popInSum / popIns.size(),
+			popIns[popIns.size() * 95 / 100], popIns.back(), pending.size());
+	}
+
+	if (prefetch.m_framesAhead > 0)
+	{
+		printf("prefetch %u frames ahead, %u loads per frame: %llu prefetches, %llu seen\n", prefetch.m_framesAhead, settings.m_maxPrefetchLoadsPerFrame,
+			static_cast<unsigned long long>(p.m_prefetches), static_cast<unsigned long long>(p.m_prefetchesSeen));
+	}
+
+	printf("%llu loads %llu maps %llu evictions %llu discards, %.1f KB read per frame\n", static_cast<unsigned long long>(p.m_loads),
+		static_cast<unsigned long long>(p.m_maps), static_cast<unsigned long long>(p.m_evictions), static_cast<unsigned long long>(p.m_discards),
+		b.m_bytesRead / 1024.0 / frames);
+	printf("%u tiles per read: %.2f reads per frame, %.2f loads per read\n", read.m_maxReadSizeInTiles, static_cast<double>(b.m_reads) / frames,
+		b.m_reads ? static_cast<double>(p.m_loads) / b.m_reads : 0.0);
+	printf("eviction %s: %llu hits %llu misses %llu thrashes, %.1f%% of the misses\n", EvictionPolicyName(settings.m_eviction.m_type),
+		static_cast<unsigned long long>(e.m_hits), static_cast<unsigned long long>(e.m_misses), static_cast<unsigned long long>(e.m_thrashes),
+		e.m_misses ? 100.0 * e.m_thrashes / e.m_misses : 0.0);
+	printf("cpu %.3f ms per frame, p95 %.3f max %.3f ms\n", timeSum / frames, times[times.size() * 95 / 100], times.back());
+
+	if (b.m_errors != 0)
+	{
+		printf("%llu invalid backend calls\n", static_cast<unsigned long long>(b.m_errors));
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,203 @@
+#include "tile_prefetcher.h"
+#include "check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+//the projected feedback of random cameras, which look at a point of the planet: the center of the view is the point, the
+//mip grows with the distance. cameras, which move and turn at a constant rate, must predict the feedback of the pose ahead,
+//cameras, which stand still, predict nothing
+using namespace sample;
+using namespace residency_benchmark;
+
+namespace
+{
+	//a point of the unit sphere and a camera above it, which looks at it
+	void RandomView(std::mt19937& g, float distance, float at[3], float eye[3], float up[3])
+	{
+		std::uniform_real_distribution<float> u(-1.0f, 1.0f);
+
+		float n[3]		= { u(g), u(g), u(g) };
+		float side[3]	= { u(g), u(g), u(g) };
+		float length	= sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+		for (uint32_t i = 0; i < 3; ++i)
+		{
+			at[i]	= n[i] / length;
+			eye[i]	= at[i] * (1.0f + distance) + side[i] * distance * 0.5f;
+			up[i]	= at[i];
+		}
+	}
+
+	uint32_t Equal(const std::vector<DecodedSample>& a, const std::vector<DecodedSample>& b)
+	{
+		uint32_t r = 0;
+
+		for (size_t i = 0; i < std::min(a.size(), b.size()); ++i)
+		{
+			r += a[i].face == b[i].face && a[i].mip == b[i].mip && fabsf(a[i].u - b[i].u) < 0.02f && fabsf(a[i].v - b[i].v) < 0.02f ? 1 : 0;
+		}
+
+		return r;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t cases = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 300;
+
+	std::mt19937					g(31);
+	CheckGroups						groups;
+	FeedbackProjection				projection;
+
+	{
+		auto& s = groups.Add("projection");
+
+		for (uint32_t i = 0; i < cases; ++i)
+		{
+			float at[3];
+			float eye[3];
+			float up[3];
+
+			RandomView(g, 0.02f + 0.002f * (g() % 100), at, eye, up);
+
+			//the quantized center moves to the next face at the edges
+			const float a[3] = { fabsf(at[0]), fabsf(at[1]), fabsf(at[2]) };
+			const float m = std::max(a[0], std::max(a[1], a[2]));
+
+			if (a[0] + a[1] + a[2] - m - std::min(a[0], std::min(a[1], a[2])) > m * 0.9f)
+			{
+				continue;
+			}
+
+			s.m_cases++;
+
+			std::vector<DecodedSample>	center;
+			std::vector<DecodedSample>	closer;
+			const DecodedSample			expected = SampleDirection(at[0], at[1], at[2], 0);
+
+			ProjectFeedback(LookAt(eye, at, up), projection, 1, 1, center);
+
+			if (center.size() != 1 || center[0].face != expected.face || fabsf(center[0].u - expected.u) > 0.02f || fabsf(center[0].v - expected.v) > 0.02f)
+			{
+				Fail(s, "center of the view");
+				continue;
+			}
+
+			//half the distance, one mip less, up to the quantization of the level of detail
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				eye[k] = (eye[k] + at[k]) / 2.0f;
+			}
+
+			ProjectFeedback(LookAt(eye, at, up), projection, 1, 1, closer);
+
+			if (closer.size() != 1 || (center[0].mip > 0 && std::abs(center[0].mip - 1 - closer[0].mip) > 1))
+			{
+				Fail(s, "mip of the distance");
+			}
+		}
+	}
+
+	{
+		auto& s = groups.Add("prediction");
+
+		for (uint32_t i = 0; i < cases; ++i)
+		{
+			float at[3];
+			float eye[3];
+			float up[3];
+
+			RandomView(g, 0.05f + 0.002f * (g() % 100), at, eye, up);
+			s.m_cases++;
+
+			//a camera, which moves along a line, or turns around its up axis, at a constant rate
+			const bool						turns	= i % 2 == 1;
+			const float						rate	= 0.002f * (1 + g() % 5);
+			std::vector<CameraPose>			poses;
+			std::vector<float>				offset(3);
+
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				offset[k] = std::uniform_real_distribution<float>(-1.0f, 1.0f)(g) * 0.001f;
+			}
+
+			for (uint32_t f = 0; f < 20; ++f)
+			{
+				float e[3];
+				float a[3];
+
+				for (uint32_t k = 0; k < 3; ++k)
+				{
+					e[k] = turns ? eye[k] : eye[k] + offset[k] * f;
+					a[k] = turns ? at[k] : at[k] + offset[k] * f;
+				}
+
+				if (turns)
+				{
+					//the point the camera looks at circles around the up axis through the eye
+					float d[3]		= { at[0] - eye[0], at[1] - eye[1], at[2] - eye[2] };
+					float side[3]	= { up[1] * d[2] - up[2] * d[1], up[2] * d[0] - up[0] * d[2], up[0] * d[1] - up[1] * d[0] };
+					float along		= d[0] * up[0] + d[1] * up[1] + d[2] * up[2];
+					float c			= cosf(rate * f);
+					float sn		= sinf(rate * f);
+
+					for (uint32_t k = 0; k < 3; ++k)
+					{
+						const float flat = d[k] - along * up[k];
+						a[k] = eye[k] + along * up[k] + flat * c + side[k] * sn;
+					}
+				}
+
+				poses.push_back(LookAt(e, a, up));
+			}
+
+			TilePrefetchSettings settings;
+			settings.m_framesAhead = 1 + g() % 8;
+
+			TilePrefetcher				prefetcher(settings, projection);
+			std::vector<DecodedSample>	predicted;
+			std::vector<DecodedSample>	expected;
+
+			for (uint32_t f = 0; f + settings.m_framesAhead < 20; ++f)
+			{
+				predicted = prefetcher.Predict(poses[f]);
+			}
+
+			ProjectFeedback(poses[19], projection, settings.m_gridWidth, settings.m_gridHeight, expected);
+
+			if (predicted.size() != expected.size() || Equal(predicted, expected) < expected.size() * 95 / 100)
+			{
+				Fail(s, "feedback of the pose ahead");
+			}
+		}
+	}
+
+	{
+		auto& s = groups.Add("still camera");
+
+		for (uint32_t i = 0; i < cases; ++i)
+		{
+			float at[3];
+			float eye[3];
+			float up[3];
+
+			RandomView(g, 0.1f, at, eye, up);
+			s.m_cases++;
+
+			TilePrefetcher		prefetcher;
+			const CameraPose	pose = LookAt(eye, at, up);
+
+			if (!prefetcher.Predict(pose).empty() || !prefetcher.Predict(pose).empty())
+			{
+				Fail(s, "no prediction");
+			}
+		}
+	}
+
+	return groups.Report();
+}
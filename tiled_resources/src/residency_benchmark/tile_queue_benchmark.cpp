@@ -0,0 +1,147 @@
+#include "tile_queue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+//cost of the priority order of a frame: the tracked tiles seen again move in the tile queue, against the stable sort of the
+//whole list with the eviction predicate every frame, which UpdateTiles did before
+using namespace sample;
+
+namespace
+{
+	//best of three runs, in nanoseconds per item
+	template <typename F>
+	double Measure(uint32_t items, F f)
+	{
+		double best = INFINITY;
+
+		for (uint32_t run = 0; run < 3; ++run)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			f();
+			const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			best = std::min(best, ns / items);
+		}
+
+		return best;
+	}
+
+	void Print(const char* name, double ns)
+	{
+		printf("%-36s %10.1f ns %12.0f per second\n", name, ns, 1e9 / ns);
+	}
+
+	struct Tile
+	{
+		TileKey				m_key		= 0;
+		Tile*				m_prev		= nullptr;
+		Tile*				m_next		= nullptr;
+		TileBucket<Tile>*	m_bucket	= nullptr;
+		uint16_t			m_mipLevel	= 0;
+		uint32_t			m_lastSeen	= 0;
+	};
+
+	bool EvictPredicate(const Tile* a, const Tile* b)
+	{
+		if (a->m_lastSeen != b->m_lastSeen) return a->m_lastSeen < b->m_lastSeen;
+		return a->m_mipLevel < b->m_mipLevel;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t tracked	= argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 20000;
+	const uint32_t seen		= tracked / 10;
+	const uint32_t frames	= 20;
+
+	std::mt19937 g(17);
+
+	//the tiles of two textures with 6 and 7 mips, a tenth of them is seen again every frame, a window moving over the tiles
+	TileTable<Tile>		table;
+	std::vector<Tile*>	tiles;
+
+	for (uint32_t i = 0; i < tracked; ++i)
+	{
+		Tile* t = table.insert(MakeTileKey(i % 2, 0, i, 0));
+		t->m_mipLevel = static_cast<uint16_t>(g() % (6 + i % 2));
+		t->m_lastSeen = 1 + g() % 100;
+		tiles.push_back(t);
+	}
+
+	TileQueue<Tile>		queue;
+	TileList<Tile>		list;
+	std::vector<Tile*>	scratch;
+	uint32_t			frame	= 100;
+	Tile*				oldest	= nullptr;
+
+	for (auto&& t : tiles)
+	{
+		queue.push(t);
+	}
+
+	const double queue_ns = Measure(frames, [&]
+	{
+		for (uint32_t f = 0; f < frames; ++f)
+		{
+			++frame;
+
+			for (uint32_t i = 0; i < seen; ++i)
+			{
+				queue.touch(tiles[(frame * 97 + i) % tracked], frame);
+			}
+
+			oldest = queue.oldest();
+		}
+	});
+
+	//the same frames with the list, which is sorted once per frame like before
+	while (!queue.empty())
+	{
+		list.push_back(queue.pop_oldest());
+	}
+
+	const double sort_ns = Measure(frames, [&]
+	{
+		for (uint32_t f = 0; f < frames; ++f)
+		{
+			++frame;
+
+			for (uint32_t i = 0; i < seen; ++i)
+			{
+				tiles[(frame * 97 + i) % tracked]->m_lastSeen = frame;
+			}
+
+			scratch.clear();
+
+			for (Tile* t = list.front(); t != nullptr; t = t->m_next)
+			{
+				scratch.push_back(t);
+			}
+
+			std::stable_sort(scratch.begin(), scratch.end(), EvictPredicate);
+
+			while (!list.empty())
+			{
+				list.pop_front();
+			}
+
+			for (auto&& t : scratch)
+			{
+				list.push_back(t);
+			}
+
+			oldest = list.front();
+		}
+	});
+
+	printf("%u tracked tiles, %u seen per frame\n", tracked, seen);
+	Print("tile queue, frame", queue_ns);
+	Print("sorted list, frame", sort_ns);
+
+	return oldest != nullptr ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+#include "tile_queue.h"
+#include "check.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+//random pushes, touches, removes and pops of the tile queue against a vector of the queued tiles. the oldest and the newest
+//tile must have the (last seen, mip) of the first tile of the eviction and the load predicates the lists were sorted with
+using namespace sample;
+using namespace residency_benchmark;
+
+namespace
+{
+	struct Tile
+	{
+		TileKey				m_key		= 0;
+		Tile*				m_prev		= nullptr;
+		Tile*				m_next		= nullptr;
+		TileBucket<Tile>*	m_bucket	= nullptr;
+		uint16_t			m_mipLevel	= 0;
+		uint32_t			m_lastSeen	= 0;
+		bool				m_queued	= false;
+	};
+
+	//the predicates of the lists
+	bool EvictPredicate(const Tile* a, const Tile* b)
+	{
+		if (a->m_lastSeen != b->m_lastSeen) return a->m_lastSeen < b->m_lastSeen;
+		return a->m_mipLevel < b->m_mipLevel;
+	}
+
+	bool LoadPredicate(const Tile* a, const Tile* b)
+	{
+		if (a->m_lastSeen != b->m_lastSeen) return a->m_lastSeen > b->m_lastSeen;
+		return a->m_mipLevel > b->m_mipLevel;
+	}
+
+	bool SameKey(const Tile* a, const Tile* b)
+	{
+		return a->m_lastSeen == b->m_lastSeen && a->m_mipLevel == b->m_mipLevel;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t cases = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 200;
+
+	std::mt19937					g(13);
+	CheckGroups						groups;
+
+	//few mips and frames for many ties, tiles pushed with older frames like loaded tiles, which move to the mapped queue
+	{
+		auto& s = groups.Add("queue");
+
+		for (uint32_t i = 0; i < cases; ++i)
+		{
+			TileTable<Tile>		table;
+			TileQueue<Tile>		queue;
+			std::vector<Tile*>	tiles;
+			std::vector<Tile*>	reference;
+			const uint32_t		mips	= 1 + i % 8;
+			uint32_t			frame	= 1;
+			bool				failed	= false;
+
+			s.m_cases++;
+
+			for (uint32_t j = 0; j < 400; ++j)
+			{
+				Tile* t = table.insert(MakeTileKey(0, 0, j, i));
+				t->m_mipLevel = static_cast<uint16_t>(g() % mips);
+				tiles.push_back(t);
+			}
+
+			for (uint32_t j = 0; j < 5000 && !failed; ++j)
+			{
+				Tile*			t	= tiles[g() % tiles.size()];
+				const uint32_t	op	= g() % 16;
+
+				if (op == 0)
+				{
+					frame += 1 + g() % 2;
+				}
+				else if (op < 3 && !reference.empty())
+				{
+					//pop the first tile of a sorted list
+					const bool	oldest	= op == 1;
+					Tile*		f		= oldest ? queue.oldest() : queue.newest();
+					Tile*		r		= *std::min_element(reference.begin(), reference.end(), oldest ? EvictPredicate : LoadPredicate);
+
+					if (f == nullptr || !f->m_queued || !SameKey(f, r))
+					{
+						Fail(s, oldest ? "oldest" : "newest");
+						failed = true;
+						break;
+					}
+
+					if (oldest ? queue.pop_oldest() != f : queue.pop_newest() != f)
+					{
+						Fail(s, "pop the same tile");
+						failed = true;
+						break;
+					}
+
+					reference.erase(std::find(reference.begin(), reference.end(), f));
+					f->m_queued = false;
+				}
+				else if (t->m_queued && op < 10)
+				{
+					queue.touch(t, frame);
+				}
+				else if (t->m_queued)
+				{
+					queue.remove(t);
+					reference.erase(std::find(reference.begin(), reference.end(), t));
+					t->m_queued = false;
+				}
+				else
+				{
+					t->m_lastSeen = frame - std::min<uint32_t>(frame - 1, g() % 4 == 0 ? g() % 8 : 0);
+					queue.push(t);
+					reference.push_back(t);
+					t->m_queued = true;
+				}
+
+				if (queue.size() != reference.size() || queue.empty() != reference.empty())
+				{
+					Fail(s, "size");
+					failed = true;
+				}
+			}
+
+			//drained, the tiles come out in the order of the eviction predicate
+			Tile* prev = nullptr;
+
+			while (!failed && !queue.empty())
+			{
+				Tile* t = queue.pop_oldest();
+
+				if (prev != nullptr && EvictPredicate(t, prev))
+				{
+					Fail(s, "drained in order");
+					failed = true;
+				}
+
+				prev = t;
+			}
+
+			if (!failed && (queue.oldest() != nullptr || queue.newest() != nullptr))
+			{
+				Fail(s, "empty");
+			}
+		}
+	}
+
+	return groups.Report();
+}
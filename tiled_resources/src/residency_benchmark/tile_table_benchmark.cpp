@@ -0,0 +1,145 @@
+#include "tile_table.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+//cost of the tile lookups of a frame of feedback: the tile table against the std::map with the five field key it replaced
+using namespace sample;
+
+namespace
+{
+	//best of three runs, in nanoseconds per item
+	template <typename F>
+	double Measure(uint32_t items, F f)
+	{
+		double best = INFINITY;
+
+		for (uint32_t run = 0; run < 3; ++run)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			f();
+			const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+			best = std::min(best, ns / items);
+		}
+
+		return best;
+	}
+
+	void Print(const char* name, double ns)
+	{
+		printf("%-36s %10.1f ns %12.0f per second\n", name, ns, 1e9 / ns);
+	}
+
+	struct Tile
+	{
+		TileKey		m_key		= 0;
+		Tile*		m_prev		= nullptr;
+		Tile*		m_next		= nullptr;
+		uint32_t	m_lastSeen	= 0;
+	};
+
+	//the key of the std::map: a resource pointer and a tiled resource coordinate
+	struct MapKey
+	{
+		uint32_t	m_x;
+		uint32_t	m_y;
+		uint32_t	m_z;
+		uint32_t	m_subresource;
+		const void*	m_resource;
+	};
+
+	bool operator <(const MapKey& a, const MapKey& b)
+	{
+		if (a.m_resource < b.m_resource) return true;
+		if (a.m_resource > b.m_resource) return false;
+		if (a.m_subresource < b.m_subresource) return true;
+		if (a.m_subresource > b.m_subresource) return false;
+		if (a.m_z < b.m_z) return true;
+		if (a.m_z > b.m_z) return false;
+		if (a.m_y < b.m_y) return true;
+		if (a.m_y > b.m_y) return false;
+		return a.m_x < b.m_x;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t lookups = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 500000;
+
+	std::mt19937							g(3);
+	std::uniform_real_distribution<float>	u(0.0f, 1.0f);
+
+	//samples of a camera over a 64 x 64 tile face: neighbouring samples hit neighbouring tiles, six mips per sample
+	std::vector<TileKey>	keys;
+	std::vector<MapKey>		map_keys;
+	const int				resources[2] = {};
+
+	for (uint32_t i = 0; keys.size() < lookups; ++i)
+	{
+		const float		su		= std::min(0.999f, 0.3f + 0.4f * u(g));
+		const float		sv		= std::min(0.999f, 0.3f + 0.4f * u(g));
+		const uint32_t	face	= i / 4096 % 6;
+		const uint32_t	r		= i % 2;
+
+		for (uint32_t mip = 0; mip < 6; ++mip)
+		{
+			const uint32_t size	= 64 >> mip;
+			const uint32_t x	= static_cast<uint32_t>(su * size);
+			const uint32_t y	= static_cast<uint32_t>(sv * size);
+
+			keys.push_back(MakeTileKey(r, face * 6 + mip, x, y));
+			map_keys.push_back({ x, y, 0, face * 6 + mip, &resources[r] });
+		}
+	}
+
+	TileTable<Tile>									table;
+	std::map<MapKey, std::unique_ptr<Tile>>			map;
+	uint32_t										frame = 0;
+
+	const double table_ns = Measure(lookups, [&]
+	{
+		++frame;
+
+		for (auto&& k : keys)
+		{
+			Tile* t = table.find(k);
+
+			if (t == nullptr)
+			{
+				t = table.insert(k);
+			}
+
+			t->m_lastSeen = frame;
+		}
+	});
+
+	const double map_ns = Measure(lookups, [&]
+	{
+		++frame;
+
+		for (auto&& k : map_keys)
+		{
+			auto i = map.find(k);
+
+			if (i == map.end())
+			{
+				i = map.emplace(k, std::make_unique<Tile>()).first;
+			}
+
+			i->second->m_lastSeen = frame;
+		}
+	});
+
+	printf("%zu lookups of %zu tiles\n", keys.size(), table.size());
+	Print("tile table, lookup", table_ns);
+	Print("std::map, lookup", map_ns);
+
+	return table.size() == map.size() ? 0 : 1;
+}
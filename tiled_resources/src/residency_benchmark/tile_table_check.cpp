@@ -0,0 +1,212 @@
+#include "tile_table.h"
+#include "check.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <list>
+#include <map>
+#include <random>
+#include <vector>
+
+//random operations on the tile table and the tile lists against std::map and std::list. the keys must round trip, the tiles
+//must keep their addresses while the table grows, and erased tiles must come back reset
+using namespace sample;
+using namespace residency_benchmark;
+
+namespace
+{
+	struct Tile
+	{
+		TileKey		m_key		= 0;
+		Tile*		m_prev		= nullptr;
+		Tile*		m_next		= nullptr;
+		uint32_t	m_value		= 0;
+		uint32_t	m_list		= 0;		//1 + the list of the tile, 0 for none
+	};
+
+	TileKey RandomKey(std::mt19937& g, uint32_t range)
+	{
+		std::uniform_int_distribution<uint32_t> u(0, range - 1);
+		return MakeTileKey(u(g) % 2, u(g) % 36, u(g), u(g));
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const uint32_t cases = argc > 1 ? static_cast<uint32_t>(atoi(argv[1])) : 200;
+
+	std::mt19937					g(5);
+	CheckGroups						groups;
+
+	//every field at its limits
+	{
+		auto& s = groups.Add("keys");
+
+		for (uint32_t i = 0; i < cases * 100; ++i)
+		{
+			std::uniform_int_distribution<uint32_t> u;
+
+			const uint32_t r	= u(g) & 0xFF;
+			const uint32_t sr	= u(g) & 0xFFFF;
+			const uint32_t x	= u(g) & 0xFFFFF;
+			const uint32_t y	= u(g) & 0xFFFFF;
+			const TileKey k		= MakeTileKey(r, sr, x, y);
+
+			s.m_cases++;
+
+			if (TileKeyResource(k) != r || TileKeySubresource(k) != sr || TileKeyX(k) != x || TileKeyY(k) != y)
+			{
+				Fail(s, "key round trip");
+			}
+		}
+	}
+
+	//inserts, finds and erases against a map, small key ranges for many hits and long probe sequences
+	{
+		auto& s = groups.Add("table");
+
+		for (uint32_t i = 0; i < cases; ++i)
+		{
+			TileTable<Tile>				table(1 + i % 64);
+			std::map<TileKey, Tile*>	reference;
+			std::map<TileKey, uint32_t>	values;
+			const uint32_t				range = 4 + i * 4;
+
+			s.m_cases++;
+
+			for (uint32_t j = 0; j < 4000; ++j)
+			{
+				const TileKey	k = RandomKey(g, range);
+				Tile*			t = table.find(k);
+				auto			r = reference.find(k);
+
+				if ((t == nullptr) != (r == reference.end()) || (t != nullptr && (t != r->second || t->m_key != k || t->m_value != values[k])))
+				{
+					Fail(s, "find");
+					break;
+				}
+
+				if (t == nullptr)
+				{
+					t = table.insert(k);
+
+					if (t->m_value != 0 || t->m_prev != nullptr || t->m_next != nullptr || t->m_key != k)
+					{
+						Fail(s, "inserted tiles are reset");
+						break;
+					}
+
+					t->m_value		= j + 1;
+					reference[k]	= t;
+					values[k]		= j + 1;
+				}
+				else if (g() % 3 == 0)
+				{
+					table.erase(t);
+					reference.erase(k);
+					values.erase(k);
+				}
+
+				if (table.size() != reference.size())
+				{
+					Fail(s, "size");
+					break;
+				}
+			}
+
+			//the tiles did not move while the table grew
+			for (auto&& r : reference)
+			{
+				if (table.find(r.first) != r.second || r.second->m_value != values[r.first])
+				{
+					Fail(s, "stable tiles");
+					break;
+				}
+			}
+		}
+	}
+
+	//three lists with moves between them, like the seen, the loading and the mapped tiles
+	{
+		auto& s = groups.Add("lists");
+
+		for (uint32_t i = 0; i < cases; ++i)
+		{
+			TileTable<Tile>		table;
+			TileList<Tile>		lists[3];
+			std::list<Tile*>	reference[3];
+			std::vector<Tile*>	tiles;
+
+			s.m_cases++;
+
+			for (uint32_t j = 0; j < 500; ++j)
+			{
+				Tile* t = table.insert(MakeTileKey(0, 0, j, i));
+				tiles.push_back(t);
+			}
+
+			for (uint32_t j = 0; j < 5000; ++j)
+			{
+				Tile*			t		= tiles[g() % tiles.size()];
+				const uint32_t	to		= g() % 4;
+				const uint32_t	op		= g() % 7;
+
+				if (op == 0)
+				{
+					const uint32_t l = g() % 3;
+
+					if (!lists[l].empty())
+					{
+						Tile* f = lists[l].pop_front();
+
+						if (f != reference[l].front())
+						{
+							Fail(s, "pop front");
+							break;
+						}
+
+						reference[l].pop_front();
+						f->m_list = 0;
+					}
+
+					continue;
+				}
+
+				if (t->m_list != 0)
+				{
+					lists[t->m_list - 1].remove(t);
+					reference[t->m_list - 1].remove(t);
+					t->m_list = 0;
+				}
+
+				if (to < 3)
+				{
+					lists[to].push_back(t);
+					reference[to].push_back(t);
+					t->m_list = to + 1;
+				}
+			}
+
+			for (uint32_t l = 0; l < 3; ++l)
+			{
+				auto	r		= reference[l].begin();
+				Tile*	prev	= nullptr;
+				bool	same	= lists[l].size() == reference[l].size() && lists[l].back() == (reference[l].empty() ? nullptr : reference[l].back());
+
+				for (Tile* t = lists[l].front(); t != nullptr && same; t = t->m_next, ++r)
+				{
+					same = r != reference[l].end() && *r == t && t->m_prev == prev;
+					prev = t;
+				}
+
+				if (!same)
+				{
+					Fail(s, "same order as std::list");
+					break;
+				}
+			}
+		}
+	}
+
+	return groups.Report();
+}
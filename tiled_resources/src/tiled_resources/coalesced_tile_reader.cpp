@@ -0,0 +1,208 @@
+#include "pch.h"
+#include "coalesced_tile_reader.h"
+
+#include <algorithm>
+
+namespace sample
+{
+	void PlanCoalescedReads(std::vector<TileReadRequest>& requests, const CoalescedTileReaderSettings& settings, std::vector<CoalescedRead>& reads)
+	{
+		reads.clear();
+
+		std::sort(requests.begin(), requests.end(), [](const TileReadRequest& a, const TileReadRequest& b)
+		{
+			return a.m_tile != b.m_tile ? a.m_tile < b.m_tile : a.m_request < b.m_request;
+		});
+
+		const uint64_t maxTiles	= std::max(1U, settings.m_maxReadSizeInTiles);
+		const uint64_t maxGap	= settings.m_maxGapInTiles;
+
+		for (uint32_t i = 0; i < requests.size(); ++i)
+		{
+			const uint64_t tile = requests[i].m_tile;
+
+			if (!reads.empty())
+			{
+				CoalescedRead&	r	= reads.back();
+				const uint64_t	end	= r.m_firstTile + r.m_tiles;
+
+				// The same tile again, or the next one within the gap, while the read stays within its size.
+				if (tile < end || (tile - end <= maxGap && tile + 1 - r.m_firstTile <= maxTiles))
+				{
+					r.m_tiles = static_cast<uint32_t>(std::max(end, tile + 1) - r.m_firstTile);
+					r.m_requests++;
+					continue;
+				}
+			}
+
+			reads.push_back({ tile, 1, i, 1 });
+		}
+	}
+
+	CoalescedTileReader::CoalescedTileReader(const CoalescedTileReaderSettings& settings) :
+		m_settings(settings)
+	{
+		for (uint32_t i = 0; i < std::max(1U, m_settings.m_queueDepth); ++i)
+		{
+			m_threads.emplace_back([this] { Run(); });
+		}
+	}
+
+	CoalescedTileReader::~CoalescedTileReader()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+
+			m_stop = true;
+			m_reads.clear();
+		}
+
+		m_readsQueued.notify_all();
+
+		for (auto&& t : m_threads)
+		{
+			t.join();
+		}
+	}
+
+	void CoalescedTileReader::Request(uint64_t tile, Done done)
+	{
+		m_batchTiles.push_back({ tile, static_cast<uint32_t>(m_batch.size()) });
+		m_batch.push_back(std::move(done));
+	}
+
+	void CoalescedTileReader::Flush()
+	{
+		if (m_batch.empty())
+		{
+			return;
+		}
+
+		PlanCoalescedReads(m_batchTiles, m_settings, m_plan);
+
+		{
+			std::lock_guard<std::mutex> lock(m_lock);
+
+			for (auto&& p : m_plan)
+			{
+				Read r;
+
+				r.m_firstTile	= p.m_firstTile;
+				r.m_tiles		= p.m_tiles;
+				r.m_requests.reserve(p.m_requests);
+
+				for (uint32_t i = p.m_firstRequest; i < p.m_firstRequest + p.m_requests; ++i)
+				{
+					r.m_requests.emplace_back(m_batchTiles[i].m_tile, std::move(m_batch[m_batchTiles[i].m_request]));
+				}
+
+				m_reads.push_back(std::move(r));
+
+				m_statistics.m_reads++;
+				m_statistics.m_bytesRead += static_cast<uint64_t>(p.m_tiles) * m_settings.m_tileSizeInBytes;
+			}
+
+			m_statistics.m_requests += m_batch.size();
+		}
+
+		m_batch.clear();
+		m_batchTiles.clear();
+		m_readsQueued.notify_all();
+	}
+
+	void CoalescedTileReader::Wait()
+	{
+		std::unique_lock<std::mutex> lock(m_lock);
+		m_readsDone.wait(lock, [this] { return m_reads.empty() && m_readsInFlight == 0; });
+	}
+
+	CoalescedReadStatistics CoalescedTileReader::Statistics() const
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		return m_statistics;
+	}
+
+	void CoalescedTileReader::Run()
+	{
+		std::vector<uint8_t> gap(m_settings.m_tileSizeInBytes);
+
+		for (;;)
+		{
+			Read read;
+
+			{
+				std::unique_lock<std::mutex> lock(m_lock);
+				m_readsQueued.wait(lock, [this] { return m_stop || !m_reads.empty(); });
+
+				if (m_stop)
+				{
+					return;
+				}
+
+				read = std::move(m_reads.front());
+				m_reads.pop_front();
+				m_readsInFlight++;
+				m_statistics.m_maxReadsInFlight = std::max(m_statistics.m_maxReadsInFlight, m_readsInFlight);
+			}
+
+			Execute(read, gap);
+
+			{
+				std::lock_guard<std::mutex> lock(m_lock);
+				m_readsInFlight--;
+			}
+
+			m_readsDone.notify_all();
+		}
+	}
+
+	// One buffer per tile of the read, the tiles of the gaps go to the same scratch buffer. The requests of a tile, which is
+	// asked for more than once, get copies.
+	void CoalescedTileReader::Execute(Read& read, std::vector<uint8_t>& gap)
+	{
+		const size_t						size = m_settings.m_tileSizeInBytes;
+		std::vector<std::vector<uint8_t>>	tiles;
+		std::vector<uint8_t*>				buffers(read.m_tiles, gap.data());
+
+		tiles.reserve(read.m_requests.size());
+
+		for (auto&& r : read.m_requests)
+		{
+			const uint32_t index = static_cast<uint32_t>(r.first - read.m_firstTile);
+
+			if (buffers[index] == gap.data())
+			{
+				tiles.emplace_back(size);
+				buffers[index] = tiles.back().data();
+			}
+		}
+
+		if (!m_file.ReadScatter(read.m_firstTile * size, buffers.data(), read.m_tiles, size))
+		{
+			for (auto&& t : tiles)
+			{
+				std::fill(t.begin(), t.end(), static_cast<uint8_t>(0));
+			}
+
+			std::lock_guard<std::mutex> lock(m_lock);
+			m_statistics.m_failedReads++;
+		}
+
+		// The requests are by tile, the last request of a tile takes its buffer.
+		size_t tile = 0;
+
+		for (size_t i = 0; i < read.m_requests.size(); ++i)
+		{
+			const bool last = i + 1 == read.m_requests.size() || read.m_requests[i + 1].first != read.m_requests[i].first;
+
+			if (last)
+			{
+				read.m_requests[i].second(std::move(tiles[tile++]));
+			}
+			else
+			{
+				read.m_requests[i].second(tiles[tile]);
+			}
+		}
+	}
+}
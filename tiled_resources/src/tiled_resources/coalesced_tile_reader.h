@@ -0,0 +1,113 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "tile_file.h"
+
+namespace sample
+{
+	struct CoalescedTileReaderSettings
+	{
+		uint32_t	m_tileSizeInBytes		= 65536;
+		uint32_t	m_queueDepth			= 4;		//reads in flight, one thread each
+		uint32_t	m_maxReadSizeInTiles	= 16;
+		uint32_t	m_maxGapInTiles			= 0;		//tiles, which nobody asked for, read to merge the reads around them
+	};
+
+	// A tile of the file, which a request of the batch needs.
+	struct TileReadRequest
+	{
+		uint64_t	m_tile;						//index in the file
+		uint32_t	m_request;					//index of the request in the batch
+	};
+
+	// A read of the tiles [m_firstTile, m_firstTile + m_tiles), for the sorted requests [m_firstRequest, m_firstRequest + m_requests).
+	struct CoalescedRead
+	{
+		uint64_t	m_firstTile;
+		uint32_t	m_tiles;
+		uint32_t	m_firstRequest;
+		uint32_t	m_requests;
+	};
+
+	// Sorts the requests by tile and merges the tiles, which follow each other in the file, or have at most the gap of the
+	// settings between them, into reads of at most the read size. Requests of the same tile share the read.
+	void PlanCoalescedReads(std::vector<TileReadRequest>& requests, const CoalescedTileReaderSettings& settings, std::vector<CoalescedRead>& reads);
+
+	// Counters since the reader was created.
+	struct CoalescedReadStatistics
+	{
+		uint64_t	m_requests			= 0;
+		uint64_t	m_reads				= 0;
+		uint64_t	m_bytesRead			= 0;	//with the gaps
+		uint64_t	m_failedReads		= 0;	//their tiles are delivered with zeros
+		uint32_t	m_maxReadsInFlight	= 0;
+	};
+
+	// Reads the tiles of a file. The requests of a frame are batched, Flush merges them into few large reads, which the threads
+	// of the queue depth issue. The reads scatter into the buffers of the tiles, the callback of a request gets its tile on the
+	// thread, which read it.
+	class CoalescedTileReader
+	{
+		public:
+
+		using Done = std::function<void(std::vector<uint8_t>)>;
+
+		explicit CoalescedTileReader(const CoalescedTileReaderSettings& settings = CoalescedTileReaderSettings());
+
+		// The reads, which were flushed and did not start, are dropped, the ones in flight complete.
+		~CoalescedTileReader();
+
+		CoalescedTileReader(const CoalescedTileReader&) = delete;
+		CoalescedTileReader& operator=(const CoalescedTileReader&) = delete;
+
+		bool Open(const std::filesystem::path& path)	{ return m_file.Open(path, static_cast<size_t>(m_settings.m_maxReadSizeInTiles) * m_settings.m_tileSizeInBytes); }
+		const TileFile& File() const					{ return m_file; }
+
+		// The tile is read after the next Flush.
+		void Request(uint64_t tile, Done done);
+
+		// Plans the reads of the batched requests and queues them.
+		void Flush();
+
+		// Until every queued read completed.
+		void Wait();
+
+		CoalescedReadStatistics Statistics() const;
+
+		private:
+
+		struct Read
+		{
+			uint64_t										m_firstTile;
+			uint32_t										m_tiles;
+			std::vector<std::pair<uint64_t, Done>>			m_requests;		//by tile
+		};
+
+		CoalescedTileReaderSettings		m_settings;
+		TileFile						m_file;
+
+		std::vector<Done>				m_batch;
+		std::vector<TileReadRequest>	m_batchTiles;
+		std::vector<CoalescedRead>		m_plan;
+
+		mutable std::mutex				m_lock;
+		std::condition_variable			m_readsQueued;
+		std::condition_variable			m_readsDone;
+		std::deque<Read>				m_reads;
+		uint32_t						m_readsInFlight = 0;
+		bool							m_stop = false;
+		CoalescedReadStatistics			m_statistics;
+		std::vector<std::thread>		m_threads;
+
+		void Run();
+		void Execute(Read& read, std::vector<uint8_t>& gap);
+	};
+}
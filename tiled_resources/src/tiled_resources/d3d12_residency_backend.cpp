@@ -0,0 +1,231 @@
+#include "pch.h"
+#include "d3d12_residency_backend.h"
+#include "residency_manager.h"
+#include "error.h"
+#include "sample_settings.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace sample
+{
+	D3D12ResidencyBackend::D3D12ResidencyBackend(ManagedTiledResource* const* resources, uint32_t resourceCount, ID3D12Heap* physicalHeap, ID3D12Resource1* const* tileUploadHeaps) :
+		m_resources(resources, resources + resourceCount)
+		, m_physicalHeap(physicalHeap)
+		, m_mappings(resourceCount)
+	{
+		m_tileUploadHeaps[0] = tileUploadHeaps[0];
+		m_tileUploadHeaps[1] = tileUploadHeaps[1];
+	}
+
+	void D3D12ResidencyBackend::SetFrame(ID3D12CommandQueue* queue, ID3D12GraphicsCommandList* list, uint32_t frame_index)
+	{
+		m_queue			= queue;
+		m_list			= list;
+		m_frameIndex	= frame_index;
+	}
+
+	void D3D12ResidencyBackend::LoadTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, std::function<void(std::vector<uint8_t>)> done)
+	{
+		m_resources[resource]->m_loader->LoadTile(c, std::move(done));
+	}
+
+	void D3D12ResidencyBackend::MapTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, uint32_t physicalTile)
+	{
+		auto& m = m_mappings[resource];
+
+		m.m_coordinates.push_back(c);
+		m.m_rangeFlags.push_back(D3D12_TILE_RANGE_FLAG_NONE);
+		m.m_physicalOffsets.push_back(physicalTile);
+	}
+
+	void D3D12ResidencyBackend::UnmapTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, uint32_t physicalTile)
+	{
+		auto& m = m_mappings[resource];
+
+		m.m_coordinates.push_back(c);
+		m.m_rangeFlags.push_back(D3D12_TILE_RANGE_FLAG_NULL);
+		m.m_physicalOffsets.push_back(physicalTile);
+	}
+
+	void D3D12ResidencyBackend::UploadTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, std::vector<uint8_t> data)
+	{
+		m_tileUploads.push_back({ resource, c, std::move(data) });
+	}
+
+	// Rebuilds the changed parts of the residency map and writes their boxes to the upload heap of the frame.
+	void D3D12ResidencyBackend::UpdateResidencyMap(uint32_t resource, ResidencyMap& map)
+	{
+		ManagedTiledResource*	r			= m_resources[resource];
+		uint32_t				dimension	= std::max(r->ResidencyWidth(), r->ResidencyHeight());
+		uint64_t				size		= map.CollectUploads(dimension, r->m_residencyUploads);
+
+		if (r->m_residencyUploads.empty())
+		{
+			return;
+		}
+
+		ID3D12Resource1*	upload		= r->m_residencyResourceUpload[m_frameIndex].get();
+		D3D12_RANGE			range		= { 0, static_cast<SIZE_T>(size) };
+		uint8_t*			uploadData	= nullptr;
+
+		ThrowIfFailed(upload->Map(0, &range, reinterpret_cast<void**>(&uploadData)));
+
+		for (auto&& u : r->m_residencyUploads)
+		{
+			map.WriteUpload(u, dimension, uploadData);
+		}
+
+		upload->Unmap(0, &range);
+	}
+
+	bool D3D12ResidencyBackend::CopyResidency()
+	{
+		bool copied = false;
+
+		for (auto&& r : m_resources)
+		{
+			ID3D12Resource1* upload = r->m_residencyResourceUpload[m_frameIndex].get();
+
+			for (auto&& u : r->m_residencyUploads)
+			{
+				D3D12_TEXTURE_COPY_LOCATION destination = {};
+				destination.pResource			= r->m_residencyResource.get();
+				destination.Type				= D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+				destination.SubresourceIndex	= u.m_face;
+
+				D3D12_TEXTURE_COPY_LOCATION source = {};
+				source.pResource							= upload;
+				source.Type									= D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+				source.PlacedFootprint.Offset				= u.m_offset;
+				source.PlacedFootprint.Footprint.Format		= DXGI_FORMAT_R8_UNORM;
+				source.PlacedFootprint.Footprint.Width		= u.m_right - u.m_left;
+				source.PlacedFootprint.Footprint.Height		= u.m_bottom - u.m_top;
+				source.PlacedFootprint.Footprint.Depth		= 1;
+				source.PlacedFootprint.Footprint.RowPitch	= u.m_rowPitch;
+
+				m_list->CopyTextureRegion(&destination, u.m_left, u.m_top, 0, &source, nullptr);
+				copied = true;
+			}
+
+			r->m_residencyUploads.clear();
+		}
+
+		return copied;
+	}
+
+	void D3D12ResidencyBackend::Transition(bool residency, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after)
+	{
+		std::vector<D3D12_RESOURCE_BARRIER> barriers(m_resources.size());
+
+		for (auto i = 0U; i < barriers.size(); ++i)
+		{
+			barriers[i].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+			barriers[i].Transition.pResource	= residency ? m_resources[i]->m_residencyResource.get() : m_resources[i]->m_resource.get();
+			barriers[i].Transition.StateBefore	= before;
+			barriers[i].Transition.StateAfter	= after;
+			barriers[i].Transition.Subresource	= D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+		}
+
+		m_list->ResourceBarrier(static_cast<uint32_t>(barriers.size()), barriers.data());
+	}
+
+	void D3D12ResidencyBackend::Submit()
+	{
+		const D3D12_RESOURCE_STATES shaderResource = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+
+		// Start the reads of the loads of the frame, merged by the loaders.
+		for (auto&& r : m_resources)
+		{
+			r->m_loader->Flush();
+		}
+
+		// Use a single call to update all tile mappings.
+		for (auto i = 0U; i < m_mappings.size(); ++i)
+		{
+			auto& m = m_mappings[i];
+
+			if (m.m_coordinates.empty())
+			{
+				continue;
+			}
+
+			std::vector<uint32_t> rangeCounts(m.m_rangeFlags.size(), 1);
+			D3D12_TILE_REGION_SIZE size = {};
+
+			size.NumTiles = 1;
+			std::vector<D3D12_TILE_REGION_SIZE> sizes(m.m_rangeFlags.size(), size);
+
+			m_queue->UpdateTileMappings(
+				m_resources[i]->m_resource.get(),
+				(uint32_t)m.m_coordinates.size(),
+				m.m_coordinates.data(),
+				sizes.data(),
+				m_physicalHeap,
+				(uint32_t)m.m_rangeFlags.size(),
+				m.m_rangeFlags.data(),
+				m.m_physicalOffsets.data(),
+				rangeCounts.data(),
+				D3D12_TILE_MAPPING_FLAG_NONE
+			);
+
+			m.m_coordinates.clear();
+			m.m_rangeFlags.clear();
+			m.m_physicalOffsets.clear();
+		}
+
+		//Update residency textures, only the boxes of the faces, which changed
+		bool residencyChanged = false;
+
+		for (auto&& r : m_resources)
+		{
+			residencyChanged = residencyChanged || !r->m_residencyUploads.empty();
+		}
+
+		if (residencyChanged)
+		{
+			Transition(true, shaderResource, D3D12_RESOURCE_STATE_COPY_DEST);
+			CopyResidency();
+			Transition(true, D3D12_RESOURCE_STATE_COPY_DEST, shaderResource);
+		}
+
+		//Update Tiles
+		if (!m_tileUploads.empty())
+		{
+			Transition(false, shaderResource, D3D12_RESOURCE_STATE_COPY_DEST);
+
+			ID3D12Resource1*	heap				= m_tileUploadHeaps[m_frameIndex];
+			uint64_t			uploadHeapOffset	= 0;
+			D3D12_RANGE			range				= { 0, SampleSettings::TileSizeInBytes * m_tileUploads.size() };
+			uint8_t*			heapData			= nullptr;
+
+			ThrowIfFailed(heap->Map(0, &range, reinterpret_cast<void**>(&heapData)));
+
+			// Lay linear tiles one after the other in the heap offset
+			for (auto&& t : m_tileUploads)
+			{
+				std::memcpy(heapData + uploadHeapOffset, &t.m_data[0], SampleSettings::TileSizeInBytes);
+				uploadHeapOffset += SampleSettings::TileSizeInBytes;
+			}
+
+			heap->Unmap(0, &range);
+
+			uploadHeapOffset = 0;
+
+			// Finally, copy the contents of the tiles mapped this frame.
+			for (auto&& t : m_tileUploads)
+			{
+				D3D12_TILE_REGION_SIZE regionSize = { 1, FALSE, 0,0,0 };
+				D3D12_TILED_RESOURCE_COORDINATE coordinate = t.m_coordinate;
+
+				m_list->CopyTiles(m_resources[t.m_resource]->m_resource.get(), &coordinate, &regionSize, heap, uploadHeapOffset, D3D12_TILE_COPY_FLAG_LINEAR_BUFFER_TO_SWIZZLED_TILED_RESOURCE);
+				uploadHeapOffset += SampleSettings::TileSizeInBytes;
+			}
+
+			// Cleanup tile data
+			m_tileUploads.clear();
+
+			Transition(false, D3D12_RESOURCE_STATE_COPY_DEST, shaderResource);
+		}
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <d3d12.h>
+
+#include "residency_backend.h"
+
+namespace sample
+{
+	struct ManagedTiledResource;
+
+	// The residency backend of the sample. The loads go to the tile loaders of the resources, which read the loads of a frame
+	// together from Submit on. The mappings of a frame are coalesced into one UpdateTileMappings per resource, the tiles and the
+	// residency boxes are copied through the upload heaps of the frame on the command list.
+	class D3D12ResidencyBackend : public ResidencyBackend
+	{
+		public:
+
+		D3D12ResidencyBackend(ManagedTiledResource* const* resources, uint32_t resourceCount, ID3D12Heap* physicalHeap, ID3D12Resource1* const* tileUploadHeaps);
+
+		// The queue and the command list the calls of the frame are recorded to.
+		void SetFrame(ID3D12CommandQueue* queue, ID3D12GraphicsCommandList* list, uint32_t frame_index);
+
+		void LoadTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, std::function<void(std::vector<uint8_t>)> done) override;
+		void MapTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, uint32_t physicalTile) override;
+		void UnmapTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, uint32_t physicalTile) override;
+		void UploadTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, std::vector<uint8_t> data) override;
+		void UpdateResidencyMap(uint32_t resource, ResidencyMap& map) override;
+		void Submit() override;
+
+		// Copies the boxes of the residency maps, which UpdateResidencyMap wrote to the upload heaps, to the residency textures.
+		// The textures must be in the copy destination state. True, if there were any.
+		bool CopyResidency();
+
+		private:
+
+		struct TileMappingUpdateArguments
+		{
+			std::vector<D3D12_TILED_RESOURCE_COORDINATE> m_coordinates;
+
+			std::vector<D3D12_TILE_RANGE_FLAGS>			 m_rangeFlags;
+			std::vector<uint32_t>						 m_physicalOffsets;
+		};
+
+		struct TileUpload
+		{
+			uint32_t									 m_resource;
+			D3D12_TILED_RESOURCE_COORDINATE				 m_coordinate;
+			std::vector<uint8_t>						 m_data;
+		};
+
+		std::vector<ManagedTiledResource*>				m_resources;
+		ID3D12Heap*										m_physicalHeap;
+		ID3D12Resource1*								m_tileUploadHeaps[2];
+
+		ID3D12CommandQueue*								m_queue = nullptr;
+		ID3D12GraphicsCommandList*						m_list = nullptr;
+		uint32_t										m_frameIndex = 0;
+
+		std::vector<TileMappingUpdateArguments>			m_mappings;			//per resource
+		std::vector<TileUpload>							m_tileUploads;
+
+		void Transition(bool residency, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after);
+	};
+}
@@ -0,0 +1,245 @@
+#include "pch.h"
+#include "eviction_policy.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace sample
+{
+	EvictionPolicy::EvictionPolicy(uint32_t capacity) :
+		m_capacity(capacity)
+		, m_evicted(capacity)
+	{
+
+	}
+
+	void EvictionPolicy::Insert(TrackedTile* t)
+	{
+		m_size++;
+		m_statistics.m_misses++;
+
+		// The tile was evicted, while less than a pool of tiles was evicted after it.
+		if (m_evicted.find(t->m_key) != nullptr)
+		{
+			m_statistics.m_thrashes++;
+		}
+
+		InsertTile(t);
+	}
+
+	void EvictionPolicy::Touch(TrackedTile* t, uint32_t frame)
+	{
+		m_statistics.m_hits++;
+		TouchTile(t, frame);
+	}
+
+	void EvictionPolicy::Evict(TrackedTile* t)
+	{
+		RemoveTile(t);
+		m_size--;
+		m_statistics.m_evictions++;
+
+		// Remember the key for the next capacity evictions.
+		if (EvictedTile* g = m_evicted.find(t->m_key))
+		{
+			m_evictedOrder.remove(g);
+			m_evicted.erase(g);
+		}
+
+		EvictedTile* g = m_evicted.insert(t->m_key);
+
+		g->m_eviction = m_statistics.m_evictions;
+		m_evictedOrder.push_back(g);
+
+		if (m_evictedOrder.size() > m_capacity)
+		{
+			m_evicted.erase(m_evictedOrder.pop_front());
+		}
+	}
+
+	TrackedTile* ClockEviction::Victim()
+	{
+		while (!m_ring.empty() && m_ring.front()->m_evictionState != 0)
+		{
+			TrackedTile* t = m_ring.pop_front();
+
+			t->m_evictionState = 0;
+			m_ring.push_back(t);
+		}
+
+		return m_ring.front();
+	}
+
+	void ClockEviction::InsertTile(TrackedTile* t)
+	{
+		t->m_evictionState = 0;
+		m_ring.push_back(t);
+	}
+
+	void ClockEviction::TouchTile(TrackedTile* t, uint32_t frame)
+	{
+		t->m_lastSeen		= frame;
+		t->m_evictionState	= 1;
+	}
+
+	void ClockEviction::RemoveTile(TrackedTile* t)
+	{
+		m_ring.remove(t);
+	}
+
+	AdaptiveReplacementEviction::AdaptiveReplacementEviction(uint32_t capacity) :
+		EvictionPolicy(capacity)
+		, m_ghosts(2 * capacity)
+	{
+
+	}
+
+	TrackedTile* AdaptiveReplacementEviction::Victim()
+	{
+		const TileList<TrackedTile>& recent = m_tiles[Recent];
+
+		if (!recent.empty() && (recent.size() > m_recentTarget || m_tiles[Frequent].empty()))
+		{
+			return recent.front();
+		}
+
+		return m_tiles[Frequent].front();
+	}
+
+	void AdaptiveReplacementEviction::InsertTile(TrackedTile* t)
+	{
+		List list = Recent;
+
+		// A miss on a ghost: the list it was evicted from was too small.
+		if (EvictedTile* g = m_ghosts.find(t->m_key))
+		{
+			const size_t recentGhosts	= std::max<size_t>(1, m_ghostLists[Recent].size());
+			const size_t frequentGhosts	= std::max<size_t>(1, m_ghostLists[Frequent].size());
+
+			if (g->m_list == Recent)
+			{
+				m_recentTarget = static_cast<uint32_t>(std::min<size_t>(m_capacity, m_recentTarget + std::max<size_t>(1, frequentGhosts / recentGhosts)));
+			}
+			else
+			{
+				const size_t delta = std::max<size_t>(1, recentGhosts / frequentGhosts);
+				m_recentTarget = static_cast<uint32_t>(m_recentTarget > delta ? m_recentTarget - delta : 0);
+			}
+
+			ForgetGhost(g);
+			list = Frequent;
+		}
+
+		t->m_evictionState = list;
+		m_tiles[list].push_back(t);
+	}
+
+	// The samples see a tile in every frame it is on the screen. A tile seen after frames, which did not see it, is seen again
+	// and moves to the frequent list, a tile seen in consecutive frames keeps its list.
+	void AdaptiveReplacementEviction::TouchTile(TrackedTile* t, uint32_t frame)
+	{
+		const List list = t->m_lastSeen + 1 < frame ? Frequent : static_cast<List>(t->m_evictionState);
+
+		m_tiles[t->m_evictionState].remove(t);
+		m_tiles[list].push_back(t);
+
+		t->m_evictionState	= list;
+		t->m_lastSeen		= frame;
+	}
+
+	void AdaptiveReplacementEviction::RemoveTile(TrackedTile* t)
+	{
+		const List list = static_cast<List>(t->m_evictionState);
+
+		m_tiles[list].remove(t);
+
+		EvictedTile* g = m_ghosts.insert(t->m_key);
+
+		g->m_list = list;
+		m_ghostLists[list].push_back(g);
+
+		// The recent tiles and their ghosts stay within the capacity, all of them within twice the capacity.
+		while (m_tiles[Recent].size() + m_ghostLists[Recent].size() > m_capacity && !m_ghostLists[Recent].empty())
+		{
+			ForgetGhost(m_ghostLists[Recent].front());
+		}
+
+		while (size() + m_ghostLists[Recent].size() + m_ghostLists[Frequent].size() > 2 * static_cast<size_t>(m_capacity) && !m_ghostLists[Frequent].empty())
+		{
+			ForgetGhost(m_ghostLists[Frequent].front());
+		}
+	}
+
+	void AdaptiveReplacementEviction::ForgetGhost(EvictedTile* g)
+	{
+		m_ghostLists[g->m_list].remove(g);
+		m_ghosts.erase(g);
+	}
+
+	CostAwareEviction::CostAwareEviction(uint32_t capacity, uint32_t reloadCostInFrames, float mipWeight) :
+		EvictionPolicy(capacity)
+	{
+		// The costs of the mips a resource can have, capped far above the frames a tile stays mapped.
+		for (uint32_t mip = 0; mip < 16; ++mip)
+		{
+			const double cost = reloadCostInFrames * std::pow(static_cast<double>(mipWeight), static_cast<double>(mip));
+			m_cost.push_back(static_cast<uint32_t>(std::min(cost, 1.0e9)));
+		}
+	}
+
+	std::unique_ptr<EvictionPolicy> CreateEvictionPolicy(const EvictionPolicySettings& settings, uint32_t capacity)
+	{
+		switch (settings.m_type)
+		{
+			case EvictionPolicyType::Clock:					return std::make_unique<ClockEviction>(capacity);
+			case EvictionPolicyType::AdaptiveReplacement:	return std::make_unique<AdaptiveReplacementEviction>(capacity);
+			case EvictionPolicyType::CostAware:				return std::make_unique<CostAwareEviction>(capacity, settings.m_reloadCostInFrames, settings.m_mipWeight);
+			default:										return std::make_unique<LeastRecentlyUsedEviction>(capacity);
+		}
+	}
+
+	namespace
+	{
+		struct EvictionPolicyNameEntry
+		{
+			EvictionPolicyType	m_type;
+			const char*			m_name;
+		};
+
+		const EvictionPolicyNameEntry EvictionPolicyNames[] =
+		{
+			{ EvictionPolicyType::LeastRecentlyUsed,	"lru" },
+			{ EvictionPolicyType::Clock,				"clock" },
+			{ EvictionPolicyType::AdaptiveReplacement,	"arc" },
+			{ EvictionPolicyType::CostAware,			"cost" },
+		};
+	}
+
+	const char* EvictionPolicyName(EvictionPolicyType type)
+	{
+		for (auto&& e : EvictionPolicyNames)
+		{
+			if (e.m_type == type)
+			{
+				return e.m_name;
+			}
+		}
+
+		return "";
+	}
+
+	bool EvictionPolicyFromName(const char* name, EvictionPolicyType& type)
+	{
+		for (auto&& e : EvictionPolicyNames)
+		{
+			if (std::strcmp(e.m_name, name) == 0)
+			{
+				type = e.m_type;
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "tile_queue.h"
+#include "tile_table.h"
+#include "tracked_tile.h"
+
+namespace sample
+{
+	enum class EvictionPolicyType
+	{
+		LeastRecentlyUsed,			//the least recently seen tile, more detailed tiles first
+		Clock,						//second chance: a tile seen since the hand passed it is passed again
+		AdaptiveReplacement,		//ARC: tiles seen once and tiles seen again in two lists, sized by the misses of their ghosts
+		CostAware					//the least recently seen tile, less detailed tiles are kept longer by their reload cost
+	};
+
+	struct EvictionPolicySettings
+	{
+		EvictionPolicyType	m_type					= EvictionPolicyType::LeastRecentlyUsed;
+		uint32_t			m_reloadCostInFrames	= 2;		//cost aware: frames a mapped tile of the most detailed mip is kept longer
+		float				m_mipWeight				= 1.5f;		//cost aware: the cost grows by it with every less detailed mip
+	};
+
+	// Counters since the policy was created.
+	struct EvictionStatistics
+	{
+		uint64_t	m_hits			= 0;		//mapped tiles seen in a frame
+		uint64_t	m_misses		= 0;		//tiles mapped after their load
+		uint64_t	m_thrashes		= 0;		//misses of tiles, which were evicted less than a pool of evictions ago
+		uint64_t	m_evictions		= 0;
+	};
+
+	// Orders the mapped tiles of the residency policy for eviction. The policy inserts the tiles it maps, touches the ones the
+	// samples of a frame see and evicts the tile Victim names, or a tile under it, so Evict takes any mapped tile. Victim costs
+	// O(1) amortized, O(mips) for the queues by mip. The tiles are linked through their list links and m_bucket while they are
+	// mapped, m_evictionState belongs to the policy.
+	class EvictionPolicy
+	{
+		public:
+
+		explicit EvictionPolicy(uint32_t capacity);
+		virtual ~EvictionPolicy() = default;
+
+		// The tile was mapped.
+		void Insert(TrackedTile* t);
+
+		// A sample of the frame saw the mapped tile, once per frame.
+		void Touch(TrackedTile* t, uint32_t frame);
+
+		// The mapped tile is evicted, the policy forgets it.
+		void Evict(TrackedTile* t);
+
+		// The tile to evict next, the policy keeps it until Evict. Nullptr, if no tile is mapped.
+		virtual TrackedTile* Victim() = 0;
+
+		size_t size() const									{ return m_size; }
+		const EvictionStatistics& Statistics() const		{ return m_statistics; }
+
+		protected:
+
+		virtual void InsertTile(TrackedTile* t) = 0;
+		virtual void TouchTile(TrackedTile* t, uint32_t frame) = 0;
+		virtual void RemoveTile(TrackedTile* t) = 0;
+
+		// The keys of the evicted tiles, which are remembered, in eviction order.
+		struct EvictedTile
+		{
+			TileKey			m_key		= 0;
+			uint64_t		m_eviction	= 0;		//serial of the eviction
+			uint32_t		m_list		= 0;		//adaptive replacement: the ghost list
+			EvictedTile*	m_prev		= nullptr;
+			EvictedTile*	m_next		= nullptr;
+		};
+
+		uint32_t	m_capacity;
+
+		private:
+
+		size_t					m_size = 0;
+		EvictionStatistics		m_statistics;
+		TileTable<EvictedTile>	m_evicted;					//the last capacity evictions, for the thrashes
+		TileList<EvictedTile>	m_evictedOrder;
+	};
+
+	class LeastRecentlyUsedEviction : public EvictionPolicy
+	{
+		public:
+
+		explicit LeastRecentlyUsedEviction(uint32_t capacity) : EvictionPolicy(capacity) {}
+
+		TrackedTile* Victim() override								{ return m_tiles.oldest(); }
+
+		protected:
+
+		void InsertTile(TrackedTile* t) override					{ m_tiles.push(t); }
+		void TouchTile(TrackedTile* t, uint32_t frame) override		{ m_tiles.touch(t, frame); }
+		void RemoveTile(TrackedTile* t) override					{ m_tiles.remove(t); }
+
+		private:
+
+		TileQueue<TrackedTile> m_tiles;
+	};
+
+	// The tiles are on a ring, the hand is the front of the list. Passing a tile moves it to the back, new tiles go to the back
+	// too, just behind the hand. A tile touched since the hand passed it last is passed once more, every pass clears a
+	// reference, so the hand stops within two turns.
+	class ClockEviction : public EvictionPolicy
+	{
+		public:
+
+		explicit ClockEviction(uint32_t capacity) : EvictionPolicy(capacity) {}
+
+		TrackedTile* Victim() override;
+
+		protected:
+
+		void InsertTile(TrackedTile* t) override;
+		void TouchTile(TrackedTile* t, uint32_t frame) override;
+		void RemoveTile(TrackedTile* t) override;
+
+		private:
+
+		TileList<TrackedTile> m_ring;
+	};
+
+	// Adaptive replacement cache (Megiddo and Modha): the mapped tiles seen in one frame are in the recent list, the ones seen
+	// again in the frequent list, both in least recently used order. The ghost lists remember the keys evicted from each. A miss
+	// on a recent ghost grows the target size of the recent list, a miss on a frequent ghost shrinks it, and the victim comes
+	// from the recent list while it is over its target. A flight over new ground churns the recent list only and leaves the
+	// tiles the camera keeps coming back to mapped.
+	class AdaptiveReplacementEviction : public EvictionPolicy
+	{
+		public:
+
+		explicit AdaptiveReplacementEviction(uint32_t capacity);
+
+		TrackedTile* Victim() override;
+
+		protected:
+
+		void InsertTile(TrackedTile* t) override;
+		void TouchTile(TrackedTile* t, uint32_t frame) override;
+		void RemoveTile(TrackedTile* t) override;
+
+		private:
+
+		enum List : uint32_t
+		{
+			Recent = 0,
+			Frequent = 1
+		};
+
+		TileList<TrackedTile>	m_tiles[2];
+		TileTable<EvictedTile>	m_ghosts;
+		TileList<EvictedTile>	m_ghostLists[2];
+		uint32_t				m_recentTarget = 0;		//the target size of the recent list
+
+		void ForgetGhost(EvictedTile* g);
+	};
+
+	// Greedy dual with a cost per mip: the victim has the least m_lastSeen + cost of its mip, cost(mip) = reload cost * mip
+	// weight ^ mip frames. A less detailed tile covers four times the texels and is sampled by the tiles under it, so losing it
+	// costs more. The tiles of a mip share the cost and stay in frame order, the queue by mip finds the victim.
+	class CostAwareEviction : public EvictionPolicy
+	{
+		public:
+
+		CostAwareEviction(uint32_t capacity, uint32_t reloadCostInFrames, float mipWeight);
+
+		TrackedTile* Victim() override								{ return m_tiles.oldest(m_cost); }
+
+		protected:
+
+		void InsertTile(TrackedTile* t) override					{ m_tiles.push(t); }
+		void TouchTile(TrackedTile* t, uint32_t frame) override		{ m_tiles.touch(t, frame); }
+		void RemoveTile(TrackedTile* t) override					{ m_tiles.remove(t); }
+
+		private:
+
+		TileQueue<TrackedTile>	m_tiles;
+		std::vector<uint32_t>	m_cost;					//frames by mip
+	};
+
+	// The policy of the settings for a pool of capacity tiles.
+	std::unique_ptr<EvictionPolicy> CreateEvictionPolicy(const EvictionPolicySettings& settings, uint32_t capacity);
+
+	// The name of the policy, for the reports, and its type by name. False for an unknown name.
+	const char* EvictionPolicyName(EvictionPolicyType type);
+	bool EvictionPolicyFromName(const char* name, EvictionPolicyType& type);
+}
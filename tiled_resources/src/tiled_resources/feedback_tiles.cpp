@@ -0,0 +1,128 @@
+#include "pch.h"
+#include "feedback_tiles.h"
+
+#include <algorithm>
+
+namespace sample
+{
+	void SortTileKeys(std::vector<TileKey>& keys, std::vector<TileKey>& scratch)
+	{
+		if (keys.empty())
+		{
+			return;
+		}
+
+		// The histograms of all bytes in one pass over the keys.
+		uint32_t histogram[8][256] = {};
+
+		for (auto&& k : keys)
+		{
+			for (auto b = 0U; b < 8; ++b)
+			{
+				histogram[b][(k >> (8 * b)) & 0xFF]++;
+			}
+		}
+
+		scratch.resize(keys.size());
+
+		for (auto b = 0U; b < 8; ++b)
+		{
+			// All keys have the same byte, the pass would not move anything.
+			if (histogram[b][(keys[0] >> (8 * b)) & 0xFF] == keys.size())
+			{
+				continue;
+			}
+
+			uint32_t offset = 0;
+
+			for (auto&& h : histogram[b])
+			{
+				uint32_t count = h;
+				h = offset;
+				offset += count;
+			}
+
+			for (auto&& k : keys)
+			{
+				scratch[histogram[b][(k >> (8 * b)) & 0xFF]++] = k;
+			}
+
+			keys.swap(scratch);
+		}
+	}
+
+	static void SortUnique(std::vector<TileKey>& keys, std::vector<TileKey>& scratch)
+	{
+		SortTileKeys(keys, scratch);
+		keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+	}
+
+	void CollectSampledTiles(const std::vector<DecodedSample>& samples, uint32_t resource, const D3D12_SUBRESOURCE_TILING* tilings, uint32_t mips, std::vector<TileKey>& keys, std::vector<TileKey>& scratch)
+	{
+		TileKey recent[256];
+
+		std::fill(recent, recent + 256, ~0ULL);
+		keys.clear();
+
+		for (auto&& sample : samples)
+		{
+			// Samples are encoded assuming a maximally-sized (15-MIP) texture, so offset the
+			// sampled value by the difference between actual MIPs and maximum MIPs.
+			// Also, due to low-detail MIPs not being part of the MIP chain, we clamp the actual
+			// MIP to guarantee it always hits at least one level represented in the tiled resource.
+			uint32_t mip = static_cast<uint32_t>(std::max<int32_t>(0, std::min<int32_t>(mips - 1, sample.mip)));
+			uint32_t subResource = mip + sample.face * mips;
+
+			const auto& t = tilings[subResource];
+
+			float tileX = std::max<float>(t.WidthInTiles * sample.u, 0.0f);
+			tileX = std::min<float>(t.WidthInTiles - 1.0f, tileX);
+
+			float tileY = std::max<float>(t.HeightInTiles * sample.v, 0.0f);
+			tileY = std::min<float>(t.HeightInTiles - 1.0f, tileY);
+
+			TileKey key = MakeTileKey(resource, subResource, static_cast<uint32_t>(tileX), static_cast<uint32_t>(tileY));
+
+			// Neighbouring samples mostly hit the same tiles, a small cache of the recent keys drops most repeats before the sort.
+			TileKey& cached = recent[(key ^ (key >> 20) ^ (key >> 40)) & 255];
+
+			if (cached != key)
+			{
+				cached = key;
+				keys.push_back(key);
+			}
+		}
+
+		SortUnique(keys, scratch);
+
+		// The tiles of the less detailed mips. With tile counts, which halve from mip to mip, the tile of the next mip is the one
+		// the sample would hit there. The chains of neighbouring keys meet soon, the rest of a chain is then already in the keys.
+		const size_t	sampled = keys.size();
+		TileKey			previous[16];			// the last key of every mip, d3d12 textures have at most 15 mips
+
+		std::fill(previous, previous + 16, ~0ULL);
+
+		for (size_t i = 0; i < sampled; ++i)
+		{
+			TileKey key = keys[i];
+
+			for (uint32_t s = TileKeySubresource(key); s % mips + 1 < mips; ++s)
+			{
+				const auto& fine	= tilings[s];
+				const auto& coarse	= tilings[s + 1];
+
+				key = MakeTileKey(resource, s + 1, TileKeyX(key) * coarse.WidthInTiles / fine.WidthInTiles, TileKeyY(key) * coarse.HeightInTiles / fine.HeightInTiles);
+
+				if (previous[s % mips + 1] == key)
+				{
+					break;
+				}
+
+				previous[s % mips + 1] = key;
+				keys.push_back(key);
+			}
+		}
+
+		SortUnique(keys, scratch);
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "residency_types.h"
+#include "samples.h"
+#include "tile_table.h"
+
+namespace sample
+{
+	// Sorts the keys with a radix sort on bytes. The bytes, which are the same in all keys, like the resource index, are skipped.
+	void SortTileKeys(std::vector<TileKey>& keys, std::vector<TileKey>& scratch);
+
+	// The tiles the samples of a frame need in one managed resource: the tile of the sampled mip and the tiles of all less
+	// detailed mips under it. The samples are turned into keys of the sampled mip, sorted and made unique first. The keys of the
+	// less detailed mips come from the unique keys, so neighbouring samples cost one tile. Every tile is in keys once, sorted.
+	void CollectSampledTiles(const std::vector<DecodedSample>& samples, uint32_t resource, const D3D12_SUBRESOURCE_TILING* tilings, uint32_t mips, std::vector<TileKey>& keys, std::vector<TileKey>& scratch);
+}
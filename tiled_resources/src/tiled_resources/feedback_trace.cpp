@@ -0,0 +1,458 @@
+#include "pch.h"
+#include "feedback_trace.h"
+
+#include <cstring>
+
+namespace sample
+{
+	namespace
+	{
+		const uint8_t	TraceMagic[4]	= { 'F', 'B', 'T', '1' };
+		const uint32_t	HashBits		= 16;
+		const uint32_t	MinMatch		= 4;
+		const uint32_t	MaxBlockSize	= 1 << 26;			//larger coded frames are corrupt data
+
+		uint32_t FloatBits(float f)
+		{
+			uint32_t r;
+			std::memcpy(&r, &f, sizeof(r));
+			return r;
+		}
+
+		float BitsFloat(uint32_t b)
+		{
+			float r;
+			std::memcpy(&r, &b, sizeof(r));
+			return r;
+		}
+
+		uint32_t ZigZag(int32_t v)
+		{
+			return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31);
+		}
+
+		int32_t UnZigZag(uint32_t v)
+		{
+			return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1);
+		}
+
+		void WriteVarint(std::vector<uint8_t>& data, uint32_t v)
+		{
+			while (v >= 0x80)
+			{
+				data.push_back(static_cast<uint8_t>(v | 0x80));
+				v >>= 7;
+			}
+
+			data.push_back(static_cast<uint8_t>(v));
+		}
+
+		// Reads from a range of bytes, every read checks the end.
+		struct ByteReader
+		{
+			const uint8_t*	m_data;
+			size_t			m_size;
+			size_t			m_position;
+
+			bool Varint(uint32_t& value)
+			{
+				value = 0;
+
+				for (auto shift = 0U; shift < 35 && m_position < m_size; shift += 7)
+				{
+					const uint8_t b = m_data[m_position++];
+					value |= static_cast<uint32_t>(b & 0x7F) << shift;
+
+					if ((b & 0x80) == 0)
+					{
+						return true;
+					}
+				}
+
+				return false;
+			}
+
+			size_t Remaining() const { return m_size - m_position; }
+		};
+
+		uint32_t Hash(const uint8_t* p)
+		{
+			uint32_t v;
+			std::memcpy(&v, p, sizeof(v));
+			return (v * 2654435761U) >> (32 - HashBits);
+		}
+
+		// Lz77 of the bytes of the window after the dictionary, which are its first dictionarySize bytes. Runs of literals and
+		// matches alternate, a match of length 0 ends the block.
+		void Compress(const std::vector<uint8_t>& window, size_t dictionarySize, std::vector<int32_t>& hashes, std::vector<uint8_t>& out)
+		{
+			const size_t size = window.size();
+
+			hashes.assign(size_t(1) << HashBits, -1);
+
+			for (size_t i = 0; i < dictionarySize && i + MinMatch <= size; ++i)
+			{
+				hashes[Hash(&window[i])] = static_cast<int32_t>(i);
+			}
+
+			WriteVarint(out, static_cast<uint32_t>(size - dictionarySize));
+
+			size_t literals	= dictionarySize;
+			size_t i		= dictionarySize;
+
+			while (i + MinMatch <= size)
+			{
+				const uint32_t	h		= Hash(&window[i]);
+				const int32_t	match	= hashes[h];
+
+				hashes[h] = static_cast<int32_t>(i);
+
+				if (match < 0 || std::memcmp(&window[match], &window[i], MinMatch) != 0)
+				{
+					i++;
+					continue;
+				}
+
+				size_t length = MinMatch;
+
+				while (i + length < size && window[match + length] == window[i + length])
+				{
+					length++;
+				}
+
+				WriteVarint(out, static_cast<uint32_t>(i - literals));
+				out.insert(out.end(), window.begin() + literals, window.begin() + i);
+				WriteVarint(out, static_cast<uint32_t>(length));
+				WriteVarint(out, static_cast<uint32_t>(i - match));
+
+				for (size_t j = i + 1; j < i + length && j + MinMatch <= size; ++j)
+				{
+					hashes[Hash(&window[j])] = static_cast<int32_t>(j);
+				}
+
+				i		+= length;
+				literals = i;
+			}
+
+			WriteVarint(out, static_cast<uint32_t>(size - literals));
+			out.insert(out.end(), window.begin() + literals, window.end());
+			WriteVarint(out, 0);
+		}
+
+		bool Decompress(ByteReader& r, const std::vector<uint8_t>& dictionary, std::vector<uint8_t>& block)
+		{
+			uint32_t size;
+
+			if (!r.Varint(size) || size > MaxBlockSize)
+			{
+				return false;
+			}
+
+			const size_t dictionarySize = dictionary.size();
+
+			block.clear();
+			block.reserve(size);
+
+			for (;;)
+			{
+				uint32_t literals;
+				uint32_t length;
+				uint32_t offset;
+
+				if (!r.Varint(literals) || literals > size - block.size() || literals > r.Remaining())
+				{
+					return false;
+				}
+
+				block.insert(block.end(), r.m_data + r.m_position, r.m_data + r.m_position + literals);
+				r.m_position += literals;
+
+				if (!r.Varint(length))
+				{
+					return false;
+				}
+
+				if (length == 0)
+				{
+					return block.size() == size;
+				}
+
+				if (!r.Varint(offset) || offset == 0 || offset > dictionarySize + block.size() || length > size - block.size())
+				{
+					return false;
+				}
+
+				// The match may overlap the bytes it writes, so it is copied byte by byte.
+				for (uint32_t k = 0; k < length; ++k)
+				{
+					const size_t from = dictionarySize + block.size() - offset;
+					block.push_back(from < dictionarySize ? dictionary[from] : block[from - dictionarySize]);
+				}
+			}
+		}
+
+		bool Equal(const DecodedSample& a, const DecodedSample& b)
+		{
+			return FloatBits(a.u) == FloatBits(b.u) && FloatBits(a.v) == FloatBits(b.v) && a.mip == b.mip && a.face == b.face;
+		}
+
+		// The pose as seven floats, for the xor coding.
+		void PoseBits(const CameraPose& pose, uint32_t bits[7])
+		{
+			for (auto i = 0U; i < 3; ++i)
+			{
+				bits[i] = FloatBits(pose.m_position[i]);
+			}
+
+			for (auto i = 0U; i < 4; ++i)
+			{
+				bits[3 + i] = FloatBits(pose.m_orientation[i]);
+			}
+		}
+	}
+
+	FeedbackTraceWriter::FeedbackTraceWriter()
+	{
+		m_data.assign(TraceMagic, TraceMagic + sizeof(TraceMagic));
+	}
+
+	void FeedbackTraceWriter::Write(uint32_t frame, const CameraPose& pose, const std::vector<DecodedSample>& samples)
+	{
+		uint32_t bits[7];
+		uint32_t previousBits[7];
+
+		PoseBits(pose, bits);
+		PoseBits(m_previousPose, previousBits);
+
+		m_block.clear();
+		WriteVarint(m_block, frame - m_previousFrame);
+
+		for (auto i = 0U; i < 7; ++i)
+		{
+			WriteVarint(m_block, bits[i] ^ previousBits[i]);
+		}
+
+		WriteVarint(m_block, static_cast<uint32_t>(samples.size()));
+
+		// Pairs of a run of samples equal to the previous frame and a run of coded samples, until all samples are covered.
+		const size_t	count		= samples.size();
+		uint32_t		lastU		= 0;
+		uint32_t		lastV		= 0;
+		size_t			i			= 0;
+
+		while (i < count)
+		{
+			size_t same = i;
+
+			while (same < count && same < m_previous.size() && Equal(samples[same], m_previous[same]))
+			{
+				same++;
+			}
+
+			size_t literals = same;
+
+			while (literals < count && !(literals < m_previous.size() && Equal(samples[literals], m_previous[literals])))
+			{
+				literals++;
+			}
+
+			WriteVarint(m_block, static_cast<uint32_t>(same - i));
+			WriteVarint(m_block, static_cast<uint32_t>(literals - same));
+
+			if (same > i)
+			{
+				lastU = FloatBits(samples[same - 1].u);
+				lastV = FloatBits(samples[same - 1].v);
+			}
+
+			for (auto j = same; j < literals; ++j)
+			{
+				const uint32_t u = FloatBits(samples[j].u);
+				const uint32_t v = FloatBits(samples[j].v);
+
+				WriteVarint(m_block, ZigZag(static_cast<int32_t>(u - lastU)));
+				WriteVarint(m_block, ZigZag(static_cast<int32_t>(v - lastV)));
+				WriteVarint(m_block, (ZigZag(samples[j].mip) << 3) | (samples[j].face & 7));
+
+				lastU = u;
+				lastV = v;
+			}
+
+			i = literals;
+		}
+
+		// The previous coded frame followed by this one is the window of the compression, this one is the next dictionary.
+		const size_t	dictionarySize	= m_previousBlock.size();
+		const size_t	start			= m_data.size();
+
+		m_previousBlock.insert(m_previousBlock.end(), m_block.begin(), m_block.end());
+		m_data.resize(start + 5);
+
+		Compress(m_previousBlock, dictionarySize, m_hashes, m_data);
+
+		// The size of the compressed frame in front of it, as a varint of 5 bytes, which the reader reads like a short one.
+		uint32_t compressed = static_cast<uint32_t>(m_data.size() - start - 5);
+
+		for (auto k = 0U; k < 5; ++k)
+		{
+			m_data[start + k] = static_cast<uint8_t>((compressed & 0x7F) | (k < 4 ? 0x80 : 0));
+			compressed >>= 7;
+		}
+
+		m_previousBlock.erase(m_previousBlock.begin(), m_previousBlock.begin() + dictionarySize);
+		m_previous		= samples;
+		m_previousPose	= pose;
+		m_previousFrame	= frame;
+		m_frames++;
+	}
+
+	FeedbackTraceReader::FeedbackTraceReader(const uint8_t* data, size_t size) :
+		m_data(data)
+		, m_size(size)
+	{
+		if (size < sizeof(TraceMagic) || std::memcmp(data, TraceMagic, sizeof(TraceMagic)) != 0)
+		{
+			m_failed = true;
+		}
+
+		m_position = sizeof(TraceMagic);
+	}
+
+	bool FeedbackTraceReader::Next(FeedbackTraceFrame& frame)
+	{
+		if (m_failed || m_position >= m_size)
+		{
+			return false;
+		}
+
+		if (!ReadFrame(frame))
+		{
+			m_failed = true;
+			return false;
+		}
+
+		m_previousBlock.swap(m_block);
+		m_previous		= frame.m_samples;
+		m_previousPose	= frame.m_pose;
+		m_previousFrame	= frame.m_frame;
+
+		return true;
+	}
+
+	bool FeedbackTraceReader::ReadFrame(FeedbackTraceFrame& frame)
+	{
+		ByteReader	file		= { m_data, m_size, m_position };
+		uint32_t	compressed;
+
+		if (!file.Varint(compressed) || compressed > file.Remaining())
+		{
+			return false;
+		}
+
+		ByteReader block = { m_data, file.m_position + compressed, file.m_position };
+
+		if (!Decompress(block, m_previousBlock, m_block) || block.Remaining() != 0)
+		{
+			return false;
+		}
+
+		m_position = block.m_position;
+
+		ByteReader	r		= { m_block.data(), m_block.size(), 0 };
+		uint32_t	delta;
+		uint32_t	bits[7];
+		uint32_t	count;
+
+		PoseBits(m_previousPose, bits);
+
+		if (!r.Varint(delta))
+		{
+			return false;
+		}
+
+		for (auto i = 0U; i < 7; ++i)
+		{
+			uint32_t x;
+
+			if (!r.Varint(x))
+			{
+				return false;
+			}
+
+			bits[i] ^= x;
+		}
+
+		// A coded sample costs at least three bytes, a larger count is corrupt data.
+		if (!r.Varint(count) || count > r.Remaining() / 3 + m_previous.size())
+		{
+			return false;
+		}
+
+		frame.m_frame = m_previousFrame + delta;
+
+		for (auto i = 0U; i < 3; ++i)
+		{
+			frame.m_pose.m_position[i] = BitsFloat(bits[i]);
+		}
+
+		for (auto i = 0U; i < 4; ++i)
+		{
+			frame.m_pose.m_orientation[i] = BitsFloat(bits[3 + i]);
+		}
+
+		frame.m_samples.resize(count);
+
+		uint32_t	lastU	= 0;
+		uint32_t	lastV	= 0;
+		size_t		i		= 0;
+
+		while (i < count)
+		{
+			uint32_t same;
+			uint32_t literals;
+
+			if (!r.Varint(same) || !r.Varint(literals) || same > count - i || literals > count - i - same || i + same > m_previous.size() || same + literals == 0)
+			{
+				return false;
+			}
+
+			for (auto j = i; j < i + same; ++j)
+			{
+				frame.m_samples[j] = m_previous[j];
+			}
+
+			i += same;
+
+			if (same > 0)
+			{
+				lastU = FloatBits(frame.m_samples[i - 1].u);
+				lastV = FloatBits(frame.m_samples[i - 1].v);
+			}
+
+			for (auto j = i; j < i + literals; ++j)
+			{
+				uint32_t u;
+				uint32_t v;
+				uint32_t mipFace;
+
+				if (!r.Varint(u) || !r.Varint(v) || !r.Varint(mipFace))
+				{
+					return false;
+				}
+
+				lastU += static_cast<uint32_t>(UnZigZag(u));
+				lastV += static_cast<uint32_t>(UnZigZag(v));
+
+				DecodedSample& s = frame.m_samples[j];
+				s.u		= BitsFloat(lastU);
+				s.v		= BitsFloat(lastV);
+				s.mip	= static_cast<short>(UnZigZag(mipFace >> 3));
+				s.face	= static_cast<short>(mipFace & 7);
+			}
+
+			i += literals;
+		}
+
+		return r.Remaining() == 0;
+	}
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "samples.h"
+
+namespace sample
+{
+	struct FeedbackTraceFrame
+	{
+		uint32_t					m_frame = 0;
+		CameraPose					m_pose;
+		std::vector<DecodedSample>	m_samples;
+	};
+
+	// Records the samples and the camera poses of the frames to a compact binary trace. The sampling target changes little from
+	// frame to frame, so a frame is coded against the previous one: runs of samples, which equal the sample at the same index of
+	// the previous frame, cost a count, the other samples are coded as the difference of the float bits to the sample before
+	// them in the frame, in variable length integers. The pose is coded as the xor of the float bits with the previous pose.
+	// The coded frame is compressed with an lz77, which uses the coded previous frame as its dictionary, so the rows of a moving
+	// view, which repeat the deltas of the row before them or of the previous frame, cost a match each.
+	// The samples must have faces 0 to 7, they are replayed bit exact.
+	class FeedbackTraceWriter
+	{
+		public:
+
+		FeedbackTraceWriter();
+
+		void Write(uint32_t frame, const CameraPose& pose, const std::vector<DecodedSample>& samples);
+
+		const std::vector<uint8_t>& Data() const	{ return m_data; }
+		uint32_t Frames() const						{ return m_frames; }
+
+		private:
+
+		std::vector<uint8_t>		m_data;
+		std::vector<uint8_t>		m_block;			//the coded frame, the dictionary of the next one
+		std::vector<uint8_t>		m_previousBlock;
+		std::vector<int32_t>		m_hashes;			//scratch of the compression
+		std::vector<DecodedSample>	m_previous;
+		CameraPose					m_previousPose;
+		uint32_t					m_previousFrame = 0;
+		uint32_t					m_frames = 0;
+	};
+
+	// Reads the frames of a trace in order. Next returns false at the end of the trace and on corrupt data, Failed tells them apart.
+	class FeedbackTraceReader
+	{
+		public:
+
+		FeedbackTraceReader(const uint8_t* data, size_t size);
+
+		bool Next(FeedbackTraceFrame& frame);
+		bool Failed() const							{ return m_failed; }
+
+		private:
+
+		const uint8_t*				m_data;
+		size_t						m_size;
+		size_t						m_position = 0;
+		bool						m_failed = false;
+
+		std::vector<uint8_t>		m_block;
+		std::vector<uint8_t>		m_previousBlock;
+		std::vector<DecodedSample>	m_previous;
+		CameraPose					m_previousPose;
+		uint32_t					m_previousFrame = 0;
+
+		bool ReadFrame(FeedbackTraceFrame& frame);
+	};
+}
@@ -2,6 +2,7 @@
 #include "file_helper.h"
 #include "error.h"
 #include <future>
+#include <fstream>
 
 #include <winrt/Windows.Foundation.h>
 #include <winrt/Windows.Foundation.Collections.h>
@@ -44,5 +45,15 @@ namespace sample
 		Streams::DataReader::FromBuffer(buffer).ReadBytes(view);
 		co_return v;
 	}
+
+	void WriteLocalFile(const std::wstring& filename, const std::vector<uint8_t>& data)
+	{
+		auto folder = ApplicationData::Current().LocalFolder();
+
+		std::wstring path = std::wstring(folder.Path().c_str()) + L"\\" + filename;
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+
+		file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+	}
 	
 }
\ No newline at end of file
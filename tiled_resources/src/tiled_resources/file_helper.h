@@ -12,6 +12,9 @@ namespace sample
 {
 	using namespace concurrency;
 	task<std::vector<uint8_t> > ReadFileAsync(const std::wstring& filename);
+
+	// Writes the data to a file in the local folder of the app, replacing it.
+	void WriteLocalFile(const std::wstring& filename, const std::vector<uint8_t>& data);
 }
 
 
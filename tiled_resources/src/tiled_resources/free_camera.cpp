@@ -31,7 +31,7 @@ namespace sample
 
     void FreeCamera::SetProjectionParameters(float width, float height)
     {
-        XMMATRIX projectionMatrix = XMMatrixPerspectiveFovRH(70.0f * XM_PI / 180.0f, width / height, 1.0f / 256.0f, 256.0f);
+        XMMATRIX projectionMatrix = XMMatrixPerspectiveFovRH(FieldOfView, width / height, 1.0f / 256.0f, 256.0f);
         XMStoreFloat4x4(&m_projectionMatrix, projectionMatrix);
     }
 
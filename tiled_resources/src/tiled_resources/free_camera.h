@@ -18,6 +18,8 @@ namespace sample
     public:
         FreeCamera();
 
+        static constexpr float FieldOfView = 70.0f * XM_PI / 180.0f; // Vertical, the feedback prediction projects with it too.
+
         void SetViewParameters(XMFLOAT3 eye, XMFLOAT3 at, XMFLOAT3 up);
         void SetProjectionParameters(float width, float height);
 
@@ -210,6 +210,16 @@ namespace sample
 		m_samplingRenderer = std::make_unique<sample::SamplingRenderer>();
 		m_residencyManager = std::make_unique<ResidencyManager>(m_deviceResources->Device());
 
+		{
+			TilePrefetchSettings settings;
+
+			settings.m_framesAhead	= SampleSettings::Prefetch::FramesAhead;
+			settings.m_gridWidth	= SampleSettings::Prefetch::GridWidth;
+			settings.m_gridHeight	= SampleSettings::Prefetch::GridHeight;
+
+			m_prefetcher = TilePrefetcher(settings);
+		}
+
 		//if you have many threads that generate commands. 1 per thread per frame
 		{
 			ID3D12Device1* d = m_deviceResources->Device();
@@ -224,7 +234,10 @@ namespace sample
 
 	void MainRenderer::Uninitialize()
 	{
-
+		if (SampleSettings::Trace::Record && m_trace.Frames() > 0)
+		{
+			WriteLocalFile(SampleSettings::Trace::FileName, m_trace.Data());
+		}
 	}
 
 	void MainRenderer::Load()
@@ -416,9 +429,24 @@ namespace sample
 			commandList->SetDescriptorHeaps(1, heaps);
 		}
 
-		//Process samples from the previous frame
+		//Process samples from the previous frame, with the feedback the camera will see in the frames ahead
 		{
-			m_residencyManager->UpdateTiles(m_deviceResources->Queue(), commandList, m_frame_index, m_frame_number++, m_samplingRenderer->Samples());
+			CameraPose pose;
+
+			pose.m_position[0]		= m_camera.m_position.x;
+			pose.m_position[1]		= m_camera.m_position.y;
+			pose.m_position[2]		= m_camera.m_position.z;
+			pose.m_orientation[0]	= m_camera.m_orientation.x;
+			pose.m_orientation[1]	= m_camera.m_orientation.y;
+			pose.m_orientation[2]	= m_camera.m_orientation.z;
+			pose.m_orientation[3]	= m_camera.m_orientation.w;
+
+			if (SampleSettings::Trace::Record)
+			{
+				m_trace.Write(static_cast<uint32_t>(m_frame_number), pose, m_samplingRenderer->Samples());
+			}
+
+			m_residencyManager->UpdateTiles(m_deviceResources->Queue(), commandList, m_frame_index, m_frame_number++, m_samplingRenderer->Samples(), m_prefetcher.Predict(pose));
 
 		}
 
@@ -690,6 +718,21 @@ namespace sample
 		return (value + 7) & ~7;
 	}
 
+	// The prediction projects the feedback with the camera and the sampling target of the window.
+	void MainRenderer::SetFeedbackProjection(uint32_t width, uint32_t height)
+	{
+		FeedbackProjection projection;
+
+		projection.m_fieldOfView		= FreeCamera::FieldOfView;
+		projection.m_aspectRatio		= static_cast<float>(width) / static_cast<float>(height);
+		projection.m_samplingWidth		= m_samplingRenderer->SamplingWidth();
+		projection.m_samplingHeight		= m_samplingRenderer->SamplingHeight();
+		projection.m_resourceDimension	= static_cast<float>(SampleSettings::TerrainAssets::Diffuse::DimensionSize);
+		projection.m_samplingRatio		= SampleSettings::Sampling::Ratio;
+
+		m_prefetcher.SetProjection(projection);
+	}
+
 	void MainRenderer::SetWindow(::IUnknown * w, const sample::window_environment & envrionment)
 	{
 		auto width		= align8(static_cast<uint32_t>(envrionment.m_back_buffer_size.Width));
@@ -709,6 +752,7 @@ namespace sample
 		ctx.m_depth_heap = m_deviceResources->DepthHeap();
 		ctx.m_render_target_heap = m_deviceResources->RenderTargetHeap();
 		m_samplingRenderer->CreateSamplingRenderer(ctx);
+		SetFeedbackProjection(width, height);
 
 
 		//Camera
@@ -752,6 +796,7 @@ namespace sample
 			ctx.m_depth_heap = m_deviceResources->DepthHeap();
 			ctx.m_render_target_heap = m_deviceResources->RenderTargetHeap();
 			m_samplingRenderer->CreateSamplingRenderer(ctx);
+			SetFeedbackProjection(w, h);
 		}
 
 	}
@@ -8,6 +8,8 @@
 #include "residency_manager.h"
 
 #include "free_camera.h"
+#include "feedback_trace.h"
+#include "tile_prefetcher.h"
 
 
 //Main renderer of the app
@@ -62,6 +64,10 @@ namespace sample
 		D3D12_INDEX_BUFFER_VIEW                     m_planet_index_view;		//indices for render
 
 		FreeCamera									m_camera;
+		FeedbackTraceWriter							m_trace;					//samples and camera of the frames, if recorded
+		TilePrefetcher								m_prefetcher;				//feedback of the camera of the frames ahead
+
+		void SetFeedbackProjection(uint32_t width, uint32_t height);
 	};
 }
 
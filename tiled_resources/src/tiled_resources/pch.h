@@ -5,6 +5,16 @@
 
 #pragma once
 
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <memory>
+#include <list>
+#include <map>
+
+//the residency policy also builds on linux for the harness in residency_benchmark, without the platform headers
+#if defined(_WIN32)
+
 #define NOMINMAX                        // Exclude windows header macro
 
 #include <SDKDDKVer.h>
@@ -14,12 +24,6 @@
 // Windows Header Files:
 // cppwinrt takes too much time to compile, so it is good to precompile it
 #include <windows.h>
-#include <cstdint>
-#include <vector>
-#include <string>
-#include <memory>
-#include <list>
-#include <map>
 
 #include <Unknwn.h>
 #include <winrt/base.h>
@@ -31,6 +35,8 @@
 //for async
 #include <pplawait.h>
 
+#endif
+
 
 
 
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "residency_map.h"
+#include "residency_types.h"
+
+namespace sample
+{
+	// The platform side of the residency policy: reading the tiles, mapping the tiles of the reserved resources to the physical
+	// tile pool, copying the tile data and updating the residency textures. The d3d12 backend records the calls of a frame and
+	// submits them in Submit, the simulated backend runs the policy without a gpu.
+	class ResidencyBackend
+	{
+		public:
+
+		virtual ~ResidencyBackend() = default;
+
+		// Reads the data of the tile. done may run on any thread, once the data is read.
+		virtual void LoadTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, std::function<void(std::vector<uint8_t>)> done) = 0;
+
+		// Maps the tile to the physical tile of the pool.
+		virtual void MapTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, uint32_t physicalTile) = 0;
+
+		// Maps the tile, which used the physical tile, to NULL.
+		virtual void UnmapTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, uint32_t physicalTile) = 0;
+
+		// Copies the data of the tile, which was mapped this frame, to its physical tile.
+		virtual void UploadTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, std::vector<uint8_t> data) = 0;
+
+		// Uploads the parts of the residency texture, which changed.
+		virtual void UpdateResidencyMap(uint32_t resource, ResidencyMap& map) = 0;
+
+		// The calls of the frame are done.
+		virtual void Submit() = 0;
+	};
+}
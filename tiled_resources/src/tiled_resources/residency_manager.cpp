@@ -154,6 +154,19 @@ namespace sample
 		m_null_resource = CreateReservedNullBuffer(d);
 	}
 
+	ResidencyManager::~ResidencyManager()
+	{
+		// The members go in reverse order, the policy before the resources. The loaders drop their queued reads and wait for
+		// the ones in flight, whose callbacks write to the policy and its tracked tiles, so they must go first.
+		for (auto&& r : m_resources)
+		{
+			if (r)
+			{
+				r->m_loader.reset();
+			}
+		}
+	}
+
 	std::unique_ptr<ManagedTiledResource> MakeManagedResource(ID3D12Device1* d, winrt::com_ptr<ID3D12Resource1> resource, const std::wstring& filename)
 	{
 		std::unique_ptr<ManagedTiledResource> r = std::make_unique<ManagedTiledResource>();
@@ -169,14 +182,6 @@ namespace sample
 		d->GetResourceTiling(p->m_resource.get(), &p->m_totalTiles, &p->m_packedMipDescription, &p->m_tileShape, &subresourceTilings, 0, p->m_subresourceTilings.data());
 		p->m_loader = std::make_unique<TileLoader>(filename, &p->m_subresourceTilings);
 
-		//Update the shadow residency buffer, set it up to point to the last mip
-		//this will be updated from the streaming system
-		for (auto face = 0U; face < 6U; face++)
-		{
-			p->m_residencyShadow[face].clear();
-			p->m_residencyShadow[face].resize(p->ResidencyWidth() * p->ResidencyHeight(), 0xFF);
-		}
-
 		/*
 		p->m_residencyShadow[0].clear();
 		p->m_residencyShadow[1].clear();
@@ -257,6 +262,31 @@ namespace sample
 		m_resources[0] = MakeDiffuseResource(ctx.m_device, ctx.m_diffuse);
 		m_resources[1] = MakeNormalResource(ctx.m_device, ctx.m_normal);
 
+		//The policy streams both resources through the d3d12 backend, the first physical tile is the default tile
+		{
+			using namespace SampleSettings;
+
+			ManagedTiledResource*	resources[2]	= { m_resources[0].get(), m_resources[1].get() };
+			ID3D12Resource1*		uploadHeaps[2]	= { m_upload_heap[0].get(), m_upload_heap[1].get() };
+
+			m_backend = std::make_unique<D3D12ResidencyBackend>(resources, 2, m_physical_heap.get(), uploadHeaps);
+
+			ResidencyPolicySettings settings;
+			settings.m_poolSizeInTiles				= TileResidency::PoolSizeInTiles;
+			settings.m_reservedTiles				= 1;
+			settings.m_maxSimultaneousFileLoadTasks	= TileResidency::MaxTileLoadsInFlight;
+			settings.m_maxTilesLoadedPerFrame		= TileResidency::MaxTilesLoadedPerFrame;
+			settings.m_maxPrefetchLoadsPerFrame		= Prefetch::MaxLoadsPerFrame;
+			settings.m_eviction.m_type				= TileResidency::EvictionPolicy;
+
+			m_policy = std::make_unique<ResidencyPolicy>(m_backend.get(), settings);
+
+			for (auto&& r : m_resources)
+			{
+				m_policy->AddResource(r->m_subresourceTilings.data(), r->m_textureDescription.MipLevels);
+			}
+		}
+
 		//Now setup the views
 		ResidencyManagerCreateResult r;
 
@@ -283,24 +313,17 @@ namespace sample
 
 	void ResidencyManager::ResetInitialData(ID3D12CommandQueue * queue, ID3D12GraphicsCommandList * list, uint32_t frame_index)
 	{
-		//Upload all residency resources, face by face
+		//Upload all residency resources, face by face, they are still in the copy destination state
+		m_backend->SetFrame(queue, list, frame_index);
 
 		for (auto i = 0U; i < 2; ++i)
 		{
-			auto r = m_resources[i].get();
-			uint32_t dimension = std::max(r->ResidencyWidth(), r->ResidencyHeight());
-
-			D3D12_SUBRESOURCE_DATA data[6];
-			for (auto i = 0U; i < 6; ++i)
-			{
-				data[i].pData = &r->m_residencyShadow[i][0];
-				data[i].RowPitch = dimension;
-				data[i].SlicePitch = dimension;
-			}
-
-			UpdateSubresources<6>(list, r->m_residencyResource.get(), r->m_residencyResourceUpload[frame_index].get(), 0, 0, 6, data);
+			m_policy->Residency(i).Invalidate();
+			m_backend->UpdateResidencyMap(i, m_policy->Residency(i));
 		}
 
+		m_backend->CopyResidency();
+
 		//Update the null resource
 		{
 			auto r = m_null_resource.get();
@@ -383,454 +406,10 @@ namespace sample
 		return m_resources[1]->m_residencyResource.get();
 	}
 
-	void ResidencyManager::ProcessSamples(const std::vector<DecodedSample> & samples, uint32_t frame_number)
-	{
-		if (!samples.empty())
-		{
-			for (auto&& sample : samples)
-			{
-				// Interpret each sample in the context of each managed resource.
-				for (auto&& resource : m_resources)
-				{
-
-					// Samples are encoded assuming a maximally-sized (15-MIP) texture, so offset the
-					// sampled value by the difference between actual MIPs and maximum MIPs.
-					// Also, due to low-detail MIPs not being part of the MIP chain, we clamp the actual
-					// MIP to guarantee it always hits at least one level represented in the tiled resource.
-					int16_t				mips = static_cast<int16_t>(resource->m_textureDescription.MipLevels);
-					int16_t actualMip = std::max<int16_t>(0, std::min<int16_t>(mips - 1, sample.mip));
-
-					// Loop over sampled MIP through the least detailed MIP.
-					for (auto mip = actualMip; mip < mips; ++mip)
-					{
-						// Calculate the tile coordinate.
-						TileKey tileKey = {};
-						tileKey.m_resource = resource->m_resource.get();
-
-						uint32_t subResource = mip + sample.face * mips;
-
-						const auto& tilings = resource->m_subresourceTilings[subResource];
-						tileKey.m_coordinate.Subresource = subResource;
-
-						float tileX = std::max<float>(tilings.WidthInTiles * sample.u, 0.0f);
-						tileX = std::min<float>(tilings.WidthInTiles - 1.0f, tileX);
-
-						tileKey.m_coordinate.X = static_cast<uint32_t>(tileX);
-						float tileY = std::max<float>(tilings.HeightInTiles * sample.v, 0.0f);
-
-						tileY = std::min<float>(tilings.HeightInTiles - 1.0f, tileY);
-						tileKey.m_coordinate.Y = static_cast<uint32_t>(tileY);
-
-						// See if the tile is already being tracked.
-						auto tileIterator = m_trackedTiles.find(tileKey);
-						if (tileIterator == m_trackedTiles.end())
-						{
-							// Tile is not being tracked currently, so enqueue it for load.
-							std::unique_ptr<TrackedTile> tile(new TrackedTile);
-							tile->m_managedResource = resource.get();
-							tile->m_coordinate = tileKey.m_coordinate;
-							tile->m_lastSeen = frame_number;
-							tile->m_state = TileState::Seen;
-							tile->m_mipLevel = mip;
-							tile->m_face = sample.face;
-
-							m_seenTileList.push_back(tile.get());
-							m_trackedTiles[tileKey] = std::move(tile);
-
-						}
-						else
-						{
-							// If tile is already tracked, simply update the last-seen value.
-							tileIterator->second->m_lastSeen = frame_number;
-						}
-					}
-				}
-			}
-		}
-	}
-
-	void ResidencyManager::UpdateTiles(ID3D12CommandQueue* queue, ID3D12GraphicsCommandList* list, uint32_t frame_index, uint32_t frame_number, const std::vector<DecodedSample>& samples)
+	void ResidencyManager::UpdateTiles(ID3D12CommandQueue* queue, ID3D12GraphicsCommandList* list, uint32_t frame_index, uint32_t frame_number, const std::vector<DecodedSample>& samples, const std::vector<DecodedSample>& predicted)
 	{
-		ProcessSamples(samples, frame_number);
-
-		concurrency::task_group g;
-
-		// Sort the tile lists.
-
-		g.run([this]
-		{
-			m_seenTileList.sort(LoadPredicate);
-		});
-
-		g.run([this]
-		{
-			m_loadingTileList.sort(MapPredicate);
-		});
-
-		g.run_and_wait([this]
-		{
-			m_mappedTileList.sort(EvictPredicate);
-		});
-
-
-		// Initiate loads for seen tiles.
-		for (auto i = m_active_tile_loading_operations.load(); i < SampleSettings::TileResidency::MaxSimultaneousFileLoadTasks; i++)
-		{
-			if (m_seenTileList.empty())
-			{
-				break;
-			}
-
-			TrackedTile* tileToLoad = m_seenTileList.front();
-
-			m_seenTileList.pop_front();
-
-			m_active_tile_loading_operations++;
-
-			tileToLoad->m_managedResource->m_loader->LoadTileAsync(tileToLoad->m_coordinate).then([this, tileToLoad](std::vector<uint8_t> tileData)
-			{
-				tileToLoad->m_tileData = std::move(tileData);
-				tileToLoad->m_state = TileState::Loaded;
-				m_active_tile_loading_operations--;
-			});
-
-			// Move the tile to the loading list.
-			m_loadingTileList.push_back(tileToLoad);
-		}
-
-		// Loop over the loading / loaded tile list for mapping candidates.
-		struct TileMappingUpdateArguments
-		{
-			std::vector<D3D12_TILED_RESOURCE_COORDINATE> m_coordinates;
-
-			std::vector<D3D12_TILE_RANGE_FLAGS>			 m_rangeFlags;
-			std::vector<uint32_t>						 m_physicalOffsets;
-
-			// For convenience, the tracked tile mapping is also saved.
-			std::list<TrackedTile*>						 m_tilesToMap;
-		};
-
-		// Loop over the loading / loaded tile list for mapping candidates.
-		struct TileUpdateArguments
-		{
-			std::vector<D3D12_TILED_RESOURCE_COORDINATE> m_coordinates;
-			// For convenience, the tracked tile mapping is also saved.
-			std::vector<TrackedTile*>					 m_tilesToUpdate;
-		};
-
-		std::map<ID3D12Resource1*, TileMappingUpdateArguments>  coalescedMapArguments;
-		std::map<ID3D12Resource1*, TileUpdateArguments>			coalescedUpdateTileArguments;
-
-		for (auto i = 0; i < SampleSettings::TileResidency::MaxTilesLoadedPerFrame; i++)
-		{
-			if (m_loadingTileList.empty())
-			{
-				break;
-			}
-
-			auto tileToMap = m_loadingTileList.front();
-
-			if (tileToMap->m_state != TileState::Loaded)
-			{
-				// This sample's residency management assumes that for a given texcoord,
-				// there will never be a detailed MIP resident where a less detailed one
-				// is NULL-mapped. This is enforced by sort predicates. A side-effect of
-				// this technique is that mapping cannot occur out of order.
-				break;
-			}
-
-			m_loadingTileList.pop_front();
-
-			// Default to assigning tiles to the first available tile.
-			UINT physicalTileOffset = m_reservedTiles + static_cast<UINT>(m_mappedTileList.size());
-
-			if (m_mappedTileList.size() + m_reservedTiles == SampleSettings::TileResidency::PoolSizeInTiles)
-			{
-				// Tile pool is full, need to unmap something.
-				auto tileToEvict = m_mappedTileList.front();
-
-				if (tileToMap->m_lastSeen < tileToEvict->m_lastSeen)
-				{
-					// If the candidate tile to map is older than the eviction candidate,
-					// skip the mapping and discard it. This can occur if a tile load stalls,
-					// and by the time it is ready it has moved off-screen.
-					TileKey tileKey = { tileToMap->m_coordinate, tileToMap->m_managedResource->m_resource.get() };
-
-					// Remove the tile from the tracked list.
-					m_trackedTiles.erase(tileKey);
-
-					//todo: assert the tile is not in the other lists
-
-
-					// Move on to the next map candidate.
-					continue;
-				}
-
-				m_mappedTileList.pop_front();
-
-				// Save the physical tile that was freed so the new tile can use it.
-				physicalTileOffset = tileToEvict->m_physicalTileOffset;
-
-				TileKey tileKey = { tileToEvict->m_coordinate, tileToEvict->m_managedResource->m_resource.get() };
-
-				// Add the new NULL-mapping to the argument list.
-				coalescedMapArguments[tileToEvict->m_managedResource->m_resource.get()].m_coordinates.push_back(tileToEvict->m_coordinate);
-				coalescedMapArguments[tileToEvict->m_managedResource->m_resource.get()].m_rangeFlags.push_back(D3D12_TILE_RANGE_FLAG_NULL);
-				coalescedMapArguments[tileToEvict->m_managedResource->m_resource.get()].m_physicalOffsets.push_back(physicalTileOffset);
-
-				// Update the residency map to remove this level of detail.
-				int baseTilesCoveredWidth = tileToEvict->m_managedResource->m_subresourceTilings[0].WidthInTiles / tileToEvict->m_managedResource->m_subresourceTilings[tileToEvict->m_coordinate.Subresource].WidthInTiles;
-				int baseTilesCoveredHeight = tileToEvict->m_managedResource->m_subresourceTilings[0].HeightInTiles / tileToEvict->m_managedResource->m_subresourceTilings[tileToEvict->m_coordinate.Subresource].HeightInTiles;
-
-
-				for (int Y = 0; Y < baseTilesCoveredHeight; Y++)
-				{
-					for (int X = 0; X < baseTilesCoveredWidth; X++)
-					{
-						int tileY = tileToEvict->m_coordinate.Y * baseTilesCoveredHeight + Y;
-						int tileX = tileToEvict->m_coordinate.X * baseTilesCoveredWidth + X;
-						uint8_t* value = &tileToEvict->m_managedResource->m_residencyShadow[tileToEvict->m_face][tileY * tileToEvict->m_managedResource->m_subresourceTilings[0].WidthInTiles + tileX];
-						*value = std::max<uint8_t>((tileToEvict->m_mipLevel + 1) * 16, *value);
-					}
-				}
-
-				// Remove the tile from the tracked list.
-				m_trackedTiles.erase(tileKey);
-			}
-
-
-			// Add the new mapping to the argument list.
-			coalescedMapArguments[tileToMap->m_managedResource->m_resource.get()].m_coordinates.push_back(tileToMap->m_coordinate);
-			coalescedMapArguments[tileToMap->m_managedResource->m_resource.get()].m_rangeFlags.push_back(D3D12_TILE_RANGE_FLAG_NONE);
-			coalescedMapArguments[tileToMap->m_managedResource->m_resource.get()].m_physicalOffsets.push_back(physicalTileOffset);
-			tileToMap->m_physicalTileOffset = physicalTileOffset;
-			tileToMap->m_state = TileState::Mapped;
-			coalescedMapArguments[tileToMap->m_managedResource->m_resource.get()].m_tilesToMap.push_back(tileToMap);
-
-			// Add the new mapping to upload to the gpu
-			coalescedUpdateTileArguments[tileToMap->m_managedResource->m_resource.get()].m_coordinates.push_back(tileToMap->m_coordinate);
-			coalescedUpdateTileArguments[tileToMap->m_managedResource->m_resource.get()].m_tilesToUpdate.push_back(tileToMap);
-
-			// Update the residency map to add this level of detail.
-			int baseTilesCoveredWidth = tileToMap->m_managedResource->m_subresourceTilings[0].WidthInTiles / tileToMap->m_managedResource->m_subresourceTilings[tileToMap->m_coordinate.Subresource].WidthInTiles;
-			int baseTilesCoveredHeight = tileToMap->m_managedResource->m_subresourceTilings[0].HeightInTiles / tileToMap->m_managedResource->m_subresourceTilings[tileToMap->m_coordinate.Subresource].HeightInTiles;
-			for (int Y = 0; Y < baseTilesCoveredHeight; Y++)
-			{
-				for (int X = 0; X < baseTilesCoveredWidth; X++)
-				{
-					int tileY = tileToMap->m_coordinate.Y * baseTilesCoveredHeight + Y;
-					int tileX = tileToMap->m_coordinate.X * baseTilesCoveredWidth + X;
-					uint8_t* value = &tileToMap->m_managedResource->m_residencyShadow[tileToMap->m_face][tileY * tileToMap->m_managedResource->m_subresourceTilings[0].WidthInTiles + tileX];
-					*value = std::min<uint8_t>(tileToMap->m_mipLevel * 16, *value);
-				}
-			}
-
-			m_mappedTileList.push_back(tileToMap);
-		}
-
-		// Use a single call to update all tile mappings.
-		for (auto&& perResourceArguments : coalescedMapArguments)
-		{
-			std::vector<uint32_t> rangeCounts(perResourceArguments.second.m_rangeFlags.size(), 1);
-			D3D12_TILE_REGION_SIZE size = {};
-			
-			size.NumTiles = 1;
-			std::vector<D3D12_TILE_REGION_SIZE> sizes(perResourceArguments.second.m_rangeFlags.size(), size);
-
-			queue->UpdateTileMappings(
-				perResourceArguments.first,
-				(uint32_t)perResourceArguments.second.m_coordinates.size(),
-				perResourceArguments.second.m_coordinates.data(),
-				sizes.data(),
-				m_physical_heap.get(),
-				(uint32_t)perResourceArguments.second.m_rangeFlags.size(),
-				perResourceArguments.second.m_rangeFlags.data(),
-				perResourceArguments.second.m_physicalOffsets.data(),
-				rangeCounts.data(),
-				D3D12_TILE_MAPPING_FLAG_NONE
-			);
-		}
-
-
-		//Update residency textures
-		{
-
-			//Do transitions
-			//Transtion resources, make them ready for sampling
-			{
-				D3D12_RESOURCE_BARRIER barrier[2] = {};
-
-				for (auto i = 0U; i < 2; ++i)
-				{
-					barrier[i].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-					barrier[i].Transition.StateBefore	= D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
-					barrier[i].Transition.StateAfter	= D3D12_RESOURCE_STATE_COPY_DEST;
-					barrier[i].Transition.Subresource	= D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-				}
-
-				barrier[0].Transition.pResource = m_resources[0]->m_residencyResource.get();
-				barrier[1].Transition.pResource = m_resources[1]->m_residencyResource.get();
-				list->ResourceBarrier(2, barrier);
-			}
-
-
-			// Update residency textures with the new residency data.
-			for (auto&& r : m_resources)
-			{
-				int baseWidthInTiles = r->m_subresourceTilings[0].WidthInTiles;
-				int baseHeightInTiles = r->m_subresourceTilings[0].HeightInTiles;
-				int baseMaxTileDimension = std::max(baseWidthInTiles, baseHeightInTiles);
-				std::vector<byte> residencyData(baseMaxTileDimension * baseMaxTileDimension);
-
-				for (int face = 0; face < 6; face++)
-				{
-					for (int Y = 0; Y < baseMaxTileDimension; Y++)
-					{
-						int tileY = (Y * baseHeightInTiles) / baseMaxTileDimension;
-						for (int X = 0; X < baseMaxTileDimension; X++)
-						{
-							int tileX = (X * baseWidthInTiles) / baseMaxTileDimension;
-							residencyData[Y * baseMaxTileDimension + X] = r->m_residencyShadow[face][tileY * baseWidthInTiles + tileX];
-						}
-					}
-
-					//Update face by face
-					D3D12_SUBRESOURCE_DATA data[1];
-					data[0].pData = &residencyData[0];
-					data[0].RowPitch = baseMaxTileDimension;
-					data[0].SlicePitch = baseMaxTileDimension; // 0
-
-					UpdateSubresources<1>(list, r->m_residencyResource.get(), r->m_residencyResourceUpload[frame_index].get(), 0, face, 1, data);
-				}
-			}
-
-			//Transition resources, make them ready for sampling
-			{
-				D3D12_RESOURCE_BARRIER barrier[2] = {};
-
-				for (auto i = 0U; i < 2; ++i)
-				{
-					barrier[i].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-					barrier[i].Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
-					barrier[i].Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
-					barrier[i].Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-				}
-
-				barrier[0].Transition.pResource = m_resources[0]->m_residencyResource.get();
-				barrier[1].Transition.pResource = m_resources[1]->m_residencyResource.get();
-
-				list->ResourceBarrier(2, barrier);
-			}
-		}
-
-
-		//Update Tiles
-		{
-
-			uint32_t totalTilesToCopy = 0;
-			// First copy data to the upload heap
-			for (auto&& perResourceArguments : coalescedUpdateTileArguments)
-			{
-				totalTilesToCopy += perResourceArguments.second.m_coordinates.size();
-			}
-
-			if (totalTilesToCopy > 0)
-
-			{
-				//Transition resources, make them ready for writing
-				{
-					D3D12_RESOURCE_BARRIER barrier[2] = {};
-
-					for (auto i = 0U; i < 2; ++i)
-					{
-						barrier[i].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-						barrier[i].Transition.StateBefore = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
-						barrier[i].Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_DEST;
-						barrier[i].Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-					}
-
-					barrier[0].Transition.pResource = m_resources[0]->m_resource.get();
-					barrier[1].Transition.pResource = m_resources[1]->m_resource.get();
-
-					list->ResourceBarrier(2, barrier);
-				}
-
-
-				{
-					uint64_t			uploadHeapOffset = 0;
-					ID3D12Resource1* heap = m_upload_heap[frame_index].get();
-
-
-					D3D12_RANGE range = { uploadHeapOffset,  uploadHeapOffset + SampleSettings::TileSizeInBytes * totalTilesToCopy };
-					uint8_t* heapData = nullptr;
-
-					m_upload_heap[frame_index]->Map(0, &range, reinterpret_cast<void**>(&heapData));
-
-					// Lay linear tiles one after the other in the heap offset
-					for (auto&& perResourceArguments : coalescedUpdateTileArguments)
-					{
-						auto r = perResourceArguments.first;
-
-						for (size_t i = 0; i < perResourceArguments.second.m_coordinates.size(); i++)
-						{
-							TrackedTile* trackedTile = perResourceArguments.second.m_tilesToUpdate[i];
-
-							std::memcpy(heapData + uploadHeapOffset, &trackedTile->m_tileData[0], SampleSettings::TileSizeInBytes);
-							uploadHeapOffset += SampleSettings::TileSizeInBytes;
-						}
-					}
-					m_upload_heap[frame_index]->Unmap(0, &range);
-
-
-					uploadHeapOffset = 0;
-					// Finally, copy the contents of the tiles mapped this frame.
-					for (auto perResourceArguments : coalescedUpdateTileArguments)
-					{
-						auto r = perResourceArguments.first;
-
-						for (size_t i = 0; i < perResourceArguments.second.m_coordinates.size(); i++)
-						{
-							D3D12_TILE_REGION_SIZE regionSize = { 1, FALSE, 0,0,0 };
-							D3D12_TILED_RESOURCE_COORDINATE coordinate = perResourceArguments.second.m_coordinates[i];
-
-							list->CopyTiles(r, &coordinate, &regionSize, heap, uploadHeapOffset, D3D12_TILE_COPY_FLAG_LINEAR_BUFFER_TO_SWIZZLED_TILED_RESOURCE);
-							uploadHeapOffset += SampleSettings::TileSizeInBytes;
-						}
-					}
-
-					// Cleanup tile data
-					for (auto perResourceArguments : coalescedUpdateTileArguments)
-					{
-						auto r = perResourceArguments.first;
-
-						for (size_t i = 0; i < perResourceArguments.second.m_coordinates.size(); i++)
-						{
-							TrackedTile* trackedTile = perResourceArguments.second.m_tilesToUpdate[i];
-							trackedTile->m_tileData.resize(0);
-						}
-					}
-
-
-					//Transition resources, make them ready for sampling
-					{
-						D3D12_RESOURCE_BARRIER barrier[2] = {};
-
-						for (auto i = 0U; i < 2; ++i)
-						{
-							barrier[i].Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-							barrier[i].Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
-							barrier[i].Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
-							barrier[i].Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-						}
-
-						barrier[0].Transition.pResource = m_resources[0]->m_resource.get();
-						barrier[1].Transition.pResource = m_resources[1]->m_resource.get();
-
-						list->ResourceBarrier(2, barrier);
-					}
-				}
-			}
-		}
+		m_backend->SetFrame(queue, list, frame_index);
+		m_policy->Update(samples, predicted, frame_number);
 	}
 }
 /*
@@ -10,6 +10,8 @@
 #include <d3d12.h>
 
 #include "tile_loader.h"
+#include "d3d12_residency_backend.h"
+#include "residency_policy.h"
 #include "samples.h"
 
 namespace sample
@@ -23,7 +25,7 @@ namespace sample
         std::vector<D3D12_SUBRESOURCE_TILING>				m_subresourceTilings;
         
 		std::unique_ptr<TileLoader>							m_loader;						//loader of binary data
-        std::vector<uint8_t>								m_residencyShadow[6];			//six cube faces, holding the mip level of every tile
+		std::vector<ResidencyUpload>						m_residencyUploads;				//boxes of the residency texture, which changed this frame
 
 		uint32_t											m_totalTiles;					//total tile in the virtual resource
 
@@ -35,48 +37,6 @@ namespace sample
 		winrt::com_ptr<ID3D12Resource1>						m_residencyResourceUpload[2];	//two heaps per frame, which are used to upload the 
     };
 
-    // Unique identifier for a tile.
-    struct TileKey
-    {
-        D3D12_TILED_RESOURCE_COORDINATE m_coordinate;
-		ID3D12Resource1*				m_resource;
-    };
-
-    // Define the < relational operator for use as a key in std::map.
-    inline bool operator <(const TileKey & a, const TileKey & b)
-    {
-        if (a.m_resource < b.m_resource) return true;
-        if (a.m_resource > b.m_resource) return false;
-        if (a.m_coordinate.Subresource < b.m_coordinate.Subresource) return true;
-        if (a.m_coordinate.Subresource > b.m_coordinate.Subresource) return false;
-        if (a.m_coordinate.Z < b.m_coordinate.Z) return true;
-        if (a.m_coordinate.Z > b.m_coordinate.Z) return false;
-        if (a.m_coordinate.Y < b.m_coordinate.Y) return true;
-        if (a.m_coordinate.Y > b.m_coordinate.Y) return false;
-        return a.m_coordinate.X < b.m_coordinate.X;
-    }
-
-    enum class TileState
-    {
-        Seen,
-        Loading,
-        Loaded,
-        Mapped,
-		NotDefined
-    };
-
-    struct TrackedTile
-    {
-        ManagedTiledResource*				m_managedResource = nullptr;
-		D3D12_TILED_RESOURCE_COORDINATE		m_coordinate = {};
-        uint16_t							m_mipLevel = 0;
-        uint16_t							m_face = 0;
-		uint32_t							m_physicalTileOffset = 0;
-        uint32_t							m_lastSeen = 0;
-        std::vector<uint8_t>				m_tileData;
-        TileState							m_state = TileState::NotDefined;
-    };
-
 	struct ResidencyManagerCreateContext
 	{
 		ID3D12Device1* m_device;
@@ -103,9 +63,12 @@ namespace sample
 
         ResidencyManager(ID3D12Device1* d);
 
+		// Stops the tile loaders before the policy goes, their loads in flight complete into the tiles of the policy.
+		~ResidencyManager();
+
 		ResidencyManagerCreateResult CreateResidencyManager(const ResidencyManagerCreateContext& ctx);
 
-		void UpdateTiles(ID3D12CommandQueue* queue, ID3D12GraphicsCommandList* list, uint32_t frame_index, uint32_t frame_number, const std::vector<DecodedSample>& samples);
+		void UpdateTiles(ID3D12CommandQueue* queue, ID3D12GraphicsCommandList* list, uint32_t frame_index, uint32_t frame_number, const std::vector<DecodedSample>& samples, const std::vector<DecodedSample>& predicted);
 		void ResetInitialData(ID3D12CommandQueue* queue, ID3D12GraphicsCommandList* list, uint32_t frame_index);
 
 		ID3D12Resource1* Diffuse();
@@ -123,61 +86,12 @@ namespace sample
         // Tiled Resource tile pool.
         //Microsoft::WRL::ComPtr<ID3D11Buffer> m_tilePool;
 
-        // Map of all tracked tiles.
-        std::map<TileKey, std::unique_ptr<TrackedTile> >	m_trackedTiles;
-
-        // List of seen tiles ready for loading.
-        std::list<TrackedTile*>								m_seenTileList;
-
-        // List of loading and loaded tiles.
-        std::list<TrackedTile*>								m_loadingTileList;
-
-        // List of mapped tiles.
-        std::list<TrackedTile*>								m_mappedTileList;
-
-		std::atomic<uint32_t>								m_active_tile_loading_operations;
-
-        uint32_t m_reservedTiles = 1;
-		uint32_t m_defaultTileIndex = 0;
+        // The d3d12 side of the residency policy, which decides what is mapped.
+        std::unique_ptr<D3D12ResidencyBackend>				m_backend;
+        std::unique_ptr<ResidencyPolicy>					m_policy;
 
 		winrt::com_ptr<ID3D12Resource1> m_upload_heap[2];   //to upload new tiles to the gpu, one per frame, must be able to have memory for all our uploads
 		winrt::com_ptr<ID3D12Heap>		m_physical_heap;	//to backup the reserved resources;
 		winrt::com_ptr<ID3D12Resource1> m_null_resource;
-
-		void ProcessSamples(const std::vector<DecodedSample>& samples, uint32_t frame_number);
     };
-
-	static bool LoadPredicate(const TrackedTile* a, const TrackedTile* b)
-    {
-        // Prefer more recently seen tiles.
-        if (a->m_lastSeen > b->m_lastSeen) return true;
-        if (a->m_lastSeen < b->m_lastSeen) return false;
-
-        // Break ties by loading less detailed tiles first.
-        return a->m_mipLevel > b->m_mipLevel;
-    }
-
-	static bool MapPredicate(const TrackedTile* a, const TrackedTile* b)
-    {
-        // Only loaded tiles can be mapped, so put those first.
-        if (a->m_state == TileState::Loaded && b->m_state == TileState::Loading) return true;
-        if (a->m_state == TileState::Loading && b->m_state == TileState::Loaded) return false;
-
-        // Then prefer more recently seen tiles.
-        if (a->m_lastSeen > b->m_lastSeen) return true;
-        if (a->m_lastSeen < b->m_lastSeen) return false;
-
-        // Break ties by mapping less detailed tiles first.
-        return a->m_mipLevel > b->m_mipLevel;
-    }
-
-	static bool EvictPredicate(const TrackedTile* a, const TrackedTile* b)
-    {
-        // Evict older tiles first.
-        if (a->m_lastSeen < b->m_lastSeen) return true;
-        if (a->m_lastSeen > b->m_lastSeen) return false;
-
-        // To break ties, evict more detailed tiles first.
-        return a->m_mipLevel < b->m_mipLevel;
-    }
 }
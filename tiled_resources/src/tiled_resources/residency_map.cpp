@@ -0,0 +1,255 @@
+#include "pch.h"
+#include "residency_map.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace sample
+{
+	void ResidencyMap::Create(const D3D12_SUBRESOURCE_TILING* tilings, uint32_t mips)
+	{
+		m_width		= tilings[0].WidthInTiles;
+		m_height	= tilings[0].HeightInTiles;
+
+		m_levels.resize(mips);
+
+		uint32_t offset = 0;
+
+		for (auto mip = 0U; mip < mips; ++mip)
+		{
+			Level& l = m_levels[mip];
+
+			l.m_width		= tilings[mip].WidthInTiles;
+			l.m_height		= tilings[mip].HeightInTiles;
+			l.m_coverWidth	= m_width / l.m_width;
+			l.m_coverHeight	= m_height / l.m_height;
+			l.m_offset		= offset;
+
+			offset += l.m_width * l.m_height;
+		}
+
+		for (auto face = 0U; face < 6U; ++face)
+		{
+			m_mapped[face].assign(offset, 0);
+			m_faces[face].assign(m_width * m_height, 0xFF);
+			m_dirty[face] = Rect();
+			m_changed[face] = Rect();
+		}
+	}
+
+	void ResidencyMap::Map(uint32_t face, uint32_t mip, uint32_t x, uint32_t y)
+	{
+		SetMapped(face, mip, x, y, 1);
+	}
+
+	void ResidencyMap::Unmap(uint32_t face, uint32_t mip, uint32_t x, uint32_t y)
+	{
+		SetMapped(face, mip, x, y, 0);
+	}
+
+	bool ResidencyMap::IsMapped(uint32_t face, uint32_t mip, uint32_t x, uint32_t y) const
+	{
+		const Level& l = m_levels[mip];
+		return m_mapped[face][l.m_offset + y * l.m_width + x] != 0;
+	}
+
+	bool ResidencyMap::MappedChild(uint32_t face, uint32_t mip, uint32_t x, uint32_t y, uint32_t& childX, uint32_t& childY) const
+	{
+		if (mip == 0)
+		{
+			return false;
+		}
+
+		const Level& l = m_levels[mip];
+		const Level& c = m_levels[mip - 1];
+
+		// The tiles of the child mip, which cover the tiles of the most detailed mip the tile covers.
+		const uint32_t x0 = x * l.m_coverWidth / c.m_coverWidth;
+		const uint32_t y0 = y * l.m_coverHeight / c.m_coverHeight;
+		const uint32_t x1 = std::min(c.m_width, ((x + 1) * l.m_coverWidth + c.m_coverWidth - 1) / c.m_coverWidth);
+		const uint32_t y1 = std::min(c.m_height, ((y + 1) * l.m_coverHeight + c.m_coverHeight - 1) / c.m_coverHeight);
+
+		for (auto cy = y0; cy < y1; ++cy)
+		{
+			for (auto cx = x0; cx < x1; ++cx)
+			{
+				if (m_mapped[face][c.m_offset + cy * c.m_width + cx] != 0)
+				{
+					childX = cx;
+					childY = cy;
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+	void ResidencyMap::SetMapped(uint32_t face, uint32_t mip, uint32_t x, uint32_t y, uint8_t mapped)
+	{
+		const Level& l = m_levels[mip];
+
+		m_mapped[face][l.m_offset + y * l.m_width + x] = mapped;
+
+		// Grow the dirty rectangle by the tiles the tile covers.
+		Rect r;
+
+		r.m_left	= x * l.m_coverWidth;
+		r.m_top		= y * l.m_coverHeight;
+		r.m_right	= r.m_left + l.m_coverWidth;
+		r.m_bottom	= r.m_top + l.m_coverHeight;
+
+		Grow(m_dirty[face], r);
+	}
+
+	void ResidencyMap::Grow(Rect& d, const Rect& r)
+	{
+		if (d.m_left == d.m_right)
+		{
+			d = r;
+		}
+		else
+		{
+			d.m_left	= std::min(d.m_left, r.m_left);
+			d.m_top		= std::min(d.m_top, r.m_top);
+			d.m_right	= std::max(d.m_right, r.m_right);
+			d.m_bottom	= std::max(d.m_bottom, r.m_bottom);
+		}
+	}
+
+	void ResidencyMap::Update()
+	{
+		for (auto face = 0U; face < 6U; ++face)
+		{
+			if (m_dirty[face].m_left != m_dirty[face].m_right)
+			{
+				Rebuild(face, m_dirty[face]);
+				Grow(m_changed[face], m_dirty[face]);
+				m_dirty[face] = Rect();
+			}
+		}
+	}
+
+	void ResidencyMap::Invalidate()
+	{
+		for (auto face = 0U; face < 6U; ++face)
+		{
+			m_changed[face].m_left		= 0;
+			m_changed[face].m_top		= 0;
+			m_changed[face].m_right		= m_width;
+			m_changed[face].m_bottom	= m_height;
+		}
+	}
+
+	uint64_t ResidencyMap::CollectUploads(uint32_t dimension, std::vector<ResidencyUpload>& uploads)
+	{
+		Update();
+
+		uploads.clear();
+
+		uint64_t size = 0;
+
+		for (auto face = 0U; face < 6U; ++face)
+		{
+			const Rect& c = m_changed[face];
+
+			if (c.m_left == c.m_right)
+			{
+				continue;
+			}
+
+			// The texels, which sample the changed tiles: the texel X samples the tile X * width / dimension.
+			ResidencyUpload u;
+
+			u.m_face		= face;
+			u.m_left		= (c.m_left * dimension + m_width - 1) / m_width;
+			u.m_top			= (c.m_top * dimension + m_height - 1) / m_height;
+			u.m_right		= (c.m_right * dimension + m_width - 1) / m_width;
+			u.m_bottom		= (c.m_bottom * dimension + m_height - 1) / m_height;
+			u.m_rowPitch	= (u.m_right - u.m_left + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+			u.m_offset		= (size + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) & ~static_cast<uint64_t>(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+
+			m_changed[face] = Rect();
+
+			if (u.m_left == u.m_right || u.m_top == u.m_bottom)
+			{
+				continue;
+			}
+
+			// The last row is not padded, like the footprints of GetCopyableFootprints.
+			size = u.m_offset + static_cast<uint64_t>(u.m_rowPitch) * (u.m_bottom - u.m_top - 1) + (u.m_right - u.m_left);
+			uploads.push_back(u);
+		}
+
+		return size;
+	}
+
+	void ResidencyMap::WriteUpload(const ResidencyUpload& u, uint32_t dimension, uint8_t* upload) const
+	{
+		const uint8_t*	values	= m_faces[u.m_face].data();
+		uint8_t*		row		= upload + u.m_offset;
+
+		for (auto y = u.m_top; y < u.m_bottom; ++y, row += u.m_rowPitch)
+		{
+			const uint8_t* tiles = values + (y * m_height / dimension) * m_width;
+
+			if (dimension == m_width)
+			{
+				std::memcpy(row, tiles + u.m_left, u.m_right - u.m_left);
+				continue;
+			}
+
+			for (auto x = u.m_left; x < u.m_right; ++x)
+			{
+				row[x - u.m_left] = tiles[x * m_width / dimension];
+			}
+		}
+	}
+
+	// Fills the rectangle with "none", then every mapped tile over it from the least to the most detailed mip, so the most detailed
+	// mapped mip is written last. The rows are filled with memset, which the runtime vectorizes.
+	void ResidencyMap::Rebuild(uint32_t face, const Rect& r)
+	{
+		uint8_t*		values	= m_faces[face].data();
+		const uint32_t	width	= r.m_right - r.m_left;
+
+		for (auto y = r.m_top; y < r.m_bottom; ++y)
+		{
+			std::memset(values + y * m_width + r.m_left, 0xFF, width);
+		}
+
+		for (auto mip = static_cast<uint32_t>(m_levels.size()); mip > 0; --mip)
+		{
+			const Level&	l		= m_levels[mip - 1];
+			const uint8_t*	mapped	= m_mapped[face].data() + l.m_offset;
+			const uint8_t	value	= static_cast<uint8_t>((mip - 1) * 16);
+
+			// The tiles of the mip over the rectangle.
+			const uint32_t x0 = r.m_left / l.m_coverWidth;
+			const uint32_t y0 = r.m_top / l.m_coverHeight;
+			const uint32_t x1 = std::min(l.m_width - 1, (r.m_right - 1) / l.m_coverWidth);
+			const uint32_t y1 = std::min(l.m_height - 1, (r.m_bottom - 1) / l.m_coverHeight);
+
+			for (auto y = y0; y <= y1; ++y)
+			{
+				for (auto x = x0; x <= x1; ++x)
+				{
+					if (mapped[y * l.m_width + x] == 0)
+					{
+						continue;
+					}
+
+					const uint32_t left		= std::max(r.m_left, x * l.m_coverWidth);
+					const uint32_t right	= std::min(r.m_right, (x + 1) * l.m_coverWidth);
+					const uint32_t top		= std::max(r.m_top, y * l.m_coverHeight);
+					const uint32_t bottom	= std::min(r.m_bottom, (y + 1) * l.m_coverHeight);
+
+					for (auto row = top; row < bottom; ++row)
+					{
+						std::memset(values + row * m_width + left, value, right - left);
+					}
+				}
+			}
+		}
+	}
+}
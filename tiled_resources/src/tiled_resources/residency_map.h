@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "residency_types.h"
+
+namespace sample
+{
+	// A box of a face of the residency texture, which changed since the last upload, and the place of its rows in the upload buffer.
+	struct ResidencyUpload
+	{
+		uint32_t	m_face;
+		uint32_t	m_left;					//texels, right and bottom exclusive
+		uint32_t	m_top;
+		uint32_t	m_right;
+		uint32_t	m_bottom;
+		uint32_t	m_rowPitch;
+		uint64_t	m_offset;
+	};
+
+	// The residency of the six faces of a managed resource: a pyramid of mapped flags, one level per mip and one flag per tile,
+	// and the flattened faces the residency texture is uploaded from, one byte per tile of the most detailed mip holding 16 times
+	// the most detailed mapped mip over it, 0xFF for none. Mapping and evicting a tile set one flag and grow the dirty rectangle
+	// of the face. Update rebuilds the dirty rectangles only, with a row fill per mapped tile, so evicting a tile of a less
+	// detailed mip does not cost a loop over the thousands of tiles it covers.
+	class ResidencyMap
+	{
+		public:
+
+		// The tilings of the mips of one face.
+		void Create(const D3D12_SUBRESOURCE_TILING* tilings, uint32_t mips);
+
+		uint32_t Width() const	{ return m_width; }
+		uint32_t Height() const	{ return m_height; }
+
+		void Map(uint32_t face, uint32_t mip, uint32_t x, uint32_t y);
+		void Unmap(uint32_t face, uint32_t mip, uint32_t x, uint32_t y);
+		bool IsMapped(uint32_t face, uint32_t mip, uint32_t x, uint32_t y) const;
+
+		// A mapped tile of mip - 1 under the tile, in x, y. False, if there is none or mip is 0.
+		bool MappedChild(uint32_t face, uint32_t mip, uint32_t x, uint32_t y, uint32_t& childX, uint32_t& childY) const;
+
+		// Rebuilds the dirty rectangles of the flattened faces.
+		void Update();
+
+		// The next CollectUploads uploads the faces whole.
+		void Invalidate();
+
+		// Updates the faces and returns the boxes of the texture, which changed since the last call, for a texture of dimension x
+		// dimension texels the faces are stretched to. The rows are aligned to D3D12_TEXTURE_DATA_PITCH_ALIGNMENT and the boxes
+		// to D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT in the upload buffer. Returns the bytes of the upload buffer used.
+		uint64_t CollectUploads(uint32_t dimension, std::vector<ResidencyUpload>& uploads);
+
+		// Writes the texels of the box to upload + u.m_offset.
+		void WriteUpload(const ResidencyUpload& u, uint32_t dimension, uint8_t* upload) const;
+
+		// The flattened face, Width() x Height() bytes, current after Update.
+		const uint8_t* Face(uint32_t face) const { return m_faces[face].data(); }
+
+		private:
+
+		// A tile of a mip covers m_coverWidth x m_coverHeight tiles of the most detailed mip.
+		struct Level
+		{
+			uint32_t	m_width;
+			uint32_t	m_height;
+			uint32_t	m_coverWidth;
+			uint32_t	m_coverHeight;
+			uint32_t	m_offset;				//of the flags of the level in m_mapped
+		};
+
+		// Tiles of the most detailed mip, right and bottom exclusive. Empty, when left == right.
+		struct Rect
+		{
+			uint32_t	m_left		= 0;
+			uint32_t	m_top		= 0;
+			uint32_t	m_right		= 0;
+			uint32_t	m_bottom	= 0;
+		};
+
+		std::vector<Level>		m_levels;
+		std::vector<uint8_t>	m_mapped[6];
+		std::vector<uint8_t>	m_faces[6];
+		Rect					m_dirty[6];				//to rebuild
+		Rect					m_changed[6];			//rebuilt since the last upload
+		uint32_t				m_width		= 0;
+		uint32_t				m_height	= 0;
+
+		void SetMapped(uint32_t face, uint32_t mip, uint32_t x, uint32_t y, uint8_t mapped);
+		void Rebuild(uint32_t face, const Rect& r);
+		static void Grow(Rect& d, const Rect& r);
+	};
+}
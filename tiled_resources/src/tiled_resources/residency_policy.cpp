@@ -0,0 +1,331 @@
+#include "pch.h"
+#include "residency_policy.h"
+#include "feedback_tiles.h"
+
+namespace sample
+{
+	ResidencyPolicy::ResidencyPolicy(ResidencyBackend* backend, const ResidencyPolicySettings& settings) :
+		m_backend(backend)
+		, m_settings(settings)
+		, m_eviction(CreateEvictionPolicy(settings.m_eviction, settings.m_poolSizeInTiles - settings.m_reservedTiles))
+		, m_active_tile_loading_operations(0)
+	{
+
+	}
+
+	uint32_t ResidencyPolicy::AddResource(const D3D12_SUBRESOURCE_TILING* tilings, uint32_t mips)
+	{
+		auto r = std::make_unique<Resource>();
+
+		r->m_tilings.assign(tilings, tilings + 6 * mips);
+		r->m_mips = mips;
+
+		//Set up the shadow residency buffer to point to no mip, the streaming system updates it
+		r->m_residency.Create(tilings, mips);
+
+		m_resources.push_back(std::move(r));
+		return static_cast<uint32_t>(m_resources.size() - 1);
+	}
+
+	void ResidencyPolicy::ProcessSamples(const std::vector<DecodedSample> & samples, uint32_t frame_number)
+	{
+		if (!samples.empty())
+		{
+			// Interpret the samples in the context of each managed resource.
+			for (auto resourceIndex = 0U; resourceIndex < m_resources.size(); ++resourceIndex)
+			{
+				const auto& resource = m_resources[resourceIndex];
+
+				// Every tile the samples hit, from the sampled MIP through the least detailed MIP, once.
+				CollectSampledTiles(samples, resourceIndex, resource->m_tilings.data(), resource->m_mips, m_sampledTiles, m_sampledTilesScratch);
+
+				for (auto&& tileKey : m_sampledTiles)
+				{
+					// See if the tile is already being tracked.
+					TrackedTile* tile = m_trackedTiles.find(tileKey);
+					if (tile == nullptr)
+					{
+						// Tile is not being tracked currently, so enqueue it for load.
+						tile = Track(tileKey, resourceIndex, frame_number);
+						tile->m_state = TileState::Seen;
+
+						m_seenTileQueue.push(tile);
+					}
+					else if (tile->m_state == TileState::Predicted)
+					{
+						// The prediction was right before the load started, the tile loads as a seen one.
+						m_predictedTileQueue.remove(tile);
+
+						tile->m_lastSeen = frame_number;
+						tile->m_state = TileState::Seen;
+						tile->m_predicted = false;
+
+						m_seenTileQueue.push(tile);
+					}
+					else
+					{
+						if (tile->m_predicted)
+						{
+							tile->m_predicted = false;
+							m_statistics.m_prefetchesSeen++;
+						}
+
+						if (tile->m_lastSeen != frame_number)
+						{
+							// If tile is already tracked, update the last-seen value and move it in the queue of its state.
+							switch (tile->m_state)
+							{
+								case TileState::Seen:	m_seenTileQueue.touch(tile, frame_number); break;
+								case TileState::Mapped:	m_eviction->Touch(tile, frame_number); break;
+								default:
+									if (tile->m_bucket != nullptr)
+									{
+										m_loadedTileQueue.touch(tile, frame_number);
+									}
+									else
+									{
+										tile->m_lastSeen = frame_number;
+									}
+									break;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+
+	// The tiles of the predicted samples, which are not tracked, are tracked as predicted ones. The tiles, which are predicted
+	// again, move in the queue, the other states keep their place, the prediction must not delay an eviction.
+	void ResidencyPolicy::ProcessPredictions(const std::vector<DecodedSample>& predicted, uint32_t frame_number)
+	{
+		if (!predicted.empty())
+		{
+			for (auto resourceIndex = 0U; resourceIndex < m_resources.size(); ++resourceIndex)
+			{
+				const auto& resource = m_resources[resourceIndex];
+
+				CollectSampledTiles(predicted, resourceIndex, resource->m_tilings.data(), resource->m_mips, m_sampledTiles, m_sampledTilesScratch);
+
+				for (auto&& tileKey : m_sampledTiles)
+				{
+					TrackedTile* tile = m_trackedTiles.find(tileKey);
+
+					if (tile == nullptr)
+					{
+						tile = Track(tileKey, resourceIndex, frame_number);
+						tile->m_state = TileState::Predicted;
+						tile->m_predicted = true;
+
+						m_predictedTileQueue.push(tile);
+					}
+					else if (tile->m_state == TileState::Predicted && tile->m_lastSeen != frame_number)
+					{
+						m_predictedTileQueue.touch(tile, frame_number);
+					}
+				}
+			}
+		}
+
+		// Drop the predicted tiles, which the camera turned away from.
+		while (!m_predictedTileQueue.empty() && m_predictedTileQueue.oldest()->m_lastSeen + m_settings.m_predictionLifetimeInFrames < frame_number)
+		{
+			m_trackedTiles.erase(m_predictedTileQueue.pop_oldest());
+		}
+	}
+
+	TrackedTile* ResidencyPolicy::Track(TileKey tileKey, uint32_t resourceIndex, uint32_t frame_number)
+	{
+		const uint32_t	mips		= m_resources[resourceIndex]->m_mips;
+		const uint32_t	subResource	= TileKeySubresource(tileKey);
+		TrackedTile*	tile		= m_trackedTiles.insert(tileKey);
+
+		tile->m_resource = resourceIndex;
+		tile->m_coordinate.Subresource = subResource;
+		tile->m_coordinate.X = TileKeyX(tileKey);
+		tile->m_coordinate.Y = TileKeyY(tileKey);
+		tile->m_lastSeen = frame_number;
+		tile->m_mipLevel = static_cast<uint16_t>(subResource % mips);
+		tile->m_face = static_cast<uint16_t>(subResource / mips);
+
+		return tile;
+	}
+
+	void ResidencyPolicy::Load(TrackedTile* tile)
+	{
+		// Update sets Loaded, once it takes the completion of the load.
+		tile->m_state = TileState::Loading;
+		m_active_tile_loading_operations++;
+		m_statistics.m_loads++;
+
+		// Move the tile to the loading list.
+		m_loadingTileList.push_back(tile);
+
+		m_backend->LoadTile(tile->m_resource, tile->m_coordinate, [this, tile](std::vector<uint8_t> tileData)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_completedLoadsLock);
+				m_completedLoads.push_back({ tile, std::move(tileData) });
+			}
+
+			m_active_tile_loading_operations--;
+		});
+	}
+
+	// Move the tiles, which completed their loads, to the loaded queue. The list holds the tiles in flight only.
+	void ResidencyPolicy::DeliverCompletedLoads()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_completedLoadsLock);
+			m_completedLoads.swap(m_deliveredLoads);
+		}
+
+		for (auto&& load : m_deliveredLoads)
+		{
+			TrackedTile* tile = load.m_tile;
+
+			tile->m_tileData = std::move(load.m_tileData);
+			tile->m_state = TileState::Loaded;
+
+			m_loadingTileList.remove(tile);
+			m_loadedTileQueue.push(tile);
+		}
+
+		m_deliveredLoads.clear();
+	}
+
+	// The most detailed mapped tile under the tile, or the tile. Evicting it keeps the less detailed mips of every mapped tile
+	// mapped, which the sampling of a mip between two mapped ones needs, whichever tile the eviction policy picks.
+	TrackedTile* ResidencyPolicy::MappedDescendant(TrackedTile* tile) const
+	{
+		const auto&	resource	= m_resources[tile->m_resource];
+		uint32_t	x			= 0;
+		uint32_t	y			= 0;
+
+		while (resource->m_residency.MappedChild(tile->m_face, tile->m_mipLevel, tile->m_coordinate.X, tile->m_coordinate.Y, x, y))
+		{
+			const uint32_t	subResource	= tile->m_face * resource->m_mips + tile->m_mipLevel - 1;
+			TrackedTile*	child		= m_trackedTiles.find(MakeTileKey(tile->m_resource, subResource, x, y));
+
+			if (child == nullptr || child->m_state != TileState::Mapped)
+			{
+				break;
+			}
+
+			tile = child;
+		}
+
+		return tile;
+	}
+
+	void ResidencyPolicy::Update(const std::vector<DecodedSample>& samples, uint32_t frame_number)
+	{
+		static const std::vector<DecodedSample> none;
+
+		Update(samples, none, frame_number);
+	}
+
+	void ResidencyPolicy::Update(const std::vector<DecodedSample>& samples, const std::vector<DecodedSample>& predicted, uint32_t frame_number)
+	{
+		DeliverCompletedLoads();
+		ProcessSamples(samples, frame_number);
+		ProcessPredictions(predicted, frame_number);
+
+		// Initiate loads for seen tiles, the most recently seen first.
+		for (auto i = m_active_tile_loading_operations.load(); i < m_settings.m_maxSimultaneousFileLoadTasks; i++)
+		{
+			if (m_seenTileQueue.empty())
+			{
+				break;
+			}
+
+			Load(m_seenTileQueue.pop_newest());
+		}
+
+		// Load predicted tiles with the slots the tiles seen this frame leave, the least detailed ones of the latest prediction
+		// first. They go before the seen tiles of older frames, which the camera may have left.
+		for (auto i = 0U; i < m_settings.m_maxPrefetchLoadsPerFrame; i++)
+		{
+			const bool seenWaits = !m_seenTileQueue.empty() && m_seenTileQueue.newest()->m_lastSeen == frame_number;
+
+			if (seenWaits || m_predictedTileQueue.empty() || m_active_tile_loading_operations.load() >= m_settings.m_maxSimultaneousFileLoadTasks)
+			{
+				break;
+			}
+
+			Load(m_predictedTileQueue.pop_newest());
+			m_statistics.m_prefetches++;
+		}
+
+		// Map the loaded tiles, the most recently seen first.
+		for (auto i = 0U; i < m_settings.m_maxTilesLoadedPerFrame; i++)
+		{
+			if (m_loadedTileQueue.empty())
+			{
+				break;
+			}
+
+			// This sample's residency management assumes that for a given texcoord,
+			// there will never be a detailed MIP resident where a less detailed one
+			// is NULL-mapped. This is enforced by the queue order, which maps less
+			// detailed tiles of a frame first, and by the eviction, which takes the
+			// most detailed mapped tile under the victim of the eviction policy.
+			auto tileToMap = m_loadedTileQueue.pop_newest();
+
+			// Default to assigning tiles to the first available tile.
+			uint32_t physicalTileOffset = m_settings.m_reservedTiles + static_cast<uint32_t>(m_eviction->size());
+
+			if (m_eviction->size() + m_settings.m_reservedTiles == m_settings.m_poolSizeInTiles)
+			{
+				// Tile pool is full, need to unmap something.
+				auto tileToEvict = MappedDescendant(m_eviction->Victim());
+
+				if (tileToMap->m_lastSeen < tileToEvict->m_lastSeen || (tileToMap->m_predicted && tileToEvict->m_lastSeen == frame_number))
+				{
+					// If the candidate tile to map is older than the eviction candidate,
+					// skip the mapping and discard it. This can occur if a tile load stalls,
+					// and by the time it is ready it has moved off-screen. A predicted tile
+					// does not evict a tile the samples of this frame see.
+					// Remove the tile from the tracked list, it was already taken out of the loaded queue.
+					m_trackedTiles.erase(tileToMap);
+					m_statistics.m_discards++;
+
+					// Move on to the next map candidate.
+					continue;
+				}
+
+				m_eviction->Evict(tileToEvict);
+
+				// Save the physical tile that was freed so the new tile can use it.
+				physicalTileOffset = tileToEvict->m_physicalTileOffset;
+
+				// NULL-map the tile and update the residency map to remove this level of detail.
+				m_backend->UnmapTile(tileToEvict->m_resource, tileToEvict->m_coordinate, physicalTileOffset);
+				m_resources[tileToEvict->m_resource]->m_residency.Unmap(tileToEvict->m_face, tileToEvict->m_mipLevel, tileToEvict->m_coordinate.X, tileToEvict->m_coordinate.Y);
+				m_statistics.m_evictions++;
+
+				// Remove the tile from the tracked list.
+				m_trackedTiles.erase(tileToEvict);
+			}
+
+			// Map the tile, upload its data and update the residency map to add this level of detail.
+			m_backend->MapTile(tileToMap->m_resource, tileToMap->m_coordinate, physicalTileOffset);
+			m_backend->UploadTile(tileToMap->m_resource, tileToMap->m_coordinate, std::move(tileToMap->m_tileData));
+			m_resources[tileToMap->m_resource]->m_residency.Map(tileToMap->m_face, tileToMap->m_mipLevel, tileToMap->m_coordinate.X, tileToMap->m_coordinate.Y);
+			m_statistics.m_maps++;
+
+			tileToMap->m_tileData = std::vector<uint8_t>();
+			tileToMap->m_physicalTileOffset = physicalTileOffset;
+			tileToMap->m_state = TileState::Mapped;
+
+			m_eviction->Insert(tileToMap);
+		}
+
+		for (auto resourceIndex = 0U; resourceIndex < m_resources.size(); ++resourceIndex)
+		{
+			m_backend->UpdateResidencyMap(resourceIndex, m_resources[resourceIndex]->m_residency);
+		}
+
+		m_backend->Submit();
+	}
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "eviction_policy.h"
+#include "residency_backend.h"
+#include "residency_map.h"
+#include "residency_types.h"
+#include "samples.h"
+#include "tile_queue.h"
+#include "tile_table.h"
+#include "tracked_tile.h"
+
+namespace sample
+{
+	struct ResidencyPolicySettings
+	{
+		uint32_t	m_poolSizeInTiles				= 1024;
+		uint32_t	m_reservedTiles					= 1;		//physical tiles at the start of the pool, which are not streamed
+		uint32_t	m_maxSimultaneousFileLoadTasks	= 10;
+		uint32_t	m_maxTilesLoadedPerFrame		= 100;
+		uint32_t	m_maxPrefetchLoadsPerFrame		= 2;		//loads of predicted tiles, once no seen tile waits
+		uint32_t	m_predictionLifetimeInFrames	= 4;		//predicted tiles, which are not predicted again, are dropped after it
+		EvictionPolicySettings	m_eviction;
+	};
+
+	// Counters since the policy was created.
+	struct ResidencyPolicyStatistics
+	{
+		uint64_t	m_loads				= 0;		//tile loads started
+		uint64_t	m_maps				= 0;
+		uint64_t	m_evictions			= 0;
+		uint64_t	m_discards			= 0;		//loaded tiles, which were older than the eviction candidate
+		uint64_t	m_prefetches		= 0;		//loads of predicted tiles
+		uint64_t	m_prefetchesSeen	= 0;		//predicted tiles, which a sample saw after their load started
+	};
+
+	// Decides from the samples of the frames, which tiles of the managed resources are loaded, mapped and evicted. The loads,
+	// the mappings and the uploads go through the backend, so the policy builds and runs without d3d12.
+	class ResidencyPolicy
+	{
+		public:
+
+		ResidencyPolicy(ResidencyBackend* backend, const ResidencyPolicySettings& settings);
+
+		// The tilings of the subresources of a cube texture, the mips of the faces one after the other. Returns the index of the
+		// resource, which is the resource of the samples and the backend calls.
+		uint32_t AddResource(const D3D12_SUBRESOURCE_TILING* tilings, uint32_t mips);
+
+		void Update(const std::vector<DecodedSample>& samples, uint32_t frame_number);
+
+		// The predicted samples are the feedback of the frames ahead. Their tiles load at a lower priority than the seen ones and
+		// under the prefetch budget of the settings.
+		void Update(const std::vector<DecodedSample>& samples, const std::vector<DecodedSample>& predicted, uint32_t frame_number);
+
+		ResidencyMap& Residency(uint32_t resource)				{ return m_resources[resource]->m_residency; }
+		const ResidencyPolicyStatistics& Statistics() const		{ return m_statistics; }
+		const EvictionPolicy& Eviction() const					{ return *m_eviction; }
+		size_t MappedTiles() const								{ return m_eviction->size(); }
+		size_t TrackedTiles() const								{ return m_trackedTiles.size(); }
+
+		private:
+
+		struct Resource
+		{
+			std::vector<D3D12_SUBRESOURCE_TILING>	m_tilings;
+			uint32_t								m_mips = 0;
+			ResidencyMap							m_residency;
+		};
+
+		ResidencyBackend*									m_backend;
+		ResidencyPolicySettings								m_settings;
+		ResidencyPolicyStatistics							m_statistics;
+		std::vector<std::unique_ptr<Resource>>				m_resources;
+
+        // Table of all tracked tiles.
+        TileTable<TrackedTile>								m_trackedTiles;
+
+        // Queue of seen tiles ready for loading.
+        TileQueue<TrackedTile>								m_seenTileQueue;
+
+        // Queue of predicted tiles, which load when no seen tile waits.
+        TileQueue<TrackedTile>								m_predictedTileQueue;
+
+        // List of tiles, which are loading. They move to the loaded queue, once Update takes their completed load.
+        TileList<TrackedTile>								m_loadingTileList;
+
+        // Queue of loaded tiles ready for mapping.
+        TileQueue<TrackedTile>								m_loadedTileQueue;
+
+        // Mapped tiles, in the order of the eviction policy.
+        std::unique_ptr<EvictionPolicy>						m_eviction;
+
+		// Keys of the tiles the samples of a frame hit, kept between frames.
+		std::vector<TileKey>								m_sampledTiles;
+		std::vector<TileKey>								m_sampledTilesScratch;
+
+		std::atomic<uint32_t>								m_active_tile_loading_operations;
+
+		// Loads, which completed on the threads of the backend. Update takes them under the lock and changes the tiles on its
+		// own thread, so the completions do not write tiles, which Update reads.
+		struct CompletedLoad
+		{
+			TrackedTile*			m_tile;
+			std::vector<uint8_t>	m_tileData;
+		};
+
+		std::mutex											m_completedLoadsLock;
+		std::vector<CompletedLoad>							m_completedLoads;
+		std::vector<CompletedLoad>							m_deliveredLoads;
+
+		void ProcessSamples(const std::vector<DecodedSample>& samples, uint32_t frame_number);
+		void ProcessPredictions(const std::vector<DecodedSample>& predicted, uint32_t frame_number);
+		TrackedTile* Track(TileKey key, uint32_t resourceIndex, uint32_t frame_number);
+		void Load(TrackedTile* tile);
+		void DeliverCompletedLoads();
+		TrackedTile* MappedDescendant(TrackedTile* tile) const;
+	};
+}
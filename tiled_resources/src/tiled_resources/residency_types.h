@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(_WIN32)
+
+#include <d3d12.h>
+
+#else
+
+//the d3d12 tiling structs with the layout of d3d12.h, so the residency policy builds without the platform headers
+
+struct D3D12_SUBRESOURCE_TILING
+{
+	uint32_t	WidthInTiles;
+	uint16_t	HeightInTiles;
+	uint16_t	DepthInTiles;
+	uint32_t	StartTileIndexInOverallResource;
+};
+
+#define D3D12_TEXTURE_DATA_PITCH_ALIGNMENT		256
+#define D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT	512
+
+struct D3D12_TILED_RESOURCE_COORDINATE
+{
+	uint32_t	X;
+	uint32_t	Y;
+	uint32_t	Z;
+	uint32_t	Subresource;
+};
+
+#endif
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include "eviction_policy.h"
+
 namespace sample
 {
     namespace SampleSettings
@@ -35,8 +37,11 @@ namespace sample
         namespace TileResidency
         {
             static const unsigned int PoolSizeInTiles = 1024;
-            static const unsigned int MaxSimultaneousFileLoadTasks = 10;
+            static const unsigned int ReadQueueDepth = 4; // Merged reads in flight per texture file.
+            static const unsigned int MaxTilesPerRead = 8; // Tiles, which follow each other in the file, are read together up to it.
+            static const unsigned int MaxTileLoadsInFlight = ReadQueueDepth * MaxTilesPerRead;
             static const unsigned int MaxTilesLoadedPerFrame = 100;
+            static const EvictionPolicyType EvictionPolicy = EvictionPolicyType::LeastRecentlyUsed; // The replays of the flights found it best.
         }
         namespace TerrainAssets
         {
@@ -58,6 +63,18 @@ namespace sample
             static const float Ratio = 8.0f; // Ratio of screen size to sample target size.
             static const unsigned int SamplesPerFrame = 100;
         }
+        namespace Trace
+        {
+            static const bool Record = false; // Record the samples and the camera of the frames, saved to the local folder on exit.
+            static const wchar_t FileName[] = L"feedback.trace";
+        }
+        namespace Prefetch
+        {
+            static const unsigned int FramesAhead = 8; // The camera is extrapolated this far, 0 disables the prefetch.
+            static const unsigned int GridWidth = 32; // Rays of the predicted feedback.
+            static const unsigned int GridHeight = 18;
+            static const unsigned int MaxLoadsPerFrame = 2; // Loads of predicted tiles, once no seen tile waits.
+        }
         static const UINT TileSizeInBytes = 0x10000; // Tiles are always 65536 Bytes.
     }
 }
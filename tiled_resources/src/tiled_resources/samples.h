@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace sample
 {
     //Mipmap faces
@@ -18,4 +20,24 @@ namespace sample
         short mip;
         short face;
     };
+
+    // The pose of the free camera, the orientation is the quaternion of the rotation of the view matrix.
+    struct CameraPose
+    {
+        float m_position[3]     = {};
+        float m_orientation[4]  = {};
+    };
+
+    // A texel of the sampling render target: the direction of the sphere in [-1 ; 1] and the encoded level of detail in
+    // [0 ; 1] of the pixel shader, quantized like the target.
+    uint32_t EncodeSample(float x, float y, float z, float lod);
+
+    // The mips of the level of detail encoding of the sampling pass, EncodeConstants.y of sampling_renderer_pixel.hlsl.
+    static const float EncodedMipRange = 15.0f;
+
+    // The face, the texture coordinates and the mip of a texel of the sampling render target.
+    DecodedSample DecodeSample(uint32_t encodedSample);
+
+    // The face and the texture coordinates of a direction, without the quantization of the target.
+    DecodedSample SampleDirection(float x, float y, float z, short mip);
 }
@@ -9,77 +9,6 @@ namespace sample
 {
     namespace
     {
-		DecodedSample DecodeSample(unsigned int encodedSample)
-		{
-			//Separate the bytes
-			uint8_t sampleB = static_cast<uint8_t>(encodedSample & 0xFF);
-			uint8_t sampleG = static_cast<uint8_t>((encodedSample >> 8) & 0xFF);
-			uint8_t sampleR = static_cast<uint8_t>((encodedSample >> 16) & 0xFF);
-			uint8_t sampleA = static_cast<uint8_t>((encodedSample >> 24) & 0xFF);
-
-			//Dequantize to [-1 ; 1]
-			float x = 2.0f * static_cast<float>(sampleR) / 255.0f - 1.0f;
-			float y = 2.0f * static_cast<float>(sampleG) / 255.0f - 1.0f;
-			float z = 2.0f * static_cast<float>(sampleB) / 255.0f - 1.0f;
-
-			//Compute the load
-			float lod = (static_cast<float>(sampleA) / 255.0f) * 16.0f;	//maximum mip levels from 0 - 15
-
-			short mip = lod < 0.0f ? 0 : lod > 14.0f ? 14 : static_cast<unsigned short>(lod); //clamp to texture data
-
-			short face = 0;
-			float u = 0.0f;
-			float v = 0.0f;
-
-			if (abs(x) > abs(y) && abs(x) > abs(z))
-			{
-				if (x > 0) // +X
-				{
-					face = 0;
-					u = (1.0f - z / x) / 2.0f;
-					v = (1.0f - y / x) / 2.0f;
-				}
-				else // -X
-				{
-					face = 1;
-					u = (z / -x + 1.0f) / 2.0f;
-					v = (1.0f - y / -x) / 2.0f;
-				}
-			}
-			else if (abs(y) > abs(x) && abs(y) > abs(z))
-			{
-				if (y > 0) // +Y
-				{
-					face = 2;
-					u = (x / y + 1.0f) / 2.0f;
-					v = (z / y + 1.0f) / 2.0f;
-				}
-				else // -Y
-				{
-					face = 3;
-					u = (x / -y + 1.0f) / 2.0f;
-					v = (1.0f - z / -y) / 2.0f;
-				}
-			}
-			else
-			{
-				if (z > 0) // +Z
-				{
-					face = 4;
-					u = (x / z + 1.0f) / 2.0f;
-					v = (1.0f - y / z) / 2.0f;
-				}
-				else // -Z
-				{
-					face = 5;
-					u = (1.0f - x / -z) / 2.0f;
-					v = (1.0f - y / -z) / 2.0f;
-				}
-			}
-
-			return  { u, v, mip, face };
-		}
-
         //compute sizes
         static D3D12_RESOURCE_DESC DescribeDepth(uint32_t width, uint32_t height)
         {
@@ -0,0 +1,135 @@
+#include "pch.h"
+#include "simulated_residency_backend.h"
+
+#include <algorithm>
+
+namespace sample
+{
+	SimulatedResidencyBackend::SimulatedResidencyBackend(uint32_t poolSizeInTiles, uint32_t reservedTiles, uint32_t tileSizeInBytes, uint32_t loadLatencyInFrames) :
+		m_poolSizeInTiles(poolSizeInTiles)
+		, m_reservedTiles(reservedTiles)
+		, m_tileSizeInBytes(tileSizeInBytes)
+		, m_loadLatencyInFrames(loadLatencyInFrames)
+		, m_physicalTiles(poolSizeInTiles, 0)
+	{
+
+	}
+
+	void SimulatedResidencyBackend::SetFileLayouts(const std::vector<TileFileLayout>& layouts, const CoalescedTileReaderSettings& settings)
+	{
+		m_layouts		= layouts;
+		m_readSettings	= settings;
+		m_frameReads.resize(layouts.size());
+	}
+
+	void SimulatedResidencyBackend::LoadTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, std::function<void(std::vector<uint8_t>)> done)
+	{
+		m_loads.push_back({ m_frame + m_loadLatencyInFrames, std::move(done) });
+
+		if (resource < m_layouts.size())
+		{
+			auto& reads = m_frameReads[resource];
+			reads.push_back({ m_layouts[resource].TileIndex(c), static_cast<uint32_t>(reads.size()) });
+		}
+		else
+		{
+			m_statistics.m_bytesRead += m_tileSizeInBytes;
+			m_statistics.m_reads++;
+		}
+	}
+
+	void SimulatedResidencyBackend::MapTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, uint32_t physicalTile)
+	{
+		const TileKey key = Key(resource, c);
+
+		m_statistics.m_maps++;
+
+		if (physicalTile < m_reservedTiles || physicalTile >= m_poolSizeInTiles || m_physicalTiles[physicalTile] != 0 || m_mapped.count(key) != 0)
+		{
+			m_statistics.m_errors++;
+			return;
+		}
+
+		m_physicalTiles[physicalTile]	= key + 1;
+		m_mapped[key]					= physicalTile;
+	}
+
+	void SimulatedResidencyBackend::UnmapTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, uint32_t physicalTile)
+	{
+		const TileKey	key = Key(resource, c);
+		auto			i	= m_mapped.find(key);
+
+		m_statistics.m_unmaps++;
+
+		if (i == m_mapped.end() || i->second != physicalTile)
+		{
+			m_statistics.m_errors++;
+			return;
+		}
+
+		m_physicalTiles[physicalTile] = 0;
+		m_mapped.erase(i);
+	}
+
+	void SimulatedResidencyBackend::UploadTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, std::vector<uint8_t>)
+	{
+		if (m_mapped.count(Key(resource, c)) == 0)
+		{
+			m_statistics.m_errors++;
+			return;
+		}
+
+		m_statistics.m_bytesUploaded += m_tileSizeInBytes;
+	}
+
+	// The boxes are written like the d3d12 backend does, so the cpu time of the uploads is part of a simulated frame.
+	void SimulatedResidencyBackend::UpdateResidencyMap(uint32_t, ResidencyMap& map)
+	{
+		const uint32_t dimension	= std::max(map.Width(), map.Height());
+		const uint64_t size			= map.CollectUploads(dimension, m_residencyUploads);
+
+		if (m_residencyUploadBuffer.size() < size)
+		{
+			m_residencyUploadBuffer.resize(static_cast<size_t>(size));
+		}
+
+		for (auto&& u : m_residencyUploads)
+		{
+			map.WriteUpload(u, dimension, m_residencyUploadBuffer.data());
+		}
+
+		m_statistics.m_residencyBytesUploaded += size;
+	}
+
+	void SimulatedResidencyBackend::Submit()
+	{
+		for (auto&& reads : m_frameReads)
+		{
+			PlanCoalescedReads(reads, m_readSettings, m_plan);
+
+			for (auto&& r : m_plan)
+			{
+				m_statistics.m_bytesRead += static_cast<uint64_t>(r.m_tiles) * m_tileSizeInBytes;
+			}
+
+			m_statistics.m_reads += m_plan.size();
+			reads.clear();
+		}
+
+		// The loads are issued in frame order, so the completed ones are at the front.
+		while (!m_loads.empty() && m_loads.front().m_frame <= m_frame)
+		{
+			auto done = std::move(m_loads.front().m_done);
+
+			m_loads.pop_front();
+			done(std::vector<uint8_t>());
+		}
+
+		m_frame++;
+	}
+
+	bool SimulatedResidencyBackend::IsMapped(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c) const
+	{
+		return m_mapped.count(Key(resource, c)) != 0;
+	}
+}
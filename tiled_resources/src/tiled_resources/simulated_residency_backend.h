@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include "coalesced_tile_reader.h"
+#include "residency_backend.h"
+#include "tile_file.h"
+#include "tile_table.h"
+
+namespace sample
+{
+	// Counters since the backend was created.
+	struct SimulatedResidencyStatistics
+	{
+		uint64_t	m_bytesRead					= 0;		//with the gaps of the merged reads
+		uint64_t	m_reads						= 0;		//file reads, one per load, unless they are merged
+		uint64_t	m_bytesUploaded				= 0;		//tile data
+		uint64_t	m_residencyBytesUploaded	= 0;		//boxes of the residency textures
+		uint64_t	m_maps						= 0;
+		uint64_t	m_unmaps					= 0;
+		uint64_t	m_errors					= 0;		//calls, which the d3d12 backend would turn into corrupt mappings
+	};
+
+	// Runs the residency policy without a gpu. The physical tile pool is modelled: maps must use a free physical tile after the
+	// reserved ones, unmaps must free the tile the coordinate was mapped to, uploads must go to mapped tiles, every other call
+	// counts as an error. The loads complete at the end of a frame, after a latency in frames, with empty data. The bytes, which
+	// the d3d12 backend would read and upload, are counted.
+	class SimulatedResidencyBackend : public ResidencyBackend
+	{
+		public:
+
+		SimulatedResidencyBackend(uint32_t poolSizeInTiles, uint32_t reservedTiles, uint32_t tileSizeInBytes, uint32_t loadLatencyInFrames = 1);
+
+		// The loads of a frame are merged into reads like the coalesced tile reader of the sample merges them, with the file
+		// layout of every resource, so the reads and their bytes are counted.
+		void SetFileLayouts(const std::vector<TileFileLayout>& layouts, const CoalescedTileReaderSettings& settings);
+
+		void LoadTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, std::function<void(std::vector<uint8_t>)> done) override;
+		void MapTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, uint32_t physicalTile) override;
+		void UnmapTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, uint32_t physicalTile) override;
+		void UploadTile(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c, std::vector<uint8_t> data) override;
+		void UpdateResidencyMap(uint32_t resource, ResidencyMap& map) override;
+		void Submit() override;
+
+		const SimulatedResidencyStatistics& Statistics() const	{ return m_statistics; }
+		size_t MappedTiles() const								{ return m_mapped.size(); }
+		bool IsMapped(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c) const;
+
+		// Every mapped tile, for the checks against the residency maps.
+		template <typename F> void ForEachMapped(F f) const
+		{
+			for (auto&& m : m_mapped)
+			{
+				f(TileKeyResource(m.first), TileKeySubresource(m.first), TileKeyX(m.first), TileKeyY(m.first));
+			}
+		}
+
+		private:
+
+		struct PendingLoad
+		{
+			uint32_t								m_frame;			//the load completes at the end of it
+			std::function<void(std::vector<uint8_t>)>	m_done;
+		};
+
+		uint32_t								m_poolSizeInTiles;
+		uint32_t								m_reservedTiles;
+		uint32_t								m_tileSizeInBytes;
+		uint32_t								m_loadLatencyInFrames;
+		uint32_t								m_frame = 0;
+
+		std::vector<TileKey>					m_physicalTiles;		//1 + the key of the tile using the physical tile, 0 for free
+		std::unordered_map<TileKey, uint32_t>	m_mapped;				//the physical tile of every mapped tile
+		std::deque<PendingLoad>					m_loads;
+		std::vector<ResidencyUpload>			m_residencyUploads;
+		std::vector<uint8_t>					m_residencyUploadBuffer;
+		std::vector<TileFileLayout>				m_layouts;
+		CoalescedTileReaderSettings				m_readSettings;
+		std::vector<std::vector<TileReadRequest>>	m_frameReads;		//per resource, the loads of the frame
+		std::vector<CoalescedRead>				m_plan;
+		SimulatedResidencyStatistics			m_statistics;
+
+		static TileKey Key(uint32_t resource, const D3D12_TILED_RESOURCE_COORDINATE& c)
+		{
+			return MakeTileKey(resource, c.Subresource, c.X, c.Y);
+		}
+	};
+}
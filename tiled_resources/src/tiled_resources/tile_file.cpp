@@ -0,0 +1,265 @@
+#include "pch.h"
+#include "tile_file.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <climits>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace sample
+{
+	void TileFileLayout::Create(const D3D12_SUBRESOURCE_TILING* tilings, uint32_t subresources, uint64_t tilesInFile)
+	{
+		m_subresourcesPerFaceInResource	= subresources / 6;
+		m_subresourcesPerFaceInFile		= 0;
+		m_subresourceTileOffsets.clear();
+		m_widths.clear();
+
+		for (uint32_t i = 0; i < subresources; ++i)
+		{
+			m_widths.push_back(tilings[i].WidthInTiles);
+		}
+
+		const uint64_t tilesForSingleFaceMostDetailedMip	= static_cast<uint64_t>(tilings[0].WidthInTiles) * tilings[0].HeightInTiles;
+		const uint64_t tilesPerFace							= tilesInFile / 6;
+
+		for (uint32_t face = 0; face < 6; face++)
+		{
+			uint64_t tileIndexInFace	= 0;
+			uint64_t tilesInSubresource	= tilesForSingleFaceMostDetailedMip;
+
+			m_subresourcesPerFaceInFile = 0;
+
+			while (tileIndexInFace < tilesPerFace)
+			{
+				m_subresourceTileOffsets.push_back(face * tilesPerFace + tileIndexInFace);
+				tileIndexInFace		+= tilesInSubresource;
+				tilesInSubresource	= std::max<uint64_t>(1, tilesInSubresource / 4);
+				m_subresourcesPerFaceInFile++;
+			}
+		}
+	}
+
+	TileFile::~TileFile()
+	{
+		Close();
+	}
+
+#if defined(_WIN32)
+
+	bool TileFile::Open(const std::filesystem::path& path, size_t maxScatterSize)
+	{
+		Close();
+
+		// Overlapped, so the reads of the reader threads run at once.
+		CREATEFILE2_EXTENDED_PARAMETERS parameters = {};
+		parameters.dwSize				= sizeof(parameters);
+		parameters.dwFileAttributes		= FILE_ATTRIBUTE_NORMAL;
+		parameters.dwFileFlags			= FILE_FLAG_RANDOM_ACCESS | FILE_FLAG_OVERLAPPED;
+
+		m_file = CreateFile2(path.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, &parameters);
+
+		LARGE_INTEGER size = {};
+
+		if (m_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(m_file, &size))
+		{
+			Close();
+			return false;
+		}
+
+		m_size				= static_cast<uint64_t>(size.QuadPart);
+		m_maxScatterSize	= maxScatterSize;
+		m_open				= true;
+		return true;
+	}
+
+	void TileFile::Close()
+	{
+		if (m_file != INVALID_HANDLE_VALUE)
+		{
+			CloseHandle(m_file);
+			m_file = INVALID_HANDLE_VALUE;
+		}
+
+		m_open = false;
+		m_size = 0;
+	}
+
+	// Every read waits on its own event, the handle is signaled by the reads of all threads.
+	bool TileFile::Read(uint64_t offset, uint8_t* data, size_t size) const
+	{
+		HANDLE event = CreateEventExW(nullptr, nullptr, CREATE_EVENT_MANUAL_RESET, EVENT_ALL_ACCESS);
+
+		if (event == nullptr)
+		{
+			return false;
+		}
+
+		bool result = true;
+
+		while (size > 0)
+		{
+			OVERLAPPED	o		= {};
+			DWORD		read	= 0;
+			const DWORD	chunk	= static_cast<DWORD>(std::min<size_t>(size, 1U << 30));
+
+			o.Offset		= static_cast<DWORD>(offset);
+			o.OffsetHigh	= static_cast<DWORD>(offset >> 32);
+			o.hEvent		= event;
+
+			if (!ReadFile(m_file, data, chunk, nullptr, &o) && GetLastError() != ERROR_IO_PENDING)
+			{
+				result = false;
+				break;
+			}
+
+			if (!GetOverlappedResult(m_file, &o, &read, TRUE) || read == 0)
+			{
+				result = false;
+				break;
+			}
+
+			offset	+= read;
+			data	+= read;
+			size	-= read;
+		}
+
+		CloseHandle(event);
+		return result;
+	}
+
+	// ReadFileScatter needs unbuffered reads of whole pages, the run is read into a staging buffer and copied instead. The
+	// buffer of a thread holds the scatter size of Open, MaxTilesPerRead tiles for the reader, longer runs are read in parts.
+	bool TileFile::ReadScatter(uint64_t offset, uint8_t* const* buffers, size_t count, size_t size) const
+	{
+		thread_local std::vector<uint8_t> staging;
+
+		const size_t tilesPerRead = std::max<size_t>(1, m_maxScatterSize / size);
+
+		staging.resize(tilesPerRead * size);
+
+		while (count > 0)
+		{
+			const size_t n = std::min(count, tilesPerRead);
+
+			if (!Read(offset, staging.data(), n * size))
+			{
+				return false;
+			}
+
+			for (size_t i = 0; i < n; ++i)
+			{
+				std::memcpy(buffers[i], staging.data() + i * size, size);
+			}
+
+			offset	+= n * size;
+			buffers	+= n;
+			count	-= n;
+		}
+
+		return true;
+	}
+
+#else
+
+	bool TileFile::Open(const std::filesystem::path& path, size_t maxScatterSize)
+	{
+		Close();
+
+		m_file = ::open(path.c_str(), O_RDONLY);
+
+		struct stat s = {};
+
+		if (m_file < 0 || fstat(m_file, &s) != 0)
+		{
+			Close();
+			return false;
+		}
+
+		m_size				= static_cast<uint64_t>(s.st_size);
+		m_maxScatterSize	= maxScatterSize;
+		m_open				= true;
+		return true;
+	}
+
+	void TileFile::Close()
+	{
+		if (m_file >= 0)
+		{
+			::close(m_file);
+			m_file = -1;
+		}
+
+		m_open = false;
+		m_size = 0;
+	}
+
+	bool TileFile::Read(uint64_t offset, uint8_t* data, size_t size) const
+	{
+		while (size > 0)
+		{
+			const ssize_t read = pread(m_file, data, size, static_cast<off_t>(offset));
+
+			if (read <= 0)
+			{
+				return false;
+			}
+
+			offset	+= static_cast<uint64_t>(read);
+			data	+= read;
+			size	-= static_cast<size_t>(read);
+		}
+
+		return true;
+	}
+
+	// One preadv per IOV_MAX buffers, the kernel fills the buffers of the tiles directly.
+	bool TileFile::ReadScatter(uint64_t offset, uint8_t* const* buffers, size_t count, size_t size) const
+	{
+		std::vector<iovec> vectors(std::min<size_t>(count, IOV_MAX));
+
+		while (count > 0)
+		{
+			const size_t n = std::min<size_t>(count, IOV_MAX);
+
+			for (size_t i = 0; i < n; ++i)
+			{
+				vectors[i].iov_base	= buffers[i];
+				vectors[i].iov_len	= size;
+			}
+
+			const ssize_t read = preadv(m_file, vectors.data(), static_cast<int>(n), static_cast<off_t>(offset));
+
+			if (read < 0 || static_cast<size_t>(read) != n * size)
+			{
+				// A short read, the rest goes buffer by buffer.
+				const size_t done = read > 0 ? static_cast<size_t>(read) : 0;
+
+				for (size_t i = done / size; i < n; ++i)
+				{
+					const size_t skip = i == done / size ? done % size : 0;
+
+					if (!Read(offset + i * size + skip, buffers[i] + skip, size - skip))
+					{
+						return false;
+					}
+				}
+			}
+
+			offset	+= n * size;
+			buffers	+= n;
+			count	-= n;
+		}
+
+		return true;
+	}
+
+#endif
+}
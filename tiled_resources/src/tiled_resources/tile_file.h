@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+#include "residency_types.h"
+
+namespace sample
+{
+	// The place of the tiles of a cube texture in its file: the faces one after the other, each with its mips from the most
+	// detailed one, every mip a quarter of the one before down to one tile, the tiles of a mip in rows. The file may have more
+	// mips than the resource, the packed ones.
+	class TileFileLayout
+	{
+		public:
+
+		// The tilings of the subresources, the mips of the faces one after the other, and the tiles of the file.
+		void Create(const D3D12_SUBRESOURCE_TILING* tilings, uint32_t subresources, uint64_t tilesInFile);
+
+		// The index of the tile in the file, its offset is the index times the tile size.
+		uint64_t TileIndex(const D3D12_TILED_RESOURCE_COORDINATE& c) const
+		{
+			const uint32_t subresourceInFile = (c.Subresource / m_subresourcesPerFaceInResource) * m_subresourcesPerFaceInFile + c.Subresource % m_subresourcesPerFaceInResource;
+			return m_subresourceTileOffsets[subresourceInFile] + static_cast<uint64_t>(c.Y) * m_widths[c.Subresource] + c.X;
+		}
+
+		private:
+
+		std::vector<uint64_t>	m_subresourceTileOffsets;			//first tile of every mip of the file
+		std::vector<uint32_t>	m_widths;							//in tiles, of the subresources of the resource
+		uint32_t				m_subresourcesPerFaceInResource = 0;
+		uint32_t				m_subresourcesPerFaceInFile = 0;
+	};
+
+	// A read only file with positional reads, which several threads may issue at once: pread and preadv on linux, overlapped
+	// ReadFile on windows, where a handle without FILE_FLAG_OVERLAPPED would serialize the reads of the threads. The reads
+	// do not move a file pointer, so no lock is needed.
+	class TileFile
+	{
+		public:
+
+		TileFile() = default;
+		~TileFile();
+
+		TileFile(const TileFile&) = delete;
+		TileFile& operator=(const TileFile&) = delete;
+
+		// False, if the file cannot be opened. The scatter reads of windows stage at most maxScatterSize bytes at once, the
+		// largest read of the reader.
+		bool Open(const std::filesystem::path& path, size_t maxScatterSize = 16 * 65536);
+		void Close();
+
+		bool IsOpen() const		{ return m_open; }
+		uint64_t Size() const	{ return m_size; }
+
+		// Reads size bytes at offset. False, if the file has less.
+		bool Read(uint64_t offset, uint8_t* data, size_t size) const;
+
+		// Reads count buffers of size bytes each, which follow each other in the file from offset, in one read where the platform
+		// can scatter. False, if the file has less.
+		bool ReadScatter(uint64_t offset, uint8_t* const* buffers, size_t count, size_t size) const;
+
+		private:
+
+#if defined(_WIN32)
+		HANDLE		m_file = INVALID_HANDLE_VALUE;
+#else
+		int			m_file = -1;
+#endif
+		bool		m_open = false;
+		uint64_t	m_size = 0;
+		size_t		m_maxScatterSize = 0;
+	};
+}
@@ -9,41 +9,28 @@
 
 #include <d3d12.h>
 
-#include <winrt/Windows.Foundation.h>
-#include <winrt/Windows.Foundation.Collections.h>
-#include <winrt/Windows.ApplicationModel.h>
-#include <winrt/Windows.Storage.h>
-#include <winrt/Windows.Storage.Streams.h>
+#include "coalesced_tile_reader.h"
 
 namespace sample
 {
-	using namespace winrt;
-	using namespace winrt::Windows::Foundation;
-	using namespace winrt::Windows::Foundation::Collections;
-	using namespace winrt::Windows::Storage;
-	using namespace winrt::Windows::Storage::Streams;
-		
-	using namespace std::experimental;
-	using namespace Concurrency;
-
+	// Reads the tiles of a texture file of the app package. The loads of a frame are batched and read with few large reads,
+	// see CoalescedTileReader.
     class TileLoader
     {
 		public:
 
         TileLoader(const std::wstring & filename, std::vector<D3D12_SUBRESOURCE_TILING>* tilingInfo);
-        concurrency::task<std::vector<byte> > LoadTileAsync( D3D12_TILED_RESOURCE_COORDINATE coordinate );
+
+		// The tile is read after the next Flush, done gets its data on a thread of the reader.
+		void LoadTile(D3D12_TILED_RESOURCE_COORDINATE coordinate, CoalescedTileReader::Done done);
+
+		// Starts the reads of the loads since the last Flush.
+		void Flush();
 
     private:
 
 		std::wstring							 m_filename;
-		std::vector<D3D12_SUBRESOURCE_TILING>*	 m_tilingInfo = nullptr;
-		IAsyncOperation<IRandomAccessStream>	 m_openStream;
-		IRandomAccessStream						 m_openStreamData;
-		
-        std::vector<size_t>						 m_subresourceTileOffsets;
-		uint32_t								 m_subresourcesPerFaceInResource = 0;
-		uint32_t								 m_subresourcesPerFaceInFile = 0;
-
-		IAsyncOperation< IRandomAccessStream >	 OpenStreamPrivate(const std::wstring& s, std::vector<D3D12_SUBRESOURCE_TILING>* tilingInfo);
+		TileFileLayout							 m_layout;
+		std::unique_ptr<CoalescedTileReader>	 m_reader;
     };
 }
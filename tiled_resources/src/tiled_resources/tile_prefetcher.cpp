@@ -0,0 +1,280 @@
+#include "pch.h"
+#include "tile_prefetcher.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace sample
+{
+	namespace
+	{
+		struct Vector3
+		{
+			float x;
+			float y;
+			float z;
+		};
+
+		// x, y, z, w like DirectXMath.
+		struct Quaternion
+		{
+			float x;
+			float y;
+			float z;
+			float w;
+		};
+
+		Vector3 operator+(const Vector3& a, const Vector3& b)	{ return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+		Vector3 operator-(const Vector3& a, const Vector3& b)	{ return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+		Vector3 operator*(const Vector3& a, float s)			{ return { a.x * s, a.y * s, a.z * s }; }
+		float Dot(const Vector3& a, const Vector3& b)			{ return a.x * b.x + a.y * b.y + a.z * b.z; }
+		Vector3 Cross(const Vector3& a, const Vector3& b)		{ return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+		Quaternion Multiply(const Quaternion& a, const Quaternion& b)
+		{
+			return
+			{
+				a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+				a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+				a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+				a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z
+			};
+		}
+
+		Quaternion Conjugate(const Quaternion& q)
+		{
+			return { -q.x, -q.y, -q.z, q.w };
+		}
+
+		// q v q*, like XMVector3Rotate.
+		Vector3 Rotate(const Quaternion& q, const Vector3& v)
+		{
+			const Vector3 u = { q.x, q.y, q.z };
+			const Vector3 t = Cross(u, v) * 2.0f;
+
+			return v + t * q.w + Cross(u, t);
+		}
+
+		// The rotation of q applied n times.
+		Quaternion Power(Quaternion q, float n)
+		{
+			if (q.w < 0.0f)
+			{
+				q = { -q.x, -q.y, -q.z, -q.w };
+			}
+
+			const float s = sqrtf(q.x * q.x + q.y * q.y + q.z * q.z);
+
+			if (s < 1e-7f)
+			{
+				return { 0.0f, 0.0f, 0.0f, 1.0f };
+			}
+
+			const float angle	= atan2f(s, q.w) * n;
+			const float scale	= sinf(angle) / s;
+
+			return { q.x * scale, q.y * scale, q.z * scale, cosf(angle) };
+		}
+
+		Vector3 Position(const CameraPose& pose)
+		{
+			return { pose.m_position[0], pose.m_position[1], pose.m_position[2] };
+		}
+
+		Quaternion Orientation(const CameraPose& pose)
+		{
+			return { pose.m_orientation[0], pose.m_orientation[1], pose.m_orientation[2], pose.m_orientation[3] };
+		}
+
+		// The point of the unit sphere the ray from the camera through the texel of the sampling target hits, false for none.
+		// The view looks down -z, like XMMatrixPerspectiveFovRH.
+		bool Hit(const Vector3& eye, const Quaternion& toWorld, const FeedbackProjection& p, float column, float row, Vector3& hit)
+		{
+			const float	tangent	= tanf(p.m_fieldOfView / 2.0f);
+			const float	sx		= 2.0f * column / p.m_samplingWidth - 1.0f;
+			const float	sy		= 1.0f - 2.0f * row / p.m_samplingHeight;
+
+			Vector3 d = Rotate(toWorld, { sx * tangent * p.m_aspectRatio, sy * tangent, -1.0f });
+			d = d * (1.0f / sqrtf(Dot(d, d)));
+
+			const float b			= Dot(eye, d);
+			const float c			= Dot(eye, eye) - 1.0f;
+			const float disc		= b * b - c;
+
+			if (disc < 0.0f)
+			{
+				return false;
+			}
+
+			const float t = -b - sqrtf(disc);
+
+			if (t <= 0.0f)
+			{
+				return false;
+			}
+
+			hit = eye + d * t;
+			return true;
+		}
+
+		// The texture coordinates of the point of the face, for the derivatives.
+		bool FaceCoordinates(const Vector3& p, short face, float& u, float& v)
+		{
+			const DecodedSample s = SampleDirection(p.x, p.y, p.z, 0);
+
+			u = s.u;
+			v = s.v;
+			return s.face == face;
+		}
+	}
+
+	CameraPose LookAt(const float eye[3], const float at[3], const float up[3])
+	{
+		auto normalize = [](const Vector3& v) { return v * (1.0f / sqrtf(Dot(v, v))); };
+
+		// The rows of the rotation of the view, like XMMatrixLookAtRH.
+		const Vector3 e	= { eye[0], eye[1], eye[2] };
+		const Vector3 z	= normalize(e - Vector3{ at[0], at[1], at[2] });
+		const Vector3 x	= normalize(Cross({ up[0], up[1], up[2] }, z));
+		const Vector3 y	= Cross(z, x);
+
+		const float m[3][3] = { { x.x, x.y, x.z }, { y.x, y.y, y.z }, { z.x, z.y, z.z } };
+		const float trace	= m[0][0] + m[1][1] + m[2][2];
+
+		Quaternion q;
+
+		if (trace > 0.0f)
+		{
+			const float s = 2.0f * sqrtf(1.0f + trace);
+			q = { (m[2][1] - m[1][2]) / s, (m[0][2] - m[2][0]) / s, (m[1][0] - m[0][1]) / s, s / 4.0f };
+		}
+		else if (m[0][0] > m[1][1] && m[0][0] > m[2][2])
+		{
+			const float s = 2.0f * sqrtf(1.0f + m[0][0] - m[1][1] - m[2][2]);
+			q = { s / 4.0f, (m[0][1] + m[1][0]) / s, (m[0][2] + m[2][0]) / s, (m[2][1] - m[1][2]) / s };
+		}
+		else if (m[1][1] > m[2][2])
+		{
+			const float s = 2.0f * sqrtf(1.0f + m[1][1] - m[0][0] - m[2][2]);
+			q = { (m[0][1] + m[1][0]) / s, s / 4.0f, (m[1][2] + m[2][1]) / s, (m[0][2] - m[2][0]) / s };
+		}
+		else
+		{
+			const float s = 2.0f * sqrtf(1.0f + m[2][2] - m[0][0] - m[1][1]);
+			q = { (m[0][2] + m[2][0]) / s, (m[1][2] + m[2][1]) / s, s / 4.0f, (m[1][0] - m[0][1]) / s };
+		}
+
+		CameraPose pose;
+
+		pose.m_position[0]		= eye[0];
+		pose.m_position[1]		= eye[1];
+		pose.m_position[2]		= eye[2];
+		pose.m_orientation[0]	= q.x;
+		pose.m_orientation[1]	= q.y;
+		pose.m_orientation[2]	= q.z;
+		pose.m_orientation[3]	= q.w;
+
+		return pose;
+	}
+
+	void ProjectFeedback(const CameraPose& pose, const FeedbackProjection& projection, uint32_t width, uint32_t height, std::vector<DecodedSample>& samples)
+	{
+		// Like the sampling pass, ResourceDimension / TargetRatio.
+		const float LevelOfDetailScale	= projection.m_resourceDimension / projection.m_samplingRatio;
+
+		const Vector3		eye		= Position(pose);
+		const Quaternion	toWorld	= Conjugate(Orientation(pose));
+
+		samples.clear();
+
+		for (auto y = 0U; y < height; ++y)
+		{
+			for (auto x = 0U; x < width; ++x)
+			{
+				const float column	= (x + 0.5f) * projection.m_samplingWidth / width;
+				const float row		= (y + 0.5f) * projection.m_samplingHeight / height;
+
+				Vector3 hit;
+
+				if (!Hit(eye, toWorld, projection, column, row, hit))
+				{
+					continue;
+				}
+
+				// The derivatives of the texture coordinates, over the neighbours, which hit the same face.
+				const DecodedSample center = SampleDirection(hit.x, hit.y, hit.z, 0);
+
+				float	derivative	= 0.0f;
+				bool	found		= false;
+				Vector3	right;
+				Vector3	below;
+				float	ru, rv, bu, bv;
+
+				const bool hasRight = Hit(eye, toWorld, projection, column + 1.0f, row, right) && FaceCoordinates(right, center.face, ru, rv);
+				const bool hasBelow = Hit(eye, toWorld, projection, column, row + 1.0f, below) && FaceCoordinates(below, center.face, bu, bv);
+
+				if (hasRight || hasBelow)
+				{
+					// A missing neighbour is taken like the other one.
+					const float dudx = hasRight ? ru - center.u : bu - center.u;
+					const float dvdx = hasRight ? rv - center.v : bv - center.v;
+					const float dudy = hasBelow ? bu - center.u : dudx;
+					const float dvdy = hasBelow ? bv - center.v : dvdx;
+
+					derivative	= std::max(sqrtf(dudx * dudx + dudy * dudy), sqrtf(dvdx * dvdx + dvdy * dvdy));
+					found		= derivative > 0.0f;
+				}
+
+				const float lod = found ? log2f(derivative * LevelOfDetailScale) / EncodedMipRange : 1.0f;
+
+				samples.push_back(DecodeSample(EncodeSample(hit.x, hit.y, hit.z, lod)));
+			}
+		}
+	}
+
+	TilePrefetcher::TilePrefetcher(const TilePrefetchSettings& settings, const FeedbackProjection& projection) :
+		m_settings(settings)
+		, m_projection(projection)
+	{
+
+	}
+
+	const std::vector<DecodedSample>& TilePrefetcher::Predict(const CameraPose& pose)
+	{
+		m_samples.clear();
+
+		if (m_hasPrevious && m_settings.m_framesAhead > 0)
+		{
+			const Vector3		position	= Position(pose);
+			const Vector3		velocity	= position - Position(m_previous);
+			const Quaternion	orientation	= Orientation(pose);
+			const Quaternion	rotation	= Multiply(orientation, Conjugate(Orientation(m_previous)));
+			const float			ahead		= static_cast<float>(m_settings.m_framesAhead);
+
+			// The rotation of a camera, which does not turn, is the identity up to the rounding of the products.
+			const float		still		= 1e-12f;
+
+			if (Dot(velocity, velocity) > still || rotation.x * rotation.x + rotation.y * rotation.y + rotation.z * rotation.z > still)
+			{
+				const Vector3		p = position + velocity * ahead;
+				const Quaternion	q = Multiply(Power(rotation, ahead), orientation);
+
+				CameraPose predicted;
+				predicted.m_position[0]		= p.x;
+				predicted.m_position[1]		= p.y;
+				predicted.m_position[2]		= p.z;
+				predicted.m_orientation[0]	= q.x;
+				predicted.m_orientation[1]	= q.y;
+				predicted.m_orientation[2]	= q.z;
+				predicted.m_orientation[3]	= q.w;
+
+				ProjectFeedback(predicted, m_projection, m_settings.m_gridWidth, m_settings.m_gridHeight, m_samples);
+			}
+		}
+
+		m_previous		= pose;
+		m_hasPrevious	= true;
+
+		return m_samples;
+	}
+}
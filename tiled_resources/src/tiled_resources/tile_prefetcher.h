@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "samples.h"
+
+namespace sample
+{
+	// The camera and the sampling render target the feedback is projected with. The app sets them from FreeCamera and
+	// SampleSettings, the defaults are their values for the harness, which builds without them.
+	struct FeedbackProjection
+	{
+		float		m_fieldOfView		= 70.0f * 3.14159265f / 180.0f;		//vertical, radians, FreeCamera::FieldOfView
+		float		m_aspectRatio		= 16.0f / 9.0f;
+		uint32_t	m_samplingWidth		= 240;
+		uint32_t	m_samplingHeight	= 135;
+		float		m_resourceDimension	= 16384.0f;							//texels of the textures, TerrainAssets::DimensionSize
+		float		m_samplingRatio		= 8.0f;								//screen size / sampling target size, Sampling::Ratio
+	};
+
+	// The pose of a camera at eye, which looks at at, like FreeCamera::SetViewParameters.
+	CameraPose LookAt(const float eye[3], const float at[3], const float up[3]);
+
+	// The samples, which the sampling pass would write for the camera pose, on a grid of width x height rays over the sampling
+	// target. The rays hit the unit sphere of the planet, the heights of the terrain are ignored. The level of detail comes from
+	// the rays one texel of the sampling target to the right and below, like the derivatives of the pixel shader, so a coarse
+	// grid samples the mips of the full target. The samples go through EncodeSample and DecodeSample.
+	void ProjectFeedback(const CameraPose& pose, const FeedbackProjection& projection, uint32_t width, uint32_t height, std::vector<DecodedSample>& samples);
+
+	struct TilePrefetchSettings
+	{
+		uint32_t	m_framesAhead		= 8;		//0 disables the prediction
+		uint32_t	m_gridWidth			= 32;		//rays of the predicted feedback
+		uint32_t	m_gridHeight		= 18;
+	};
+
+	// Predicts the feedback of the frames ahead: the position and the orientation of the camera are extrapolated with their
+	// change from the previous frame, the feedback of the predicted pose is projected on a coarse grid. A camera, which does
+	// not move, predicts nothing, the samples of the frame have its tiles already.
+	class TilePrefetcher
+	{
+		public:
+
+		TilePrefetcher(const TilePrefetchSettings& settings = TilePrefetchSettings(), const FeedbackProjection& projection = FeedbackProjection());
+
+		void SetProjection(const FeedbackProjection& projection)	{ m_projection = projection; }
+
+		// The pose of the frame, the predicted samples are valid until the next call.
+		const std::vector<DecodedSample>& Predict(const CameraPose& pose);
+
+		private:
+
+		TilePrefetchSettings		m_settings;
+		FeedbackProjection			m_projection;
+		CameraPose					m_previous;
+		bool						m_hasPrevious = false;
+		std::vector<DecodedSample>	m_samples;
+	};
+}
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "tile_table.h"
+
+namespace sample
+{
+	// The tiles of one mip, which were last seen in the same frame.
+	template <typename T> struct TileBucket
+	{
+		uint32_t		m_frame = 0;
+		uint32_t		m_mip	= 0;
+		TileList<T>		m_tiles;
+		TileBucket*		m_prev	= nullptr;
+		TileBucket*		m_next	= nullptr;
+	};
+
+	// Priority queue of tiles keyed by (m_lastSeen, m_mipLevel), which replaces sorting the tile lists every frame. Every mip
+	// keeps its buckets in frame order. A tile seen again moves to the bucket of the current frame, which is the last one of
+	// its mip, so a frame costs O(1) per changed tile. The oldest and the newest tile are at the ends of the mips, finding them
+	// costs O(mips). T has m_lastSeen, m_mipLevel, m_bucket and the links of a TileList.
+	template <typename T> class TileQueue
+	{
+		public:
+
+		using Bucket = TileBucket<T>;
+
+		bool	empty() const	{ return m_size == 0; }
+		size_t	size() const	{ return m_size; }
+
+		// Tiles of the current frame go to the last bucket of their mip, older ones walk the buckets from the back, which
+		// are few, because the buckets of a mip are distinct frames.
+		void push(T* t)
+		{
+			Level&		l = GetLevel(t->m_mipLevel);
+			Bucket*		b = l.m_tail;
+
+			while (b != nullptr && b->m_frame > t->m_lastSeen)
+			{
+				b = b->m_prev;
+			}
+
+			if (b == nullptr || b->m_frame != t->m_lastSeen)
+			{
+				Bucket* n = Allocate();
+
+				n->m_frame	= t->m_lastSeen;
+				n->m_mip	= t->m_mipLevel;
+				Link(l, b, n);
+				b = n;
+			}
+
+			b->m_tiles.push_back(t);
+			t->m_bucket = b;
+			m_size++;
+		}
+
+		void remove(T* t)
+		{
+			Bucket* b = t->m_bucket;
+
+			b->m_tiles.remove(t);
+			t->m_bucket = nullptr;
+			m_size--;
+
+			if (b->m_tiles.empty())
+			{
+				Unlink(m_levels[b->m_mip], b);
+				Free(b);
+			}
+		}
+
+		// The tile was seen again in the frame.
+		void touch(T* t, uint32_t frame)
+		{
+			remove(t);
+			t->m_lastSeen = frame;
+			push(t);
+		}
+
+		// Least recently seen tile, more detailed tiles first to break ties: the eviction order.
+		T* oldest() const
+		{
+			const Bucket* best = nullptr;
+
+			for (auto&& l : m_levels)
+			{
+				if (l.m_head != nullptr && (best == nullptr || l.m_head->m_frame < best->m_frame))
+				{
+					best = l.m_head;
+				}
+			}
+
+			return best ? best->m_tiles.front() : nullptr;
+		}
+
+		// The tile with the least m_lastSeen + credit[m_mipLevel], more detailed tiles first to break ties. The tiles of a mip
+		// share the credit, so their order does not change and the first bucket of each mip is the candidate. Mips past the
+		// end of credit get the last one.
+		T* oldest(const std::vector<uint32_t>& credit) const
+		{
+			const Bucket*	best		= nullptr;
+			uint64_t		bestValue	= 0;
+
+			for (size_t mip = 0; mip < m_levels.size(); ++mip)
+			{
+				const Bucket* b = m_levels[mip].m_head;
+
+				if (b != nullptr)
+				{
+					const uint64_t value = static_cast<uint64_t>(b->m_frame) + credit[std::min(mip, credit.size() - 1)];
+
+					if (best == nullptr || value < bestValue)
+					{
+						best		= b;
+						bestValue	= value;
+					}
+				}
+			}
+
+			return best ? best->m_tiles.front() : nullptr;
+		}
+
+		// Most recently seen tile, less detailed tiles first to break ties: the load and the map order.
+		T* newest() const
+		{
+			const Bucket* best = nullptr;
+
+			for (auto l = m_levels.rbegin(); l != m_levels.rend(); ++l)
+			{
+				if (l->m_tail != nullptr && (best == nullptr || l->m_tail->m_frame > best->m_frame))
+				{
+					best = l->m_tail;
+				}
+			}
+
+			return best ? best->m_tiles.front() : nullptr;
+		}
+
+		T* pop_oldest()
+		{
+			T* t = oldest();
+			remove(t);
+			return t;
+		}
+
+		T* pop_newest()
+		{
+			T* t = newest();
+			remove(t);
+			return t;
+		}
+
+		private:
+
+		// The buckets of a mip in frame order.
+		struct Level
+		{
+			Bucket* m_head = nullptr;
+			Bucket* m_tail = nullptr;
+		};
+
+		static const uint32_t	ChunkSize = 256;
+
+		std::vector<Level>						m_levels;
+		std::vector<std::unique_ptr<Bucket[]>>	m_chunks;
+		std::vector<Bucket*>					m_free;
+		size_t									m_size = 0;
+
+		Level& GetLevel(uint32_t mip)
+		{
+			if (mip >= m_levels.size())
+			{
+				m_levels.resize(mip + 1);
+			}
+
+			return m_levels[mip];
+		}
+
+		// Links n after b, or at the head for no b.
+		static void Link(Level& l, Bucket* b, Bucket* n)
+		{
+			n->m_prev = b;
+			n->m_next = b ? b->m_next : l.m_head;
+
+			if (n->m_next)
+			{
+				n->m_next->m_prev = n;
+			}
+			else
+			{
+				l.m_tail = n;
+			}
+
+			if (b)
+			{
+				b->m_next = n;
+			}
+			else
+			{
+				l.m_head = n;
+			}
+		}
+
+		static void Unlink(Level& l, Bucket* b)
+		{
+			if (b->m_prev)
+			{
+				b->m_prev->m_next = b->m_next;
+			}
+			else
+			{
+				l.m_head = b->m_next;
+			}
+
+			if (b->m_next)
+			{
+				b->m_next->m_prev = b->m_prev;
+			}
+			else
+			{
+				l.m_tail = b->m_prev;
+			}
+		}
+
+		Bucket* Allocate()
+		{
+			if (m_free.empty())
+			{
+				m_chunks.push_back(std::make_unique<Bucket[]>(ChunkSize));
+
+				Bucket* chunk = m_chunks.back().get();
+
+				for (uint32_t i = ChunkSize; i > 0; --i)
+				{
+					m_free.push_back(chunk + i - 1);
+				}
+			}
+
+			Bucket* b = m_free.back();
+			m_free.pop_back();
+			return b;
+		}
+
+		void Free(Bucket* b)
+		{
+			*b = Bucket();
+			m_free.push_back(b);
+		}
+	};
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace sample
+{
+	// Unique identifier for a tile: the index of the managed resource, the subresource and the tile coordinate packed into
+	// 64 bits. The resources are 2d cube textures, the face is part of the subresource and Z is always 0.
+	using TileKey = uint64_t;
+
+	inline TileKey MakeTileKey(uint32_t resource, uint32_t subresource, uint32_t x, uint32_t y)
+	{
+		return (static_cast<uint64_t>(resource & 0xFF) << 56) | (static_cast<uint64_t>(subresource & 0xFFFF) << 40) | (static_cast<uint64_t>(y & 0xFFFFF) << 20) | (x & 0xFFFFF);
+	}
+
+	inline uint32_t TileKeyResource(TileKey k)		{ return static_cast<uint32_t>(k >> 56); }
+	inline uint32_t TileKeySubresource(TileKey k)	{ return static_cast<uint32_t>(k >> 40) & 0xFFFF; }
+	inline uint32_t TileKeyY(TileKey k)				{ return static_cast<uint32_t>(k >> 20) & 0xFFFFF; }
+	inline uint32_t TileKeyX(TileKey k)				{ return static_cast<uint32_t>(k) & 0xFFFFF; }
+
+	// Intrusive doubly linked list. T has m_prev and m_next, so a tile is in one list at a time and moves between lists
+	// without allocations.
+	template <typename T> class TileList
+	{
+		public:
+
+		bool	empty() const	{ return m_head == nullptr; }
+		size_t	size() const	{ return m_size; }
+		T*		front() const	{ return m_head; }
+		T*		back() const	{ return m_tail; }
+
+		void push_back(T* t)
+		{
+			t->m_prev = m_tail;
+			t->m_next = nullptr;
+
+			if (m_tail)
+			{
+				m_tail->m_next = t;
+			}
+			else
+			{
+				m_head = t;
+			}
+
+			m_tail = t;
+			m_size++;
+		}
+
+		void remove(T* t)
+		{
+			if (t->m_prev)
+			{
+				t->m_prev->m_next = t->m_next;
+			}
+			else
+			{
+				m_head = t->m_next;
+			}
+
+			if (t->m_next)
+			{
+				t->m_next->m_prev = t->m_prev;
+			}
+			else
+			{
+				m_tail = t->m_prev;
+			}
+
+			t->m_prev = nullptr;
+			t->m_next = nullptr;
+			m_size--;
+		}
+
+		T* pop_front()
+		{
+			T* t = m_head;
+			remove(t);
+			return t;
+		}
+
+		private:
+
+		T*		m_head = nullptr;
+		T*		m_tail = nullptr;
+		size_t	m_size = 0;
+	};
+
+	// Open addressing hash table of the tracked tiles, with linear probing. T has m_key. The tiles live in chunks, which are
+	// never moved or freed, so pointers to a tile stay valid until it is erased, also when the table grows. Lookups do not
+	// allocate, inserts only when the table or the chunks grow.
+	template <typename T> class TileTable
+	{
+		public:
+
+		explicit TileTable(uint32_t capacity = 4096)
+		{
+			uint32_t slots = 16;
+
+			while (slots < 2 * capacity)
+			{
+				slots *= 2;
+			}
+
+			m_slots.resize(slots);
+		}
+
+		size_t size() const
+		{
+			return m_size;
+		}
+
+		T* find(TileKey key) const
+		{
+			for (size_t i = Hash(key) & Mask();; i = (i + 1) & Mask())
+			{
+				const Slot& s = m_slots[i];
+
+				if (s.m_tile == nullptr || s.m_key == key)
+				{
+					return s.m_tile;
+				}
+			}
+		}
+
+		// A new tile for a key, which is not in the table.
+		T* insert(TileKey key)
+		{
+			// Keep the load factor at most 1/2, the probe sequences stay short.
+			if (2 * (m_size + 1) > m_slots.size())
+			{
+				Grow();
+			}
+
+			if (m_free.empty())
+			{
+				AllocateChunk();
+			}
+
+			T* t = m_free.back();
+			m_free.pop_back();
+
+			t->m_key = key;
+			Place(key, t);
+			m_size++;
+
+			return t;
+		}
+
+		// Resets the tile and returns its memory to the table. The tile must not be in a list.
+		void erase(T* t)
+		{
+			size_t i = Hash(t->m_key) & Mask();
+
+			while (m_slots[i].m_tile != t)
+			{
+				i = (i + 1) & Mask();
+			}
+
+			// Backward shift: move later entries of the probe sequence into the hole, so no tombstones are needed.
+			for (size_t j = (i + 1) & Mask(); m_slots[j].m_tile != nullptr; j = (j + 1) & Mask())
+			{
+				const size_t home = Hash(m_slots[j].m_key) & Mask();
+
+				// j may move to i, if its home slot is not in (i, j] cyclically
+				if (((j - home) & Mask()) >= ((j - i) & Mask()))
+				{
+					m_slots[i] = m_slots[j];
+					i = j;
+				}
+			}
+
+			m_slots[i] = Slot();
+			m_size--;
+
+			*t = T();
+			m_free.push_back(t);
+		}
+
+		private:
+
+		struct Slot
+		{
+			TileKey m_key	= 0;
+			T*		m_tile	= nullptr;
+		};
+
+		static const uint32_t	ChunkSize = 1024;
+
+		std::vector<Slot>					m_slots;
+		std::vector<std::unique_ptr<T[]>>	m_chunks;
+		std::vector<T*>						m_free;
+		size_t								m_size = 0;
+
+		size_t Mask() const
+		{
+			return m_slots.size() - 1;
+		}
+
+		// The keys have their entropy in the low bits of x and y, mix them all into the low bits.
+		static size_t Hash(TileKey k)
+		{
+			k ^= k >> 33;
+			k *= 0xFF51AFD7ED558CCDULL;
+			k ^= k >> 33;
+			return static_cast<size_t>(k);
+		}
+
+		void Place(TileKey key, T* t)
+		{
+			size_t i = Hash(key) & Mask();
+
+			while (m_slots[i].m_tile != nullptr)
+			{
+				i = (i + 1) & Mask();
+			}
+
+			m_slots[i].m_key	= key;
+			m_slots[i].m_tile	= t;
+		}
+
+		void Grow()
+		{
+			std::vector<Slot> slots(2 * m_slots.size());
+			slots.swap(m_slots);
+
+			for (auto&& s : slots)
+			{
+				if (s.m_tile != nullptr)
+				{
+					Place(s.m_key, s.m_tile);
+				}
+			}
+		}
+
+		void AllocateChunk()
+		{
+			m_chunks.push_back(std::make_unique<T[]>(ChunkSize));
+
+			T* chunk = m_chunks.back().get();
+
+			// lower addresses are handed out first
+			for (uint32_t i = ChunkSize; i > 0; --i)
+			{
+				m_free.push_back(chunk + i - 1);
+			}
+		}
+	};
+}
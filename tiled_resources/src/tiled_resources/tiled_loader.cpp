@@ -8,77 +8,42 @@
 #include "pch.h"
 #include "tile_loader.h"
 #include "sample_settings.h"
+#include "error.h"
+
+#include <winrt/Windows.ApplicationModel.h>
+#include <winrt/Windows.Storage.h>
 
 namespace sample
 {
-	//using namespace concurrency;
-	//using namespace std::experimental;
-
-	namespace
-	{
-		IAsyncOperation< IRandomAccessStream > OpenStreamAsync(const std::wstring& filename)
-		{
-			auto folder = Windows::ApplicationModel::Package::Current().InstalledLocation();
-			auto file	= co_await folder.GetFileAsync(filename.c_str());
-			auto stream = co_await file.OpenReadAsync();
-			return stream;
-		}
-	}
-
 	TileLoader::TileLoader(const std::wstring& filename, std::vector<D3D12_SUBRESOURCE_TILING>* tilingInfo) :
 		m_filename(filename)
-		, m_tilingInfo(tilingInfo)
-		, m_subresourcesPerFaceInResource( 0 )
-		, m_subresourcesPerFaceInFile ( 0 )
 	{
-//		m_openStream = OpenStreamPrivate(m_filename, m_tilingInfo);
+		CoalescedTileReaderSettings settings;
 
-		m_openStreamData = OpenStreamPrivate(m_filename, m_tilingInfo).get();
-	}
+		settings.m_tileSizeInBytes		= SampleSettings::TileSizeInBytes;
+		settings.m_queueDepth			= SampleSettings::TileResidency::ReadQueueDepth;
+		settings.m_maxReadSizeInTiles	= SampleSettings::TileResidency::MaxTilesPerRead;
 
-	IAsyncOperation< IRandomAccessStream >	 TileLoader::OpenStreamPrivate(const std::wstring& s, std::vector<D3D12_SUBRESOURCE_TILING>* tilingInfo )
-	{
-		auto&& stream = co_await OpenStreamAsync(s);
+		m_reader = std::make_unique<CoalescedTileReader>(settings);
 
-		m_subresourcesPerFaceInResource				= static_cast<uint32_t>(tilingInfo->size() / 6 );
-		uint32_t tilesForSingleFaceMostDetailedMip	= tilingInfo->at(1).StartTileIndexInOverallResource;
-		uint32_t tilesPerFace						= static_cast<uint32_t>( (stream.Size() / SampleSettings::TileSizeInBytes) / 6 );
-		
-		//Setup offsets
-		for (uint32_t face = 0; face < 6; face++)
-		{
-			uint32_t tileIndexInFace		= 0;
-			uint32_t tilesInSubresource		= tilesForSingleFaceMostDetailedMip;
-			m_subresourcesPerFaceInFile		= 0;
-			
-			while ( tileIndexInFace < tilesPerFace )
-			{
-				uint32_t offset		= ( face * tilesPerFace) + tileIndexInFace;
+		// The files are in the install folder of the package, which the app may read with positional reads.
+		std::filesystem::path folder(std::wstring(winrt::Windows::ApplicationModel::Package::Current().InstalledLocation().Path()));
 
-				m_subresourceTileOffsets.push_back(offset);
-				tileIndexInFace		+= tilesInSubresource;
-				tilesInSubresource	= std::max(1U, tilesInSubresource / 4);
-				m_subresourcesPerFaceInFile++;
-			}
+		if (!m_reader->Open(folder / m_filename))
+		{
+			throw exception(HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND));
 		}
 
-		co_return stream;
+		m_layout.Create(tilingInfo->data(), static_cast<uint32_t>(tilingInfo->size()), m_reader->File().Size() / SampleSettings::TileSizeInBytes);
 	}
 
-	task<std::vector<byte>> TileLoader::LoadTileAsync(D3D12_TILED_RESOURCE_COORDINATE _coordinate)
+	void TileLoader::LoadTile(D3D12_TILED_RESOURCE_COORDINATE coordinate, CoalescedTileReader::Done done)
 	{
-		auto   localCoordinate = _coordinate;
-		uint32_t subresourceInFile = (localCoordinate.Subresource / m_subresourcesPerFaceInResource ) * m_subresourcesPerFaceInFile + localCoordinate.Subresource % m_subresourcesPerFaceInResource;
-		size_t fileOffset		   = (m_subresourceTileOffsets[subresourceInFile] + (localCoordinate.Y * m_tilingInfo->at(localCoordinate.Subresource).WidthInTiles + localCoordinate.X) ) * SampleSettings::TileSizeInBytes;
-
-		auto offset		= fileOffset;
-		auto stream		= m_openStreamData;
-		auto reader		= DataReader(stream.GetInputStreamAt(offset));
-		auto bytesRead	= co_await reader.LoadAsync(SampleSettings::TileSizeInBytes);
+		m_reader->Request(m_layout.TileIndex(coordinate), std::move(done));
+	}
 
-		std::vector<byte> tileData(SampleSettings::TileSizeInBytes);
-		winrt::array_view<uint8_t> view(tileData);
-		reader.ReadBytes(view);
-		co_return std::move(tileData);
+	void TileLoader::Flush()
+	{
+		m_reader->Flush();
 	}
 }
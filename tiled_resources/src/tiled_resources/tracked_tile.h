@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "residency_types.h"
+#include "tile_queue.h"
+#include "tile_table.h"
+
+namespace sample
+{
+    enum class TileState
+    {
+        Seen,
+        Predicted,				//the prediction of the camera needs it, no sample has seen it yet
+        Loading,
+        Loaded,
+        Mapped,
+		NotDefined
+    };
+
+    struct TrackedTile
+    {
+		uint32_t							m_resource = 0;					//index of the resource in the policy
+		D3D12_TILED_RESOURCE_COORDINATE		m_coordinate = {};
+		TileKey								m_key = 0;
+		TrackedTile*						m_prev = nullptr;				//links of the list of the state
+		TrackedTile*						m_next = nullptr;
+		TileBucket<TrackedTile>*			m_bucket = nullptr;				//bucket of the queue of the state, if it is in one
+        uint16_t							m_mipLevel = 0;
+        uint16_t							m_face = 0;
+		uint32_t							m_physicalTileOffset = 0;
+        uint32_t							m_lastSeen = 0;
+		bool								m_predicted = false;			//tracked for the prediction, until a sample sees it
+		uint32_t							m_evictionState = 0;			//owned by the eviction policy, while the tile is mapped
+        std::vector<uint8_t>				m_tileData;
+        TileState							m_state = TileState::NotDefined;
+    };
+}